@@ -0,0 +1,276 @@
+/**
+ * @brief Red Pitaya PID block anti-windup testbench.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in Verilog hardware description language (HDL).
+ * Please visit http://en.wikipedia.org/wiki/Verilog
+ * for more details on the language used herein.
+ */
+
+
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Recovery time of a PI loop from saturation with each anti-windup mode.
+ *
+ * Four fast PID blocks (no anti-windup, conditional integration,
+ * back-calculation with AWK = 3, back-calculation with AWK = 0) each drive a first order plant with a gain of 1/2
+ * through an output stage like the one of red_pitaya_pid.v: the block
+ * output plus a constant (the other PID of the output) is clamped to 14
+ * bits, and the clamp excess is fed back to the block. The set point starts
+ * out of reach, so the output sits in the clamp of the sum while the block
+ * itself is in range, then steps to a reachable value.
+ *
+ * The four slow channels of one red_pitaya_pid_slow engine run the same
+ * four cases in slow counts (12 bit output stage, set points, offset and
+ * band scaled by 1/4).
+ *
+ * Prints the clocks from the step until the plant stays within TOL of the
+ * new set point for each mode, and the peak to peak ripple of the clamped
+ * output over the last RIPPLE clocks before the step. PASS if all
+ * anti-windup cases recover faster than the plain integrator and the
+ * back-calculation holds the output still in the clamp, also with AWK = 0
+ * and ICD = 0 (which acts as AWK = 3, a tracking gain of 1 limit-cycles
+ * against the loop latency), on both engines.
+ */
+
+
+
+
+`timescale 1ns / 1ps
+
+module red_pitaya_pid_antiwindup_tb(
+);
+
+localparam WINDUP  = 40000 ;          // clocks with the set point out of reach
+localparam RUN     = 60000 ;          // clocks after the step
+localparam OFFSET  = 4000  ;          // the other PID of the output stage
+localparam SP_HIGH = 6000  ;          // out of reach, the plant ends at 4095
+localparam SP_LOW  = 1000  ;
+localparam TOL     = 50    ;          // settled band
+localparam SETTLE  = 2000  ;          // clocks the plant has to stay in the band
+localparam RIPPLE  = 20000 ;          // clocks before the step the clamped output is watched
+localparam CASES   = 4     ;          // fast blocks, then as many slow channels
+
+reg              clk             ;
+reg              rstn            ;
+reg   [ 14-1: 0] sp              ;
+integer          t               ;    // clocks since the step, -1 before
+integer          rec  [0:2*CASES-1]    ;  // recovery time of each case
+integer          in_band [0:2*CASES-1] ;
+integer          u_min [0:2*CASES-1]   ;  // clamped output range before the step
+integer          u_max [0:2*CASES-1]   ;
+integer          y_m                   ;  // plant of case m, fast counts
+integer          m                   ;
+integer          errors              ;
+reg              watch               ;
+
+
+
+//---------------------------------------------------------------------------------
+//
+// blocks, output stages and plants, case m = AWM, case 3 back-calculation
+// with AWK = 0
+
+wire  [ CASES*14-1: 0] pid_out       ;
+reg   [ CASES*14-1: 0] plant         ;
+reg   [ CASES*17-1: 0] exc           ;
+reg   [ CASES*14-1: 0] u             ;
+
+genvar gm ;
+
+generate
+for (gm = 0; gm < CASES; gm = gm + 1) begin : awm
+
+   localparam [2-1:0] AWM = (gm < 3) ? gm : 2 ;
+   localparam [5-1:0] AWK = (gm < 3) ? 3  : 0 ;
+
+   reg  [22-1: 0] y ;                  // plant state, 8 fractional bits
+   wire [17-1: 0] sum = $signed(pid_out[14*gm +: 14]) + OFFSET ;
+
+   red_pitaya_pid_block #(.adc_res (14)) i_pid
+   (
+     .clk_i (clk), .rstn_i (rstn), .dat_i (plant[14*gm +: 14]), .dat_o (pid_out[14*gm +: 14]),
+     .set_sp_i (sp), .set_kp_i (14'd2048), .set_ki_i (14'd64), .set_kd_i (14'd0),
+     .int_rst_i (1'b0), .int_hold (1'b0), .int_scale_i (1'b0),
+     .PSR (5'd12), .ISR (5'd18), .DSR (5'd10), .ICD (30'd0), .TOL (9'd0),
+     .DCD (30'd0), .DFL (5'd0), .AWM (AWM), .AWK (AWK), .sat_exc_i (exc[17*gm +: 17]), .ff_i (16'd0),
+     .tlm_clr_i (1'b0), .tlm_err_o (), .tlm_int_o (), .tlm_p_o (), .tlm_i_o (), .tlm_d_o (),
+     .tlm_sat_o (), .sat_o ()
+   );
+
+   // output stage of red_pitaya_pid.v, clamp and excess registered
+   always @(posedge clk) begin
+      if (rstn == 1'b0) begin
+         u[14*gm +: 14]   <= 14'd0 ;
+         exc[17*gm +: 17] <= 17'd0 ;
+      end
+      else if (sum[17-1:14-1] == {4{sum[17-1]}}) begin
+         u[14*gm +: 14]   <= sum[14-1:0] ;
+         exc[17*gm +: 17] <= 17'd0 ;
+      end
+      else if (sum[17-1]) begin
+         u[14*gm +: 14]   <= 14'h2000 ;
+         exc[17*gm +: 17] <= $signed(17'h1E000) - $signed(sum) ;
+      end
+      else begin
+         u[14*gm +: 14]   <= 14'h1FFF ;
+         exc[17*gm +: 17] <= $signed(17'h01FFF) - $signed(sum) ;
+      end
+   end
+
+   // plant: y += (u / 2 - y) / 256
+   always @(posedge clk) begin
+      if (rstn == 1'b0)
+         y <= 22'd0 ;
+      else
+         y <= $signed(y) + (($signed({u[14*gm +: 14], 8'h0}) >>> 1) - $signed(y) >>> 8) ;
+      plant[14*gm +: 14] <= y[22-1:8] ;
+   end
+
+end
+endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//
+// slow engine, the same cases on channels 0 - 3
+
+wire  [ CASES*12-1: 0] slow_out    ;
+reg   [ CASES*12-1: 0] slow_plant  ;
+reg   [ CASES*15-1: 0] slow_exc    ;
+reg   [ CASES*12-1: 0] slow_u      ;
+wire  [       12-1: 0] slow_sp     = $signed(sp) >>> 2 ;
+
+red_pitaya_pid_slow #(.NUM (CASES)) i_slow
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (slow_plant), .dat_o (slow_out),
+  .set_sp_i ({CASES{slow_sp}}), .set_kp_i ({CASES{12'd2048}}), .set_ki_i ({CASES{12'd64}}),
+  .set_kd_i ({CASES{12'd0}}), .int_rst_i ({CASES{1'b0}}), .int_hold_i ({CASES{1'b0}}),
+  .int_scale_i ({CASES{1'b0}}), .psr_i ({CASES{5'd12}}), .isr_i ({CASES{5'd18}}),
+  .dsr_i ({CASES{5'd10}}), .icd_i ({CASES{30'd0}}), .tol_i ({CASES{9'd0}}), .ff_i ({CASES{16'd0}}),
+  .awm_i ({2'd2, 2'd2, 2'd1, 2'd0}), .awk_i ({5'd0, 5'd3, 5'd3, 5'd3}), .sat_exc_i (slow_exc),
+  .tlm_clr_i (1'b0), .tlm_err_o (), .tlm_int_o (), .tlm_p_o (), .tlm_i_o (), .tlm_d_o (),
+  .tlm_sat_o (), .sat_o ()
+);
+
+generate
+for (gm = 0; gm < CASES; gm = gm + 1) begin : slow
+
+   reg  [20-1: 0] y ;                  // plant state, 8 fractional bits
+   wire [15-1: 0] sum = $signed(slow_out[12*gm +: 12]) + OFFSET / 4 ;
+
+   // output stage of red_pitaya_pid_route.v, combinational as for the slow DACs
+   always @(*) begin
+      if (sum[15-1:12-1] == {4{sum[15-1]}}) begin
+         slow_u  [12*gm +: 12] = sum[12-1:0] ;
+         slow_exc[15*gm +: 15] = 15'd0 ;
+      end
+      else if (sum[15-1]) begin
+         slow_u  [12*gm +: 12] = 12'h800 ;
+         slow_exc[15*gm +: 15] = $signed(15'h7800) - $signed(sum) ;
+      end
+      else begin
+         slow_u  [12*gm +: 12] = 12'h7FF ;
+         slow_exc[15*gm +: 15] = $signed(15'h07FF) - $signed(sum) ;
+      end
+   end
+
+   // plant: y += (u / 2 - y) / 256
+   always @(posedge clk) begin
+      if (rstn == 1'b0)
+         y <= 20'd0 ;
+      else
+         y <= $signed(y) + (($signed({slow_u[12*gm +: 12], 8'h0}) >>> 1) - $signed(y) >>> 8) ;
+      slow_plant[12*gm +: 12] <= y[20-1:8] ;
+   end
+
+end
+endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//
+// signal generation and measurement
+
+initial begin
+   clk <= 1'b0 ;
+end
+
+always begin
+   #4  clk <= !clk ;
+end
+
+always @(posedge clk) begin
+   if (watch) begin
+      for (m = 0; m < 2*CASES; m = m + 1) begin
+         y_m = (m < CASES) ? $signed(u[14*m +: 14]) : $signed(slow_u[12*(m-CASES) +: 12]) ;
+         if (y_m < u_min[m])
+            u_min[m] = y_m ;
+         if (y_m > u_max[m])
+            u_max[m] = y_m ;
+      end
+   end
+   if (t >= 0) begin
+      t = t + 1 ;
+      for (m = 0; m < 2*CASES; m = m + 1) begin
+         y_m = (m < CASES) ? $signed(plant[14*m +: 14]) : 4 * $signed(slow_plant[12*(m-CASES) +: 12]) ;
+         if (y_m >= SP_LOW - TOL && y_m <= SP_LOW + TOL) begin
+            in_band[m] = in_band[m] + 1 ;
+            if (in_band[m] == SETTLE && rec[m] < 0)
+               rec[m] = t - SETTLE ;
+         end
+         else
+            in_band[m] = 0 ;
+      end
+   end
+end
+
+initial begin
+   t     = -1 ;
+   watch = 1'b0 ;
+   for (m = 0; m < 2*CASES; m = m + 1) begin
+      rec[m]     = -1 ;
+      in_band[m] = 0 ;
+      u_min[m]   = 8191 ;
+      u_max[m]   = -8192 ;
+   end
+   rstn <= 1'b0 ;
+   sp   <= SP_HIGH ;
+   repeat(10) @(posedge clk);
+   rstn <= 1'b1 ;
+   repeat(WINDUP - RIPPLE) @(posedge clk);
+   watch = 1'b1 ;
+   repeat(RIPPLE) @(posedge clk);
+   watch = 1'b0 ;
+
+   sp <= SP_LOW ;
+   t   = 0 ;
+   repeat(RUN) @(posedge clk);
+
+   errors = 0 ;
+   for (m = 0; m < 2*CASES; m = m + CASES) begin
+      $display("red_pitaya_pid_antiwindup_tb: %s recovery in clocks, none %0d, conditional %0d, back-calculation %0d, back-calculation AWK 0 %0d",
+               (m == 0) ? "fast" : "slow", rec[m], rec[m+1], rec[m+2], rec[m+3]);
+      $display("red_pitaya_pid_antiwindup_tb: %s clamped output ripple, none %0d, conditional %0d, back-calculation %0d, back-calculation AWK 0 %0d",
+               (m == 0) ? "fast" : "slow", u_max[m] - u_min[m], u_max[m+1] - u_min[m+1],
+               u_max[m+2] - u_min[m+2], u_max[m+3] - u_min[m+3]);
+      if (!(rec[m+1] >= 0 && rec[m+2] >= 0 && rec[m+3] >= 0 &&
+            (rec[m] < 0 || (rec[m+1] < rec[m] && rec[m+2] < rec[m] && rec[m+3] < rec[m])) &&
+            u_max[m+2] == u_min[m+2] && u_max[m+3] == u_min[m+3]))
+         errors = errors + 1 ;
+   end
+   if (errors == 0)
+      $display("red_pitaya_pid_antiwindup_tb: PASS");
+   else
+      $display("red_pitaya_pid_antiwindup_tb: FAIL");
+   $finish ;
+end
+
+
+
+endmodule
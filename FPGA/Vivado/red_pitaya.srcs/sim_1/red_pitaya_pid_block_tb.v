@@ -0,0 +1,275 @@
+/**
+ * @brief Red Pitaya PID block testbench.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in Verilog hardware description language (HDL).
+ * Please visit http://en.wikipedia.org/wiki/Verilog
+ * for more details on the language used herein.
+ */
+
+
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Bit-exact check of the PID block datapath against the case table version
+ * (red_pitaya_pid_block_ref.v).
+ *
+ * Fast and slow blocks with the default widths run next to the reference
+ * with the same random inputs; a fast block with 25 bit gains and a wider
+ * integrator runs with the gains shifted up by the extra bits. Every vector
+ * loads random gains during reset, then runs with random inputs, integrator
+ * resets, holds, tolerance, divider and resolution settings (valid and
+ * invalid ones), comparing the output and all telemetry every clock.
+ *
+ * The derivative divider and filter, the anti-windup, the feedforward and
+ * the integrator rescale of the new blocks stay off (DCD = 0, DFL = 0,
+ * AWM = 0, ff_i = 0, int_scale_i = 0), which is the datapath of the
+ * reference.
+ *
+ * Prints PASS or FAIL with the number of mismatching clocks.
+ */
+
+
+
+
+`timescale 1ns / 1ps
+
+module red_pitaya_pid_block_tb(
+);
+
+localparam VECTORS = 200  ;           // gain sets
+localparam SAMPLES = 4000 ;           // clocks compared per set
+localparam GX      = 11   ;           // extra gain bits of the wide block
+
+reg              clk             ;
+reg              rstn            ;
+reg              chk             ;
+integer          errors          ;
+integer          seed            ;
+integer          v               ;
+
+// stimulus
+reg   [ 14-1: 0] dat_f           ;
+reg   [ 14-1: 0] sp_f            ;
+reg   [ 14-1: 0] kp_f            ;
+reg   [ 14-1: 0] ki_f            ;
+reg   [ 14-1: 0] kd_f            ;
+reg   [ 12-1: 0] dat_s           ;
+reg   [ 12-1: 0] sp_s            ;
+reg   [ 12-1: 0] kp_s            ;
+reg   [ 12-1: 0] ki_s            ;
+reg   [ 12-1: 0] kd_s            ;
+reg   [  5-1: 0] psr             ;
+reg   [  5-1: 0] isr             ;
+reg   [  5-1: 0] dsr             ;
+reg   [ 30-1: 0] icd             ;
+reg   [  9-1: 0] tol             ;
+reg              irst            ;
+reg              hold            ;
+reg              tclr            ;
+reg              near            ;  // inputs close to the set point
+
+
+
+//---------------------------------------------------------------------------------
+//
+// blocks under test, outputs and telemetry concatenated per block
+
+wire  [14+5*32+4-1: 0] ref_f     ;
+wire  [14+5*32+4-1: 0] new_f     ;
+wire  [14+5*32+4-1: 0] wide_f    ;
+wire  [12+5*32+4-1: 0] ref_s     ;
+wire  [12+5*32+4-1: 0] new_s     ;
+
+red_pitaya_pid_block_ref #(.adc_res (14)) i_ref_f
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat_f), .dat_o (ref_f[178-1 -: 14]),
+  .set_sp_i (sp_f), .set_kp_i (kp_f), .set_ki_i (ki_f), .set_kd_i (kd_f),
+  .int_rst_i (irst), .int_hold (hold),
+  .PSR (psr), .ISR (isr), .DSR (dsr), .ICD (icd), .TOL (tol),
+  .tlm_clr_i (tclr), .tlm_err_o (ref_f[164-1 -: 32]), .tlm_int_o (ref_f[132-1 -: 32]),
+  .tlm_p_o (ref_f[100-1 -: 32]), .tlm_i_o (ref_f[68-1 -: 32]), .tlm_d_o (ref_f[36-1 -: 32]),
+  .tlm_sat_o (ref_f[3:2]), .sat_o (ref_f[1:0])
+);
+
+red_pitaya_pid_block #(.adc_res (14)) i_new_f
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat_f), .dat_o (new_f[178-1 -: 14]),
+  .set_sp_i (sp_f), .set_kp_i (kp_f), .set_ki_i (ki_f), .set_kd_i (kd_f),
+  .int_rst_i (irst), .int_hold (hold), .int_scale_i (1'b0),
+  .PSR (psr), .ISR (isr), .DSR (dsr), .ICD (icd), .TOL (tol), .DCD (30'd0), .DFL (5'd0),
+  .AWM (2'd0), .AWK (5'd0), .sat_exc_i (17'd0), .ff_i (16'd0),
+  .tlm_clr_i (tclr), .tlm_err_o (new_f[164-1 -: 32]), .tlm_int_o (new_f[132-1 -: 32]),
+  .tlm_p_o (new_f[100-1 -: 32]), .tlm_i_o (new_f[68-1 -: 32]), .tlm_d_o (new_f[36-1 -: 32]),
+  .tlm_sat_o (new_f[3:2]), .sat_o (new_f[1:0])
+);
+
+red_pitaya_pid_block #(.adc_res (14), .gain_res (14+GX), .int_res (32+GX)) i_wide_f
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat_f), .dat_o (wide_f[178-1 -: 14]),
+  .set_sp_i (sp_f), .set_kp_i ({kp_f, {GX{1'b0}}}), .set_ki_i ({ki_f, {GX{1'b0}}}), .set_kd_i ({kd_f, {GX{1'b0}}}),
+  .int_rst_i (irst), .int_hold (hold), .int_scale_i (1'b0),
+  .PSR (psr), .ISR (isr), .DSR (dsr), .ICD (icd), .TOL (tol), .DCD (30'd0), .DFL (5'd0),
+  .AWM (2'd0), .AWK (5'd0), .sat_exc_i (17'd0), .ff_i (16'd0),
+  .tlm_clr_i (tclr), .tlm_err_o (wide_f[164-1 -: 32]), .tlm_int_o (wide_f[132-1 -: 32]),
+  .tlm_p_o (wide_f[100-1 -: 32]), .tlm_i_o (wide_f[68-1 -: 32]), .tlm_d_o (wide_f[36-1 -: 32]),
+  .tlm_sat_o (wide_f[3:2]), .sat_o (wide_f[1:0])
+);
+
+red_pitaya_pid_block_ref #(.adc_res (12)) i_ref_s
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat_s), .dat_o (ref_s[176-1 -: 12]),
+  .set_sp_i (sp_s), .set_kp_i (kp_s), .set_ki_i (ki_s), .set_kd_i (kd_s),
+  .int_rst_i (irst), .int_hold (hold),
+  .PSR (psr), .ISR (isr), .DSR (dsr), .ICD (icd), .TOL (tol),
+  .tlm_clr_i (tclr), .tlm_err_o (ref_s[164-1 -: 32]), .tlm_int_o (ref_s[132-1 -: 32]),
+  .tlm_p_o (ref_s[100-1 -: 32]), .tlm_i_o (ref_s[68-1 -: 32]), .tlm_d_o (ref_s[36-1 -: 32]),
+  .tlm_sat_o (ref_s[3:2]), .sat_o (ref_s[1:0])
+);
+
+red_pitaya_pid_block #(.adc_res (12)) i_new_s
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat_s), .dat_o (new_s[176-1 -: 12]),
+  .set_sp_i (sp_s), .set_kp_i (kp_s), .set_ki_i (ki_s), .set_kd_i (kd_s),
+  .int_rst_i (irst), .int_hold (hold), .int_scale_i (1'b0),
+  .PSR (psr), .ISR (isr), .DSR (dsr), .ICD (icd), .TOL (tol), .DCD (30'd0), .DFL (5'd0),
+  .AWM (2'd0), .AWK (5'd0), .sat_exc_i (15'd0), .ff_i (16'd0),
+  .tlm_clr_i (tclr), .tlm_err_o (new_s[164-1 -: 32]), .tlm_int_o (new_s[132-1 -: 32]),
+  .tlm_p_o (new_s[100-1 -: 32]), .tlm_i_o (new_s[68-1 -: 32]), .tlm_d_o (new_s[36-1 -: 32]),
+  .tlm_sat_o (new_s[3:2]), .sat_o (new_s[1:0])
+);
+
+
+
+//---------------------------------------------------------------------------------
+//
+// random settings
+
+// gain: full range, small, at the limits or zero
+function [14-1:0] rnd_gain ;
+   input integer a_rnd ;
+   begin
+      case (a_rnd[17:16])
+         2'd0:    rnd_gain = a_rnd[14-1:0] ;
+         2'd1:    rnd_gain = {{8{a_rnd[6]}}, a_rnd[6-1:0]} ;
+         2'd2:    rnd_gain = a_rnd[0] ? 14'h1FFF : 14'h2000 ;
+         default: rnd_gain = 14'h0 ;
+      endcase
+   end
+endfunction
+
+// resolution: mostly in the valid range, sometimes any setting
+function [5-1:0] rnd_shift ;
+   input integer a_rnd ;
+   input integer a_lo  ;
+   begin
+      if (a_rnd[8])
+         rnd_shift = a_rnd[5-1:0] ;
+      else
+         rnd_shift = a_lo + (a_rnd[7:4] % 11) ;
+   end
+endfunction
+
+
+
+//---------------------------------------------------------------------------------
+//
+// signal generation
+
+initial begin
+   clk <= 1'b0 ;
+end
+
+always begin
+   #4  clk <= !clk ;
+end
+
+// inputs, integrator control and resolutions change while running
+always @(posedge clk) begin
+   if (near) begin
+      dat_f <= sp_f + ($random(seed) % 16) ;
+      dat_s <= sp_s + ($random(seed) % 16) ;
+   end
+   else begin
+      dat_f <= $random(seed) ;
+      dat_s <= $random(seed) ;
+   end
+   irst <= (($random(seed) & 511) == 0) ;
+   if (($random(seed) & 255) == 0)
+      hold <= !hold ;
+   tclr <= (($random(seed) & 63) == 0) ;
+   if (($random(seed) & 1023) == 0) begin
+      psr <= rnd_shift($random(seed),  5) ;
+      isr <= rnd_shift($random(seed), 14) ;
+      dsr <= rnd_shift($random(seed),  3) ;
+   end
+   if (($random(seed) & 2047) == 0)
+      tol <= $random(seed) & 9'h1F ;
+end
+
+// gains are loaded in reset, they take effect one clock later than in the reference
+initial begin
+   seed   = 1 ;
+   errors = 0 ;
+   chk   <= 1'b0 ;
+   near  <= 1'b0 ;
+   rstn  <= 1'b1 ;
+   {sp_f, kp_f, ki_f, kd_f} <= 0 ;
+   {sp_s, kp_s, ki_s, kd_s} <= 0 ;
+   {psr, isr, dsr, icd, tol} <= 0 ;
+   {irst, hold, tclr} <= 0 ;
+   repeat(8) @(posedge clk);
+
+   for (v = 0; v < VECTORS; v = v + 1) begin
+      chk  <= 1'b0 ;
+      rstn <= 1'b0 ;
+      kp_f <= rnd_gain($random(seed)) ;
+      ki_f <= rnd_gain($random(seed)) ;
+      kd_f <= rnd_gain($random(seed)) ;
+      kp_s <= rnd_gain($random(seed)) >> 2 ;
+      ki_s <= rnd_gain($random(seed)) >> 2 ;
+      kd_s <= rnd_gain($random(seed)) >> 2 ;
+      sp_f <= $random(seed) ;
+      sp_s <= $random(seed) ;
+      psr  <= rnd_shift($random(seed),  5) ;
+      isr  <= rnd_shift($random(seed), 14) ;
+      dsr  <= rnd_shift($random(seed),  3) ;
+      icd  <= (v % 4 == 0) ? 30'd0 : $random(seed) & 30'h7 ;
+      tol  <= (v % 3 == 0) ? 9'd0 : $random(seed) & 9'h1F ;
+      near <= (v % 2) ;
+      hold <= 1'b0 ;
+      repeat(4) @(posedge clk);
+      rstn <= 1'b1 ;
+      repeat(8) @(posedge clk);
+      chk  <= 1'b1 ;
+      repeat(SAMPLES) @(posedge clk);
+   end
+
+   chk <= 1'b0 ;
+   @(posedge clk);
+   if (errors == 0)
+      $display("red_pitaya_pid_block_tb: PASS, %0d vectors of %0d clocks", VECTORS, SAMPLES);
+   else
+      $display("red_pitaya_pid_block_tb: FAIL, %0d mismatching clocks", errors);
+   $finish ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//
+// comparison
+
+always @(negedge clk) begin
+   if (chk && (new_f !== ref_f || wide_f !== ref_f || new_s !== ref_s)) begin
+      errors = errors + 1 ;
+      if (errors <= 10)
+         $display("%t vector %0d: fast %h / %h / %h, slow %h / %h", $time, v, ref_f, new_f, wide_f, ref_s, new_s);
+   end
+end
+
+
+
+endmodule
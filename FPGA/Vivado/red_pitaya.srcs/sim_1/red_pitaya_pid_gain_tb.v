@@ -0,0 +1,264 @@
+/**
+ * @brief Red Pitaya PID legacy gain register testbench.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in Verilog hardware description language (HDL).
+ * Please visit http://en.wikipedia.org/wiki/Verilog
+ * for more details on the language used herein.
+ */
+
+
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Bit-exact check of the fast gain registers of red_pitaya_pid.v in their
+ * reset mode (FINE = 0): PID11, which runs with 25 bit gains, against the
+ * 14 bit case table version (red_pitaya_pid_block_ref.v) given the very
+ * words written to Kp/Ki/Kd.
+ *
+ * Every vector writes random legacy gains (with junk above bit 13), set
+ * point and resolutions over the bus while the integrator is reset, then
+ * runs with random inputs and integrator holds, comparing the output and
+ * all telemetry every clock. The reference takes everything but the gains
+ * from the ports of PID11, so only the bus view of the gains is under
+ * test. Some vectors switch FINE on and off while running, which must not
+ * disturb the loop, and read the gains back in both modes.
+ *
+ * Prints PASS or FAIL with the number of mismatching clocks and reads.
+ */
+
+
+
+
+`timescale 1ns / 1ps
+
+module red_pitaya_pid_gain_tb(
+);
+
+localparam VECTORS = 40   ;           // gain sets
+localparam SAMPLES = 2000 ;           // clocks compared per set
+localparam GX      = 11   ;           // fractional gain bits of the fast blocks
+
+reg              clk             ;
+reg              rstn            ;
+reg              chk             ;
+integer          errors          ;
+integer          seed            ;
+integer          v               ;
+
+reg   [ 14-1: 0] dat_a           ;
+reg   [  8-1: 0] pins            ;
+reg   [ 14-1: 0] kp              ;
+reg   [ 14-1: 0] ki              ;
+reg   [ 14-1: 0] kd              ;
+reg   [ 32-1: 0] rd              ;
+
+reg   [ 32-1: 0] sys_addr        ;
+reg   [ 32-1: 0] sys_wdata       ;
+reg              sys_wen         ;
+reg              sys_ren         ;
+wire  [ 32-1: 0] sys_rdata       ;
+wire             sys_err         ;
+wire             sys_ack         ;
+
+
+
+//---------------------------------------------------------------------------------
+//
+// design under test and reference, outputs and telemetry concatenated
+
+wire  [14+5*32+4-1: 0] dut       ;
+wire  [14+5*32+4-1: 0] ref       ;
+
+red_pitaya_pid i_pid
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_a_i (dat_a), .dat_b_i (14'd0), .dat_a_o (), .dat_b_o (),
+  .adc_slx_a_i (12'd0), .adc_slx_b_i (12'd0), .adc_slx_c_i (12'd0), .adc_slx_d_i (12'd0),
+  .dac_pwm_a_o (), .dac_pwm_b_o (), .dac_pwm_c_o (), .dac_pwm_d_o (),
+  .int_hold_pins (pins), .led (),
+  .sys_clk_i (clk), .sys_rstn_i (rstn), .sys_addr_i (sys_addr), .sys_wdata_i (sys_wdata),
+  .sys_sel_i (4'hF), .sys_wen_i (sys_wen), .sys_ren_i (sys_ren), .sys_rdata_o (sys_rdata),
+  .sys_err_o (sys_err), .sys_ack_o (sys_ack)
+);
+
+assign dut = {i_pid.i_pid11.dat_o, i_pid.i_pid11.tlm_err_o, i_pid.i_pid11.tlm_int_o, i_pid.i_pid11.tlm_p_o,
+              i_pid.i_pid11.tlm_i_o, i_pid.i_pid11.tlm_d_o, i_pid.i_pid11.tlm_sat_o, i_pid.i_pid11.sat_o} ;
+
+red_pitaya_pid_block_ref #(.adc_res (14)) i_ref
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (i_pid.i_pid11.dat_i), .dat_o (ref[178-1 -: 14]),
+  .set_sp_i (i_pid.i_pid11.set_sp_i), .set_kp_i (kp), .set_ki_i (ki), .set_kd_i (kd),
+  .int_rst_i (i_pid.i_pid11.int_rst_i), .int_hold (i_pid.i_pid11.int_hold),
+  .PSR (i_pid.i_pid11.PSR), .ISR (i_pid.i_pid11.ISR), .DSR (i_pid.i_pid11.DSR),
+  .ICD (i_pid.i_pid11.ICD), .TOL (i_pid.i_pid11.TOL),
+  .tlm_clr_i (i_pid.i_pid11.tlm_clr_i), .tlm_err_o (ref[164-1 -: 32]), .tlm_int_o (ref[132-1 -: 32]),
+  .tlm_p_o (ref[100-1 -: 32]), .tlm_i_o (ref[68-1 -: 32]), .tlm_d_o (ref[36-1 -: 32]),
+  .tlm_sat_o (ref[3:2]), .sat_o (ref[1:0])
+);
+
+
+
+//---------------------------------------------------------------------------------
+//
+// system bus
+
+task bus_write ;
+   input [32-1: 0] addr  ;
+   input [32-1: 0] wdata ;
+   begin
+      @(posedge clk)
+      sys_wen   <= 1'b1  ;
+      sys_addr  <= addr  ;
+      sys_wdata <= wdata ;
+      @(posedge clk);
+      sys_wen   <= 1'b0  ;
+      while (!sys_ack)
+         @(posedge clk);
+   end
+endtask
+
+task bus_check ;
+   input [32-1: 0] addr  ;
+   input [32-1: 0] value ;
+   begin
+      @(posedge clk)
+      sys_ren  <= 1'b1  ;
+      sys_addr <= addr  ;
+      @(posedge clk);
+      sys_ren  <= 1'b0  ;
+      while (!sys_ack)
+         @(posedge clk);
+      rd = sys_rdata ;
+      if (rd !== value) begin
+         errors = errors + 1 ;
+         $display("%t vector %0d: %h reads %h, expected %h", $time, v, addr, rd, value);
+      end
+   end
+endtask
+
+
+
+//---------------------------------------------------------------------------------
+//
+// random settings, as red_pitaya_pid_block_tb.v
+
+// gain: full range, small, at the limits or zero
+function [14-1:0] rnd_gain ;
+   input integer a_rnd ;
+   begin
+      case (a_rnd[17:16])
+         2'd0:    rnd_gain = a_rnd[14-1:0] ;
+         2'd1:    rnd_gain = {{8{a_rnd[6]}}, a_rnd[6-1:0]} ;
+         2'd2:    rnd_gain = a_rnd[0] ? 14'h1FFF : 14'h2000 ;
+         default: rnd_gain = 14'h0 ;
+      endcase
+   end
+endfunction
+
+// resolution: mostly in the valid range, sometimes any setting
+function [5-1:0] rnd_shift ;
+   input integer a_rnd ;
+   input integer a_lo  ;
+   begin
+      if (a_rnd[8])
+         rnd_shift = a_rnd[5-1:0] ;
+      else
+         rnd_shift = a_lo + (a_rnd[7:4] % 11) ;
+   end
+endfunction
+
+
+
+//---------------------------------------------------------------------------------
+//
+// signal generation
+
+initial begin
+   clk <= 1'b0 ;
+end
+
+always begin
+   #4  clk <= !clk ;
+end
+
+// input and integrator hold change while running
+always @(posedge clk) begin
+   dat_a <= $random(seed) ;
+   if (($random(seed) & 255) == 0)
+      pins[0] <= !pins[0] ;
+end
+
+initial begin
+   seed   = 1 ;
+   errors = 0 ;
+   chk   <= 1'b0 ;
+   rstn  <= 1'b0 ;
+   pins  <= 8'h0 ;
+   {kp, ki, kd} <= 0 ;
+   {sys_addr, sys_wdata, sys_wen, sys_ren} <= 0 ;
+   repeat(10) @(posedge clk);
+   rstn  <= 1'b1 ;
+   repeat(10) @(posedge clk);
+
+   for (v = 0; v < VECTORS; v = v + 1) begin
+      chk <= 1'b0 ;
+      bus_write(32'h090, 32'h1) ;
+      kp  <= rnd_gain($random(seed)) ;
+      ki  <= rnd_gain($random(seed)) ;
+      kd  <= rnd_gain($random(seed)) ;
+      @(posedge clk);
+      // the bits above the 14 bit gain are ignored
+      bus_write(32'h014, {$random(seed), 14'h0} | kp) ;
+      bus_write(32'h018, {$random(seed), 14'h0} | ki) ;
+      bus_write(32'h01C, {$random(seed), 14'h0} | kd) ;
+      bus_write(32'h010, $random(seed)) ;
+      bus_write(32'h0B0, rnd_shift($random(seed),  5)) ;
+      bus_write(32'h0B4, rnd_shift($random(seed), 14)) ;
+      bus_write(32'h0B8, rnd_shift($random(seed),  3)) ;
+      bus_write(32'h0BC, (v % 4 == 0) ? 30'd0 : $random(seed) & 30'h7) ;
+      bus_write(32'h130, (v % 3 == 0) ? 9'd0 : $random(seed) & 9'h1F) ;
+      bus_check(32'h014, {18'h0, kp}) ;
+      bus_check(32'h214, {18'h0, kp}) ;
+      repeat(8) @(posedge clk);
+      chk <= 1'b1 ;
+      bus_write(32'h090, 32'h0) ;
+      repeat(SAMPLES / 2) @(posedge clk);
+      if (v % 2) begin
+         // the mode is a bus view, the loop keeps running with the same gains
+         bus_write(32'h70C, 32'h1) ;
+         bus_check(32'h018, {7'h0, ki, {GX{1'b0}}}) ;
+         bus_check(32'h21C, {7'h0, kd, {GX{1'b0}}}) ;
+         bus_write(32'h70C, 32'h0) ;
+         bus_check(32'h018, {18'h0, ki}) ;
+      end
+      repeat(SAMPLES / 2) @(posedge clk);
+   end
+
+   chk <= 1'b0 ;
+   @(posedge clk);
+   if (errors == 0)
+      $display("red_pitaya_pid_gain_tb: PASS, %0d vectors of %0d clocks", VECTORS, SAMPLES);
+   else
+      $display("red_pitaya_pid_gain_tb: FAIL, %0d mismatching clocks and reads", errors);
+   $finish ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//
+// comparison
+
+always @(negedge clk) begin
+   if (chk && dut !== ref) begin
+      errors = errors + 1 ;
+      if (errors <= 10)
+         $display("%t vector %0d: %h / %h", $time, v, ref, dut);
+   end
+end
+
+
+
+endmodule
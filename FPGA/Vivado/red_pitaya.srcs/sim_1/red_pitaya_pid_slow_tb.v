@@ -0,0 +1,359 @@
+/**
+ * @brief Red Pitaya slow PID engine testbench.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in Verilog hardware description language (HDL).
+ * Please visit http://en.wikipedia.org/wiki/Verilog
+ * for more details on the language used herein.
+ */
+
+
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Check of the time multiplexed engine (red_pitaya_pid_slow.v, NUM = 4)
+ * against four slow blocks of the case table version
+ * (red_pitaya_pid_block_ref.v), one per channel, with the same random
+ * inputs and settings per channel.
+ *
+ * The engine samples a channel on one clock of SLOTS, so the comparison
+ * follows the visits. Four kinds of vectors take turns:
+ *
+ * Exact (inputs far from or near the set point): ICD + 1 of 1, 2 or 4, or a
+ * multiple of SLOTS, Kd = 0. The inputs change every 2 * SLOTS clocks,
+ * so every visit sees one input the blocks integrated for SLOTS clocks.
+ * Once per input the output of every channel, as left by its first visit
+ * to the new input, must equal the block output 9 clocks after the change:
+ * by then the block has integrated SLOTS clocks of it, and its P term
+ * (from a sample 4 clocks later than the integrator) still sees it. The
+ * blocks leave reset one clock after the engine, which puts their
+ * integrator divider in phase with the visits. TOL stays 0, since the
+ * blocks compare a sample with the tolerance one clock late.
+ *
+ * Integrator rate: ICD + 1 of 3, or above SLOTS and not a multiple of it,
+ * with a constant error per channel. At the end the integrator counts
+ * steps at the documented rate: 2^floor(log2(SLOTS / (ICD + 1))) steps a
+ * visit below SLOTS (3/4 of the gain with ICD = 2), one step per ICD + 1
+ * clocks above, to within a visit of the blocks.
+ *
+ * Derivative: random Kd and inputs every clock. The D term of a visit
+ * times SLOTS is the sum of the block D terms over the SLOTS clocks since
+ * the last visit, to within SLOTS - 1 (the engine divides by SLOTS before
+ * the difference).
+ *
+ * In all vectors the output and the D term of a channel hold between its
+ * visits.
+ *
+ * Prints PASS or FAIL with the number of failed checks.
+ */
+
+
+
+
+`timescale 1ns / 1ps
+
+module red_pitaya_pid_slow_tb(
+);
+
+localparam NUM     = 4    ;           // engine channels
+localparam SLOTS   = 4    ;           // clocks from one visit of a channel to the next
+localparam GROUP   = 2 * SLOTS ;      // clocks an input holds in the exact vectors
+localparam VECTORS = 40   ;           // settings
+localparam SAMPLES = 1600 ;           // clocks per setting
+
+reg              clk             ;
+reg              rstn            ;
+reg              rstn_r          ;    // reset of the blocks, one clock later
+reg              chk             ;
+integer          errors          ;
+integer          seed            ;
+integer          v               ;
+integer          mode            ;    // 0 exact, 1 exact near the set point, 2 integrator rate, 3 derivative
+integer          cyc             ;    // clocks since the engine left reset
+integer          k               ;
+integer          m               ;
+
+// stimulus, channel n at [w*n +: w]
+reg   [NUM*12-1: 0] dat          ;
+reg   [NUM*12-1: 0] sp           ;
+reg   [NUM*12-1: 0] kp           ;
+reg   [NUM*12-1: 0] ki           ;
+reg   [NUM*12-1: 0] kd           ;
+reg   [NUM* 5-1: 0] psr          ;
+reg   [NUM* 5-1: 0] isr          ;
+reg   [NUM* 5-1: 0] dsr          ;
+reg   [NUM*30-1: 0] icd          ;
+
+
+
+//---------------------------------------------------------------------------------
+//
+// engine under test and one reference block per channel
+
+wire  [NUM*12-1: 0] eng_out      ;
+wire  [NUM*32-1: 0] eng_int      ;
+wire  [NUM*32-1: 0] eng_d        ;
+wire  [NUM*12-1: 0] ref_out      ;
+wire  [NUM*32-1: 0] ref_int      ;
+wire  [NUM*32-1: 0] ref_d        ;
+
+reg   [NUM*12-1: 0] eng_out_r    ;    // last clock
+reg   [NUM*32-1: 0] eng_d_r      ;
+reg   [    32-1: 0] ref_dh [0:NUM*SLOTS-1] ;  // block D terms of the last SLOTS clocks
+
+red_pitaya_pid_slow #(.NUM (NUM)) i_slow
+(
+  .clk_i (clk), .rstn_i (rstn), .dat_i (dat), .dat_o (eng_out),
+  .set_sp_i (sp), .set_kp_i (kp), .set_ki_i (ki), .set_kd_i (kd),
+  .int_rst_i ({NUM{1'b0}}), .int_hold_i ({NUM{1'b0}}), .int_scale_i ({NUM{1'b0}}),
+  .psr_i (psr), .isr_i (isr), .dsr_i (dsr), .icd_i (icd), .tol_i ({NUM*9{1'b0}}),
+  .ff_i ({NUM*16{1'b0}}), .awm_i ({NUM*2{1'b0}}), .awk_i ({NUM*5{1'b0}}), .sat_exc_i ({NUM*15{1'b0}}),
+  .tlm_clr_i (1'b0), .tlm_err_o (), .tlm_int_o (eng_int), .tlm_p_o (), .tlm_i_o (),
+  .tlm_d_o (eng_d), .tlm_sat_o (), .sat_o ()
+);
+
+genvar n ;
+generate for (n = 0; n < NUM; n = n + 1) begin : ch
+
+red_pitaya_pid_block_ref #(.adc_res (12)) i_ref
+(
+  .clk_i (clk), .rstn_i (rstn_r), .dat_i (dat[12*n +: 12]), .dat_o (ref_out[12*n +: 12]),
+  .set_sp_i (sp[12*n +: 12]), .set_kp_i (kp[12*n +: 12]), .set_ki_i (ki[12*n +: 12]), .set_kd_i (kd[12*n +: 12]),
+  .int_rst_i (1'b0), .int_hold (1'b0),
+  .PSR (psr[5*n +: 5]), .ISR (isr[5*n +: 5]), .DSR (dsr[5*n +: 5]), .ICD (icd[30*n +: 30]), .TOL (9'd0),
+  .tlm_clr_i (1'b0), .tlm_err_o (), .tlm_int_o (ref_int[32*n +: 32]), .tlm_p_o (), .tlm_i_o (),
+  .tlm_d_o (ref_d[32*n +: 32]), .tlm_sat_o (), .sat_o ()
+);
+
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//
+// random settings, as red_pitaya_pid_block_tb.v
+
+// gain: full range, small, at the limits or zero
+function [14-1:0] rnd_gain ;
+   input integer a_rnd ;
+   begin
+      case (a_rnd[17:16])
+         2'd0:    rnd_gain = a_rnd[14-1:0] ;
+         2'd1:    rnd_gain = {{8{a_rnd[6]}}, a_rnd[6-1:0]} ;
+         2'd2:    rnd_gain = a_rnd[0] ? 14'h1FFF : 14'h2000 ;
+         default: rnd_gain = 14'h0 ;
+      endcase
+   end
+endfunction
+
+// resolution: mostly in the valid range, sometimes any setting
+function [5-1:0] rnd_shift ;
+   input integer a_rnd ;
+   input integer a_lo  ;
+   begin
+      if (a_rnd[8])
+         rnd_shift = a_rnd[5-1:0] ;
+      else
+         rnd_shift = a_lo + (a_rnd[7:4] % 11) ;
+   end
+endfunction
+
+// integrator divider: one the engine matches exactly, or one it does not
+function [30-1:0] rnd_icd ;
+   input integer a_rnd   ;
+   input integer a_exact ;
+   begin
+      if (a_exact)
+         case (a_rnd[6:4] % 7)
+            0: rnd_icd =  0 ;
+            1: rnd_icd =  1 ;
+            2: rnd_icd =  3 ;
+            3: rnd_icd =  7 ;
+            4: rnd_icd = 11 ;
+            5: rnd_icd = 15 ;
+            default: rnd_icd = 31 ;
+         endcase
+      else
+         case (a_rnd[6:4] % 6)
+            0: rnd_icd =  2 ;
+            1: rnd_icd =  4 ;
+            2: rnd_icd =  5 ;
+            3: rnd_icd =  6 ;
+            4: rnd_icd =  9 ;
+            default: rnd_icd = 22 ;
+         endcase
+   end
+endfunction
+
+// steps of the engine integrator per visit with ICD below SLOTS, 2^floor(log2(SLOTS / (ICD + 1)))
+function integer visit_steps ;
+   input integer a_icd ;
+   begin
+      visit_steps = 1 ;
+      while (visit_steps * 2 * (a_icd + 1) <= SLOTS)
+         visit_steps = visit_steps * 2 ;
+   end
+endfunction
+
+
+
+//---------------------------------------------------------------------------------
+//
+// signal generation
+
+initial begin
+   clk <= 1'b0 ;
+end
+
+always begin
+   #4  clk <= !clk ;
+end
+
+always @(posedge clk) begin
+   rstn_r <= rstn ;
+   cyc    <= rstn ? cyc + 1 : 0 ;
+end
+
+// the exact vectors change all inputs together, the first time 12 clocks
+// after reset, so the blocks start from a zero error as the engine does
+always @(posedge clk) begin
+   if (rstn) begin
+      for (k = 0; k < NUM; k = k + 1) begin
+         if (((mode < 2) && (cyc >= 11) && (cyc % GROUP == 3)) || (mode == 3)) begin
+            if (mode == 1)
+               dat[12*k +: 12] <= sp[12*k +: 12] + ($random(seed) % 16) ;
+            else
+               dat[12*k +: 12] <= $random(seed) ;
+         end
+      end
+   end
+end
+
+initial begin
+   seed   = 1 ;
+   errors = 0 ;
+   mode   = 0 ;
+   chk   <= 1'b0 ;
+   rstn  <= 1'b1 ;
+   {dat, sp, kp, ki, kd} <= 0 ;
+   {psr, isr, dsr, icd} <= 0 ;
+   repeat(8) @(posedge clk);
+
+   for (v = 0; v < VECTORS; v = v + 1) begin
+      chk  <= 1'b0 ;
+      mode  = v % 4 ;
+      for (k = 0; k < NUM; k = k + 1) begin
+         kp [12*k +: 12] <= rnd_gain($random(seed)) >> 2 ;
+         ki [12*k +: 12] <= (mode == 2) ? ($random(seed) % 511) | 12'h1 : rnd_gain($random(seed)) >> 2 ;
+         kd [12*k +: 12] <= (mode == 3) ? rnd_gain($random(seed)) >> 2 : 12'h0 ;
+         sp [12*k +: 12] <= $random(seed) ;
+         psr[ 5*k +:  5] <= rnd_shift($random(seed),  5) ;
+         isr[ 5*k +:  5] <= rnd_shift($random(seed), 14) ;
+         dsr[ 5*k +:  5] <= rnd_shift($random(seed),  3) ;
+         icd[30*k +: 30] <= rnd_icd($random(seed), (mode < 2) || (mode == 3 && k % 2 == 0)) ;
+      end
+      @(posedge clk);
+      // no error to start from, or the constant error of the rate vectors;
+      // the blocks take it into their input pipeline before the reset
+      for (k = 0; k < NUM; k = k + 1)
+         dat[12*k +: 12] <= sp[12*k +: 12] - ((mode == 2) ? (($random(seed) % 127) | 12'h1) : 12'h0) ;
+      repeat(4) @(posedge clk);
+      rstn <= 1'b0 ;
+      repeat(4) @(posedge clk);
+      rstn <= 1'b1 ;
+      chk  <= 1'b1 ;
+      repeat(SAMPLES) @(posedge clk);
+      chk  <= 1'b0 ;
+
+      if (mode == 2) begin
+         for (k = 0; k < NUM; k = k + 1)
+            rate_check(k) ;
+      end
+   end
+
+   @(posedge clk);
+   if (errors == 0)
+      $display("red_pitaya_pid_slow_tb: PASS, %0d vectors of %0d clocks", VECTORS, SAMPLES);
+   else
+      $display("red_pitaya_pid_slow_tb: FAIL, %0d failed checks", errors);
+   $finish ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//
+// comparison
+
+// integrator steps of channel a_ch against the rate of its ICD
+task rate_check ;
+   input integer a_ch ;
+   integer step, num, den, e_int, r_int, diff, tol ;
+   begin
+      step = $signed(sp[12*a_ch +: 12] - dat[12*a_ch +: 12]) * $signed(ki[12*a_ch +: 12]) ;
+      e_int = $signed(eng_int[32*a_ch +: 32]) / step ;
+      r_int = $signed(ref_int[32*a_ch +: 32]) / step ;
+      if (icd[30*a_ch +: 30] < SLOTS) begin
+         num = visit_steps(icd[30*a_ch +: 30]) * (icd[30*a_ch +: 30] + 1) ;
+         den = SLOTS ;
+      end
+      else begin
+         num = 1 ;
+         den = 1 ;
+      end
+      // steps over the run: the blocks r_int, the engine r_int * num / den
+      diff = den * e_int - num * r_int ;
+      tol  = den * visit_steps(icd[30*a_ch +: 30]) + num ;
+      if (diff > tol || diff < -tol || e_int < 8) begin
+         errors = errors + 1 ;
+         $display("vector %0d channel %0d: ICD %0d, %0d integrator steps, %0d in the blocks",
+                  v, a_ch, icd[30*a_ch +: 30], e_int, r_int);
+      end
+   end
+endtask
+
+reg signed [32-1: 0] dsum ;
+
+always @(negedge clk) begin
+   if (chk) begin
+      for (k = 0; k < NUM; k = k + 1) begin
+         // the channel is updated in this clock
+         if ((cyc - k - 1) % SLOTS == 0) begin
+            if (mode < 2 && cyc >= 13 && cyc % GROUP == 5 && eng_out_r[12*k +: 12] !== ref_out[12*k +: 12]) begin
+               errors = errors + 1 ;
+               if (errors <= 10)
+                  $display("%t vector %0d channel %0d: output %h, blocks %h", $time, v, k,
+                           eng_out_r[12*k +: 12], ref_out[12*k +: 12]);
+            end
+            if (mode == 3 && cyc >= k + 5 + 2 * SLOTS) begin
+               dsum = 0 ;
+               for (m = 0; m < SLOTS; m = m + 1)
+                  dsum = dsum + $signed(ref_dh[SLOTS*k + m]) ;
+               dsum = dsum - SLOTS * $signed(eng_d[32*k +: 32]) ;
+               if (dsum >= SLOTS || dsum <= -SLOTS) begin
+                  errors = errors + 1 ;
+                  if (errors <= 10)
+                     $display("%t vector %0d channel %0d: D %0d times SLOTS, blocks %0d over the visit", $time, v, k,
+                              $signed(eng_d[32*k +: 32]), dsum + SLOTS * $signed(eng_d[32*k +: 32]));
+               end
+            end
+         end
+         else if (cyc >= SLOTS && (eng_out[12*k +: 12] !== eng_out_r[12*k +: 12] || eng_d[32*k +: 32] !== eng_d_r[32*k +: 32])) begin
+            errors = errors + 1 ;
+            if (errors <= 10)
+               $display("%t vector %0d channel %0d: output changed between visits", $time, v, k);
+         end
+         for (m = SLOTS - 1; m > 0; m = m - 1)
+            ref_dh[SLOTS*k + m] = ref_dh[SLOTS*k + m - 1] ;
+         ref_dh[SLOTS*k] = ref_d[32*k +: 32] ;
+      end
+   end
+   eng_out_r <= eng_out ;
+   eng_d_r   <= eng_d   ;
+end
+
+
+
+endmodule
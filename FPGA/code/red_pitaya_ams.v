@@ -37,6 +37,10 @@
  * connector. Measured values are then exposed to SW.
  *
  * Beside that SW can sets registes which controls logic for PWM DAC (analog module).
+ *
+ * The waveform generator (red_pitaya_ams_wave.v) can take over each PWM DAC
+ * and play a table from its own block RAM with hardware timing; it owns the
+ * registers from 0x50 and the tables from 0x10000.
  * 
  */
 
@@ -57,6 +61,8 @@ module red_pitaya_ams
    output     [ 24-1: 0] dac_b_o         ,  //!< conversion into PWM signal
    output     [ 24-1: 0] dac_c_o         ,  //!< 
    output     [ 24-1: 0] dac_d_o         ,  //!< 
+   output     [  4-1: 0] dac_act_o       ,  //!< waveform generator drives DAC n, even with a 0 word
+   input      [  8-1: 0] dio_i           ,  //!< DIO_P pins, waveform triggers
 
    input   [ 12-1: 0] adc_temp_r   ,
    input   [ 12-1: 0] adc_pint_r   ,
@@ -146,16 +152,37 @@ always @(posedge clk_i) begin
      20'h00044 : begin ack <= 1'b1;         rdata <= {{32-12{1'b0}}, adc_aux_r}        ; end
      20'h00048 : begin ack <= 1'b1;         rdata <= {{32-12{1'b0}}, adc_ddr_r}        ; end
 
+     20'h0005? ,
+     20'h001?? ,
+     20'h1???? : begin ack <= 1'b1;         rdata <= wave_rdata                        ; end
+
        default : begin ack <= 1'b1;         rdata <=   32'h0                           ; end
    endcase
 end
 
 
 
-assign dac_a_o = dac_a_r ;
-assign dac_b_o = dac_b_r ;
-assign dac_c_o = dac_c_r ;
-assign dac_d_o = dac_d_r ;
+
+//---------------------------------------------------------------------------------
+//
+//  Waveform generator
+
+wire  [ 32-1: 0] wave_rdata   ;
+
+red_pitaya_ams_wave i_wave
+(
+   .clk_i     (  clk_i          ),
+   .rstn_i    (  rstn_i         ),
+   .dio_i     (  dio_i          ),
+   .dac_i     (  {dac_d_r, dac_c_r, dac_b_r, dac_a_r}  ),
+   .dac_o     (  {dac_d_o, dac_c_o, dac_b_o, dac_a_o}  ),
+   .act_o     (  dac_act_o      ),
+
+   .addr_i    (  addr           ),
+   .wdata_i   (  wdata          ),
+   .wen_i     (  wen            ),
+   .rdata_o   (  wave_rdata     )
+);
 
 
 // bridge between ADC and sys clock
@@ -0,0 +1,247 @@
+/**
+Title: Red Pitaya Slow DAC Waveform Generator
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Hardware timed playback of waveform tables on the four slow DACs.
+ *
+ *
+ *            /-------\     /-------\     /-----\
+ *   bus ---> | TABLE | --> | INDEX | --> | MUX | ---> PWM DAC word
+ *            \-------/     \-------/     \-----/
+ *                              ^            ^
+ *   DIO, start, stop ----------+            +---- static DAC register
+ *
+ * Every channel owns a table of 1024 slow DAC words in block RAM, in the
+ * 24 bit PWM format of the static DAC registers (see slow_dac_converter.v).
+ * A running channel steps through entries 0 to LEN every DIV + 1 clocks
+ * (8 ns steps at 125 MHz) and drives the entry as its DAC word; the PWM
+ * stage takes a new word every 16 PWM periods (about 10 us).
+ *
+ * Modes: off (the static register drives the DAC), one-shot (the last
+ * entry is held at the end) and loop. With the DIO trigger enabled a start
+ * only arms the channel: it drives entry 0 until the selected DIO_P pin
+ * shows the selected edge, or a software trigger arrives, and then runs.
+ * A stop returns the channel to the static register. act_o flags the
+ * channels that drive their DAC (armed, running, or holding the last
+ * entry of a one-shot), so the top level keeps a playing table on the DAC
+ * also through entries of 0.
+ *
+ * Registers (offset in the AMS window):
+ *   0x050  control  w: [3:0] start, [7:4] stop, [11:8] software trigger,
+ *                      one bit per channel
+ *                   r: [3:0] running, [7:4] armed, [11:8] done, [15:12] driving
+ *   0x100 + 0x10*n  configuration of channel n: [1:0] mode (0 off,
+ *                   1 one-shot, 2 loop), [4] DIO trigger, [10:8] DIO pin,
+ *                   [12] falling edge
+ *   0x104 + 0x10*n  clocks per entry minus 1
+ *   0x108 + 0x10*n  last entry (table length minus 1)
+ *   0x10C + 0x10*n  entry being played (read only)
+ *   0x10000 + 0x1000*n  table of channel n, 1024 words
+ */
+
+
+
+module red_pitaya_ams_wave #(
+   parameter     aw = 10             // table address width, 2^aw entries
+)
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   input    [  8-1: 0]   dio_i     ,  // DIO_P pins, asynchronous
+   input    [4*24-1: 0]  dac_i     ,  // static DAC words, channel n at [24*n +: 24]
+   output   [4*24-1: 0]  dac_o     ,  // DAC words
+   output   [   4-1: 0]  act_o     ,  // channel n drives its DAC from the table
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the generator registers
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Control
+//---------------------------------------------------------------------------------
+
+wire            ctrl_wr  = wen_i && (addr_i[19:0] == 20'h050) ;
+wire  [ 4-1: 0] start    = ctrl_wr ? wdata_i[ 3:0] : 4'h0 ;
+wire  [ 4-1: 0] stop     = ctrl_wr ? wdata_i[ 7:4] : 4'h0 ;
+wire  [ 4-1: 0] sw_trig  = ctrl_wr ? wdata_i[11:8] : 4'h0 ;
+
+reg   [ 3-1: 0] dio_sync [0:8-1] ;
+
+integer k ;
+always @(posedge clk_i) begin
+   for (k = 0; k < 8; k = k + 1)
+      dio_sync[k] <= {dio_sync[k][1:0], dio_i[k]} ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Channels
+//---------------------------------------------------------------------------------
+
+localparam  M_OFF = 2'd0, M_ONCE = 2'd1, M_LOOP = 2'd2 ;
+
+wire  [ 4-1: 0] running  ;
+wire  [ 4-1: 0] armed    ;
+wire  [ 4-1: 0] done     ;
+wire  [ 4-1: 0] active   ;
+wire  [4*32-1: 0] cfg_w  ;
+wire  [4*32-1: 0] div_w  ;
+wire  [4*aw-1: 0] len_w  ;
+wire  [4*aw-1: 0] pos_w  ;
+wire  [4*24-1: 0] tbl_w  ;
+
+genvar n ;
+generate for (n = 0; n < 4; n = n + 1) begin : ch
+
+   reg  [  2-1: 0] cfg_mode  ;
+   reg             cfg_trig  ;
+   reg  [  3-1: 0] cfg_dio   ;
+   reg             cfg_fall  ;
+   reg  [ 32-1: 0] cfg_div   ;
+   reg  [ aw-1: 0] cfg_len   ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         cfg_mode <= M_OFF ;
+         cfg_trig <= 1'b0 ;
+         cfg_dio  <= 3'd0 ;
+         cfg_fall <= 1'b0 ;
+         cfg_div  <= 32'd1249 ;   // 10 us per entry
+         cfg_len  <= {aw{1'b1}} ;
+      end
+      else if (wen_i) begin
+         if (addr_i[19:0] == 20'h100 + 16*n)  {cfg_fall, cfg_dio, cfg_trig, cfg_mode} <= {wdata_i[12], wdata_i[10:8], wdata_i[4], wdata_i[1:0]} ;
+         if (addr_i[19:0] == 20'h104 + 16*n)  cfg_div <= wdata_i ;
+         if (addr_i[19:0] == 20'h108 + 16*n)  cfg_len <= wdata_i[aw-1:0] ;
+      end
+   end
+
+   // table, written and read back by the bus on one port, played on the other
+   reg  [ 24-1: 0] mem [0:(1<<aw)-1] ;
+   reg  [ 24-1: 0] bus_rd    ;
+   reg  [ 24-1: 0] play_rd   ;
+   reg  [ aw-1: 0] pos       ;
+
+   always @(posedge clk_i) begin
+      if (wen_i && (addr_i[19:12] == 8'h10 + n))
+         mem[addr_i[aw+2-1:2]] <= wdata_i[24-1:0] ;
+      bus_rd  <= mem[addr_i[aw+2-1:2]] ;
+      play_rd <= mem[pos] ;
+   end
+
+   // playback
+   reg             run_r     ;
+   reg             arm_r     ;
+   reg             done_r    ;
+   reg             act_r     ;
+   reg  [ 32-1: 0] cnt       ;
+
+   wire            edge_evt = cfg_fall ? (dio_sync[cfg_dio][2:1] == 2'b10) : (dio_sync[cfg_dio][2:1] == 2'b01) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         run_r  <= 1'b0 ;
+         arm_r  <= 1'b0 ;
+         done_r <= 1'b0 ;
+         act_r  <= 1'b0 ;
+         cnt    <= 32'd0 ;
+         pos    <= {aw{1'b0}} ;
+      end
+      else if (stop[n] || (cfg_mode == M_OFF)) begin
+         run_r  <= 1'b0 ;
+         arm_r  <= 1'b0 ;
+         act_r  <= 1'b0 ;
+      end
+      else if (start[n]) begin
+         run_r  <= !cfg_trig ;
+         arm_r  <= cfg_trig ;
+         done_r <= 1'b0 ;
+         act_r  <= 1'b1 ;
+         cnt    <= 32'd0 ;
+         pos    <= {aw{1'b0}} ;
+      end
+      else if (arm_r) begin
+         if (edge_evt || sw_trig[n]) begin
+            arm_r <= 1'b0 ;
+            run_r <= 1'b1 ;
+         end
+      end
+      else if (run_r) begin
+         if (cnt >= cfg_div) begin
+            cnt <= 32'd0 ;
+            if (pos >= cfg_len) begin
+               if (cfg_mode == M_LOOP)
+                  pos <= {aw{1'b0}} ;
+               else begin
+                  run_r  <= 1'b0 ;
+                  done_r <= 1'b1 ;   // the last entry stays on the output
+               end
+            end
+            else
+               pos <= pos + 1'b1 ;
+         end
+         else
+            cnt <= cnt + 32'd1 ;
+      end
+   end
+
+   assign dac_o[24*n +: 24] = act_r ? play_rd : dac_i[24*n +: 24] ;
+
+   assign running[n] = run_r ;
+   assign armed[n]   = arm_r ;
+   assign done[n]    = done_r ;
+   assign active[n]  = act_r ;
+   assign act_o [n]  = act_r ;
+   assign cfg_w[32*n +: 32] = {{32-13{1'b0}}, cfg_fall, 1'b0, cfg_dio, 3'b0, cfg_trig, 2'b0, cfg_mode} ;
+   assign div_w[32*n +: 32] = cfg_div ;
+   assign len_w[aw*n +: aw] = cfg_len ;
+   assign pos_w[aw*n +: aw] = pos ;
+   assign tbl_w[24*n +: 24] = bus_rd ;
+
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+// The tables are read synchronously. The bus bridge holds the address for
+// two clocks before it asserts the read, so the data is valid by then.
+
+reg             tbl_sel     ;
+reg   [ 2-1: 0] tbl_ch      ;
+
+always @(posedge clk_i) begin
+   tbl_sel <= (addr_i[19:14] == 6'h04) ;
+   tbl_ch  <= addr_i[13:12] ;
+end
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   if (tbl_sel)  rdata_o = {{32-24{1'b0}}, tbl_w[24*tbl_ch +: 24]} ;
+   if (addr_i[19:0] == 20'h050)
+      rdata_o = {{32-16{1'b0}}, active, done, armed, running} ;
+   if (addr_i[19:6] == 14'h004) begin
+      case (addr_i[3:0])
+         4'h0:    rdata_o = cfg_w[32*addr_i[5:4] +: 32] ;
+         4'h4:    rdata_o = div_w[32*addr_i[5:4] +: 32] ;
+         4'h8:    rdata_o = {{32-aw{1'b0}}, len_w[aw*addr_i[5:4] +: aw]} ;
+         4'hC:    rdata_o = {{32-aw{1'b0}}, pos_w[aw*addr_i[5:4] +: aw]} ;
+         default: ;
+      endcase
+   end
+end
+
+endmodule
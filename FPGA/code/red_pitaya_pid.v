@@ -49,8 +49,84 @@ Date: 28/08/2015
  * Each output is sum of two controllers with different input. That sum is also
  * saturated to protect from wrapping.
  *
- * The SISO controllers operate independently and are also saturated
- * 
+ * The SISO controllers operate independently and are also saturated. They
+ * are computed by one time multiplexed engine (red_pitaya_pid_slow.v) that
+ * visits every slow channel every few clocks, with per-channel state in
+ * distributed RAM, instead of a PID block per channel.
+ *
+ * Every channel parameter is double buffered. Writes to the live address
+ * (0x10 - 0x14C) take effect immediately and also update the shadow copy.
+ * Writes to the shadow window (live address + 0x200) are only staged; a
+ * write of a channel mask to the commit register (0x150, bit n = channel n,
+ * room for 32 channels) copies the staged set of every selected channel
+ * into the active registers on one clock edge, so a loop never runs with a
+ * partially updated parameter set. Bits of missing channels are ignored.
+ *
+ * A write to the telemetry trigger (0x400) latches a coherent snapshot of the
+ * error, integrator, P/I/D terms, output and sticky saturation flags of all
+ * channels, read back from 0x420 + 0x20 * channel.
+ *
+ * The capture buffer (red_pitaya_pid_capture.v, registers 0x540 - 0x564,
+ * samples from 0x10000) records two loop signals of one channel around a
+ * trigger at up to the full clock rate.
+ *
+ * The loop analyzer (red_pitaya_pid_bode.v, registers 0x580 - 0x5BC) adds a
+ * swept sine to the set point or the output of one channel and demodulates
+ * two of its loop signals. Set point injection saturates to the channel
+ * range; output injection adds to the output sum of a fast channel (so the
+ * other PID of that output sees it too) or to the slow DAC value, while the
+ * telemetry, capture and analyzer keep the PID block output alone.
+ *
+ * The set point ramps (red_pitaya_pid_ramp.v, registers 0x600 - 0x680) move
+ * the set point a loop runs with towards its register at a limited slew
+ * rate, linearly or with an S-curve profile, before the excitation is added.
+ *
+ * The fast PID blocks take their derivative over a clock divider, DCD at
+ * 0x700 + 0x10 * n (n = 0 - 3 for 11, 12, 21, 22), through an optional low-pass
+ * set by DFL at 0x704 + 0x10 * n. Both are live registers without a shadow
+ * copy; 0 in both keeps the one clock difference. The anti-windup of every
+ * channel is set at 0x708 + 0x10 * n (n = 4 - 7 for the slow channels aa -
+ * dd, [1:0] mode, [12:8] tracking shift, 3 - 31, 3 after reset) and
+ * follows the clamp of the outputs the channel feeds (route_exc).
+ *
+ * The routing crossbar (red_pitaya_pid_route.v, registers 0x800 - 0x834)
+ * selects the input and, for cascades, the set point of every channel from
+ * the ADCs and the channel outputs, and forms every fast and slow DAC
+ * output as a signed sum of channel outputs. It resets to the fixed MIMO
+ * and SISO wiring drawn above.
+ *
+ * Every channel adds a feedforward term to its PID sum before the output
+ * saturation (red_pitaya_pid_ff.v, registers 0x880 - 0x8FC): a 1024 entry
+ * table per channel at 0x20000 + 0x1000 * n, played periodically or once
+ * per trigger, or a scaled copy of an ADC input. It is off after reset.
+ *
+ * The fast PID blocks run with 25 bit gains (gain_res_fast), 11 fractional
+ * bits below the 14 bit gains. After reset the Kp/Ki/Kd registers of 11, 12,
+ * 21 and 22 keep their 14 bit meaning: a write clears the fractional bits,
+ * a read drops them.
+ * Setting FINE at 0x70C + 0x10 * n ([0], n = 0 - 3) makes them 25 bit words,
+ * 2^11 times the 14 bit value for the same loop; the mode only changes the
+ * bus view, so switching it leaves the running loop alone. Shadow registers
+ * and banks follow the mode of their channel. PSR/ISR/DSR keep their meaning
+ * either way. The slow channels keep 12 bit gains.
+ *
+ * Every channel holds four complete parameter banks (red_pitaya_pid_bank.v,
+ * selection at 0x900 + 4 * n, banks from 0x30000). Selecting another bank
+ * by register or by a pair of DIO_P pins loads sp, the gains, resolutions,
+ * ICD and TOL into the live and shadow registers on one clock edge, like a
+ * commit, and the integrator can follow ISR changes without a bump. The
+ * integrator hold of every channel comes from the DIO_P pin set at 0x920 +
+ * 4 * n, or from none; after reset 11, 21, 12, 22 and the slow channels
+ * are held by pins 0 - 7 as before, so a pin used for bank selection is
+ * taken off hold duty there.
+ *
+ * A read only ROM (red_pitaya_pid_info.v, header at 0xE00 - 0xE1F, channel
+ * descriptors from 0x40000) describes the channels: their type, widths and
+ * register offsets, and the features of this bitstream, so tools build
+ * their channel table from the hardware. The register offsets come from
+ * red_pitaya_pid_map.vh, which the decoders here include as well; the
+ * features and channel flags are set next to it below.
+ *
  */
 
 
@@ -109,6 +185,110 @@ reg             ack          ;
 
 localparam  adc_res_fast = 14     ;
 localparam  adc_res_slow = 12    ;
+localparam  gain_res_fast = 25    ;  // fast Kp/Ki/Kd, 11 fractional bits below the 14 bit gains
+localparam  gain_frac_fast = gain_res_fast - adc_res_fast ;
+localparam  int_res_fast  = 32 + gain_res_fast - adc_res_fast ;
+
+`include "red_pitaya_pid_map.vh"
+
+// features and channel flags of the discovery ROM, as built below
+localparam  features   = FEAT_SHADOW | FEAT_TLM | FEAT_CAPTURE | FEAT_BODE | FEAT_RAMP |
+                         FEAT_DERIV | FEAT_AWINDUP | FEAT_ROUTE | FEAT_FF | FEAT_BANK ;
+localparam  flags_fast = CH_RAMP | CH_BODE | CH_CAPTURE | CH_DERIV | CH_AWINDUP | CH_FF | CH_BANK ;
+localparam  flags_slow = CH_RAMP | CH_BODE | CH_CAPTURE | CH_TM | CH_AWINDUP | CH_FF | CH_BANK ;
+
+// fine gains of the fast channels, [n] set: Kp/Ki/Kd of channel n are bus
+// words of gain_res_fast bits, else of adc_res_fast bits as before
+reg  [  8-1: 0] gain_fine ;
+
+// bus word -> fast gain register
+function [gain_res_fast-1: 0] gain_wr ;
+   input            a_fine ;
+   input [ 32-1: 0] a_dat  ;
+   begin
+      gain_wr = a_fine ? a_dat[gain_res_fast-1:0] : a_dat[adc_res_fast-1:0] << gain_frac_fast ;
+   end
+endfunction
+
+// fast gain register -> bus word
+function [32-1: 0] gain_rd ;
+   input                      a_fine ;
+   input [gain_res_fast-1: 0] a_gain ;
+   begin
+      gain_rd = a_fine ? {{32-gain_res_fast{1'b0}}, a_gain} : {{32-adc_res_fast{1'b0}}, a_gain[gain_res_fast-1:gain_frac_fast]} ;
+   end
+endfunction
+
+
+// telemetry of the PID blocks, channel index as for the shadow registers
+wire            tlm_trig          ;
+wire [ 32-1: 0] tlm_err  [0:8-1]  ;
+wire [ 32-1: 0] tlm_int  [0:8-1]  ;
+wire [ 32-1: 0] tlm_p    [0:8-1]  ;
+wire [ 32-1: 0] tlm_i    [0:8-1]  ;
+wire [ 32-1: 0] tlm_d    [0:8-1]  ;
+wire [  2-1: 0] tlm_sat  [0:8-1]  ;
+wire [  2-1: 0] pid_sat  [0:8-1]  ;
+
+// loop analyzer excitation and the channels it is injected into
+wire [ 16-1: 0] bode_exc          ;
+wire [  8-1: 0] bode_inj_sp       ;
+wire [  8-1: 0] bode_inj_out      ;
+
+// ramped set points, channel n at [14*n +: 14], slow channels sign extended
+wire [8*14-1: 0] ramp_sp          ;
+
+// routed channel inputs and set points, channel n at [14*n +: 14], slow channels sign extended
+wire [8*14-1: 0] route_dat        ;
+wire [8*14-1: 0] route_sp         ;
+// excess of the outputs a channel feeds (clamped - unclamped sum), for the anti-windup, slow channels in slow counts
+wire [8*17-1: 0] route_exc        ;
+
+// feedforward terms, channel n at [16*n +: 16]
+wire [8*16-1: 0] ff_term          ;
+
+// parameter bank to load into the live and shadow registers of channel n, widths as the shadow registers
+wire [   8-1: 0] bank_load        ;
+wire [8*14-1: 0] bank_sp          ;
+wire [8*25-1: 0] bank_kp          ;
+wire [8*25-1: 0] bank_ki          ;
+wire [8*25-1: 0] bank_kd          ;
+wire [8* 5-1: 0] bank_psr         ;
+wire [8* 5-1: 0] bank_isr         ;
+wire [8* 5-1: 0] bank_dsr         ;
+wire [8*30-1: 0] bank_icd         ;
+wire [8* 9-1: 0] bank_tol         ;
+wire [   8-1: 0] bank_scale       ;
+wire [   8-1: 0] bank_hold        ;  // integrator hold of channel n, from the DIO_P pin HOLD selects
+
+// a_val plus the excitation if a_en, saturated to the fast and slow range
+function [14-1:0] add_exc14 ;
+   input [14-1:0] a_val ;
+   input [16-1:0] a_exc ;
+   input          a_en  ;
+   reg   [17-1:0] sum   ;
+   begin
+      sum = $signed(a_val) + $signed(a_en ? a_exc : 16'h0) ;
+      if (sum[17-1:14-1] == {4{sum[17-1]}})
+         add_exc14 = sum[14-1:0] ;
+      else
+         add_exc14 = sum[17-1] ? 14'h2000 : 14'h1FFF ;
+   end
+endfunction
+
+function [12-1:0] add_exc12 ;
+   input [12-1:0] a_val ;
+   input [16-1:0] a_exc ;
+   input          a_en  ;
+   reg   [17-1:0] sum   ;
+   begin
+      sum = $signed(a_val) + $signed(a_en ? a_exc : 16'h0) ;
+      if (sum[17-1:12-1] == {6{sum[17-1]}})
+         add_exc12 = sum[12-1:0] ;
+      else
+         add_exc12 = sum[17-1] ? 12'h800 : 12'h7FF ;
+   end
+endfunction
 
 
 
@@ -118,10 +298,11 @@ localparam  adc_res_slow = 12    ;
 
 wire [ 14-1: 0] pid_11_out   ;
 reg  [ 14-1: 0] set_11_sp    ;
-reg  [ 14-1: 0] set_11_kp    ;
-reg  [ 14-1: 0] set_11_ki    ;
-reg  [ 14-1: 0] set_11_kd    ;
+reg  [ 25-1: 0] set_11_kp    ;
+reg  [ 25-1: 0] set_11_ki    ;
+reg  [ 25-1: 0] set_11_kd    ;
 reg             set_11_irst  ;
+wire [ 14-1: 0] set_11_spx   = add_exc14(route_sp[14*0 +: 14], bode_exc, bode_inj_sp[0]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_11           ;
@@ -129,33 +310,56 @@ reg [5-1:0] ISR_11           ;
 reg [5-1:0] DSR_11           ;
 reg [30-1:0] ICD_11          ;
 reg [9-1:0] TOL_11           ;
+reg [30-1:0] DCD_11          ;
+reg [5-1:0] DFL_11           ;
+reg [2-1:0] AWM_11           ;
+reg [5-1:0] AWK_11           ;
 
 
 red_pitaya_pid_block #(
-  .adc_res (  adc_res_fast  ) 
+  .adc_res  (  adc_res_fast   ),
+  .gain_res (  gain_res_fast  ),
+  .int_res  (  int_res_fast   )
 )
 i_pid11
 (
    // data
   .clk_i        (  clk_i          ),  // clock
   .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  dat_a_i        ),  // input data
+  .dat_i        (  route_dat[14*0 +: 14]  ),  // input data
   .dat_o        (  pid_11_out     ),  // output data
 
    // settings
-  .set_sp_i     (  set_11_sp      ),  // set point
+  .set_sp_i     (  set_11_spx     ),  // set point
   .set_kp_i     (  set_11_kp      ),  // Kp
   .set_ki_i     (  set_11_ki      ),  // Ki
   .set_kd_i     (  set_11_kd      ),  // Kd
   .int_rst_i    (  set_11_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[0]  ),
+  .int_hold     (  bank_hold[0]   ),  // integrator hold
+  .int_scale_i  (  bank_scale[0]  ),  // bumpless ISR changes
   
   // advanced parameters
   .PSR     (  PSR_11      ),  
   .ISR     (  ISR_11      ),
   .DSR     (  DSR_11      ),  
   .ICD     (  ICD_11      ),
-  .TOL     (  TOL_11      )  
+  .TOL     (  TOL_11      ),
+  .DCD     (  DCD_11      ),
+  .DFL     (  DFL_11      ),
+  .AWM     (  AWM_11      ),
+  .AWK     (  AWK_11      ),
+  .sat_exc_i (  route_exc[17*0 +: 17]  ),
+  .ff_i    (  ff_term[16*0 +: 16]  ),
+
+  // telemetry
+  .tlm_clr_i     (  tlm_trig      ),
+  .tlm_err_o     (  tlm_err[0]    ),
+  .tlm_int_o     (  tlm_int[0]    ),
+  .tlm_p_o       (  tlm_p[0]      ),
+  .tlm_i_o       (  tlm_i[0]      ),
+  .tlm_d_o       (  tlm_d[0]      ),
+  .tlm_sat_o     (  tlm_sat[0]    ),
+  .sat_o         (  pid_sat[0]    )
 );
 
 
@@ -165,10 +369,11 @@ i_pid11
 
 wire [ 14-1: 0] pid_21_out   ;
 reg  [ 14-1: 0] set_21_sp    ;
-reg  [ 14-1: 0] set_21_kp    ;
-reg  [ 14-1: 0] set_21_ki    ;
-reg  [ 14-1: 0] set_21_kd    ;
+reg  [ 25-1: 0] set_21_kp    ;
+reg  [ 25-1: 0] set_21_ki    ;
+reg  [ 25-1: 0] set_21_kd    ;
 reg             set_21_irst  ;
+wire [ 14-1: 0] set_21_spx   = add_exc14(route_sp[14*2 +: 14], bode_exc, bode_inj_sp[2]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_21           ;
@@ -176,32 +381,55 @@ reg [5-1:0] ISR_21           ;
 reg [5-1:0] DSR_21           ;
 reg [30-1:0] ICD_21           ;
 reg [9-1:0] TOL_21           ;
+reg [30-1:0] DCD_21          ;
+reg [5-1:0] DFL_21           ;
+reg [2-1:0] AWM_21           ;
+reg [5-1:0] AWK_21           ;
 
 red_pitaya_pid_block #(
-.adc_res (  adc_res_fast  ) 
+.adc_res  (  adc_res_fast   ),
+  .gain_res (  gain_res_fast  ),
+  .int_res  (  int_res_fast   )
 )
 i_pid21
 (
    // data
   .clk_i        (  clk_i          ),  // clock
   .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  dat_a_i        ),  // input data
+  .dat_i        (  route_dat[14*2 +: 14]  ),  // input data
   .dat_o        (  pid_21_out     ),  // output data
 
    // settings
-  .set_sp_i     (  set_21_sp      ),  // set point
+  .set_sp_i     (  set_21_spx     ),  // set point
   .set_kp_i     (  set_21_kp      ),  // Kp
   .set_ki_i     (  set_21_ki      ),  // Ki
   .set_kd_i     (  set_21_kd      ),  // Kd
   .int_rst_i    (  set_21_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[1]  ),
+  .int_hold     (  bank_hold[2]   ),  // integrator hold
+  .int_scale_i  (  bank_scale[2]  ),  // bumpless ISR changes
   
     // advanced parameters
   .PSR     (  PSR_21      ),  
   .ISR     (  ISR_21      ),
   .DSR     (  DSR_21      ),  
   .ICD     (  ICD_21      ),
-  .TOL     (  TOL_21      ) 
+  .TOL     (  TOL_21      ),
+  .DCD     (  DCD_21      ),
+  .DFL     (  DFL_21      ),
+  .AWM     (  AWM_21      ),
+  .AWK     (  AWK_21      ),
+  .sat_exc_i (  route_exc[17*2 +: 17]  ),
+  .ff_i    (  ff_term[16*2 +: 16]  ),
+
+  // telemetry
+  .tlm_clr_i     (  tlm_trig      ),
+  .tlm_err_o     (  tlm_err[2]    ),
+  .tlm_int_o     (  tlm_int[2]    ),
+  .tlm_p_o       (  tlm_p[2]      ),
+  .tlm_i_o       (  tlm_i[2]      ),
+  .tlm_d_o       (  tlm_d[2]      ),
+  .tlm_sat_o     (  tlm_sat[2]    ),
+  .sat_o         (  pid_sat[2]    )
 );
 
 
@@ -211,10 +439,11 @@ i_pid21
 
 wire [ 14-1: 0] pid_12_out   ;
 reg  [ 14-1: 0] set_12_sp    ;
-reg  [ 14-1: 0] set_12_kp    ;
-reg  [ 14-1: 0] set_12_ki    ;
-reg  [ 14-1: 0] set_12_kd    ;
+reg  [ 25-1: 0] set_12_kp    ;
+reg  [ 25-1: 0] set_12_ki    ;
+reg  [ 25-1: 0] set_12_kd    ;
 reg             set_12_irst  ;
+wire [ 14-1: 0] set_12_spx   = add_exc14(route_sp[14*1 +: 14], bode_exc, bode_inj_sp[1]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_12           ;
@@ -222,32 +451,55 @@ reg [5-1:0] ISR_12           ;
 reg [5-1:0] DSR_12           ;
 reg [30-1:0] ICD_12           ;
 reg [9-1:0] TOL_12           ;
+reg [30-1:0] DCD_12          ;
+reg [5-1:0] DFL_12           ;
+reg [2-1:0] AWM_12           ;
+reg [5-1:0] AWK_12           ;
 
 red_pitaya_pid_block #(
-.adc_res (  adc_res_fast  )    
+.adc_res  (  adc_res_fast   ),
+  .gain_res (  gain_res_fast  ),
+  .int_res  (  int_res_fast   )
 )
 i_pid12
 (
    // data
   .clk_i        (  clk_i          ),  // clock
   .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  dat_b_i        ),  // input data
+  .dat_i        (  route_dat[14*1 +: 14]  ),  // input data
   .dat_o        (  pid_12_out     ),  // output data
 
    // settings
-  .set_sp_i     (  set_12_sp      ),  // set point
+  .set_sp_i     (  set_12_spx     ),  // set point
   .set_kp_i     (  set_12_kp      ),  // Kp
   .set_ki_i     (  set_12_ki      ),  // Ki
   .set_kd_i     (  set_12_kd      ),  // Kd
   .int_rst_i    (  set_12_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[2]  ),
+  .int_hold     (  bank_hold[1]   ),  // integrator hold
+  .int_scale_i  (  bank_scale[1]  ),  // bumpless ISR changes
     
    // advanced parameters
   .PSR     (  PSR_12      ),  
   .ISR     (  ISR_12      ),
   .DSR     (  DSR_12      ),  
   .ICD     (  ICD_12      ),
-  .TOL     (  TOL_12      )    
+  .TOL     (  TOL_12      ),
+  .DCD     (  DCD_12      ),
+  .DFL     (  DFL_12      ),
+  .AWM     (  AWM_12      ),
+  .AWK     (  AWK_12      ),
+  .sat_exc_i (  route_exc[17*1 +: 17]  ),
+  .ff_i    (  ff_term[16*1 +: 16]  ),
+
+  // telemetry
+  .tlm_clr_i     (  tlm_trig      ),
+  .tlm_err_o     (  tlm_err[1]    ),
+  .tlm_int_o     (  tlm_int[1]    ),
+  .tlm_p_o       (  tlm_p[1]      ),
+  .tlm_i_o       (  tlm_i[1]      ),
+  .tlm_d_o       (  tlm_d[1]      ),
+  .tlm_sat_o     (  tlm_sat[1]    ),
+  .sat_o         (  pid_sat[1]    )
 );
 
 //---------------------------------------------------------------------------------
@@ -257,10 +509,11 @@ i_pid12
 
 wire [ 14-1: 0] pid_22_out   ;
 reg  [ 14-1: 0] set_22_sp    ;
-reg  [ 14-1: 0] set_22_kp    ;
-reg  [ 14-1: 0] set_22_ki    ;
-reg  [ 14-1: 0] set_22_kd    ;
+reg  [ 25-1: 0] set_22_kp    ;
+reg  [ 25-1: 0] set_22_ki    ;
+reg  [ 25-1: 0] set_22_kd    ;
 reg             set_22_irst  ;
+wire [ 14-1: 0] set_22_spx   = add_exc14(route_sp[14*3 +: 14], bode_exc, bode_inj_sp[3]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_22           ;
@@ -268,33 +521,56 @@ reg [5-1:0] ISR_22           ;
 reg [5-1:0] DSR_22           ;
 reg [30-1:0] ICD_22           ;
 reg [9-1:0] TOL_22           ;
+reg [30-1:0] DCD_22          ;
+reg [5-1:0] DFL_22           ;
+reg [2-1:0] AWM_22           ;
+reg [5-1:0] AWK_22           ;
 
 
 red_pitaya_pid_block #(
-  .adc_res (  adc_res_fast  ) 
+  .adc_res  (  adc_res_fast   ),
+  .gain_res (  gain_res_fast  ),
+  .int_res  (  int_res_fast   )
 )
 i_pid22
 (
    // data
   .clk_i        (  clk_i          ),  // clock
   .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  dat_b_i        ),  // input data
+  .dat_i        (  route_dat[14*3 +: 14]  ),  // input data
   .dat_o        (  pid_22_out     ),  // output data
 
    // settings
-  .set_sp_i     (  set_22_sp      ),  // set point
+  .set_sp_i     (  set_22_spx     ),  // set point
   .set_kp_i     (  set_22_kp      ),  // Kp
   .set_ki_i     (  set_22_ki      ),  // Ki
   .set_kd_i     (  set_22_kd      ),  // Kd
   .int_rst_i    (  set_22_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[3]  ),
+  .int_hold     (  bank_hold[3]   ),  // integrator hold
+  .int_scale_i  (  bank_scale[3]  ),  // bumpless ISR changes
         
   // advanced parameters
   .PSR     (  PSR_22      ),  
   .ISR     (  ISR_22      ),
   .DSR     (  DSR_22      ),  
   .ICD     (  ICD_22      ),
-  .TOL     (  TOL_22      )   
+  .TOL     (  TOL_22      ),
+  .DCD     (  DCD_22      ),
+  .DFL     (  DFL_22      ),
+  .AWM     (  AWM_22      ),
+  .AWK     (  AWK_22      ),
+  .sat_exc_i (  route_exc[17*3 +: 17]  ),
+  .ff_i    (  ff_term[16*3 +: 16]  ),
+
+  // telemetry
+  .tlm_clr_i     (  tlm_trig      ),
+  .tlm_err_o     (  tlm_err[3]    ),
+  .tlm_int_o     (  tlm_int[3]    ),
+  .tlm_p_o       (  tlm_p[3]      ),
+  .tlm_i_o       (  tlm_i[3]      ),
+  .tlm_d_o       (  tlm_d[3]      ),
+  .tlm_sat_o     (  tlm_sat[3]    ),
+  .sat_o         (  pid_sat[3]    )
 );
 
 
@@ -309,6 +585,7 @@ reg  [ 12-1: 0] set_aa_kp    ;
 reg  [ 12-1: 0] set_aa_ki    ;
 reg  [ 12-1: 0] set_aa_kd    ;
 reg             set_aa_irst  ;
+wire [ 12-1: 0] set_aa_spx   = add_exc12(route_sp[14*4 +: 12], bode_exc, bode_inj_sp[4]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_aa           ;
@@ -316,33 +593,8 @@ reg [5-1:0] ISR_aa           ;
 reg [5-1:0] DSR_aa           ;
 reg [30-1:0] ICD_aa           ;
 reg [9-1:0] TOL_aa           ;
-
-red_pitaya_pid_block #(
-  .adc_res (  adc_res_slow  )       
-)
-i_pidAA
-(
-   // data
-  .clk_i        (  clk_i          ),  // clock
-  .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  adc_slx_a_i    ),  // input data
-  .dat_o        (  pid_aa_out     ),  // output data
-
-   // settings
-  .set_sp_i     (  set_aa_sp      ),  // set point
-  .set_kp_i     (  set_aa_kp      ),  // Kp
-  .set_ki_i     (  set_aa_ki      ),  // Ki
-  .set_kd_i     (  set_aa_kd      ),  // Kd
-  .int_rst_i    (  set_aa_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[4]  ),
-      
-        // advanced parameters
-  .PSR     (  PSR_aa      ),  
-  .ISR     (  ISR_aa      ),
-  .DSR     (  DSR_aa      ),  
-  .ICD     (  ICD_aa      ),
-  .TOL     (  TOL_aa      )
-);
+reg [2-1:0] AWM_aa           ;
+reg [5-1:0] AWK_aa           ;
 
 //---------------------------------------------------------------------------------
 //  PID SLOW BB
@@ -355,6 +607,7 @@ reg  [ 12-1: 0] set_bb_kp    ;
 reg  [ 12-1: 0] set_bb_ki    ;
 reg  [ 12-1: 0] set_bb_kd    ;
 reg             set_bb_irst  ;
+wire [ 12-1: 0] set_bb_spx   = add_exc12(route_sp[14*5 +: 12], bode_exc, bode_inj_sp[5]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_bb           ;
@@ -362,32 +615,8 @@ reg [5-1:0] ISR_bb           ;
 reg [5-1:0] DSR_bb           ;
 reg [30-1:0] ICD_bb           ;
 reg [9-1:0] TOL_bb           ;
-
-
-red_pitaya_pid_block #(
-  .adc_res (  adc_res_slow  )      
-)
-i_pidBB
-( 
-  .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  adc_slx_b_i    ),  // input data
-  .dat_o        (  pid_bb_out     ),  // output data
-
-   // settings
-  .set_sp_i     (  set_bb_sp      ),  // set point
-  .set_kp_i     (  set_bb_kp      ),  // Kp
-  .set_ki_i     (  set_bb_ki      ),  // Ki
-  .set_kd_i     (  set_bb_kd      ),  // Kd
-  .int_rst_i    (  set_bb_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[5]  ),
-        
-  // advanced parameters
-  .PSR     (  PSR_bb      ),  
-  .ISR     (  ISR_bb      ),
-  .DSR     (  DSR_bb      ),  
-  .ICD     (  ICD_bb      ),
-  .TOL     (  TOL_bb      )
-);
+reg [2-1:0] AWM_bb           ;
+reg [5-1:0] AWK_bb           ;
 
 //---------------------------------------------------------------------------------
 //  PID SLOW CC
@@ -400,6 +629,7 @@ reg  [ 12-1: 0] set_cc_kp    ;
 reg  [ 12-1: 0] set_cc_ki    ;
 reg  [ 12-1: 0] set_cc_kd    ;
 reg             set_cc_irst  ;
+wire [ 12-1: 0] set_cc_spx   = add_exc12(route_sp[14*6 +: 12], bode_exc, bode_inj_sp[6]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_cc           ;
@@ -407,33 +637,8 @@ reg [5-1:0] ISR_cc           ;
 reg [5-1:0] DSR_cc           ;
 reg [30-1:0] ICD_cc           ;
 reg [9-1:0] TOL_cc           ;
-
-red_pitaya_pid_block #(
-  .adc_res (  adc_res_slow  )   
-)
-i_pidCC
-(
-   // data
-  .clk_i        (  clk_i          ),  // clock
-  .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  adc_slx_c_i    ),  // input data
-  .dat_o        (  pid_cc_out     ),  // output data
-
-   // settings
-  .set_sp_i     (  set_cc_sp      ),  // set point
-  .set_kp_i     (  set_cc_kp      ),  // Kp
-  .set_ki_i     (  set_cc_ki      ),  // Ki
-  .set_kd_i     (  set_cc_kd      ),  // Kd
-  .int_rst_i    (  set_cc_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[6]  ),
-          
-    // advanced parameters
-  .PSR     (  PSR_cc      ),  
-  .ISR     (  ISR_cc      ),
-  .DSR     (  DSR_cc      ),  
-  .ICD     (  ICD_cc      ),
-  .TOL     (  TOL_cc      )
-);
+reg [2-1:0] AWM_cc           ;
+reg [5-1:0] AWK_cc           ;
 
 //---------------------------------------------------------------------------------
 //  PID SLOW DD
@@ -446,6 +651,7 @@ reg  [ 12-1: 0] set_dd_kp    ;
 reg  [ 12-1: 0] set_dd_ki    ;
 reg  [ 12-1: 0] set_dd_kd    ;
 reg             set_dd_irst  ;
+wire [ 12-1: 0] set_dd_spx   = add_exc12(route_sp[14*7 +: 12], bode_exc, bode_inj_sp[7]) ;  // set point with the analyzer excitation
 
 // Advanced Parameters
 reg [5-1:0] PSR_dd           ;
@@ -453,34 +659,84 @@ reg [5-1:0] ISR_dd           ;
 reg [5-1:0] DSR_dd           ;
 reg [30-1:0] ICD_dd           ;
 reg [9-1:0] TOL_dd          ;
+reg [2-1:0] AWM_dd           ;
+reg [5-1:0] AWK_dd           ;
 
-red_pitaya_pid_block #(
-  .adc_res (  adc_res_slow  )       
+
+//---------------------------------------------------------------------------------
+//  PID SLOW ENGINE
+//---------------------------------------------------------------------------------
+
+// the four slow channels share one time multiplexed pipeline
+wire [4*12-1: 0] slow_out      ;
+wire [4*32-1: 0] slow_tlm_err  ;
+wire [4*32-1: 0] slow_tlm_int  ;
+wire [4*32-1: 0] slow_tlm_p    ;
+wire [4*32-1: 0] slow_tlm_i    ;
+wire [4*32-1: 0] slow_tlm_d    ;
+wire [4* 2-1: 0] slow_tlm_sat  ;
+wire [4* 2-1: 0] slow_sat      ;
+
+red_pitaya_pid_slow #(
+  .NUM (  4  )
 )
-i_pidDD
+i_pidSlow
 (
    // data
   .clk_i        (  clk_i          ),  // clock
   .rstn_i       (  rstn_i         ),  // reset - active low
-  .dat_i        (  adc_slx_d_i    ),  // input data
-  .dat_o        (  pid_dd_out     ),  // output data
+  .dat_i        ({ route_dat[14*7 +: 12], route_dat[14*6 +: 12],
+                   route_dat[14*5 +: 12], route_dat[14*4 +: 12] }),  // input data
+  .dat_o        (  slow_out       ),  // output data
 
    // settings
-  .set_sp_i     (  set_dd_sp      ),  // set point
-  .set_kp_i     (  set_dd_kp      ),  // Kp
-  .set_ki_i     (  set_dd_ki      ),  // Ki
-  .set_kd_i     (  set_dd_kd      ),  // Kd
-  .int_rst_i    (  set_dd_irst    ),   // integrator reset
-  .int_hold     (   int_hold_pins[7]  ),
-            
-      // advanced parameters
-  .PSR     (  PSR_dd      ),  
-  .ISR     (  ISR_dd      ),
-  .DSR     (  DSR_dd      ),  
-  .ICD     (  ICD_dd      ),
-  .TOL     (  TOL_dd      )
+  .set_sp_i     ({ set_dd_spx,  set_cc_spx,  set_bb_spx,  set_aa_spx  }),  // set point
+  .set_kp_i     ({ set_dd_kp,   set_cc_kp,   set_bb_kp,   set_aa_kp   }),  // Kp
+  .set_ki_i     ({ set_dd_ki,   set_cc_ki,   set_bb_ki,   set_aa_ki   }),  // Ki
+  .set_kd_i     ({ set_dd_kd,   set_cc_kd,   set_bb_kd,   set_aa_kd   }),  // Kd
+  .int_rst_i    ({ set_dd_irst, set_cc_irst, set_bb_irst, set_aa_irst }),  // integrator reset
+  .int_hold_i   (  bank_hold[7:4]      ),  // integrator holds
+  .int_scale_i  (  bank_scale[7:4]     ),  // bumpless ISR changes
+
+  // advanced parameters
+  .psr_i        ({ PSR_dd, PSR_cc, PSR_bb, PSR_aa }),
+  .isr_i        ({ ISR_dd, ISR_cc, ISR_bb, ISR_aa }),
+  .dsr_i        ({ DSR_dd, DSR_cc, DSR_bb, DSR_aa }),
+  .icd_i        ({ ICD_dd, ICD_cc, ICD_bb, ICD_aa }),
+  .tol_i        ({ TOL_dd, TOL_cc, TOL_bb, TOL_aa }),
+  .ff_i         (  ff_term[16*4 +: 4*16]  ),
+  .awm_i        ({ AWM_dd, AWM_cc, AWM_bb, AWM_aa }),  // anti-windup
+  .awk_i        ({ AWK_dd, AWK_cc, AWK_bb, AWK_aa }),
+  .sat_exc_i    ({ route_exc[17*7 +: 15], route_exc[17*6 +: 15],
+                   route_exc[17*5 +: 15], route_exc[17*4 +: 15] }),
+
+  // telemetry
+  .tlm_clr_i    (  tlm_trig       ),
+  .tlm_err_o    (  slow_tlm_err   ),
+  .tlm_int_o    (  slow_tlm_int   ),
+  .tlm_p_o      (  slow_tlm_p     ),
+  .tlm_i_o      (  slow_tlm_i     ),
+  .tlm_d_o      (  slow_tlm_d     ),
+  .tlm_sat_o    (  slow_tlm_sat   ),
+  .sat_o        (  slow_sat       )
 );
 
+assign pid_aa_out = slow_out[12*0 +: 12] ;
+assign pid_bb_out = slow_out[12*1 +: 12] ;
+assign pid_cc_out = slow_out[12*2 +: 12] ;
+assign pid_dd_out = slow_out[12*3 +: 12] ;
+
+genvar sn ;
+generate for (sn = 0; sn < 4; sn = sn + 1) begin : slow_tlm
+   assign tlm_err[4+sn] = slow_tlm_err[32*sn +: 32] ;
+   assign tlm_int[4+sn] = slow_tlm_int[32*sn +: 32] ;
+   assign tlm_p  [4+sn] = slow_tlm_p  [32*sn +: 32] ;
+   assign tlm_i  [4+sn] = slow_tlm_i  [32*sn +: 32] ;
+   assign tlm_d  [4+sn] = slow_tlm_d  [32*sn +: 32] ;
+   assign tlm_sat[4+sn] = slow_tlm_sat[ 2*sn +:  2] ;
+   assign pid_sat[4+sn] = slow_sat    [ 2*sn +:  2] ;
+end endgenerate
+
 //---------------------------------------------------------------------------------
 // LED Logic
 //---------------------------------------------------------------------------------
@@ -539,43 +795,15 @@ always @(posedge clk_i) begin
   
            
 //---------------------------------------------------------------------------------
-//  Sum and saturation for fast PIDS
+//  Sum and saturation of the outputs
 //---------------------------------------------------------------------------------
 
+// fast DAC sums and saturation in the routing crossbar below
+wire [2*14-1: 0] route_dac  ;
+wire [4*12-1: 0] route_pwm  ;
 
-wire [ 15-1: 0] out_1_sum   ;
-reg  [ 14-1: 0] out_1_sat   ;
-wire [ 15-1: 0] out_2_sum   ;
-reg  [ 14-1: 0] out_2_sat   ;
-
-assign out_1_sum = $signed(pid_11_out) + $signed(pid_12_out);
-assign out_2_sum = $signed(pid_22_out) + $signed(pid_21_out);
-
-always @(posedge clk_i) begin
-   if (rstn_i == 1'b0) begin
-      out_1_sat <= 14'd0 ;
-      out_2_sat <= 14'd0 ;
-   end
-   else begin
-      if (out_1_sum[15-1:15-2]==2'b01) // postitive sat
-         out_1_sat <= 14'h1FFF ;
-      else if (out_1_sum[15-1:15-2]==2'b10) // negative sat
-         out_1_sat <= 14'h2000 ;
-      else
-         out_1_sat <= out_1_sum[14-1:0] ;
-
-      if (out_2_sum[15-1:15-2]==2'b01) // postitive sat
-         out_2_sat <= 14'h1FFF ;
-      else if (out_2_sum[15-1:15-2]==2'b10) // negative sat
-         out_2_sat <= 14'h2000 ;
-      else
-         out_2_sat <= out_2_sum[14-1:0] ;
-   end
-end
-
-
-assign dat_a_o = out_1_sat ;
-assign dat_b_o = out_2_sat ;
+assign dat_a_o = route_dac[14*0 +: 14] ;
+assign dat_b_o = route_dac[14*1 +: 14] ;
 
 
 //---------------------------------------------------------------------------------
@@ -591,7 +819,7 @@ slow_dac_converter s_dac_a
 (
     .clk_i  (   clk_i   ),
     .rstn_i (   rstn_i  ),
-    .dat_i  (   pid_aa_out  ),
+    .dat_i  (   route_pwm[12*0 +: 12]  ),
     .dat_o  (   out_a_sat   )
 );
 
@@ -599,7 +827,7 @@ slow_dac_converter s_dac_b
 (
     .clk_i  (   clk_i   ),
     .rstn_i (   rstn_i  ),
-    .dat_i  (   pid_bb_out  ),
+    .dat_i  (   route_pwm[12*1 +: 12]  ),
     .dat_o  (   out_b_sat   )
 );
 
@@ -607,7 +835,7 @@ slow_dac_converter s_dac_c
 (
     .clk_i  (   clk_i   ),
     .rstn_i (   rstn_i  ),
-    .dat_i  (   pid_cc_out  ),
+    .dat_i  (   route_pwm[12*2 +: 12]  ),
     .dat_o  (   out_c_sat   )
 );
 
@@ -615,7 +843,7 @@ slow_dac_converter s_dac_d
 (
     .clk_i  (   clk_i   ),
     .rstn_i (   rstn_i  ),
-    .dat_i  (   pid_dd_out  ),
+    .dat_i  (   route_pwm[12*3 +: 12]  ),
     .dat_o  (   out_d_sat   )
 );
 
@@ -624,6 +852,405 @@ assign dac_pwm_b_o = out_b_sat ;
 assign dac_pwm_c_o = out_c_sat ;
 assign dac_pwm_d_o = out_d_sat ;
 
+//---------------------------------------------------------------------------------
+//  Shadow registers
+//---------------------------------------------------------------------------------
+
+// channel index: 0 => 11, 1 => 12, 2 => 21, 3 => 22, 4 => aa, 5 => bb, 6 => cc, 7 => dd
+// slow channels only use the lower 12 bits of the set point and gains
+
+reg  [ 14-1: 0] shd_sp   [0:8-1] ;
+reg  [ 25-1: 0] shd_kp   [0:8-1] ;
+reg  [ 25-1: 0] shd_ki   [0:8-1] ;
+reg  [ 25-1: 0] shd_kd   [0:8-1] ;
+reg             shd_irst [0:8-1] ;
+reg  [  5-1: 0] shd_PSR  [0:8-1] ;
+reg  [  5-1: 0] shd_ISR  [0:8-1] ;
+reg  [  5-1: 0] shd_DSR  [0:8-1] ;
+reg  [ 30-1: 0] shd_ICD  [0:8-1] ;
+reg  [  9-1: 0] shd_TOL  [0:8-1] ;
+reg  [ 32-1: 0] shd_rdata        ;
+
+wire            commit      = wen && (addr[19:0] == REG_COMMIT) ;
+wire [ 32-1: 0] commit_mask = wdata ;    // bit n = channel n, up to 32 channels
+
+integer i ;
+integer j ;
+integer k ;  // telemetry read back, a loop variable per always @(*) block
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      for (i = 0; i < 8; i = i + 1) begin
+         shd_sp[i]   <= 14'd0 ;
+         shd_kp[i]   <= 25'd0 ;
+         shd_ki[i]   <= 25'd0 ;
+         shd_kd[i]   <= 25'd0 ;
+         shd_irst[i] <=  1'b1 ;
+         shd_PSR[i]  <= (i < 4) ? 5'd12 : 5'd8  ; // default fast and slow values
+         shd_ISR[i]  <= (i < 4) ? 5'd18 : 5'd20 ;
+         shd_DSR[i]  <= (i < 4) ? 5'd10 : 5'd6  ;
+         shd_ICD[i]  <= 30'd0 ;
+         shd_TOL[i]  <=  9'd0 ;
+      end
+   end
+   else begin
+      // both the live and the shadow address update the staged value
+      for (i = 0; i < 8; i = i + 1) begin
+         if (wen) begin
+            if ((addr[19:0] == REG_SP + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_SP + REG_CH*i))  shd_sp[i]   <= (i < 4) ? wdata[14-1:0] : {2'b00, wdata[12-1:0]} ;
+            if ((addr[19:0] == REG_KP + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_KP + REG_CH*i))  shd_kp[i]   <= (i < 4) ? gain_wr(gain_fine[i], wdata) : {13'h0, wdata[12-1:0]} ;
+            if ((addr[19:0] == REG_KI + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_KI + REG_CH*i))  shd_ki[i]   <= (i < 4) ? gain_wr(gain_fine[i], wdata) : {13'h0, wdata[12-1:0]} ;
+            if ((addr[19:0] == REG_KD + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_KD + REG_CH*i))  shd_kd[i]   <= (i < 4) ? gain_wr(gain_fine[i], wdata) : {13'h0, wdata[12-1:0]} ;
+            if ((addr[19:0] == REG_IRST + REG_CH4*i) || (addr[19:0] == REG_SHADOW + REG_IRST + REG_CH4*i))  shd_irst[i] <= wdata[0] ;
+            if ((addr[19:0] == REG_PSR + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_PSR + REG_CH*i))  shd_PSR[i]  <= wdata[5-1:0] ;
+            if ((addr[19:0] == REG_ISR + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_ISR + REG_CH*i))  shd_ISR[i]  <= wdata[5-1:0] ;
+            if ((addr[19:0] == REG_DSR + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_DSR + REG_CH*i))  shd_DSR[i]  <= wdata[5-1:0] ;
+            if ((addr[19:0] == REG_ICD + REG_CH*i) || (addr[19:0] == REG_SHADOW + REG_ICD + REG_CH*i))  shd_ICD[i]  <= wdata[30-1:0] ;
+            if ((addr[19:0] == REG_TOL + REG_CH4*i) || (addr[19:0] == REG_SHADOW + REG_TOL + REG_CH4*i))  shd_TOL[i]  <= wdata[9-1:0] ;
+         end
+      end
+      // so does a parameter bank loaded into the live registers
+      for (i = 0; i < 8; i = i + 1) begin
+         if (bank_load[i]) begin
+            shd_sp[i]  <= bank_sp [14*i +: 14] ;
+            shd_kp[i]  <= bank_kp [25*i +: 25] ;
+            shd_ki[i]  <= bank_ki [25*i +: 25] ;
+            shd_kd[i]  <= bank_kd [25*i +: 25] ;
+            shd_PSR[i] <= bank_psr[ 5*i +:  5] ;
+            shd_ISR[i] <= bank_isr[ 5*i +:  5] ;
+            shd_DSR[i] <= bank_dsr[ 5*i +:  5] ;
+            shd_ICD[i] <= bank_icd[30*i +: 30] ;
+            shd_TOL[i] <= bank_tol[ 9*i +:  9] ;
+         end
+      end
+   end
+end
+
+always @(*) begin
+   shd_rdata = 32'h0 ;
+   for (j = 0; j < 8; j = j + 1) begin
+      if (addr[19:0] == REG_SHADOW + REG_SP + REG_CH*j)  shd_rdata = {{32-14{1'b0}}, shd_sp[j]}   ;
+      if (addr[19:0] == REG_SHADOW + REG_KP + REG_CH*j)  shd_rdata = (j < 4) ? gain_rd(gain_fine[j], shd_kp[j]) : {{32-25{1'b0}}, shd_kp[j]} ;
+      if (addr[19:0] == REG_SHADOW + REG_KI + REG_CH*j)  shd_rdata = (j < 4) ? gain_rd(gain_fine[j], shd_ki[j]) : {{32-25{1'b0}}, shd_ki[j]} ;
+      if (addr[19:0] == REG_SHADOW + REG_KD + REG_CH*j)  shd_rdata = (j < 4) ? gain_rd(gain_fine[j], shd_kd[j]) : {{32-25{1'b0}}, shd_kd[j]} ;
+      if (addr[19:0] == REG_SHADOW + REG_IRST + REG_CH4*j)  shd_rdata = {{32- 1{1'b0}}, shd_irst[j]} ;
+      if (addr[19:0] == REG_SHADOW + REG_PSR + REG_CH*j)  shd_rdata = {{32- 5{1'b0}}, shd_PSR[j]}  ;
+      if (addr[19:0] == REG_SHADOW + REG_ISR + REG_CH*j)  shd_rdata = {{32- 5{1'b0}}, shd_ISR[j]}  ;
+      if (addr[19:0] == REG_SHADOW + REG_DSR + REG_CH*j)  shd_rdata = {{32- 5{1'b0}}, shd_DSR[j]}  ;
+      if (addr[19:0] == REG_SHADOW + REG_ICD + REG_CH*j)  shd_rdata = {{32-30{1'b0}}, shd_ICD[j]}  ;
+      if (addr[19:0] == REG_SHADOW + REG_TOL + REG_CH4*j)  shd_rdata = {{32- 9{1'b0}}, shd_TOL[j]}  ;
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Telemetry snapshot
+//---------------------------------------------------------------------------------
+
+// A write to 0x400 latches the telemetry of all channels on one clock edge and
+// clears the sticky saturation flags in the PID blocks, so the flags of a
+// snapshot cover the time since the previous one. 0x400 reads back the number
+// of snapshots taken. Channel n (index as above) reads back at 0x420 + 0x20*n:
+//   +0x00 error           +0x04 integrator      +0x08 P term
+//   +0x0C I term          +0x10 D term          +0x14 PID block output
+//   +0x18 flags: bit 0 integrator saturated, bit 1 output saturated
+// All values are signed and sign extended to 32 bits.
+
+wire [ 32-1: 0] tlm_out  [0:8-1] ;
+
+assign tlm_out[0] = {{32-14{pid_11_out[14-1]}}, pid_11_out} ;
+assign tlm_out[1] = {{32-14{pid_12_out[14-1]}}, pid_12_out} ;
+assign tlm_out[2] = {{32-14{pid_21_out[14-1]}}, pid_21_out} ;
+assign tlm_out[3] = {{32-14{pid_22_out[14-1]}}, pid_22_out} ;
+assign tlm_out[4] = {{32-12{pid_aa_out[12-1]}}, pid_aa_out} ;
+assign tlm_out[5] = {{32-12{pid_bb_out[12-1]}}, pid_bb_out} ;
+assign tlm_out[6] = {{32-12{pid_cc_out[12-1]}}, pid_cc_out} ;
+assign tlm_out[7] = {{32-12{pid_dd_out[12-1]}}, pid_dd_out} ;
+
+assign tlm_trig = wen && (addr[19:0] == REG_TLM_TRIG) ;
+
+reg  [ 32-1: 0] snp_err  [0:8-1] ;
+reg  [ 32-1: 0] snp_int  [0:8-1] ;
+reg  [ 32-1: 0] snp_p    [0:8-1] ;
+reg  [ 32-1: 0] snp_i    [0:8-1] ;
+reg  [ 32-1: 0] snp_d    [0:8-1] ;
+reg  [ 32-1: 0] snp_out  [0:8-1] ;
+reg  [  2-1: 0] snp_sat  [0:8-1] ;
+reg  [ 32-1: 0] snp_cnt          ;
+reg  [ 32-1: 0] tlm_rdata        ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      for (i = 0; i < 8; i = i + 1) begin
+         snp_err[i] <= 32'h0 ;
+         snp_int[i] <= 32'h0 ;
+         snp_p[i]   <= 32'h0 ;
+         snp_i[i]   <= 32'h0 ;
+         snp_d[i]   <= 32'h0 ;
+         snp_out[i] <= 32'h0 ;
+         snp_sat[i] <=  2'h0 ;
+      end
+      snp_cnt <= 32'h0 ;
+   end
+   else if (tlm_trig) begin
+      for (i = 0; i < 8; i = i + 1) begin
+         snp_err[i] <= tlm_err[i] ;
+         snp_int[i] <= tlm_int[i] ;
+         snp_p[i]   <= tlm_p[i]   ;
+         snp_i[i]   <= tlm_i[i]   ;
+         snp_d[i]   <= tlm_d[i]   ;
+         snp_out[i] <= tlm_out[i] ;
+         snp_sat[i] <= tlm_sat[i] ;
+      end
+      snp_cnt <= snp_cnt + 32'h1 ;
+   end
+end
+
+always @(*) begin
+   tlm_rdata = 32'h0 ;
+   if (addr[19:0] == REG_TLM_TRIG)  tlm_rdata = snp_cnt ;
+   for (k = 0; k < 8; k = k + 1) begin
+      if (addr[19:0] == REG_TLM + 20'h00 + REG_TLM_CH*k)  tlm_rdata = snp_err[k] ;
+      if (addr[19:0] == REG_TLM + 20'h04 + REG_TLM_CH*k)  tlm_rdata = snp_int[k] ;
+      if (addr[19:0] == REG_TLM + 20'h08 + REG_TLM_CH*k)  tlm_rdata = snp_p[k]   ;
+      if (addr[19:0] == REG_TLM + 20'h0C + REG_TLM_CH*k)  tlm_rdata = snp_i[k]   ;
+      if (addr[19:0] == REG_TLM + 20'h10 + REG_TLM_CH*k)  tlm_rdata = snp_d[k]   ;
+      if (addr[19:0] == REG_TLM + 20'h14 + REG_TLM_CH*k)  tlm_rdata = snp_out[k] ;
+      if (addr[19:0] == REG_TLM + 20'h18 + REG_TLM_CH*k)  tlm_rdata = {{32-2{1'b0}}, snp_sat[k]} ;
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Capture buffer
+//---------------------------------------------------------------------------------
+
+wire [8*32-1: 0] cap_adc  ;
+wire [8*32-1: 0] cap_err  ;
+wire [8*32-1: 0] cap_p    ;
+wire [8*32-1: 0] cap_i    ;
+wire [8*32-1: 0] cap_d    ;
+wire [8*32-1: 0] cap_out  ;
+wire [8*32-1: 0] cap_int  ;
+wire [8* 2-1: 0] cap_sat  ;
+wire [  32-1: 0] cap_rdata ;
+
+
+genvar g ;
+generate
+   for (g = 0; g < 8; g = g + 1) begin : cap_bus
+      assign cap_adc[32*g +: 32] = {{32-14{route_dat[14*g+13]}}, route_dat[14*g +: 14]} ;
+      assign cap_err[32*g +: 32] = tlm_err[g] ;
+      assign cap_p  [32*g +: 32] = tlm_p[g]   ;
+      assign cap_i  [32*g +: 32] = tlm_i[g]   ;
+      assign cap_d  [32*g +: 32] = tlm_d[g]   ;
+      assign cap_out[32*g +: 32] = tlm_out[g] ;
+      assign cap_int[32*g +: 32] = tlm_int[g] ;
+      assign cap_sat[ 2*g +:  2] = pid_sat[g] ;
+   end
+endgenerate
+
+red_pitaya_pid_capture i_capture
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .adc_i        (  cap_adc        ),  // input
+  .err_i        (  cap_err        ),  // error
+  .p_i          (  cap_p          ),  // proportional term
+  .i_i          (  cap_i          ),  // integral term
+  .d_i          (  cap_d          ),  // derivative term
+  .out_i        (  cap_out        ),  // PID block output
+  .int_i        (  cap_int        ),  // integrator register
+  .sat_i        (  cap_sat        ),  // saturation
+  .dio_i        (  int_hold_pins  ),  // DIO_P pins
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  cap_rdata      )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Loop analyzer
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] bode_rdata ;
+
+red_pitaya_pid_bode i_bode
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .adc_i        (  cap_adc        ),  // input
+  .err_i        (  cap_err        ),  // error
+  .p_i          (  cap_p          ),  // proportional term
+  .i_i          (  cap_i          ),  // integral term
+  .d_i          (  cap_d          ),  // derivative term
+  .out_i        (  cap_out        ),  // PID block output
+  .int_i        (  cap_int        ),  // integrator register
+
+  .exc_o        (  bode_exc       ),  // excitation
+  .inj_sp_o     (  bode_inj_sp    ),  // set point injection
+  .inj_out_o    (  bode_inj_out   ),  // output injection
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  bode_rdata     )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Set point ramps
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] ramp_rdata ;
+
+red_pitaya_pid_ramp i_ramp
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .sp_i         ({ {2{set_dd_sp[12-1]}}, set_dd_sp, {2{set_cc_sp[12-1]}}, set_cc_sp,
+                   {2{set_bb_sp[12-1]}}, set_bb_sp, {2{set_aa_sp[12-1]}}, set_aa_sp,
+                   set_22_sp, set_21_sp, set_12_sp, set_11_sp }),  // set point registers
+  .sp_o         (  ramp_sp        ),  // ramped set points
+  .done_o       (                 ),
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  ramp_rdata     )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Routing crossbar
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] route_rdata ;
+
+red_pitaya_pid_route i_route
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .fast_adc_i   ({ dat_b_i, dat_a_i }),  // fast ADC
+  .slow_adc_i   ({ adc_slx_d_i, adc_slx_c_i, adc_slx_b_i, adc_slx_a_i }),  // slow ADC
+  .fast_pid_i   ({ pid_22_out, pid_21_out, pid_12_out, pid_11_out }),  // fast channel outputs
+  .slow_pid_i   ({ pid_dd_out, pid_cc_out, pid_bb_out, pid_aa_out }),  // slow channel outputs
+  .sp_i         (  ramp_sp        ),  // ramped set points
+  .exc_i        (  bode_exc       ),  // excitation
+  .inj_i        (  bode_inj_out   ),  // output injection
+
+  .dat_o        (  route_dat      ),  // channel inputs
+  .sp_o         (  route_sp       ),  // channel set points
+  .dac_o        (  route_dac      ),  // fast DAC
+  .pwm_o        (  route_pwm      ),  // slow DAC
+  .exc_o        (  route_exc      ),  // anti-windup excess
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  route_rdata    )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Feedforward
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] ff_rdata ;
+
+red_pitaya_pid_ff i_ff
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .fast_adc_i   ({ dat_b_i, dat_a_i }),  // fast ADC
+  .slow_adc_i   ({ adc_slx_d_i, adc_slx_c_i, adc_slx_b_i, adc_slx_a_i }),  // slow ADC
+  .dio_i        (  int_hold_pins  ),  // DIO_P pins
+  .ff_o         (  ff_term        ),  // feedforward terms
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  ff_rdata       )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Parameter banks
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] bank_rdata ;
+
+red_pitaya_pid_bank #(
+  .FAST_GAIN    (  gain_res_fast  )
+)
+i_bank
+(
+  .clk_i        (  clk_i          ),  // clock
+  .rstn_i       (  rstn_i         ),  // reset - active low
+
+  .dio_i        (  int_hold_pins  ),  // DIO_P pins
+  .fine_i       (  gain_fine      ),  // fine gains
+  .load_o       (  bank_load      ),  // load into the live registers
+  .sp_o         (  bank_sp        ),  // set point
+  .kp_o         (  bank_kp        ),  // Kp
+  .ki_o         (  bank_ki        ),  // Ki
+  .kd_o         (  bank_kd        ),  // Kd
+  .psr_o        (  bank_psr       ),  // PSR
+  .isr_o        (  bank_isr       ),  // ISR
+  .dsr_o        (  bank_dsr       ),  // DSR
+  .icd_o        (  bank_icd       ),  // ICD
+  .tol_o        (  bank_tol       ),  // TOL
+  .scale_o      (  bank_scale     ),  // bumpless ISR changes
+  .hold_o       (  bank_hold      ),  // integrator holds
+
+  .addr_i       (  addr           ),
+  .wdata_i      (  wdata          ),
+  .wen_i        (  wen            ),
+  .rdata_o      (  bank_rdata     )
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Discovery ROM
+//---------------------------------------------------------------------------------
+
+wire [  32-1: 0] info_rdata ;
+
+red_pitaya_pid_info #(
+  .FAST_NUM     (  4              ),
+  .SLOW_NUM     (  4              ),
+  .FAST_RES     (  14             ),
+  .SLOW_RES     (  12             ),
+  .FAST_GAIN    (  adc_res_fast   ),
+  .FAST_FRAC    (  gain_frac_fast ),
+  .SLOW_GAIN    (  12             ),
+  .FEATURES     (  features       ),
+  .FAST_FLAGS   (  flags_fast     ),
+  .SLOW_FLAGS   (  flags_slow     )
+)
+i_info
+(
+  .addr_i       (  addr           ),
+  .rdata_o      (  info_rdata     )
+);
+
+
+
 //---------------------------------------------------------------------------------
 //  System bus connection
 //---------------------------------------------------------------------------------
@@ -631,27 +1258,27 @@ assign dac_pwm_d_o = out_d_sat ;
 always @(posedge clk_i) begin
    if (rstn_i == 1'b0) begin
       set_11_sp    <= 14'd0 ;
-      set_11_kp    <= 14'd0 ;
-      set_11_ki    <= 14'd0 ;
-      set_11_kd    <= 14'd0 ;
+      set_11_kp    <= 25'd0 ;
+      set_11_ki    <= 25'd0 ;
+      set_11_kd    <= 25'd0 ;
       set_11_irst  <=  1'b1 ;
       
       set_12_sp    <= 14'd0 ;
-      set_12_kp    <= 14'd0 ;
-      set_12_ki    <= 14'd0 ;
-      set_12_kd    <= 14'd0 ;
+      set_12_kp    <= 25'd0 ;
+      set_12_ki    <= 25'd0 ;
+      set_12_kd    <= 25'd0 ;
       set_12_irst  <=  1'b1 ;
       
       set_21_sp    <= 14'd0 ;
-      set_21_kp    <= 14'd0 ;
-      set_21_ki    <= 14'd0 ;
-      set_21_kd    <= 14'd0 ;
+      set_21_kp    <= 25'd0 ;
+      set_21_ki    <= 25'd0 ;
+      set_21_kd    <= 25'd0 ;
       set_21_irst  <=  1'b1 ;
       
       set_22_sp    <= 14'd0 ;
-      set_22_kp    <= 14'd0 ;
-      set_22_ki    <= 14'd0 ;
-      set_22_kd    <= 14'd0 ;
+      set_22_kp    <= 25'd0 ;
+      set_22_ki    <= 25'd0 ;
+      set_22_kd    <= 25'd0 ;
       set_22_irst  <=  1'b1 ;
       
       set_aa_sp    <= 12'd0 ;
@@ -683,149 +1310,384 @@ always @(posedge clk_i) begin
       DSR_11       <= 5'd10 ;     
       ICD_11       <= 30'd0  ;      
       TOL_11       <= 9'd0;
+      DCD_11       <= 30'd0 ;
+      DFL_11       <= 5'd0 ;
+      AWM_11       <= 2'd0 ;
+      AWK_11       <= 5'd3 ;
       
       PSR_12       <= 5'd12 ; 
       ISR_12       <= 5'd18 ;      
       DSR_12       <= 5'd10 ;     
       ICD_12       <= 30'd0  ;      
       TOL_12       <= 9'd0;
+      DCD_12       <= 30'd0 ;
+      DFL_12       <= 5'd0 ;
+      AWM_12       <= 2'd0 ;
+      AWK_12       <= 5'd3 ;
             
       PSR_21       <= 5'd12 ; 
       ISR_21       <= 5'd18 ;      
       DSR_21       <= 5'd10 ;     
       ICD_21       <= 30'd0  ;       
       TOL_21       <= 9'd0;
+      DCD_21       <= 30'd0 ;
+      DFL_21       <= 5'd0 ;
+      AWM_21       <= 2'd0 ;
+      AWK_21       <= 5'd3 ;
             
       PSR_22       <= 5'd12 ; 
       ISR_22       <= 5'd18 ;      
       DSR_22       <= 5'd10 ;     
       ICD_22       <= 30'd0  ;       
       TOL_22       <= 9'd0;
+      DCD_22       <= 30'd0 ;
+      DFL_22       <= 5'd0 ;
+      AWM_22       <= 2'd0 ;
+      AWK_22       <= 5'd3 ;
+      gain_fine    <= 8'h0 ;
             
       PSR_aa       <= 5'd8 ; // set to default slow values
       ISR_aa       <= 5'd20 ;      
       DSR_aa       <= 5'd6 ;     
       ICD_aa       <= 30'd0  ;       
       TOL_aa       <= 9'd0;
+      AWM_aa       <= 2'd0 ;
+      AWK_aa       <= 5'd3 ;
       
       PSR_bb       <= 5'd8 ; 
       ISR_bb       <= 5'd20 ;      
       DSR_bb       <= 5'd6 ;     
       ICD_bb       <= 30'd0  ;        
       TOL_bb       <= 9'd0;
+      AWM_bb       <= 2'd0 ;
+      AWK_bb       <= 5'd3 ;
  
       PSR_cc       <= 5'd8 ; 
       ISR_cc       <= 5'd20 ;      
       DSR_cc       <= 5'd6 ;     
       ICD_cc       <= 30'd0  ;  
       TOL_cc       <= 9'd0;
+      AWM_cc       <= 2'd0 ;
+      AWK_cc       <= 5'd3 ;
       
       PSR_dd       <= 5'd8 ; 
       ISR_dd       <= 5'd20 ;      
       DSR_dd       <= 5'd6 ;     
       ICD_dd       <= 30'd0  ;   
       TOL_dd       <= 9'd0;
+      AWM_dd       <= 2'd0 ;
+      AWK_dd       <= 5'd3 ;
             
    end
    else begin
       if (wen) begin
        
-         if (addr[19:0]==16'h90)    set_11_irst  <= wdata[1-1: 0] ; //just a 1 bit number
-         if (addr[19:0]==16'h10)    set_11_sp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h14)    set_11_kp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h18)    set_11_ki  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h1C)    set_11_kd  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_IRST + REG_CH4*0)    set_11_irst  <= wdata[1-1: 0] ; //just a 1 bit number
+         if (addr[19:0]==REG_SP + REG_CH*0)       set_11_sp  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*0)       set_11_kp  <= gain_wr(gain_fine[0], wdata) ;
+         if (addr[19:0]==REG_KI + REG_CH*0)       set_11_ki  <= gain_wr(gain_fine[0], wdata) ;
+         if (addr[19:0]==REG_KD + REG_CH*0)       set_11_kd  <= gain_wr(gain_fine[0], wdata) ;
          
-         if (addr[19:0]==16'h94)    set_12_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h20)    set_12_sp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h24)    set_12_kp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h28)    set_12_ki  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h2C)    set_12_kd  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_IRST + REG_CH4*1)    set_12_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*1)       set_12_sp  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*1)       set_12_kp  <= gain_wr(gain_fine[1], wdata) ;
+         if (addr[19:0]==REG_KI + REG_CH*1)       set_12_ki  <= gain_wr(gain_fine[1], wdata) ;
+         if (addr[19:0]==REG_KD + REG_CH*1)       set_12_kd  <= gain_wr(gain_fine[1], wdata) ;
          
-         if (addr[19:0]==16'h98)    set_21_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h30)    set_21_sp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h34)    set_21_kp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h38)    set_21_ki  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h3C)    set_21_kd  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_IRST + REG_CH4*2)    set_21_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*2)       set_21_sp  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*2)       set_21_kp  <= gain_wr(gain_fine[2], wdata) ;
+         if (addr[19:0]==REG_KI + REG_CH*2)       set_21_ki  <= gain_wr(gain_fine[2], wdata) ;
+         if (addr[19:0]==REG_KD + REG_CH*2)       set_21_kd  <= gain_wr(gain_fine[2], wdata) ;
          
-         if (addr[19:0]==16'h9C)    set_22_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h40)    set_22_sp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h44)    set_22_kp  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h48)    set_22_ki  <= wdata[14-1:0] ;
-         if (addr[19:0]==16'h4C)    set_22_kd  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_IRST + REG_CH4*3)    set_22_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*3)       set_22_sp  <= wdata[14-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*3)       set_22_kp  <= gain_wr(gain_fine[3], wdata) ;
+         if (addr[19:0]==REG_KI + REG_CH*3)       set_22_ki  <= gain_wr(gain_fine[3], wdata) ;
+         if (addr[19:0]==REG_KD + REG_CH*3)       set_22_kd  <= gain_wr(gain_fine[3], wdata) ;
          
-         if (addr[19:0]==16'hA0)    set_aa_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h50)    set_aa_sp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h54)    set_aa_kp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h58)    set_aa_ki  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h5C)    set_aa_kd  <= wdata[12-1:0] ;         
+         if (addr[19:0]==REG_IRST + REG_CH4*4)    set_aa_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*4)       set_aa_sp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*4)       set_aa_kp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KI + REG_CH*4)       set_aa_ki  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KD + REG_CH*4)       set_aa_kd  <= wdata[12-1:0] ;         
  
-         if (addr[19:0]==16'hA4)    set_bb_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h60)    set_bb_sp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h64)    set_bb_kp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h68)    set_bb_ki  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h6C)    set_bb_kd  <= wdata[12-1:0] ; 
+         if (addr[19:0]==REG_IRST + REG_CH4*5)    set_bb_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*5)       set_bb_sp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*5)       set_bb_kp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KI + REG_CH*5)       set_bb_ki  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KD + REG_CH*5)       set_bb_kd  <= wdata[12-1:0] ; 
  
-         if (addr[19:0]==16'hA8)    set_cc_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h70)    set_cc_sp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h74)    set_cc_kp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h78)    set_cc_ki  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h7C)    set_cc_kd  <= wdata[12-1:0] ;      
+         if (addr[19:0]==REG_IRST + REG_CH4*6)    set_cc_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*6)       set_cc_sp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*6)       set_cc_kp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KI + REG_CH*6)       set_cc_ki  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KD + REG_CH*6)       set_cc_kd  <= wdata[12-1:0] ;      
          
-         if (addr[19:0]==16'hAC)    set_dd_irst  <= wdata[1-1:0] ;
-         if (addr[19:0]==16'h80)    set_dd_sp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h84)    set_dd_kp  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h88)    set_dd_ki  <= wdata[12-1:0] ;
-         if (addr[19:0]==16'h8C)    set_dd_kd  <= wdata[12-1:0] ;            
+         if (addr[19:0]==REG_IRST + REG_CH4*7)    set_dd_irst  <= wdata[1-1:0] ;
+         if (addr[19:0]==REG_SP + REG_CH*7)       set_dd_sp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KP + REG_CH*7)       set_dd_kp  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KI + REG_CH*7)       set_dd_ki  <= wdata[12-1:0] ;
+         if (addr[19:0]==REG_KD + REG_CH*7)       set_dd_kd  <= wdata[12-1:0] ;            
          
-         if (addr[19:0]==16'hB0)    PSR_11  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hB4)    ISR_11  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hB8)    DSR_11  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hBC)    ICD_11  <= wdata[30-1:0] ;         
-         if (addr[19:0]==16'h130)   TOL_11  <= wdata[9-1:0] ; 
+         if (addr[19:0]==REG_PSR + REG_CH*0)      PSR_11  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*0)      ISR_11  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*0)      DSR_11  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*0)      ICD_11  <= wdata[30-1:0] ;         
+         if (addr[19:0]==REG_TOL + REG_CH4*0)     TOL_11  <= wdata[9-1:0] ; 
+         if (addr[19:0]==REG_DCD + REG_CH*0)      DCD_11  <= wdata[30-1:0] ;
+         if (addr[19:0]==REG_DFL + REG_CH*0)      DFL_11  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*0)       {AWK_11, AWM_11}  <= {wdata[13-1:8], wdata[2-1:0]} ;
+         if (addr[19:0]==REG_FINE + REG_CH*0)     gain_fine[0]  <= wdata[0] ;
          
-         if (addr[19:0]==16'hC0)    PSR_12  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hC4)    ISR_12  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hC8)    DSR_12  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hCC)    ICD_12  <= wdata[30-1:0] ;          
-        if (addr[19:0]==16'h134)    TOL_12  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*1)      PSR_12  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*1)      ISR_12  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*1)      DSR_12  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*1)      ICD_12  <= wdata[30-1:0] ;          
+        if (addr[19:0]==REG_TOL + REG_CH4*1)     TOL_12  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_DCD + REG_CH*1)      DCD_12  <= wdata[30-1:0] ;
+         if (addr[19:0]==REG_DFL + REG_CH*1)      DFL_12  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*1)       {AWK_12, AWM_12}  <= {wdata[13-1:8], wdata[2-1:0]} ;
+         if (addr[19:0]==REG_FINE + REG_CH*1)     gain_fine[1]  <= wdata[0] ;
                   
-         if (addr[19:0]==16'hD0)    PSR_21  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hD4)    ISR_21  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hD8)    DSR_21  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hDC)    ICD_21  <= wdata[30-1:0] ;           
-        if (addr[19:0]==16'h138)    TOL_21  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*2)      PSR_21  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*2)      ISR_21  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*2)      DSR_21  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*2)      ICD_21  <= wdata[30-1:0] ;           
+        if (addr[19:0]==REG_TOL + REG_CH4*2)     TOL_21  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_DCD + REG_CH*2)      DCD_21  <= wdata[30-1:0] ;
+         if (addr[19:0]==REG_DFL + REG_CH*2)      DFL_21  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*2)       {AWK_21, AWM_21}  <= {wdata[13-1:8], wdata[2-1:0]} ;
+         if (addr[19:0]==REG_FINE + REG_CH*2)     gain_fine[2]  <= wdata[0] ;
                  
-         if (addr[19:0]==16'hE0)    PSR_22  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hE4)    ISR_22  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hE8)    DSR_22  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hEC)    ICD_22  <= wdata[30-1:0] ;           
-         if (addr[19:0]==16'h13C)    TOL_22  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*3)      PSR_22  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*3)      ISR_22  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*3)      DSR_22  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*3)      ICD_22  <= wdata[30-1:0] ;           
+         if (addr[19:0]==REG_TOL + REG_CH4*3)     TOL_22  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_DCD + REG_CH*3)      DCD_22  <= wdata[30-1:0] ;
+         if (addr[19:0]==REG_DFL + REG_CH*3)      DFL_22  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*3)       {AWK_22, AWM_22}  <= {wdata[13-1:8], wdata[2-1:0]} ;
+         if (addr[19:0]==REG_FINE + REG_CH*3)     gain_fine[3]  <= wdata[0] ;
                  
-         if (addr[19:0]==16'hF0)    PSR_aa  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hF4)    ISR_aa  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hF8)    DSR_aa  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'hFC)    ICD_aa  <= wdata[30-1:0] ;          
-         if (addr[19:0]==16'h140)    TOL_aa  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*4)      PSR_aa  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*4)      ISR_aa  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*4)      DSR_aa  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*4)      ICD_aa  <= wdata[30-1:0] ;          
+         if (addr[19:0]==REG_TOL + REG_CH4*4)     TOL_aa  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*4)       {AWK_aa, AWM_aa}  <= {wdata[13-1:8], wdata[2-1:0]} ;
                   
-         if (addr[19:0]==16'h100)    PSR_bb  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h104)    ISR_bb  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h108)    DSR_bb  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h10C)    ICD_bb  <= wdata[30-1:0] ;         
-         if (addr[19:0]==16'h144)    TOL_bb  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*5)      PSR_bb  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*5)      ISR_bb  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*5)      DSR_bb  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*5)      ICD_bb  <= wdata[30-1:0] ;         
+         if (addr[19:0]==REG_TOL + REG_CH4*5)     TOL_bb  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*5)       {AWK_bb, AWM_bb}  <= {wdata[13-1:8], wdata[2-1:0]} ;
                   
-         if (addr[19:0]==16'h110)    PSR_cc  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h114)    ISR_cc  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h118)    DSR_cc  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h11C)    ICD_cc  <= wdata[30-1:0] ;          
-          if (addr[19:0]==16'h148)   TOL_cc  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_PSR + REG_CH*6)      PSR_cc  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*6)      ISR_cc  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*6)      DSR_cc  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*6)      ICD_cc  <= wdata[30-1:0] ;          
+          if (addr[19:0]==REG_TOL + REG_CH4*6)     TOL_cc  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*6)       {AWK_cc, AWM_cc}  <= {wdata[13-1:8], wdata[2-1:0]} ;
                   
-         if (addr[19:0]==16'h120)    PSR_dd  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h124)    ISR_dd  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h128)    DSR_dd  <= wdata[5-1:0] ;
-         if (addr[19:0]==16'h12C)    ICD_dd  <= wdata[30-1:0] ;         
-         if (addr[19:0]==16'h14C)    TOL_dd  <= wdata[9-1:0] ;
-                              
+         if (addr[19:0]==REG_PSR + REG_CH*7)      PSR_dd  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ISR + REG_CH*7)      ISR_dd  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_DSR + REG_CH*7)      DSR_dd  <= wdata[5-1:0] ;
+         if (addr[19:0]==REG_ICD + REG_CH*7)      ICD_dd  <= wdata[30-1:0] ;         
+         if (addr[19:0]==REG_TOL + REG_CH4*7)     TOL_dd  <= wdata[9-1:0] ;
+         if (addr[19:0]==REG_AW + REG_CH*7)       {AWK_dd, AWM_dd}  <= {wdata[13-1:8], wdata[2-1:0]} ;
+
+         // commit staged parameters of the selected channels on one clock edge
+         if (commit) begin
+            if (commit_mask[0]) begin
+               set_11_sp   <= shd_sp[0]   ;
+               set_11_kp   <= shd_kp[0]   ;
+               set_11_ki   <= shd_ki[0]   ;
+               set_11_kd   <= shd_kd[0]   ;
+               set_11_irst <= shd_irst[0] ;
+               PSR_11      <= shd_PSR[0]  ;
+               ISR_11      <= shd_ISR[0]  ;
+               DSR_11      <= shd_DSR[0]  ;
+               ICD_11      <= shd_ICD[0]  ;
+               TOL_11      <= shd_TOL[0]  ;
+            end
+            if (commit_mask[1]) begin
+               set_12_sp   <= shd_sp[1]   ;
+               set_12_kp   <= shd_kp[1]   ;
+               set_12_ki   <= shd_ki[1]   ;
+               set_12_kd   <= shd_kd[1]   ;
+               set_12_irst <= shd_irst[1] ;
+               PSR_12      <= shd_PSR[1]  ;
+               ISR_12      <= shd_ISR[1]  ;
+               DSR_12      <= shd_DSR[1]  ;
+               ICD_12      <= shd_ICD[1]  ;
+               TOL_12      <= shd_TOL[1]  ;
+            end
+            if (commit_mask[2]) begin
+               set_21_sp   <= shd_sp[2]   ;
+               set_21_kp   <= shd_kp[2]   ;
+               set_21_ki   <= shd_ki[2]   ;
+               set_21_kd   <= shd_kd[2]   ;
+               set_21_irst <= shd_irst[2] ;
+               PSR_21      <= shd_PSR[2]  ;
+               ISR_21      <= shd_ISR[2]  ;
+               DSR_21      <= shd_DSR[2]  ;
+               ICD_21      <= shd_ICD[2]  ;
+               TOL_21      <= shd_TOL[2]  ;
+            end
+            if (commit_mask[3]) begin
+               set_22_sp   <= shd_sp[3]   ;
+               set_22_kp   <= shd_kp[3]   ;
+               set_22_ki   <= shd_ki[3]   ;
+               set_22_kd   <= shd_kd[3]   ;
+               set_22_irst <= shd_irst[3] ;
+               PSR_22      <= shd_PSR[3]  ;
+               ISR_22      <= shd_ISR[3]  ;
+               DSR_22      <= shd_DSR[3]  ;
+               ICD_22      <= shd_ICD[3]  ;
+               TOL_22      <= shd_TOL[3]  ;
+            end
+            if (commit_mask[4]) begin
+               set_aa_sp   <= shd_sp[4][12-1:0]   ;
+               set_aa_kp   <= shd_kp[4][12-1:0]   ;
+               set_aa_ki   <= shd_ki[4][12-1:0]   ;
+               set_aa_kd   <= shd_kd[4][12-1:0]   ;
+               set_aa_irst <= shd_irst[4] ;
+               PSR_aa      <= shd_PSR[4]  ;
+               ISR_aa      <= shd_ISR[4]  ;
+               DSR_aa      <= shd_DSR[4]  ;
+               ICD_aa      <= shd_ICD[4]  ;
+               TOL_aa      <= shd_TOL[4]  ;
+            end
+            if (commit_mask[5]) begin
+               set_bb_sp   <= shd_sp[5][12-1:0]   ;
+               set_bb_kp   <= shd_kp[5][12-1:0]   ;
+               set_bb_ki   <= shd_ki[5][12-1:0]   ;
+               set_bb_kd   <= shd_kd[5][12-1:0]   ;
+               set_bb_irst <= shd_irst[5] ;
+               PSR_bb      <= shd_PSR[5]  ;
+               ISR_bb      <= shd_ISR[5]  ;
+               DSR_bb      <= shd_DSR[5]  ;
+               ICD_bb      <= shd_ICD[5]  ;
+               TOL_bb      <= shd_TOL[5]  ;
+            end
+            if (commit_mask[6]) begin
+               set_cc_sp   <= shd_sp[6][12-1:0]   ;
+               set_cc_kp   <= shd_kp[6][12-1:0]   ;
+               set_cc_ki   <= shd_ki[6][12-1:0]   ;
+               set_cc_kd   <= shd_kd[6][12-1:0]   ;
+               set_cc_irst <= shd_irst[6] ;
+               PSR_cc      <= shd_PSR[6]  ;
+               ISR_cc      <= shd_ISR[6]  ;
+               DSR_cc      <= shd_DSR[6]  ;
+               ICD_cc      <= shd_ICD[6]  ;
+               TOL_cc      <= shd_TOL[6]  ;
+            end
+            if (commit_mask[7]) begin
+               set_dd_sp   <= shd_sp[7][12-1:0]   ;
+               set_dd_kp   <= shd_kp[7][12-1:0]   ;
+               set_dd_ki   <= shd_ki[7][12-1:0]   ;
+               set_dd_kd   <= shd_kd[7][12-1:0]   ;
+               set_dd_irst <= shd_irst[7] ;
+               PSR_dd      <= shd_PSR[7]  ;
+               ISR_dd      <= shd_ISR[7]  ;
+               DSR_dd      <= shd_DSR[7]  ;
+               ICD_dd      <= shd_ICD[7]  ;
+               TOL_dd      <= shd_TOL[7]  ;
+            end
+         end
+
+      end
+
+      // load a parameter bank of the selected channels on one clock edge
+      if (bank_load[0]) begin
+         set_11_sp   <= bank_sp [14*0 +: 14] ;
+         set_11_kp   <= bank_kp [25*0 +: 25] ;
+         set_11_ki   <= bank_ki [25*0 +: 25] ;
+         set_11_kd   <= bank_kd [25*0 +: 25] ;
+         PSR_11      <= bank_psr[ 5*0 +:  5] ;
+         ISR_11      <= bank_isr[ 5*0 +:  5] ;
+         DSR_11      <= bank_dsr[ 5*0 +:  5] ;
+         ICD_11      <= bank_icd[30*0 +: 30] ;
+         TOL_11      <= bank_tol[ 9*0 +:  9] ;
+      end
+      if (bank_load[1]) begin
+         set_12_sp   <= bank_sp [14*1 +: 14] ;
+         set_12_kp   <= bank_kp [25*1 +: 25] ;
+         set_12_ki   <= bank_ki [25*1 +: 25] ;
+         set_12_kd   <= bank_kd [25*1 +: 25] ;
+         PSR_12      <= bank_psr[ 5*1 +:  5] ;
+         ISR_12      <= bank_isr[ 5*1 +:  5] ;
+         DSR_12      <= bank_dsr[ 5*1 +:  5] ;
+         ICD_12      <= bank_icd[30*1 +: 30] ;
+         TOL_12      <= bank_tol[ 9*1 +:  9] ;
+      end
+      if (bank_load[2]) begin
+         set_21_sp   <= bank_sp [14*2 +: 14] ;
+         set_21_kp   <= bank_kp [25*2 +: 25] ;
+         set_21_ki   <= bank_ki [25*2 +: 25] ;
+         set_21_kd   <= bank_kd [25*2 +: 25] ;
+         PSR_21      <= bank_psr[ 5*2 +:  5] ;
+         ISR_21      <= bank_isr[ 5*2 +:  5] ;
+         DSR_21      <= bank_dsr[ 5*2 +:  5] ;
+         ICD_21      <= bank_icd[30*2 +: 30] ;
+         TOL_21      <= bank_tol[ 9*2 +:  9] ;
+      end
+      if (bank_load[3]) begin
+         set_22_sp   <= bank_sp [14*3 +: 14] ;
+         set_22_kp   <= bank_kp [25*3 +: 25] ;
+         set_22_ki   <= bank_ki [25*3 +: 25] ;
+         set_22_kd   <= bank_kd [25*3 +: 25] ;
+         PSR_22      <= bank_psr[ 5*3 +:  5] ;
+         ISR_22      <= bank_isr[ 5*3 +:  5] ;
+         DSR_22      <= bank_dsr[ 5*3 +:  5] ;
+         ICD_22      <= bank_icd[30*3 +: 30] ;
+         TOL_22      <= bank_tol[ 9*3 +:  9] ;
+      end
+      if (bank_load[4]) begin
+         set_aa_sp   <= bank_sp [14*4 +: 12] ;
+         set_aa_kp   <= bank_kp [25*4 +: 12] ;
+         set_aa_ki   <= bank_ki [25*4 +: 12] ;
+         set_aa_kd   <= bank_kd [25*4 +: 12] ;
+         PSR_aa      <= bank_psr[ 5*4 +:  5] ;
+         ISR_aa      <= bank_isr[ 5*4 +:  5] ;
+         DSR_aa      <= bank_dsr[ 5*4 +:  5] ;
+         ICD_aa      <= bank_icd[30*4 +: 30] ;
+         TOL_aa      <= bank_tol[ 9*4 +:  9] ;
+      end
+      if (bank_load[5]) begin
+         set_bb_sp   <= bank_sp [14*5 +: 12] ;
+         set_bb_kp   <= bank_kp [25*5 +: 12] ;
+         set_bb_ki   <= bank_ki [25*5 +: 12] ;
+         set_bb_kd   <= bank_kd [25*5 +: 12] ;
+         PSR_bb      <= bank_psr[ 5*5 +:  5] ;
+         ISR_bb      <= bank_isr[ 5*5 +:  5] ;
+         DSR_bb      <= bank_dsr[ 5*5 +:  5] ;
+         ICD_bb      <= bank_icd[30*5 +: 30] ;
+         TOL_bb      <= bank_tol[ 9*5 +:  9] ;
+      end
+      if (bank_load[6]) begin
+         set_cc_sp   <= bank_sp [14*6 +: 12] ;
+         set_cc_kp   <= bank_kp [25*6 +: 12] ;
+         set_cc_ki   <= bank_ki [25*6 +: 12] ;
+         set_cc_kd   <= bank_kd [25*6 +: 12] ;
+         PSR_cc      <= bank_psr[ 5*6 +:  5] ;
+         ISR_cc      <= bank_isr[ 5*6 +:  5] ;
+         DSR_cc      <= bank_dsr[ 5*6 +:  5] ;
+         ICD_cc      <= bank_icd[30*6 +: 30] ;
+         TOL_cc      <= bank_tol[ 9*6 +:  9] ;
+      end
+      if (bank_load[7]) begin
+         set_dd_sp   <= bank_sp [14*7 +: 12] ;
+         set_dd_kp   <= bank_kp [25*7 +: 12] ;
+         set_dd_ki   <= bank_ki [25*7 +: 12] ;
+         set_dd_kd   <= bank_kd [25*7 +: 12] ;
+         PSR_dd      <= bank_psr[ 5*7 +:  5] ;
+         ISR_dd      <= bank_isr[ 5*7 +:  5] ;
+         DSR_dd      <= bank_dsr[ 5*7 +:  5] ;
+         ICD_dd      <= bank_icd[30*7 +: 30] ;
+         TOL_dd      <= bank_tol[ 9*7 +:  9] ;
       end
    end
 end
@@ -836,102 +1698,122 @@ always @(*) begin
 
    casez (addr[19:0])
 
-      20'h90 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_11_irst}         ; end     
-      20'h10 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_11_sp}          ; end 
-      20'h14 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_11_kp}          ; end 
-      20'h18 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_11_ki}          ; end 
-      20'h1C : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_11_kd}          ; end 
-
-      20'h94 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_12_irst}         ; end     
-      20'h20 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_12_sp}          ; end 
-      20'h24 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_12_kp}          ; end 
-      20'h28 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_12_ki}          ; end 
-      20'h2C : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_12_kd}          ; end 
-
-      20'h98 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_21_irst}         ; end     
-      20'h30 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_21_sp}          ; end 
-      20'h34 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_21_kp}          ; end 
-      20'h38 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_21_ki}          ; end 
-      20'h3C : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_21_kd}          ; end 
-
-      20'h9C : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_22_irst}         ; end     
-      20'h40 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_22_sp}          ; end 
-      20'h44 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_22_kp}          ; end 
-      20'h48 : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_22_ki}          ; end 
-      20'h4C : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_22_kd}          ; end 
-
-      20'hA0 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_aa_irst}         ; end     
-      20'h50 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_sp}          ; end 
-      20'h54 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_kp}          ; end 
-      20'h58 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_ki}          ; end 
-      20'h5C : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_kd}          ; end 
-
-      20'hA4 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_bb_irst}         ; end     
-      20'h60 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_sp}          ; end 
-      20'h64 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_kp}          ; end 
-      20'h68 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_ki}          ; end 
-      20'h6C : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_kd}          ; end 
-
-      20'hA8 : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_cc_irst}         ; end     
-      20'h70 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_sp}          ; end 
-      20'h74 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_kp}          ; end 
-      20'h78 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_ki}          ; end 
-      20'h7C : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_kd}          ; end 
-
-      20'hAC : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_dd_irst}         ; end     
-      20'h80 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_sp}          ; end 
-      20'h84 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_kp}          ; end 
-      20'h88 : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_ki}          ; end 
-      20'h8C : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_kd}          ; end 
+      REG_IRST + REG_CH4*0  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_11_irst}         ; end     
+      REG_SP + REG_CH*0     : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_11_sp}          ; end 
+      REG_KP + REG_CH*0     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[0], set_11_kp)          ; end 
+      REG_KI + REG_CH*0     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[0], set_11_ki)          ; end 
+      REG_KD + REG_CH*0     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[0], set_11_kd)          ; end 
+
+      REG_IRST + REG_CH4*1  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_12_irst}         ; end     
+      REG_SP + REG_CH*1     : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_12_sp}          ; end 
+      REG_KP + REG_CH*1     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[1], set_12_kp)          ; end 
+      REG_KI + REG_CH*1     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[1], set_12_ki)          ; end 
+      REG_KD + REG_CH*1     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[1], set_12_kd)          ; end 
+
+      REG_IRST + REG_CH4*2  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_21_irst}         ; end     
+      REG_SP + REG_CH*2     : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_21_sp}          ; end 
+      REG_KP + REG_CH*2     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[2], set_21_kp)          ; end 
+      REG_KI + REG_CH*2     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[2], set_21_ki)          ; end 
+      REG_KD + REG_CH*2     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[2], set_21_kd)          ; end 
+
+      REG_IRST + REG_CH4*3  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_22_irst}         ; end     
+      REG_SP + REG_CH*3     : begin ack <= 1'b1;          rdata <= {{32-14{1'b0}}, set_22_sp}          ; end 
+      REG_KP + REG_CH*3     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[3], set_22_kp)          ; end 
+      REG_KI + REG_CH*3     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[3], set_22_ki)          ; end 
+      REG_KD + REG_CH*3     : begin ack <= 1'b1;          rdata <= gain_rd(gain_fine[3], set_22_kd)          ; end 
+
+      REG_IRST + REG_CH4*4  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_aa_irst}         ; end     
+      REG_SP + REG_CH*4     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_sp}          ; end 
+      REG_KP + REG_CH*4     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_kp}          ; end 
+      REG_KI + REG_CH*4     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_ki}          ; end 
+      REG_KD + REG_CH*4     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_aa_kd}          ; end 
+
+      REG_IRST + REG_CH4*5  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_bb_irst}         ; end     
+      REG_SP + REG_CH*5     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_sp}          ; end 
+      REG_KP + REG_CH*5     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_kp}          ; end 
+      REG_KI + REG_CH*5     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_ki}          ; end 
+      REG_KD + REG_CH*5     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_bb_kd}          ; end 
+
+      REG_IRST + REG_CH4*6  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_cc_irst}         ; end     
+      REG_SP + REG_CH*6     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_sp}          ; end 
+      REG_KP + REG_CH*6     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_kp}          ; end 
+      REG_KI + REG_CH*6     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_ki}          ; end 
+      REG_KD + REG_CH*6     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_cc_kd}          ; end 
+
+      REG_IRST + REG_CH4*7  : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, set_dd_irst}         ; end     
+      REG_SP + REG_CH*7     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_sp}          ; end 
+      REG_KP + REG_CH*7     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_kp}          ; end 
+      REG_KI + REG_CH*7     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_ki}          ; end 
+      REG_KD + REG_CH*7     : begin ack <= 1'b1;          rdata <= {{32-12{1'b0}}, set_dd_kd}          ; end 
       
-      20'hB0 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_11}             ; end     
-      20'hB4 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_11}             ; end 
-      20'hB8 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_11}             ; end 
-      20'hBC : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_11}             ; end 
-      20'h130 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_11}             ; end 
+      REG_PSR + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_11}             ; end     
+      REG_ISR + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_11}             ; end 
+      REG_DSR + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_11}             ; end 
+      REG_ICD + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_11}             ; end 
+      REG_TOL + REG_CH4*0   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_11}             ; end 
+      REG_DCD + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, DCD_11}             ; end
+      REG_DFL + REG_CH*0    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DFL_11}             ; end
+      REG_AW + REG_CH*0     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_11, 6'h0, AWM_11}             ; end
+      REG_FINE + REG_CH*0   : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, gain_fine[0]}             ; end
          
-      20'hC0 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_12}             ; end     
-      20'hC4 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_12}             ; end 
-      20'hC8 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_12}             ; end 
-      20'hCC : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_12}             ; end       
-      20'h134 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_12}             ; end 
+      REG_PSR + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_12}             ; end     
+      REG_ISR + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_12}             ; end 
+      REG_DSR + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_12}             ; end 
+      REG_ICD + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_12}             ; end       
+      REG_TOL + REG_CH4*1   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_12}             ; end 
+      REG_DCD + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, DCD_12}             ; end
+      REG_DFL + REG_CH*1    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DFL_12}             ; end
+      REG_AW + REG_CH*1     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_12, 6'h0, AWM_12}             ; end
+      REG_FINE + REG_CH*1   : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, gain_fine[1]}             ; end
             
-      20'hD0 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_21}             ; end     
-      20'hD4 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_21}             ; end 
-      20'hD8 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_21}             ; end 
-      20'hDC : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_21}             ; end       
-      20'h138 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_21}             ; end 
+      REG_PSR + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_21}             ; end     
+      REG_ISR + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_21}             ; end 
+      REG_DSR + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_21}             ; end 
+      REG_ICD + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_21}             ; end       
+      REG_TOL + REG_CH4*2   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_21}             ; end 
+      REG_DCD + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, DCD_21}             ; end
+      REG_DFL + REG_CH*2    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DFL_21}             ; end
+      REG_AW + REG_CH*2     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_21, 6'h0, AWM_21}             ; end
+      REG_FINE + REG_CH*2   : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, gain_fine[2]}             ; end
             
-      20'hE0 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_22}             ; end     
-      20'hE4 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_22}             ; end 
-      20'hE8 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_22}             ; end 
-      20'hEC : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_22}             ; end       
-      20'h13C : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_22}             ; end
+      REG_PSR + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_22}             ; end     
+      REG_ISR + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_22}             ; end 
+      REG_DSR + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_22}             ; end 
+      REG_ICD + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_22}             ; end       
+      REG_TOL + REG_CH4*3   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_22}             ; end
+      REG_DCD + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, DCD_22}             ; end
+      REG_DFL + REG_CH*3    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DFL_22}             ; end
+      REG_AW + REG_CH*3     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_22, 6'h0, AWM_22}             ; end
+      REG_FINE + REG_CH*3   : begin ack <= 1'b1;          rdata <= {{32-1{1'b0}}, gain_fine[3]}             ; end
             
-      20'hF0 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_aa}             ; end     
-      20'hF4 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_aa}             ; end 
-      20'hF8 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_aa}             ; end 
-      20'hFC : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_aa}             ; end      
-      20'h140 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_aa}             ; end
+      REG_PSR + REG_CH*4    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_aa}             ; end     
+      REG_ISR + REG_CH*4    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_aa}             ; end 
+      REG_DSR + REG_CH*4    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_aa}             ; end 
+      REG_ICD + REG_CH*4    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_aa}             ; end      
+      REG_TOL + REG_CH4*4   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_aa}             ; end
+      REG_AW + REG_CH*4     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_aa, 6'h0, AWM_aa}             ; end
             
-      20'h100 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_bb}             ; end     
-      20'h104 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_bb}             ; end 
-      20'h108 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_bb}             ; end 
-      20'h10C : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_bb}             ; end       
-      20'h144 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_bb}             ; end
+      REG_PSR + REG_CH*5    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_bb}             ; end     
+      REG_ISR + REG_CH*5    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_bb}             ; end 
+      REG_DSR + REG_CH*5    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_bb}             ; end 
+      REG_ICD + REG_CH*5    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_bb}             ; end       
+      REG_TOL + REG_CH4*5   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_bb}             ; end
+      REG_AW + REG_CH*5     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_bb, 6'h0, AWM_bb}             ; end
             
-      20'h110 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_cc}             ; end     
-      20'h114 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_cc}             ; end 
-      20'h118 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_cc}             ; end 
-      20'h11C : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_cc}             ; end       
-      20'h148 : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_cc}             ; end
+      REG_PSR + REG_CH*6    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_cc}             ; end     
+      REG_ISR + REG_CH*6    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_cc}             ; end 
+      REG_DSR + REG_CH*6    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_cc}             ; end 
+      REG_ICD + REG_CH*6    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_cc}             ; end       
+      REG_TOL + REG_CH4*6   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_cc}             ; end
+      REG_AW + REG_CH*6     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_cc, 6'h0, AWM_cc}             ; end
             
-      20'h120 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_dd}             ; end     
-      20'h124 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_dd}             ; end 
-      20'h128 : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_dd}             ; end 
-      20'h12C : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_dd}             ; end       
-      20'h14C : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_dd}             ; end     
-     default : begin ack <= 1'b1;          rdata <=  32'h0                              ; end
+      REG_PSR + REG_CH*7    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, PSR_dd}             ; end     
+      REG_ISR + REG_CH*7    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, ISR_dd}             ; end 
+      REG_DSR + REG_CH*7    : begin ack <= 1'b1;          rdata <= {{32-5{1'b0}}, DSR_dd}             ; end 
+      REG_ICD + REG_CH*7    : begin ack <= 1'b1;          rdata <= {{32-30{1'b0}}, ICD_dd}             ; end       
+      REG_TOL + REG_CH4*7   : begin ack <= 1'b1;          rdata <= {{32-9{1'b0}}, TOL_dd}             ; end     
+      REG_AW + REG_CH*7     : begin ack <= 1'b1;          rdata <= {{32-13{1'b0}}, AWK_dd, 6'h0, AWM_dd}             ; end
+     default : begin ack <= 1'b1;          rdata <=  shd_rdata | tlm_rdata | cap_rdata | bode_rdata | ramp_rdata | route_rdata | ff_rdata | bank_rdata | info_rdata  ; end
    endcase
 end
 
@@ -0,0 +1,264 @@
+/**
+Title: Red Pitaya PID Parameter Banks
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Gain schedule of the eight PID channels: four complete parameter sets
+ * per channel, switched in hardware.
+ *
+ *
+ *                  /--------\     /-----\
+ *   bus -------->  | BANK 0 | --> |     |
+ *                  | ...    |     | MUX | ---> live registers (load_o)
+ *                  | BANK 3 | --> |     |
+ *                  \--------/     \-----/
+ *                                    ^
+ *   CFG or DIO_P pair -------------- +
+ *
+ * A bank holds sp, kp, ki, kd, PSR, ISR, DSR, ICD and TOL of one channel.
+ * The bank a channel runs with is selected by CFG or by a pair of DIO_P
+ * pins; when the selection changes, load_o copies the whole bank into the
+ * live registers of red_pitaya_pid.v on one clock edge, like a commit of
+ * the shadow registers, so a phase change of an experiment costs no bus
+ * writes and no partially updated loop. The staged copies follow.
+ *
+ * The pins are synchronised and have to hold the same pair for STABLE
+ * clocks before a switch, so skew between the two pins never selects a
+ * bank in between.
+ *
+ * The integrator holds of all channels come from the same DIO_P pins,
+ * through HOLD (hold_o): a pin that selects banks is taken off hold duty
+ * by clearing HOLD[4] of the channels it holds, or by moving their hold
+ * to another pin. After reset every channel keeps the pin of the original
+ * design: 11 pin 0, 21 pin 1, 12 pin 2, 22 pin 3, the slow channels pins
+ * 4 - 7. The holds are not synchronised, as before.
+ *
+ * A bank written while it is active takes effect on the next switch to it,
+ * or at once with a write of CFG with bit 31 set.
+ *
+ * CFG[12] makes ISR changes of the channel bumpless, the PID datapaths
+ * rescale the integrator with the shift (int_scale_i). Without it the
+ * integrator is kept as it is; Ki changes are bumpless either way, as the
+ * integrator sums error times Ki.
+ *
+ * Registers (channel index n as in red_pitaya_pid.v):
+ *   0x900 + 4*n     CFG: [1:0] bank, [4] select by DIO_P pins instead,
+ *                   [10:8] DIO_P pin p of the pair: bank = {pin p+1, pin p}
+ *                   (pin 7 pairs with pin 0), [12] bumpless ISR, [17:16]
+ *                   active bank (read only), [31] load the selected bank
+ *                   (write only)
+ *   0x920 + 4*n     HOLD: [2:0] DIO_P pin of the integrator hold, [4] hold
+ *                   enabled; reset: enabled, pin as above
+ *   0x30000 + 0x100*n + 0x40*b  bank b of channel n: +0x00 sp, +0x04 kp,
+ *                   +0x08 ki, +0x0C kd, +0x10 PSR, +0x14 ISR, +0x18 DSR,
+ *                   +0x1C ICD, +0x20 TOL, widths as the live registers,
+ *                   gains in the units FINE of the channel selects
+ *
+ * Bank 0 is active after reset and the banks are not cleared, CFG = 0
+ * leaves the live registers alone until a bank is selected.
+ */
+
+
+
+module red_pitaya_pid_bank #(
+   parameter STABLE    = 4 ,             // clocks a DIO_P pair has to hold, 2 - 16
+   parameter FAST_GAIN = 14              // gain width of the fast channels, 14 - 25, fraction above 14 bits
+)
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   input    [   8-1: 0]  dio_i     ,  // DIO_P pins
+   output   [   8-1: 0]  hold_o    ,  // integrator hold of channel n
+   input    [   8-1: 0]  fine_i    ,  // fine gains of channel n, else 14 bit gain words
+
+   // parameters of the selected bank, channel n at [w*n +: w], slow channels in the lower 12 bits
+   output   [   8-1: 0]  load_o    ,  // load the parameters into the live registers of channel n
+   output   [8*14-1: 0]  sp_o      ,  // set point
+   output   [8*FAST_GAIN-1: 0]  kp_o ,  // Kp
+   output   [8*FAST_GAIN-1: 0]  ki_o ,  // Ki
+   output   [8*FAST_GAIN-1: 0]  kd_o ,  // Kd
+   output   [8* 5-1: 0]  psr_o     ,  // PSR
+   output   [8* 5-1: 0]  isr_o     ,  // ISR
+   output   [8* 5-1: 0]  dsr_o     ,  // DSR
+   output   [8*30-1: 0]  icd_o     ,  // ICD
+   output   [8* 9-1: 0]  tol_o     ,  // TOL
+   output   [   8-1: 0]  scale_o   ,  // bumpless ISR changes
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the bank registers
+);
+
+`include "red_pitaya_pid_map.vh"
+
+wire [8*32-1: 0] ch_rdata ;
+
+
+genvar n ;
+generate for (n = 0; n < 8; n = n + 1) begin : ch
+
+   localparam W  = (n < 4) ? 14 : 12 ;          // set point width
+   localparam GW = (n < 4) ? FAST_GAIN : 12 ;   // gain width
+   localparam GF = (n < 4) ? FAST_GAIN - 14 : 0 ; // fractional gain bits
+
+   //---------------------------------------------------------------------------------
+   //  Settings
+
+   reg  [ 2-1: 0] cfg_bank  ;
+   reg            cfg_pin   ;
+   reg  [ 3-1: 0] cfg_dio   ;
+   reg            cfg_scale ;
+   reg            reload    ;
+   reg  [ 3-1: 0] hold_dio  ;
+   reg            hold_en   ;
+
+   wire           cfg_we  = wen_i && (addr_i[19:0] == REG_BANK + REG_CH4*n) ;
+   wire           hold_we = wen_i && (addr_i[19:0] == REG_HOLD + REG_CH4*n) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         {cfg_scale, cfg_dio, cfg_pin, cfg_bank} <= 7'd0 ;
+         reload <= 1'b0 ;
+         // pins of the original design, 21 and 12 swap their indices
+         hold_dio <= (n == 1) ? 3'd2 : (n == 2) ? 3'd1 : n ;
+         hold_en  <= 1'b1 ;
+      end
+      else begin
+         if (cfg_we)
+            {cfg_scale, cfg_dio, cfg_pin, cfg_bank} <= {wdata_i[12], wdata_i[10:8], wdata_i[4], wdata_i[1:0]} ;
+         if (hold_we)
+            {hold_en, hold_dio} <= {wdata_i[4], wdata_i[2:0]} ;
+         // one clock later, so the load sees the new selection
+         reload <= cfg_we && wdata_i[31] ;
+      end
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Banks, distributed RAM written and read back by the bus
+
+   reg  [14-1: 0] b_sp  [0:4-1] ;
+   reg  [FAST_GAIN-1: 0] b_kp  [0:4-1] ;
+   reg  [FAST_GAIN-1: 0] b_ki  [0:4-1] ;
+   reg  [FAST_GAIN-1: 0] b_kd  [0:4-1] ;
+   reg  [ 5-1: 0] b_psr [0:4-1] ;
+   reg  [ 5-1: 0] b_isr [0:4-1] ;
+   reg  [ 5-1: 0] b_dsr [0:4-1] ;
+   reg  [30-1: 0] b_icd [0:4-1] ;
+   reg  [ 9-1: 0] b_tol [0:4-1] ;
+
+   wire           bank_sel = (addr_i[19:8] == 12'h300 + n) ;
+   wire [ 2-1: 0] wb       = addr_i[7:6] ;
+   wire [14-1: 0] wsp      = wdata_i[W-1:0] ;
+   wire [FAST_GAIN-1: 0] wgain = fine_i[n] ? wdata_i[GW-1:0] : wdata_i[GW-GF-1:0] << GF ;
+
+   always @(posedge clk_i) begin
+      if (wen_i && bank_sel) begin
+         case (addr_i[5:2])
+            4'd0 : b_sp [wb] <= wsp ;
+            4'd1 : b_kp [wb] <= wgain ;
+            4'd2 : b_ki [wb] <= wgain ;
+            4'd3 : b_kd [wb] <= wgain ;
+            4'd4 : b_psr[wb] <= wdata_i[ 5-1:0] ;
+            4'd5 : b_isr[wb] <= wdata_i[ 5-1:0] ;
+            4'd6 : b_dsr[wb] <= wdata_i[ 5-1:0] ;
+            4'd7 : b_icd[wb] <= wdata_i[30-1:0] ;
+            4'd8 : b_tol[wb] <= wdata_i[ 9-1:0] ;
+         endcase
+      end
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Selection
+
+   reg  [ 2-1: 0] pin_m   ;             // first synchroniser stage
+   reg  [ 2-1: 0] pin_q   ;
+   reg  [ 4-1: 0] pin_cnt ;             // clocks pin_q has held
+   reg  [ 2-1: 0] pin_sel ;
+   reg  [ 2-1: 0] act     ;
+
+   wire [ 2-1: 0] sel  = cfg_pin ? pin_sel : cfg_bank ;
+   wire           load = rstn_i && ((sel != act) || reload) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         pin_m   <= 2'd0 ;
+         pin_q   <= 2'd0 ;
+         pin_cnt <= 4'd0 ;
+         pin_sel <= 2'd0 ;
+         act     <= 2'd0 ;
+      end
+      else begin
+         pin_m <= {dio_i[cfg_dio + 3'd1], dio_i[cfg_dio]} ;
+         pin_q <= pin_m ;
+         if (pin_m != pin_q)
+            pin_cnt <= 4'd0 ;
+         else if (pin_cnt != STABLE - 1)
+            pin_cnt <= pin_cnt + 4'd1 ;
+         else
+            pin_sel <= pin_q ;
+         act <= sel ;
+      end
+   end
+
+   assign load_o [      n       ] = load ;
+   assign sp_o   [14*n +: 14] = b_sp [sel] ;
+   assign kp_o   [FAST_GAIN*n +: FAST_GAIN] = b_kp [sel] ;
+   assign ki_o   [FAST_GAIN*n +: FAST_GAIN] = b_ki [sel] ;
+   assign kd_o   [FAST_GAIN*n +: FAST_GAIN] = b_kd [sel] ;
+   assign psr_o  [ 5*n +:  5] = b_psr[sel] ;
+   assign isr_o  [ 5*n +:  5] = b_isr[sel] ;
+   assign dsr_o  [ 5*n +:  5] = b_dsr[sel] ;
+   assign icd_o  [30*n +: 30] = b_icd[sel] ;
+   assign tol_o  [ 9*n +:  9] = b_tol[sel] ;
+   assign scale_o[      n       ] = cfg_scale ;
+   assign hold_o [      n       ] = hold_en && dio_i[hold_dio] ;
+
+   //---------------------------------------------------------------------------------
+   //  Read back
+
+   reg  [32-1: 0] bank_rd ;
+
+   always @(*) begin
+      case (addr_i[5:2])
+         4'd0    : bank_rd = {{32-W{1'b0}}, b_sp [wb][W-1:0]} ;
+         4'd1    : bank_rd = {{32-GW{1'b0}}, b_kp [wb][GW-1:0] >> (fine_i[n] ? 0 : GF)} ;
+         4'd2    : bank_rd = {{32-GW{1'b0}}, b_ki [wb][GW-1:0] >> (fine_i[n] ? 0 : GF)} ;
+         4'd3    : bank_rd = {{32-GW{1'b0}}, b_kd [wb][GW-1:0] >> (fine_i[n] ? 0 : GF)} ;
+         4'd4    : bank_rd = {{32- 5{1'b0}}, b_psr[wb]} ;
+         4'd5    : bank_rd = {{32- 5{1'b0}}, b_isr[wb]} ;
+         4'd6    : bank_rd = {{32- 5{1'b0}}, b_dsr[wb]} ;
+         4'd7    : bank_rd = {{32-30{1'b0}}, b_icd[wb]} ;
+         4'd8    : bank_rd = {{32- 9{1'b0}}, b_tol[wb]} ;
+         default : bank_rd = 32'h0 ;
+      endcase
+   end
+
+   assign ch_rdata[32*n +: 32] =
+      bank_sel                           ? bank_rd :
+      (addr_i[19:0] == REG_BANK + REG_CH4*n)  ? {14'h0, act, 3'h0, cfg_scale, 1'b0, cfg_dio, 3'h0, cfg_pin, 2'h0, cfg_bank} :
+      (addr_i[19:0] == REG_HOLD + REG_CH4*n)  ? {27'h0, hold_en, 1'b0, hold_dio} :
+                                           32'h0 ;
+
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+integer j ;
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   for (j = 0; j < 8; j = j + 1)
+      rdata_o = rdata_o | ch_rdata[32*j +: 32] ;
+end
+
+endmodule
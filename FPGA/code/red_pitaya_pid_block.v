@@ -36,12 +36,65 @@ Date: 28/08/2015
  *  - Sample and hold capability is included for integration term
  *  - Integrator reset is included
  *  - User defined lock divider has been implemented for the integrator term
+ *  - Derivative taken over a user defined clock divider (DCD), with an optional
+ *    first or second order low-pass filter (DFL)
+ *  - Anti-windup on the saturation of the final output (AWM, AWK)
+ *  - Feedforward term added to the sum before the saturation (ff_i)
+ *  - Optional bumpless ISR changes (int_scale_i)
+ *  - Telemetry outputs of the error, integrator, P/I/D terms and output, with
+ *    sticky saturation flags of the integrator and the output (cleared by tlm_clr_i)
+ *
+ * Gains are a mantissa of gain_res bits with the PSR/ISR/DSR shift as the
+ * exponent. The three products are registered in DSP48E1 slices (error on
+ * the 18 bit port, gain on the 25 bit port) and scaled by one parameterized
+ * barrel shifter per term (red_pitaya_pid_shift.v). With gain_res above
+ * adc_res the extra gain bits are fractional: the shifts grow by
+ * gain_res - adc_res, so a resolution setting keeps its meaning and a gain
+ * written shifted up by that much gives the old result exactly. int_res
+ * widens the integrator for the larger products.
+ *
+ * With the default widths the datapath is bit-exact with the previous case
+ * table implementation, see red_pitaya_pid_block_tb. Gain writes take effect
+ * one clock later than before.
+ *
+ * The derivative is the difference of the scaled Kd product over DCD + 1
+ * clocks, updated every DCD + 1 clocks, so it sees the slope over a useful
+ * time base instead of the ADC noise between two samples. DFL[3:0] = k
+ * selects a low-pass of y += (x - y) / 2^k per update on the difference
+ * (corner near f_update / (2 pi 2^k)), DFL[4] a second identical section
+ * after it. DCD = 0 and DFL = 0 give the one clock difference of before.
+ *
+ * Anti-windup looks at the output after all clamping: the saturation of this
+ * block plus the excess of the output stage it feeds (sat_exc_i, clamped
+ * minus unclamped sum, 0 when in range), so a block that is in range itself
+ * still sees the clamp of the two block sum. AWM[0] selects conditional
+ * integration: the integrator holds while the output is clamped and the
+ * integral would push further into the clamp. AWM[1] selects
+ * back-calculation: the excess, scaled to integrator units by ISR and by
+ * 2^-AWK, is added on every integrator update, which bleeds the integrator
+ * back to the value that just holds the output at the limit. The excess
+ * reaches the integrator about four clocks after the output it comes from,
+ * so with ICD = 0 a gain of 1 or 1/2 corrects the same excess several times
+ * over and limit-cycles; AWK below 3 acts as 3. AWM = 0 keeps the
+ * integrator as it was, limited by its own width only.
+ *
+ * The feedforward term ff_i (output counts, from red_pitaya_pid_ff.v) adds
+ * to the P, I and D terms before the output saturation, so the saturation
+ * flags and the anti-windup see it like any other part of the output.
+ *
+ * With int_scale_i set, a change of ISR shifts the integrator by the same
+ * number of bits on the clock the new ISR reaches the I term, so the I term
+ * carries on where it was (up to the bits shifted out, or the integrator
+ * limit). ISR takes effect one clock later then; without int_scale_i the
+ * datapath is unchanged.
  */ 
 
 
 
 module red_pitaya_pid_block #(
-   parameter	 adc_res = 14 			// ADC resolution
+   parameter	 adc_res  = 14 ,		// ADC resolution
+   parameter	 gain_res = adc_res ,	// Kp/Ki/Kd width, up to 25
+   parameter	 int_res  = 32  		// integrator width, 32 or more and at least adc_res + 1 + gain_res
 )
 (
    // data  
@@ -52,18 +105,35 @@ module red_pitaya_pid_block #(
 
    // PID parameters 
    input [adc_res-1:0] set_sp_i, // set point
-   input [adc_res-1:0] set_kp_i, // Kp
-   input [adc_res-1:0] set_ki_i, // Ki
-   input [adc_res-1:0] set_kd_i, // Kd
+   input [gain_res-1:0] set_kp_i, // Kp
+   input [gain_res-1:0] set_ki_i, // Ki
+   input [gain_res-1:0] set_kd_i, // Kd
    input int_rst_i, // integrator reset
    input int_hold , // sample and hold
+   input int_scale_i , // rescale the integrator on ISR changes
    
    // advanced parameters
    input [5-1:0] PSR,  // Proportional Signal Resolution
    input [5-1:0] ISR,  // Integral Signal Resolution
    input [5-1:0] DSR,  // Derivative Signal Resolution
    input [30-1:0]ICD,  // Integral Clock Divider
-   input [9-1:0] TOL   // Tolerance 
+   input [9-1:0] TOL,  // Tolerance 
+   input [30-1:0]DCD,  // Derivative Clock Divider
+   input [5-1:0] DFL,  // Derivative Filter, [3:0] shift (0 = off), [4] second order
+   input [2-1:0] AWM,  // Anti-Windup Mode, [0] conditional integration, [1] back-calculation
+   input [5-1:0] AWK,  // Anti-Windup tracking gain, 2^-AWK
+   input [adc_res+3-1:0] sat_exc_i, // excess of the output stage, clamped - unclamped sum
+   input [16-1:0] ff_i,  // feedforward term, output counts
+
+   // telemetry
+   input tlm_clr_i,                // clear sticky saturation flags
+   output [32-1:0] tlm_err_o,      // error, sign extended
+   output [32-1:0] tlm_int_o,      // integrator register, upper 32 bits
+   output [32-1:0] tlm_p_o,        // proportional term, sign extended
+   output [32-1:0] tlm_i_o,        // integral term
+   output [32-1:0] tlm_d_o,        // derivative term, sign extended
+   output [2-1:0]  tlm_sat_o,      // sticky saturation {output, integrator}
+   output [2-1:0]  sat_o           // saturation in this cycle {output, integrator}
 );
 
 
@@ -74,7 +144,9 @@ module red_pitaya_pid_block #(
 
 
 
-localparam MAXWIDTH = adc_res*2 + 1;
+localparam GX       = gain_res - adc_res ;                    // extra fractional gain bits
+localparam MAXWIDTH = adc_res + 1 + gain_res ;                // error times gain
+localparam SUMWIDTH = ((int_res > MAXWIDTH + 1) ? int_res : MAXWIDTH + 1) + 2 ;
 
 reg  [ (adc_res+1)-1: 0] error        ;
 reg  [ (adc_res+1)-1: 0] err_temp        ;
@@ -93,6 +165,38 @@ end
 
 
 
+//---------------------------------------------------------------------------------
+//  Gain products
+//---------------------------------------------------------------------------------
+
+
+
+// The error register is cleared one clock after abs_temp falls inside the
+// tolerance, so the products are formed from err_temp in parallel and
+// cleared under the same condition: error * gain one clock after error,
+// registered in the DSP48 (M register with synchronous reset).
+
+wire err_zero = (abs_temp < TOL) ;
+
+(* use_dsp48 = "yes" *) reg [MAXWIDTH-1: 0] kp_prd ;
+(* use_dsp48 = "yes" *) reg [MAXWIDTH-1: 0] ki_prd ;
+(* use_dsp48 = "yes" *) reg [MAXWIDTH-1: 0] kd_prd ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0 || err_zero) begin
+      kp_prd <= {MAXWIDTH{1'b0}};
+      ki_prd <= {MAXWIDTH{1'b0}};
+      kd_prd <= {MAXWIDTH{1'b0}};
+   end else begin
+      kp_prd <= $signed(err_temp) * $signed(set_kp_i) ;
+      ki_prd <= $signed(err_temp) * $signed(set_ki_i) ;
+      kd_prd <= $signed(err_temp) * $signed(set_kd_i) ;
+   end
+end
+
+
+
+
 //---------------------------------------------------------------------------------
 //  Proportional Term
 //---------------------------------------------------------------------------------
@@ -100,32 +204,24 @@ end
 
 
 reg   [    MAXWIDTH-1: 0] kp_reg        ;
-wire  [    MAXWIDTH-1: 0] kp_mult       ;
+wire  [    MAXWIDTH-1: 0] kp_shr        ;
+
+// set the proportional term resolution i.e. the number of bits to include in the final PID summation
+red_pitaya_pid_shift #(.W (MAXWIDTH), .LO (5), .HI (15), .DEF (12), .OFS (GX)) i_kp_shr
+(
+  .dat_i  (  kp_prd  ),
+  .sh_i   (  PSR     ),
+  .dat_o  (  kp_shr  )
+);
 
 always @(posedge clk_i) begin
    if (rstn_i == 1'b0) begin
       kp_reg  <= {MAXWIDTH{1'b0}};
    end else begin
-       // set the proportional term resolution i.e. the number of bits to include in the final PID summation
-      case (PSR)
-          5'd5:    kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{5{1'b1}}, {kp_mult[MAXWIDTH-1:5]}} : {{5{1'b0}}, {kp_mult[MAXWIDTH-1:5]}} ;   
-          5'd6:    kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{6{1'b1}}, {kp_mult[MAXWIDTH-1:6]}} : {{6{1'b0}}, {kp_mult[MAXWIDTH-1:6]}} ;   
-          5'd7:    kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{7{1'b1}}, {kp_mult[MAXWIDTH-1:7]}} : {{7{1'b0}}, {kp_mult[MAXWIDTH-1:7]}} ;
-          5'd8:    kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{8{1'b1}}, {kp_mult[MAXWIDTH-1:8]}} : {{8{1'b0}}, {kp_mult[MAXWIDTH-1:8]}} ;  
-          5'd9:    kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{9{1'b1}}, {kp_mult[MAXWIDTH-1:9]}} : {{9{1'b0}}, {kp_mult[MAXWIDTH-1:9]}} ;   
-          5'd10:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{10{1'b1}}, {kp_mult[MAXWIDTH-1:10]}} : {{10{1'b0}}, {kp_mult[MAXWIDTH-1:10]}} ;  
-          5'd11:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{11{1'b1}}, {kp_mult[MAXWIDTH-1:11]}} : {{11{1'b0}}, {kp_mult[MAXWIDTH-1:11]}} ;   
-          5'd12:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{12{1'b1}}, {kp_mult[MAXWIDTH-1:12]}} : {{12{1'b0}}, {kp_mult[MAXWIDTH-1:12]}} ;    
-          5'd13:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{13{1'b1}}, {kp_mult[MAXWIDTH-1:13]}} : {{13{1'b0}}, {kp_mult[MAXWIDTH-1:13]}} ;   
-          5'd14:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{14{1'b1}}, {kp_mult[MAXWIDTH-1:14]}} : {{14{1'b0}}, {kp_mult[MAXWIDTH-1:14]}} ;   
-          5'd15:   kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{15{1'b1}}, {kp_mult[MAXWIDTH-1:15]}} : {{15{1'b0}}, {kp_mult[MAXWIDTH-1:15]}} ;        
-          default:       kp_reg <= (kp_mult[MAXWIDTH-1] == 1'b1) ? {{12{1'b1}}, {kp_mult[MAXWIDTH-1:12]}} : {{12{1'b0}}, {kp_mult[MAXWIDTH-1:12]}} ;
-     endcase       
+      kp_reg  <= kp_shr ;
    end
 end
 
-assign kp_mult = $signed(error) * $signed(set_kp_i); 
-
 
 
 //---------------------------------------------------------------------------------
@@ -135,74 +231,152 @@ assign kp_mult = $signed(error) * $signed(set_kp_i);
 
 
 
-reg  [29-1: 0] ki_mult; 
-wire [33-1: 0] int_sum;	
-reg  [32-1: 0] int_reg;	
-reg  [32-1: 0] int_shr;  
+// anti-windup: total excess of the output after every clamp, in output
+// counts (negative while clamped at the top), limited to the output stage
+// range and scaled to integrator units for the back-calculation
+
+localparam EW = adc_res + 3 ;                                 // excess width
+localparam TW = EW + 24 + GX + 1 ;                            // tracking term width
+localparam IW = ((int_res > TW) ? int_res : TW) + 2 ;         // integrator sum width
+
+reg  [SUMWIDTH-1: 0] out_exc ;                                // clamped - unclamped block output
+wire [SUMWIDTH  : 0] exc_tot = $signed(out_exc) + $signed(sat_exc_i) ;
+wire                 exc_pos = ($signed(exc_tot) > $signed({1'b0, {EW-1{1'b1}}})) ;
+wire                 exc_neg = ($signed(exc_tot) < $signed({1'b1, {EW-1{1'b0}}})) ;
+wire [      EW-1: 0] exc_lim = exc_pos ? {1'b0, {EW-1{1'b1}}} : exc_neg ? {1'b1, {EW-1{1'b0}}} : exc_tot[EW-1:0] ;
+wire [       6-1: 0] isr_eff = ((ISR >= 14 && ISR <= 24) ? ISR : 5'd18) + GX ;
+wire signed [TW-1: 0] exc_ext = $signed(exc_lim) ;
+wire [      TW-1: 0] trk_shr ;
+reg  [      TW-1: 0] trk ;
+reg                  clamp_hi ;
+reg                  clamp_lo ;
+
+red_pitaya_pid_shift #(.W (TW), .LO (3), .HI (31), .DEF (3), .OFS (0)) i_trk_shr
+(
+  .dat_i  (  exc_ext <<< isr_eff  ),
+  .sh_i   (  AWK                  ),
+  .dat_o  (  trk_shr              )
+);
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      trk      <= {TW{1'b0}};
+      clamp_hi <= 1'b0;
+      clamp_lo <= 1'b0;
+   end else begin
+      trk      <= AWM[1] ? trk_shr : {TW{1'b0}};
+      clamp_hi <= AWM[0] && ($signed(exc_tot) < 0);
+      clamp_lo <= AWM[0] && ($signed(exc_tot) > 0);
+   end
+end
+
+
+
+reg  [MAXWIDTH-1: 0] ki_mult; 
+wire [    IW-1: 0] int_sum;
+reg  [int_res-1: 0] int_reg;	
+reg  [int_res-1: 0] int_shr;  
+wire [int_res-1: 0] ki_shr;
 reg  [27-1: 0] counter;
+reg            int_sat;
+reg            int_lim;
+
+// conditional integration: no integral step that drives further into the
+// clamp, the tracking term still applies
+// bumpless ISR changes: the integrator is rescaled on the clock isr_use
+// takes the new value, so int_reg >> isr_use stays the same
+wire [       5-1: 0] isr_new = (ISR >= 14 && ISR <= 24) ? ISR : 5'd18 ;
+reg  [       5-1: 0] isr_use ;
+wire                 int_scl = int_scale_i && (isr_new != isr_use) ;
+wire [int_res+10-1: 0] int_up = {{10{int_reg[int_res-1]}}, int_reg} << (isr_new - isr_use) ;
+wire [int_res-1: 0] int_dn = $signed(int_reg) >>> (isr_use - isr_new) ;
+wire                 int_ovf = (int_up[int_res+10-1:int_res-1] != {11{int_reg[int_res-1]}}) ;
+wire [int_res-1: 0] int_scaled = (isr_new < isr_use) ? int_dn :
+                                 !int_ovf ? int_up[int_res-1:0] :
+                                 int_reg[int_res-1] ? {1'b1, {int_res-1{1'b0}}} : {1'b0, {int_res-1{1'b1}}} ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0)
+      isr_use <= 5'd18 ;
+   else
+      isr_use <= isr_new ;
+end
+
+wire int_freeze = (clamp_hi && !ki_mult[MAXWIDTH-1] && (ki_mult != {MAXWIDTH{1'b0}})) ||
+                  (clamp_lo && ki_mult[MAXWIDTH-1]) ;
+wire [MAXWIDTH-1: 0] ki_step = int_freeze ? {MAXWIDTH{1'b0}} : ki_mult ;
 
 always @(posedge clk_i) begin
 
    if (rstn_i == 1'b0) begin
-      ki_mult <= {29{1'b0}};
-      int_reg <= {32{1'b0}};
+      ki_mult <= {MAXWIDTH{1'b0}};
+      int_reg <= {int_res{1'b0}};
       counter <= {27{1'b0}};
+      int_sat <= 1'b0;
+      int_lim <= 1'b0;
    end else begin
        
+      if (tlm_clr_i)
+         int_sat <= 1'b0;
+      int_lim <= 1'b0;
+
       counter = (counter >= $unsigned(ICD)) ? 27'h0 : counter + 27'h1;
 
       if (int_rst_i) begin // integrator reset
         
-         ki_mult <=  $signed(error) * $signed(set_ki_i)  ;
-         int_reg <= 32'h0;
+         ki_mult <= ki_prd ;
+         int_reg <= {int_res{1'b0}};
     
+      end else if (int_scl) begin // integrator rescale to the new ISR
+
+         ki_mult <= ki_prd ;
+         int_reg <= int_scaled ;
+
       end else if(int_hold) begin // integrator sample-and-hold
         
-         ki_mult <= {29{1'b0}};
-         int_reg <= int_reg[32-1:0];
+         ki_mult <= {MAXWIDTH{1'b0}};
+         int_reg <= int_reg ;
            
       end else if(counter != ICD) begin // integrator clock division
         
-           ki_mult <=  $signed(error) * $signed(set_ki_i)  ;
-           int_reg <= int_reg[32-1:0]; // use reg as it is
+           ki_mult <= ki_prd ;
+           int_reg <= int_reg ; // use reg as it is
            
-      end else if (int_sum[33-1:33-2] == 2'b01) begin // positive saturation
+      end else if ($signed(int_sum) > $signed({1'b0, {int_res-1{1'b1}}})) begin // positive saturation
       
-         ki_mult <=  $signed(error) * $signed(set_ki_i)  ;
-         int_reg <= 32'h7FFFFFFF; // max positive     
+         ki_mult <= ki_prd ;
+         int_reg <= {1'b0, {int_res-1{1'b1}}}; // max positive     
+         int_sat <= 1'b1;
+         int_lim <= 1'b1;
             
-      end else if (int_sum[33-1:33-2] == 2'b10) begin // negative saturation  
+      end else if ($signed(int_sum) < $signed({1'b1, {int_res-1{1'b0}}})) begin // negative saturation  
         
-         ki_mult <=  $signed(error) * $signed(set_ki_i)  ;
-         int_reg <= 32'h80000000; // max negative   
+         ki_mult <= ki_prd ;
+         int_reg <= {1'b1, {int_res-1{1'b0}}}; // max negative   
+         int_sat <= 1'b1;
+         int_lim <= 1'b1;
          
       end else begin 
       
-         ki_mult <=  $signed(error) * $signed(set_ki_i)  ;
-         int_reg <= int_sum[32-1:0]; // use sum as it is
+         ki_mult <= ki_prd ;
+         int_reg <= int_sum[int_res-1:0]; // use sum as it is
          
       end
    end
 end
 
-assign int_sum = $signed(ki_mult) + $signed(int_reg) ;
+assign int_sum = $signed(ki_step) + $signed(int_reg) + $signed(trk) ;
+
+// integral term resolution
+red_pitaya_pid_shift #(.W (int_res), .LO (14), .HI (24), .DEF (18), .OFS (GX)) i_ki_shr
+(
+  .dat_i  (  int_reg      ),
+  .sh_i   (  int_scale_i ? isr_use : ISR  ),
+  .dat_o  (  ki_shr  )
+);
 
 always @(posedge clk_i) begin
-    // integral term resolution
-    case (ISR)
-          5'd14:   int_shr <= (int_reg[32-1] == 1'b1) ? {{14{1'b1}}, {int_reg[32-1:14]}} : {{14{1'b0}}, {int_reg[32-1:14]}};   
-          5'd15:   int_shr <= (int_reg[32-1] == 1'b1) ? {{15{1'b1}}, {int_reg[32-1:15]}} : {{15{1'b0}}, {int_reg[32-1:15]}};     
-          5'd16:   int_shr <= (int_reg[32-1] == 1'b1) ? {{16{1'b1}}, {int_reg[32-1:16]}} : {{16{1'b0}}, {int_reg[32-1:16]}}; 
-          5'd17:   int_shr <= (int_reg[32-1] == 1'b1) ? {{17{1'b1}}, {int_reg[32-1:17]}} : {{17{1'b0}}, {int_reg[32-1:17]}};   
-          5'd18:   int_shr <= (int_reg[32-1] == 1'b1) ? {{18{1'b1}}, {int_reg[32-1:18]}} : {{18{1'b0}}, {int_reg[32-1:18]}};  
-          5'd19:   int_shr <= (int_reg[32-1] == 1'b1) ? {{19{1'b1}}, {int_reg[32-1:19]}} : {{19{1'b0}}, {int_reg[32-1:19]}};  
-          5'd20:   int_shr <= (int_reg[32-1] == 1'b1) ? {{20{1'b1}}, {int_reg[32-1:20]}} : {{20{1'b0}}, {int_reg[32-1:20]}};  
-          5'd21:   int_shr <= (int_reg[32-1] == 1'b1) ? {{21{1'b1}}, {int_reg[32-1:21]}} : {{21{1'b0}}, {int_reg[32-1:21]}}; 
-          5'd22:   int_shr <= (int_reg[32-1] == 1'b1) ? {{22{1'b1}}, {int_reg[32-1:22]}} : {{22{1'b0}}, {int_reg[32-1:22]}};   
-          5'd23:   int_shr <= (int_reg[32-1] == 1'b1) ? {{23{1'b1}}, {int_reg[32-1:23]}} : {{23{1'b0}}, {int_reg[32-1:23]}};       
-          5'd24:   int_shr <= (int_reg[32-1] == 1'b1) ? {{24{1'b1}}, {int_reg[32-1:24]}} : {{24{1'b0}}, {int_reg[32-1:24]}};        
-          default: int_shr <= (int_reg[32-1] == 1'b1) ? {{18{1'b1}}, {int_reg[32-1:18]}} : {{18{1'b0}}, {int_reg[32-1:18]}}; 
-   endcase       
+   int_shr <= ki_shr ;
 end
 
 
@@ -214,40 +388,90 @@ end
 
 
 
-wire  [MAXWIDTH-1: 0] kd_mult;
+localparam DFRAC = 16 ;                                       // fractional bits of the filter
+
+wire  [MAXWIDTH-1: 0] kd_shr;
 reg   [MAXWIDTH-1: 0] kd_reg;
 reg   [MAXWIDTH-1: 0] kd_reg_r;
 reg   [MAXWIDTH  : 0] kd_reg_s;
+reg   [30-1: 0] d_cnt;
+wire            d_tick = (d_cnt == DCD) ;
 
+// derivative term resolution
+red_pitaya_pid_shift #(.W (MAXWIDTH), .LO (3), .HI (13), .DEF (10), .OFS (GX)) i_kd_shr
+(
+  .dat_i  (  kd_prd  ),
+  .sh_i   (  DSR     ),
+  .dat_o  (  kd_shr  )
+);
+
+// difference over DCD + 1 clocks, held between the updates
 always @(posedge clk_i) begin
    if (rstn_i == 1'b0) begin
       kd_reg   <= {MAXWIDTH{1'b0}};
       kd_reg_r <= {MAXWIDTH{1'b0}};
       kd_reg_s <= {MAXWIDTH+1{1'b0}};
+      d_cnt    <= 30'h0;
+   end
+   else begin
+      d_cnt    <= (d_cnt >= DCD) ? 30'h0 : d_cnt + 30'h1;
+      kd_reg   <= kd_shr;
+      if (d_tick) begin
+         kd_reg_r <= kd_reg;
+         kd_reg_s <=  $signed(kd_reg) - $signed(kd_reg_r);
+      end
+   end
+end
+
+// low-pass sections, each updated one clock after its input
+reg   [MAXWIDTH+DFRAC  : 0] kd_f1;
+reg   [MAXWIDTH+DFRAC  : 0] kd_f2;
+wire  [MAXWIDTH+DFRAC+1: 0] kd_f1_d = $signed({kd_reg_s, {DFRAC{1'b0}}}) - $signed(kd_f1) ;
+wire  [MAXWIDTH+DFRAC+1: 0] kd_f2_d = $signed(kd_f1) - $signed(kd_f2) ;
+wire  [MAXWIDTH+DFRAC+1: 0] kd_f1_s;
+wire  [MAXWIDTH+DFRAC+1: 0] kd_f2_s;
+wire  [MAXWIDTH+DFRAC+1: 0] kd_f_rnd;
+reg   [ 2-1: 0] d_tick_r;
+
+red_pitaya_pid_shift #(.W (MAXWIDTH+DFRAC+2), .LO (1), .HI (15), .DEF (15), .OFS (0)) i_kd_f1_shr
+(
+  .dat_i  (  kd_f1_d         ),
+  .sh_i   (  {1'b0, DFL[3:0]} ),
+  .dat_o  (  kd_f1_s         )
+);
+
+red_pitaya_pid_shift #(.W (MAXWIDTH+DFRAC+2), .LO (1), .HI (15), .DEF (15), .OFS (0)) i_kd_f2_shr
+(
+  .dat_i  (  kd_f2_d         ),
+  .sh_i   (  {1'b0, DFL[3:0]} ),
+  .dat_o  (  kd_f2_s         )
+);
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      kd_f1    <= {MAXWIDTH+DFRAC+1{1'b0}};
+      kd_f2    <= {MAXWIDTH+DFRAC+1{1'b0}};
+      d_tick_r <= 2'b0;
    end
    else begin
-       // derivative term resolution
-       case (DSR)
-               5'd3:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{3{1'b1}}, {kd_mult[MAXWIDTH-1:3]}} : {{3{1'b0}}, {kd_mult[MAXWIDTH-1:3]}} ; 
-               5'd4:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{4{1'b1}}, {kd_mult[MAXWIDTH-1:4]}} : {{4{1'b0}}, {kd_mult[MAXWIDTH-1:4]}} ; 
-               5'd5:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{5{1'b1}}, {kd_mult[MAXWIDTH-1:5]}} : {{5{1'b0}}, {kd_mult[MAXWIDTH-1:5]}} ;  
-               5'd6:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{6{1'b1}}, {kd_mult[MAXWIDTH-1:6]}} : {{6{1'b0}}, {kd_mult[MAXWIDTH-1:6]}} ;   
-               5'd7:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{7{1'b1}}, {kd_mult[MAXWIDTH-1:7]}} : {{7{1'b0}}, {kd_mult[MAXWIDTH-1:7]}} ; 
-               5'd8:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{8{1'b1}}, {kd_mult[MAXWIDTH-1:8]}} : {{8{1'b0}}, {kd_mult[MAXWIDTH-1:8]}} ; 
-               5'd9:    kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{9{1'b1}}, {kd_mult[MAXWIDTH-1:9]}} : {{9{1'b0}}, {kd_mult[MAXWIDTH-1:9]}} ;    
-               5'd10:   kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{10{1'b1}}, {kd_mult[MAXWIDTH-1:10]}} : {{10{1'b0}}, {kd_mult[MAXWIDTH-1:10]}} ;   
-               5'd11:   kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{11{1'b1}}, {kd_mult[MAXWIDTH-1:11]}} : {{11{1'b0}}, {kd_mult[MAXWIDTH-1:11]}} ;  
-               5'd12:   kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{12{1'b1}}, {kd_mult[MAXWIDTH-1:12]}} : {{12{1'b0}}, {kd_mult[MAXWIDTH-1:12]}} ;   
-               5'd13:   kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{13{1'b1}}, {kd_mult[MAXWIDTH-1:13]}} : {{13{1'b0}}, {kd_mult[MAXWIDTH-1:13]}} ;  
-               default:  kd_reg <= (kd_mult[MAXWIDTH-1] == 1'b1) ? {{10{1'b1}}, {kd_mult[MAXWIDTH-1:10]}} : {{10{1'b0}}, {kd_mult[MAXWIDTH-1:10]}} ;   
-      endcase       
-          
-      kd_reg_r <= kd_reg;
-      kd_reg_s <=  $signed(kd_reg) - $signed(kd_reg_r);
+      d_tick_r <= {d_tick_r[0], d_tick};
+      if (DFL[3:0] == 4'h0) begin // filter off, the sections follow the difference
+         kd_f1 <= {kd_reg_s, {DFRAC{1'b0}}};
+         kd_f2 <= {kd_reg_s, {DFRAC{1'b0}}};
+      end
+      else begin
+         if (d_tick_r[0])
+            kd_f1 <= $signed(kd_f1) + $signed(kd_f1_s);
+         if (d_tick_r[1])
+            kd_f2 <= $signed(kd_f2) + $signed(kd_f2_s);
+      end
    end
 end
 
-assign kd_mult = $signed(error) * $signed(set_kd_i) ;
+// the state settles within 2^k of the input, rounding keeps a zero slope at zero
+assign kd_f_rnd = $signed(DFL[4] ? kd_f2 : kd_f1) + $signed({1'b0, 1'b1, {DFRAC-1{1'b0}}}) ;
+
+wire  [MAXWIDTH  : 0] kd_term = (DFL[3:0] == 4'h0) ? kd_reg_s : kd_f_rnd[MAXWIDTH+DFRAC : DFRAC] ;
 
 
 
@@ -256,41 +480,57 @@ assign kd_mult = $signed(error) * $signed(set_kd_i) ;
 //---------------------------------------------------------------------------------
 
 
-wire  [   33-1: 0] pid_sum     ; 
+wire  [   SUMWIDTH-1: 0] pid_sum     ; 
 reg   [   adc_res-1: 0] pid_out     ;
-reg int_rst;
+reg                     out_sat     ;
+reg                     out_lim     ;
+
 always @(posedge clk_i) begin
 
     if (rstn_i == 1'b0) begin
           pid_out  <= {adc_res{1'b0}} ; 
+          out_sat  <= 1'b0 ;
+          out_lim  <= 1'b0 ;
+          out_exc  <= {SUMWIDTH{1'b0}} ;
     end else begin
     
-        if(adc_res == 14) begin // fast adc (14 bit)
-         
-              if ({pid_sum[33-1],|pid_sum[32-2:13]} == 2'b01)  begin //positive overflow
-                    pid_out <= 14'h1FFF ; 
-              end else if ({pid_sum[33-1],&pid_sum[33-2:13]} == 2'b10) begin //negative overflow      	
-                    pid_out <= 14'h2000 ; 
-             end else begin
-                    pid_out <= pid_sum[14-1:0] ;
-              end
-                        
-         end else if(adc_res == 12) begin // slow adc (12 bit)
-                
-              if ({pid_sum[33-1],|pid_sum[32-2:11]} == 2'b01)  begin //positive overflow
-                    pid_out <= 12'h7FF ;
-              end else if ({pid_sum[33-1],&pid_sum[33-2:11]} == 2'b10) begin //negative overflow  
-                    pid_out <= 12'h800 ; 
-              end else begin                
-                    pid_out <= pid_sum[12-1:0] ;
-              end
-           
-         end     
+        if (tlm_clr_i)
+              out_sat <= 1'b0 ;
+        out_lim <= 1'b0 ;
+        out_exc <= {SUMWIDTH{1'b0}} ;
+    
+        if ({pid_sum[SUMWIDTH-1],|pid_sum[SUMWIDTH-2:adc_res-1]} == 2'b01)  begin //positive overflow
+              pid_out <= {1'b0, {adc_res-1{1'b1}}} ; 
+              out_sat <= 1'b1 ;
+              out_lim <= 1'b1 ;
+              out_exc <= $signed({1'b0, {adc_res-1{1'b1}}}) - $signed(pid_sum) ;
+        end else if ({pid_sum[SUMWIDTH-1],&pid_sum[SUMWIDTH-2:adc_res-1]} == 2'b10) begin //negative overflow      	
+              pid_out <= {1'b1, {adc_res-1{1'b0}}} ; 
+              out_sat <= 1'b1 ;
+              out_lim <= 1'b1 ;
+              out_exc <= $signed({1'b1, {adc_res-1{1'b0}}}) - $signed(pid_sum) ;
+        end else begin
+              pid_out <= pid_sum[adc_res-1:0] ;
+        end
     end 
 end
 
-assign pid_sum = $signed(kp_reg) + $signed(int_shr) + $signed(kd_reg_s) ;
+assign pid_sum = $signed(kp_reg) + $signed(int_shr) + $signed(kd_term) + $signed(ff_i) ;
 assign dat_o = pid_out ;
+
+
+
+//---------------------------------------------------------------------------------
+//  Telemetry
+//---------------------------------------------------------------------------------
+
+assign tlm_err_o = {{32-(adc_res+1){error[adc_res]}}, error} ;
+assign tlm_int_o = int_reg[int_res-1 -: 32] ;
+assign tlm_p_o   = $signed(kp_reg) ;
+assign tlm_i_o   = $signed(int_shr) ;
+assign tlm_d_o   = $signed(kd_term) ;
+assign tlm_sat_o = {out_sat, int_sat} ;
+assign sat_o     = {out_lim, int_lim} ;
  
 
 
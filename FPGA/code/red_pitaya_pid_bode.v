@@ -0,0 +1,420 @@
+/**
+Title: Red Pitaya PID Loop Analyzer
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Swept-sine measurement of the loops of the PID channels.
+ *
+ *
+ *            /-----\     /-----\                  excitation to the set point
+ *   FREQ --> | DDS | -+-> | AMP | ---------------> or output of one channel
+ *            \-----/  |   \-----/
+ *                     | sin, cos
+ *                     v
+ *   channel  /-----\     /-----\     /---------\
+ *   signals -| MUX |---> | SAT |---> | I/Q ACC | ---> bus
+ *            \-----/     \-----/     \---------/
+ *
+ * A direct digital synthesizer (32 bit phase, quarter wave table of 256
+ * entries) drives a sine of AMP counts, which the top level adds to the set
+ * point or the output of the selected channel. Two traces (A and B) of the
+ * channel, selected as for the capture buffer or the excitation itself, are
+ * saturated to 16 bits and multiplied with the sine and cosine of the
+ * synthesizer phase. The products are summed into four 64 bit accumulators,
+ * so the host reads one complex amplitude per trace and frequency point:
+ *
+ *   I = sum x * sin,  Q = sum x * cos,  x = (I + jQ) * 2 / (N * 32767)
+ *
+ * for a trace x = |x| sin(wt + phi) over an integer number of periods; the
+ * phase is atan2(Q, I) relative to the excitation.
+ *
+ * A start resets the phase and the accumulators, waits SETTLE clocks for the
+ * loop to reach its steady state and then accumulates LENGTH samples. The
+ * excitation stays on after the point is done, so the next frequency can be
+ * started without a step, until a stop.
+ *
+ * Registers (offset in the PID window):
+ *   0x580  control  w: bit 0 start, bit 1 stop
+ *                   r: bit 0 running, bit 1 done, bit 2 excitation on
+ *   0x584  source   [2:0] channel, [5:4] injection (0 none, 1 set point,
+ *                   2 output), [10:8] trace A, [14:12] trace B
+ *   0x588  phase increment per clock, f = FREQ * 125 MHz / 2^32
+ *   0x58C  amplitude in counts, 0 - 32767
+ *   0x590  settling clocks
+ *   0x594  accumulated samples
+ *   0x598  samples accumulated so far (read only)
+ *   0x5A0 - 0x5BC  accumulators A I, A Q, B I, B Q, lower word first (read only)
+ */
+
+
+
+module red_pitaya_pid_bode
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   // signals of all channels, sign extended to 32 bits, channel n at [32*n +: 32]
+   input    [8*32-1: 0]  adc_i     ,  // input
+   input    [8*32-1: 0]  err_i     ,  // error
+   input    [8*32-1: 0]  p_i       ,  // proportional term
+   input    [8*32-1: 0]  i_i       ,  // integral term
+   input    [8*32-1: 0]  d_i       ,  // derivative term
+   input    [8*32-1: 0]  out_i     ,  // PID block output
+   input    [8*32-1: 0]  int_i     ,  // integrator register
+
+   // excitation
+   output reg [ 16-1: 0] exc_o     ,  // signed, 0 while off
+   output reg [  8-1: 0] inj_sp_o  ,  // channels to add it to the set point
+   output reg [  8-1: 0] inj_out_o ,  // channels to add it to the output
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the analyzer registers
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Configuration
+//---------------------------------------------------------------------------------
+
+reg  [  3-1: 0] cfg_ch      ;
+reg  [  2-1: 0] cfg_inj     ;
+reg  [  3-1: 0] cfg_sig_a   ;
+reg  [  3-1: 0] cfg_sig_b   ;
+reg  [ 32-1: 0] cfg_freq    ;
+reg  [ 15-1: 0] cfg_amp     ;
+reg  [ 32-1: 0] cfg_settle  ;
+reg  [ 32-1: 0] cfg_len     ;
+
+wire            ctrl_wr  = wen_i && (addr_i[19:0] == 20'h580) ;
+wire            start    = ctrl_wr && wdata_i[0] ;
+wire            stop     = ctrl_wr && wdata_i[1] ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      cfg_ch     <=  3'd0 ;
+      cfg_inj    <=  2'd0 ;
+      cfg_sig_a  <=  3'd5 ;
+      cfg_sig_b  <=  3'd7 ;
+      cfg_freq   <= 32'd0 ;
+      cfg_amp    <= 15'd0 ;
+      cfg_settle <= 32'd0 ;
+      cfg_len    <= 32'd0 ;
+   end
+   else if (wen_i) begin
+      if (addr_i[19:0] == 20'h584)  {cfg_sig_b, cfg_sig_a, cfg_inj, cfg_ch} <= {wdata_i[14:12], wdata_i[10:8], wdata_i[5:4], wdata_i[2:0]} ;
+      if (addr_i[19:0] == 20'h588)  cfg_freq   <= wdata_i ;
+      if (addr_i[19:0] == 20'h58C)  cfg_amp    <= wdata_i[15-1:0] ;
+      if (addr_i[19:0] == 20'h590)  cfg_settle <= wdata_i ;
+      if (addr_i[19:0] == 20'h594)  cfg_len    <= wdata_i ;
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Synthesizer
+//---------------------------------------------------------------------------------
+
+// first quarter of the sine, sampled half a step off zero so the other
+// quarters are exact mirrors of it
+function [15-1:0] quarter ;
+   input [8-1:0] idx ;
+   begin
+      case (idx)
+      8'h00: quarter = 15'h0065 ;  8'h01: quarter = 15'h012E ;  8'h02: quarter = 15'h01F7 ;  8'h03: quarter = 15'h02C0 ;
+      8'h04: quarter = 15'h0389 ;  8'h05: quarter = 15'h0452 ;  8'h06: quarter = 15'h051B ;  8'h07: quarter = 15'h05E3 ;
+      8'h08: quarter = 15'h06AC ;  8'h09: quarter = 15'h0775 ;  8'h0A: quarter = 15'h083E ;  8'h0B: quarter = 15'h0906 ;
+      8'h0C: quarter = 15'h09CF ;  8'h0D: quarter = 15'h0A97 ;  8'h0E: quarter = 15'h0B5F ;  8'h0F: quarter = 15'h0C28 ;
+      8'h10: quarter = 15'h0CF0 ;  8'h11: quarter = 15'h0DB8 ;  8'h12: quarter = 15'h0E80 ;  8'h13: quarter = 15'h0F47 ;
+      8'h14: quarter = 15'h100F ;  8'h15: quarter = 15'h10D6 ;  8'h16: quarter = 15'h119D ;  8'h17: quarter = 15'h1264 ;
+      8'h18: quarter = 15'h132B ;  8'h19: quarter = 15'h13F2 ;  8'h1A: quarter = 15'h14B9 ;  8'h1B: quarter = 15'h157F ;
+      8'h1C: quarter = 15'h1645 ;  8'h1D: quarter = 15'h170B ;  8'h1E: quarter = 15'h17D0 ;  8'h1F: quarter = 15'h1896 ;
+      8'h20: quarter = 15'h195B ;  8'h21: quarter = 15'h1A20 ;  8'h22: quarter = 15'h1AE5 ;  8'h23: quarter = 15'h1BA9 ;
+      8'h24: quarter = 15'h1C6D ;  8'h25: quarter = 15'h1D31 ;  8'h26: quarter = 15'h1DF5 ;  8'h27: quarter = 15'h1EB8 ;
+      8'h28: quarter = 15'h1F7B ;  8'h29: quarter = 15'h203E ;  8'h2A: quarter = 15'h2100 ;  8'h2B: quarter = 15'h21C2 ;
+      8'h2C: quarter = 15'h2284 ;  8'h2D: quarter = 15'h2346 ;  8'h2E: quarter = 15'h2407 ;  8'h2F: quarter = 15'h24C8 ;
+      8'h30: quarter = 15'h2588 ;  8'h31: quarter = 15'h2648 ;  8'h32: quarter = 15'h2708 ;  8'h33: quarter = 15'h27C7 ;
+      8'h34: quarter = 15'h2886 ;  8'h35: quarter = 15'h2944 ;  8'h36: quarter = 15'h2A02 ;  8'h37: quarter = 15'h2AC0 ;
+      8'h38: quarter = 15'h2B7D ;  8'h39: quarter = 15'h2C3A ;  8'h3A: quarter = 15'h2CF7 ;  8'h3B: quarter = 15'h2DB3 ;
+      8'h3C: quarter = 15'h2E6E ;  8'h3D: quarter = 15'h2F2A ;  8'h3E: quarter = 15'h2FE4 ;  8'h3F: quarter = 15'h309E ;
+      8'h40: quarter = 15'h3158 ;  8'h41: quarter = 15'h3211 ;  8'h42: quarter = 15'h32CA ;  8'h43: quarter = 15'h3383 ;
+      8'h44: quarter = 15'h343A ;  8'h45: quarter = 15'h34F2 ;  8'h46: quarter = 15'h35A8 ;  8'h47: quarter = 15'h365F ;
+      8'h48: quarter = 15'h3715 ;  8'h49: quarter = 15'h37CA ;  8'h4A: quarter = 15'h387E ;  8'h4B: quarter = 15'h3933 ;
+      8'h4C: quarter = 15'h39E6 ;  8'h4D: quarter = 15'h3A99 ;  8'h4E: quarter = 15'h3B4C ;  8'h4F: quarter = 15'h3BFE ;
+      8'h50: quarter = 15'h3CAF ;  8'h51: quarter = 15'h3D60 ;  8'h52: quarter = 15'h3E10 ;  8'h53: quarter = 15'h3EBF ;
+      8'h54: quarter = 15'h3F6E ;  8'h55: quarter = 15'h401D ;  8'h56: quarter = 15'h40CA ;  8'h57: quarter = 15'h4177 ;
+      8'h58: quarter = 15'h4224 ;  8'h59: quarter = 15'h42D0 ;  8'h5A: quarter = 15'h437B ;  8'h5B: quarter = 15'h4425 ;
+      8'h5C: quarter = 15'h44CF ;  8'h5D: quarter = 15'h4578 ;  8'h5E: quarter = 15'h4621 ;  8'h5F: quarter = 15'h46C9 ;
+      8'h60: quarter = 15'h4770 ;  8'h61: quarter = 15'h4816 ;  8'h62: quarter = 15'h48BC ;  8'h63: quarter = 15'h4961 ;
+      8'h64: quarter = 15'h4A06 ;  8'h65: quarter = 15'h4AA9 ;  8'h66: quarter = 15'h4B4C ;  8'h67: quarter = 15'h4BEE ;
+      8'h68: quarter = 15'h4C90 ;  8'h69: quarter = 15'h4D31 ;  8'h6A: quarter = 15'h4DD1 ;  8'h6B: quarter = 15'h4E70 ;
+      8'h6C: quarter = 15'h4F0E ;  8'h6D: quarter = 15'h4FAC ;  8'h6E: quarter = 15'h5049 ;  8'h6F: quarter = 15'h50E5 ;
+      8'h70: quarter = 15'h5181 ;  8'h71: quarter = 15'h521B ;  8'h72: quarter = 15'h52B5 ;  8'h73: quarter = 15'h534E ;
+      8'h74: quarter = 15'h53E7 ;  8'h75: quarter = 15'h547E ;  8'h76: quarter = 15'h5515 ;  8'h77: quarter = 15'h55AA ;
+      8'h78: quarter = 15'h563F ;  8'h79: quarter = 15'h56D3 ;  8'h7A: quarter = 15'h5767 ;  8'h7B: quarter = 15'h57F9 ;
+      8'h7C: quarter = 15'h588B ;  8'h7D: quarter = 15'h591C ;  8'h7E: quarter = 15'h59AC ;  8'h7F: quarter = 15'h5A3B ;
+      8'h80: quarter = 15'h5AC9 ;  8'h81: quarter = 15'h5B56 ;  8'h82: quarter = 15'h5BE2 ;  8'h83: quarter = 15'h5C6E ;
+      8'h84: quarter = 15'h5CF9 ;  8'h85: quarter = 15'h5D82 ;  8'h86: quarter = 15'h5E0B ;  8'h87: quarter = 15'h5E93 ;
+      8'h88: quarter = 15'h5F1A ;  8'h89: quarter = 15'h5FA0 ;  8'h8A: quarter = 15'h6025 ;  8'h8B: quarter = 15'h60AA ;
+      8'h8C: quarter = 15'h612D ;  8'h8D: quarter = 15'h61AF ;  8'h8E: quarter = 15'h6231 ;  8'h8F: quarter = 15'h62B1 ;
+      8'h90: quarter = 15'h6331 ;  8'h91: quarter = 15'h63AF ;  8'h92: quarter = 15'h642D ;  8'h93: quarter = 15'h64AA ;
+      8'h94: quarter = 15'h6525 ;  8'h95: quarter = 15'h65A0 ;  8'h96: quarter = 15'h661A ;  8'h97: quarter = 15'h6693 ;
+      8'h98: quarter = 15'h670A ;  8'h99: quarter = 15'h6781 ;  8'h9A: quarter = 15'h67F7 ;  8'h9B: quarter = 15'h686C ;
+      8'h9C: quarter = 15'h68E0 ;  8'h9D: quarter = 15'h6952 ;  8'h9E: quarter = 15'h69C4 ;  8'h9F: quarter = 15'h6A35 ;
+      8'hA0: quarter = 15'h6AA4 ;  8'hA1: quarter = 15'h6B13 ;  8'hA2: quarter = 15'h6B81 ;  8'hA3: quarter = 15'h6BED ;
+      8'hA4: quarter = 15'h6C59 ;  8'hA5: quarter = 15'h6CC3 ;  8'hA6: quarter = 15'h6D2D ;  8'hA7: quarter = 15'h6D95 ;
+      8'hA8: quarter = 15'h6DFD ;  8'hA9: quarter = 15'h6E63 ;  8'hAA: quarter = 15'h6EC8 ;  8'hAB: quarter = 15'h6F2C ;
+      8'hAC: quarter = 15'h6F90 ;  8'hAD: quarter = 15'h6FF2 ;  8'hAE: quarter = 15'h7053 ;  8'hAF: quarter = 15'h70B2 ;
+      8'hB0: quarter = 15'h7111 ;  8'hB1: quarter = 15'h716F ;  8'hB2: quarter = 15'h71CB ;  8'hB3: quarter = 15'h7227 ;
+      8'hB4: quarter = 15'h7281 ;  8'hB5: quarter = 15'h72DB ;  8'hB6: quarter = 15'h7333 ;  8'hB7: quarter = 15'h738A ;
+      8'hB8: quarter = 15'h73E0 ;  8'hB9: quarter = 15'h7435 ;  8'hBA: quarter = 15'h7488 ;  8'hBB: quarter = 15'h74DB ;
+      8'hBC: quarter = 15'h752D ;  8'hBD: quarter = 15'h757D ;  8'hBE: quarter = 15'h75CC ;  8'hBF: quarter = 15'h761A ;
+      8'hC0: quarter = 15'h7667 ;  8'hC1: quarter = 15'h76B3 ;  8'hC2: quarter = 15'h76FE ;  8'hC3: quarter = 15'h7747 ;
+      8'hC4: quarter = 15'h778F ;  8'hC5: quarter = 15'h77D7 ;  8'hC6: quarter = 15'h781D ;  8'hC7: quarter = 15'h7862 ;
+      8'hC8: quarter = 15'h78A5 ;  8'hC9: quarter = 15'h78E8 ;  8'hCA: quarter = 15'h7929 ;  8'hCB: quarter = 15'h796A ;
+      8'hCC: quarter = 15'h79A9 ;  8'hCD: quarter = 15'h79E6 ;  8'hCE: quarter = 15'h7A23 ;  8'hCF: quarter = 15'h7A5F ;
+      8'hD0: quarter = 15'h7A99 ;  8'hD1: quarter = 15'h7AD2 ;  8'hD2: quarter = 15'h7B0A ;  8'hD3: quarter = 15'h7B41 ;
+      8'hD4: quarter = 15'h7B77 ;  8'hD5: quarter = 15'h7BAB ;  8'hD6: quarter = 15'h7BDE ;  8'hD7: quarter = 15'h7C10 ;
+      8'hD8: quarter = 15'h7C41 ;  8'hD9: quarter = 15'h7C71 ;  8'hDA: quarter = 15'h7C9F ;  8'hDB: quarter = 15'h7CCD ;
+      8'hDC: quarter = 15'h7CF9 ;  8'hDD: quarter = 15'h7D24 ;  8'hDE: quarter = 15'h7D4D ;  8'hDF: quarter = 15'h7D76 ;
+      8'hE0: quarter = 15'h7D9D ;  8'hE1: quarter = 15'h7DC3 ;  8'hE2: quarter = 15'h7DE8 ;  8'hE3: quarter = 15'h7E0B ;
+      8'hE4: quarter = 15'h7E2E ;  8'hE5: quarter = 15'h7E4F ;  8'hE6: quarter = 15'h7E6F ;  8'hE7: quarter = 15'h7E8D ;
+      8'hE8: quarter = 15'h7EAB ;  8'hE9: quarter = 15'h7EC7 ;  8'hEA: quarter = 15'h7EE2 ;  8'hEB: quarter = 15'h7EFC ;
+      8'hEC: quarter = 15'h7F15 ;  8'hED: quarter = 15'h7F2C ;  8'hEE: quarter = 15'h7F42 ;  8'hEF: quarter = 15'h7F57 ;
+      8'hF0: quarter = 15'h7F6B ;  8'hF1: quarter = 15'h7F7D ;  8'hF2: quarter = 15'h7F8F ;  8'hF3: quarter = 15'h7F9F ;
+      8'hF4: quarter = 15'h7FAD ;  8'hF5: quarter = 15'h7FBB ;  8'hF6: quarter = 15'h7FC7 ;  8'hF7: quarter = 15'h7FD2 ;
+      8'hF8: quarter = 15'h7FDC ;  8'hF9: quarter = 15'h7FE5 ;  8'hFA: quarter = 15'h7FEC ;  8'hFB: quarter = 15'h7FF3 ;
+      8'hFC: quarter = 15'h7FF7 ;  8'hFD: quarter = 15'h7FFB ;  8'hFE: quarter = 15'h7FFE ;  8'hFF: quarter = 15'h7FFF ;
+      endcase
+   end
+endfunction
+
+function [16-1:0] sine ;
+   input [10-1:0] ph ;
+   reg   [15-1:0] q  ;
+   begin
+      q    = quarter(ph[8] ? ~ph[8-1:0] : ph[8-1:0]) ;
+      sine = ph[9] ? -{1'b0, q} : {1'b0, q} ;
+   end
+endfunction
+
+reg  [ 32-1: 0] phase       ;
+reg  [ 16-1: 0] dds_sin     ;
+reg  [ 16-1: 0] dds_cos     ;
+reg  [ 31-1: 0] exc_mult    ;
+reg             exc_en      ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      phase     <= 32'd0 ;
+      dds_sin   <= 16'd0 ;
+      dds_cos   <= 16'd0 ;
+      exc_mult  <= 31'd0 ;
+      exc_en    <=  1'b0 ;
+      exc_o     <= 16'd0 ;
+      inj_sp_o  <=  8'd0 ;
+      inj_out_o <=  8'd0 ;
+   end
+   else begin
+      phase    <= start ? 32'd0 : phase + cfg_freq ;
+      dds_sin  <= sine(phase[32-1:22]) ;
+      dds_cos  <= sine(phase[32-1:22] + 10'd256) ;
+      exc_mult <= $signed(dds_sin) * $signed({1'b0, cfg_amp}) ;
+
+      if (start)
+         exc_en <= 1'b1 ;
+      else if (stop)
+         exc_en <= 1'b0 ;
+
+      exc_o     <= exc_en ? exc_mult[31-1:15] : 16'd0 ;
+      inj_sp_o  <= (exc_en && (cfg_inj == 2'd1)) ? (8'd1 << cfg_ch) : 8'd0 ;
+      inj_out_o <= (exc_en && (cfg_inj == 2'd2)) ? (8'd1 << cfg_ch) : 8'd0 ;
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Signal selection and saturation to 16 bits
+//---------------------------------------------------------------------------------
+
+function [16-1:0] sat16 ;
+   input [32-1:0] val ;
+   begin
+      if ((val[32-1:15] == {17{1'b0}}) || (val[32-1:15] == {17{1'b1}}))
+         sat16 = val[16-1:0] ;
+      else
+         sat16 = val[32-1] ? 16'h8000 : 16'h7FFF ;
+   end
+endfunction
+
+function [32-1:0] select ;
+   input [3-1:0] sig ;
+   input [3-1:0] ch ;
+   begin
+      case (sig)
+         3'd0:    select = adc_i[32*ch +: 32] ;
+         3'd1:    select = err_i[32*ch +: 32] ;
+         3'd2:    select = p_i[32*ch +: 32]   ;
+         3'd3:    select = i_i[32*ch +: 32]   ;
+         3'd4:    select = d_i[32*ch +: 32]   ;
+         3'd5:    select = out_i[32*ch +: 32] ;
+         3'd6:    select = {{16{int_i[32*ch+31]}}, int_i[32*ch+16 +: 16]} ; // upper half
+         default: select = {{16{exc_o[16-1]}}, exc_o} ;                      // excitation
+      endcase
+   end
+endfunction
+
+reg  [ 16-1: 0] trace_a     ;
+reg  [ 16-1: 0] trace_b     ;
+reg  [ 16-1: 0] ref_sin [0:3-1] ;
+reg  [ 16-1: 0] ref_cos [0:3-1] ;
+
+// the references are delayed to the synthesizer phase the traces were
+// sampled at: through the amplitude product, exc_o and the trace register
+always @(posedge clk_i) begin
+   trace_a    <= sat16(select(cfg_sig_a, cfg_ch)) ;
+   trace_b    <= sat16(select(cfg_sig_b, cfg_ch)) ;
+   ref_sin[0] <= dds_sin    ;
+   ref_sin[1] <= ref_sin[0] ;
+   ref_sin[2] <= ref_sin[1] ;
+   ref_cos[0] <= dds_cos    ;
+   ref_cos[1] <= ref_cos[0] ;
+   ref_cos[2] <= ref_cos[1] ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Demodulation
+//---------------------------------------------------------------------------------
+
+localparam  S_IDLE = 2'd0, S_SETTLE = 2'd1, S_ACC = 2'd2 ;
+
+reg  [  2-1: 0] state       ;
+reg  [ 32-1: 0] cnt         ;
+reg  [ 32-1: 0] acc_cnt     ;
+reg             acc_en      ;
+reg             acc_last    ;
+reg             done        ;
+reg  [ 32-1: 0] mult_ai     ;
+reg  [ 32-1: 0] mult_aq     ;
+reg  [ 32-1: 0] mult_bi     ;
+reg  [ 32-1: 0] mult_bq     ;
+reg  [ 64-1: 0] acc_ai      ;
+reg  [ 64-1: 0] acc_aq      ;
+reg  [ 64-1: 0] acc_bi      ;
+reg  [ 64-1: 0] acc_bq      ;
+
+wire            running = (state != S_IDLE) ;
+
+always @(posedge clk_i) begin
+   mult_ai <= $signed(trace_a) * $signed(ref_sin[2]) ;
+   mult_aq <= $signed(trace_a) * $signed(ref_cos[2]) ;
+   mult_bi <= $signed(trace_b) * $signed(ref_sin[2]) ;
+   mult_bq <= $signed(trace_b) * $signed(ref_cos[2]) ;
+end
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      state    <= S_IDLE ;
+      cnt      <= 32'd0 ;
+      acc_cnt  <= 32'd0 ;
+      acc_en   <= 1'b0 ;
+      acc_last <= 1'b0 ;
+      done     <= 1'b0 ;
+      acc_ai   <= 64'd0 ;
+      acc_aq   <= 64'd0 ;
+      acc_bi   <= 64'd0 ;
+      acc_bq   <= 64'd0 ;
+   end
+   else if (start) begin
+      cnt      <= 32'd0 ;
+      acc_cnt  <= 32'd0 ;
+      acc_en   <= 1'b0 ;
+      acc_last <= 1'b0 ;
+      done     <= 1'b0 ;
+      acc_ai   <= 64'd0 ;
+      acc_aq   <= 64'd0 ;
+      acc_bi   <= 64'd0 ;
+      acc_bq   <= 64'd0 ;
+      state    <= (cfg_settle != 32'd0) ? S_SETTLE : (cfg_len != 32'd0) ? S_ACC : S_IDLE ;
+      if ((cfg_settle == 32'd0) && (cfg_len == 32'd0))
+         done  <= 1'b1 ;
+   end
+   else if (stop) begin
+      state    <= S_IDLE ;
+      acc_en   <= 1'b0 ;
+      acc_last <= 1'b0 ;
+   end
+   else begin
+      // the products of a sample are ready one clock after it
+      acc_en   <= (state == S_ACC) ;
+      acc_last <= (state == S_ACC) && (cnt + 32'd1 >= cfg_len) ;
+
+      if (acc_en) begin
+         acc_ai  <= $signed(acc_ai) + $signed(mult_ai) ;
+         acc_aq  <= $signed(acc_aq) + $signed(mult_aq) ;
+         acc_bi  <= $signed(acc_bi) + $signed(mult_bi) ;
+         acc_bq  <= $signed(acc_bq) + $signed(mult_bq) ;
+         acc_cnt <= acc_cnt + 32'd1 ;
+      end
+      if (acc_last)
+         done <= 1'b1 ;
+
+      case (state)
+         S_SETTLE: begin
+            cnt <= cnt + 32'd1 ;
+            if (cnt + 32'd1 >= cfg_settle) begin
+               cnt   <= 32'd0 ;
+               state <= (cfg_len != 32'd0) ? S_ACC : S_IDLE ;
+               if (cfg_len == 32'd0)
+                  done <= 1'b1 ;
+            end
+         end
+         S_ACC: begin
+            cnt <= cnt + 32'd1 ;
+            if (cnt + 32'd1 >= cfg_len)
+               state <= S_IDLE ;
+         end
+         default: ;
+      endcase
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   case (addr_i[19:0])
+      20'h580: rdata_o = {{32-3{1'b0}}, exc_en, done, running} ;
+      20'h584: rdata_o = {{32-15{1'b0}}, cfg_sig_b, 1'b0, cfg_sig_a, 2'b0, cfg_inj, 1'b0, cfg_ch} ;
+      20'h588: rdata_o = cfg_freq ;
+      20'h58C: rdata_o = {{32-15{1'b0}}, cfg_amp} ;
+      20'h590: rdata_o = cfg_settle ;
+      20'h594: rdata_o = cfg_len ;
+      20'h598: rdata_o = acc_cnt ;
+      20'h5A0: rdata_o = acc_ai[32-1: 0] ;
+      20'h5A4: rdata_o = acc_ai[64-1:32] ;
+      20'h5A8: rdata_o = acc_aq[32-1: 0] ;
+      20'h5AC: rdata_o = acc_aq[64-1:32] ;
+      20'h5B0: rdata_o = acc_bi[32-1: 0] ;
+      20'h5B4: rdata_o = acc_bi[64-1:32] ;
+      20'h5B8: rdata_o = acc_bq[32-1: 0] ;
+      20'h5BC: rdata_o = acc_bq[64-1:32] ;
+      default: ;
+   endcase
+end
+
+endmodule
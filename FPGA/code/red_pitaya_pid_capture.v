@@ -0,0 +1,325 @@
+/**
+Title: Red Pitaya PID Capture Buffer
+Author: Lewis Woolfson
+(Based upon the Red Pitaya oscilloscope acquisition by Matej Oblak)
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Triggered capture of the loop signals of one PID channel into block RAM.
+ *
+ *
+ *   channel  /-----\     /-----\     /------\     /-------\
+ *   signals -| MUX |-+-> | SAT |---> | DEC  |---> | BRAM  | ---> bus
+ *            \-----/ |   \-----/     \------/     \-------/
+ *                    |   /---------\      ^
+ *   sat, DIO --------+-> | TRIGGER | -----
+ *                        \---------/
+ *
+ * Two traces (A and B) are selected from the input, error, P, I and D terms,
+ * output and integrator of the selected channel, saturated to 16 bits and
+ * written as one word {B, A} per sample into a ring of 16k words, every
+ * DEC-th clock (125 MS/s for DEC 0 or 1).
+ *
+ * After an arm the engine first records PRE samples, then waits for the
+ * trigger and records POST samples after it. Triggers: immediate, trace A
+ * crossing LEVEL upwards or downwards, integrator or output saturation of
+ * the channel, rising or falling edge of a DIO_P pin, and the software
+ * trigger. The trigger time (clock cycles since reset) is latched.
+ *
+ * The buffer window reads in time order: word 0 is the first pre-trigger
+ * sample, word PRE the trigger sample, so PRE + POST words can be copied
+ * out in one go. With PRE + POST above the buffer depth the oldest samples
+ * are overwritten.
+ *
+ * Registers (offset in the PID window):
+ *   0x540  control  w: bit 0 arm, bit 1 software trigger, bit 2 stop
+ *                   r: bit 0 running, bit 1 triggered, bit 2 done
+ *   0x544  source   [2:0] channel, [6:4] trace A, [10:8] trace B
+ *   0x548  trigger  [2:0] source, [10:8] DIO pin
+ *   0x54C  level    signed 16 bit trigger level of trace A
+ *   0x550  decimation
+ *   0x554  pre-trigger samples
+ *   0x558  post-trigger samples
+ *   0x55C  buffer index of the first sample (read only)
+ *   0x560  trigger time, lower 32 bits (read only)
+ *   0x564  trigger time, upper 32 bits (read only)
+ *   0x10000 - 0x1FFFC  sample buffer (read only)
+ */
+
+
+
+module red_pitaya_pid_capture #(
+   parameter     aw = 14             // buffer address width, 2^aw samples
+)
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   // signals of all channels, sign extended to 32 bits, channel n at [32*n +: 32]
+   input    [8*32-1: 0]  adc_i     ,  // input
+   input    [8*32-1: 0]  err_i     ,  // error
+   input    [8*32-1: 0]  p_i       ,  // proportional term
+   input    [8*32-1: 0]  i_i       ,  // integral term
+   input    [8*32-1: 0]  d_i       ,  // derivative term
+   input    [8*32-1: 0]  out_i     ,  // PID block output
+   input    [8*32-1: 0]  int_i     ,  // integrator register
+   input    [8* 2-1: 0]  sat_i     ,  // saturation {output, integrator}
+   input    [  8-1: 0]   dio_i     ,  // DIO_P pins, asynchronous
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the capture registers
+);
+
+
+
+//---------------------------------------------------------------------------------
+//  Configuration
+//---------------------------------------------------------------------------------
+
+reg  [  3-1: 0] cfg_ch      ;
+reg  [  3-1: 0] cfg_sig_a   ;
+reg  [  3-1: 0] cfg_sig_b   ;
+reg  [  3-1: 0] cfg_trig    ;
+reg  [  3-1: 0] cfg_dio     ;
+reg  [ 16-1: 0] cfg_level   ;
+reg  [ 32-1: 0] cfg_dec     ;
+reg  [ 32-1: 0] cfg_pre     ;
+reg  [ 32-1: 0] cfg_post    ;
+
+wire            ctrl_wr  = wen_i && (addr_i[19:0] == 20'h540) ;
+wire            arm      = ctrl_wr && wdata_i[0] ;
+wire            sw_trig  = ctrl_wr && wdata_i[1] ;
+wire            stop     = ctrl_wr && wdata_i[2] ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      cfg_ch    <=  3'd0 ;
+      cfg_sig_a <=  3'd0 ;
+      cfg_sig_b <=  3'd1 ;
+      cfg_trig  <=  3'd0 ;
+      cfg_dio   <=  3'd0 ;
+      cfg_level <= 16'd0 ;
+      cfg_dec   <= 32'd1 ;
+      cfg_pre   <= 32'd0 ;
+      cfg_post  <= 32'd1 << aw ;
+   end
+   else if (wen_i) begin
+      if (addr_i[19:0] == 20'h544)  {cfg_sig_b, cfg_sig_a, cfg_ch} <= {wdata_i[10:8], wdata_i[6:4], wdata_i[2:0]} ;
+      if (addr_i[19:0] == 20'h548)  {cfg_dio, cfg_trig} <= {wdata_i[10:8], wdata_i[2:0]} ;
+      if (addr_i[19:0] == 20'h54C)  cfg_level <= wdata_i[16-1:0] ;
+      if (addr_i[19:0] == 20'h550)  cfg_dec   <= wdata_i ;
+      if (addr_i[19:0] == 20'h554)  cfg_pre   <= wdata_i ;
+      if (addr_i[19:0] == 20'h558)  cfg_post  <= wdata_i ;
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Signal selection and saturation to 16 bits
+//---------------------------------------------------------------------------------
+
+function [16-1:0] sat16 ;
+   input [32-1:0] val ;
+   begin
+      if ((val[32-1:15] == {17{1'b0}}) || (val[32-1:15] == {17{1'b1}}))
+         sat16 = val[16-1:0] ;
+      else
+         sat16 = val[32-1] ? 16'h8000 : 16'h7FFF ;
+   end
+endfunction
+
+function [32-1:0] select ;
+   input [3-1:0] sig ;
+   input [3-1:0] ch ;
+   begin
+      case (sig)
+         3'd0:    select = adc_i[32*ch +: 32] ;
+         3'd1:    select = err_i[32*ch +: 32] ;
+         3'd2:    select = p_i[32*ch +: 32]   ;
+         3'd3:    select = i_i[32*ch +: 32]   ;
+         3'd4:    select = d_i[32*ch +: 32]   ;
+         3'd5:    select = out_i[32*ch +: 32] ;
+         3'd6:    select = {{16{int_i[32*ch+31]}}, int_i[32*ch+16 +: 16]} ; // upper half
+         default: select = 32'h0 ;
+      endcase
+   end
+endfunction
+
+reg  [ 16-1: 0] trace_a     ;
+reg  [ 16-1: 0] trace_b     ;
+reg  [ 16-1: 0] trace_a_r   ;
+reg  [  2-1: 0] sat         ;
+reg  [  3-1: 0] dio_sync    ;
+
+always @(posedge clk_i) begin
+   trace_a   <= sat16(select(cfg_sig_a, cfg_ch)) ;
+   trace_b   <= sat16(select(cfg_sig_b, cfg_ch)) ;
+   trace_a_r <= trace_a ;
+   sat       <= sat_i[2*cfg_ch +: 2] ;
+   dio_sync  <= {dio_sync[1:0], dio_i[cfg_dio]} ;
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Trigger
+//---------------------------------------------------------------------------------
+
+reg             trig_evt    ;
+
+always @(posedge clk_i) begin
+   case (cfg_trig)
+      3'd0:    trig_evt <= 1'b1 ;                                                     // immediate
+      3'd1:    trig_evt <= ($signed(trace_a_r) <  $signed(cfg_level)) &&
+                           ($signed(trace_a)   >= $signed(cfg_level)) ;               // level rising
+      3'd2:    trig_evt <= ($signed(trace_a_r) >  $signed(cfg_level)) &&
+                           ($signed(trace_a)   <= $signed(cfg_level)) ;               // level falling
+      3'd3:    trig_evt <= sat[0] ;                                                   // integrator saturation
+      3'd4:    trig_evt <= sat[1] ;                                                   // output saturation
+      3'd5:    trig_evt <= (dio_sync[2:1] == 2'b01) ;                                 // DIO rising
+      3'd6:    trig_evt <= (dio_sync[2:1] == 2'b10) ;                                 // DIO falling
+      default: trig_evt <= 1'b0 ;
+   endcase
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Acquisition
+//---------------------------------------------------------------------------------
+
+localparam  S_IDLE = 2'd0, S_PRE = 2'd1, S_WAIT = 2'd2, S_POST = 2'd3 ;
+
+reg  [ 32-1: 0] buf_mem [0:(1<<aw)-1] ;
+reg  [ aw-1: 0] wr_ptr      ;
+reg  [ aw-1: 0] start_ptr   ;
+reg  [  2-1: 0] state       ;
+reg             triggered   ;
+reg             done        ;
+reg  [ 32-1: 0] dec_cnt     ;
+reg  [ 32-1: 0] smp_cnt     ;
+reg  [ 64-1: 0] time_cnt    ;
+reg  [ 64-1: 0] trig_time   ;
+
+wire            smp_stb = (dec_cnt == 32'd0) ;
+wire            running = (state != S_IDLE) ;
+
+always @(posedge clk_i) begin
+   if (running && smp_stb)
+      buf_mem[wr_ptr] <= {trace_b, trace_a} ;
+end
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      wr_ptr    <= {aw{1'b0}} ;
+      start_ptr <= {aw{1'b0}} ;
+      state     <= S_IDLE ;
+      triggered <= 1'b0 ;
+      done      <= 1'b0 ;
+      dec_cnt   <= 32'd0 ;
+      smp_cnt   <= 32'd0 ;
+      time_cnt  <= 64'd0 ;
+      trig_time <= 64'd0 ;
+   end
+   else begin
+      time_cnt <= time_cnt + 64'd1 ;
+
+      if (running)
+         dec_cnt <= (dec_cnt + 32'd1 >= cfg_dec) ? 32'd0 : dec_cnt + 32'd1 ;
+
+      if (arm) begin
+         wr_ptr    <= {aw{1'b0}} ;
+         dec_cnt   <= 32'd0 ;
+         smp_cnt   <= 32'd0 ;
+         triggered <= 1'b0 ;
+         done      <= 1'b0 ;
+         state     <= (cfg_pre == 32'd0) ? S_WAIT : S_PRE ;
+      end
+      else if (stop) begin
+         state <= S_IDLE ;
+      end
+      else begin
+         case (state)
+            S_PRE: begin
+               if (smp_stb) begin
+                  wr_ptr  <= wr_ptr + 1'b1 ;
+                  smp_cnt <= smp_cnt + 32'd1 ;
+                  if (smp_cnt + 32'd1 >= cfg_pre)
+                     state <= S_WAIT ;
+               end
+            end
+            S_WAIT: begin
+               if (smp_stb)
+                  wr_ptr <= wr_ptr + 1'b1 ;
+               if (trig_evt || sw_trig) begin
+                  // the next sample written is the trigger sample
+                  start_ptr <= wr_ptr + (smp_stb ? 1'b1 : 1'b0) - cfg_pre[aw-1:0] ;
+                  trig_time <= time_cnt ;
+                  triggered <= 1'b1 ;
+                  smp_cnt   <= 32'd0 ;
+                  if (cfg_post == 32'd0) begin
+                     done  <= 1'b1 ;
+                     state <= S_IDLE ;
+                  end
+                  else
+                     state <= S_POST ;
+               end
+            end
+            S_POST: begin
+               if (smp_stb) begin
+                  wr_ptr  <= wr_ptr + 1'b1 ;
+                  smp_cnt <= smp_cnt + 32'd1 ;
+                  if (smp_cnt + 32'd1 >= cfg_post) begin
+                     done  <= 1'b1 ;
+                     state <= S_IDLE ;
+                  end
+               end
+            end
+            default: ;
+         endcase
+      end
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+// The buffer is read synchronously. The bus bridge holds the address for
+// two clocks before it asserts the read, so the data is valid by then.
+
+reg  [ 32-1: 0] buf_rdata   ;
+reg             buf_sel     ;
+
+always @(posedge clk_i) begin
+   buf_rdata <= buf_mem[addr_i[aw+2-1:2] + start_ptr] ;
+   buf_sel   <= (addr_i[19:16] == 4'h1) ;
+end
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   if (buf_sel)  rdata_o = buf_rdata ;
+   case (addr_i[19:0])
+      20'h540: rdata_o = {{32-3{1'b0}}, done, triggered, running} ;
+      20'h544: rdata_o = {{32-11{1'b0}}, cfg_sig_b, 1'b0, cfg_sig_a, 1'b0, cfg_ch} ;
+      20'h548: rdata_o = {{32-11{1'b0}}, cfg_dio, 5'b0, cfg_trig} ;
+      20'h54C: rdata_o = {{16{cfg_level[16-1]}}, cfg_level} ;
+      20'h550: rdata_o = cfg_dec ;
+      20'h554: rdata_o = cfg_pre ;
+      20'h558: rdata_o = cfg_post ;
+      20'h55C: rdata_o = {{32-aw{1'b0}}, start_ptr} ;
+      20'h560: rdata_o = trig_time[32-1:0] ;
+      20'h564: rdata_o = trig_time[64-1:32] ;
+      default: ;
+   endcase
+end
+
+endmodule
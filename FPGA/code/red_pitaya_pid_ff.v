@@ -0,0 +1,224 @@
+/**
+Title: Red Pitaya PID Feedforward
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Feedforward terms of the eight PID channels.
+ *
+ *
+ *                 /-------\
+ *   phase    ---> | TABLE | ---\     /-----\     /------\
+ *                 \-------/     +--> | MUX | --> | GAIN | ---> PID block sum
+ *   ADC      ------------------/     \-----/     \------/
+ *
+ * Every channel adds a feedforward term to its PID sum before the output
+ * saturation, so a predictable disturbance is cancelled without waiting
+ * for the error to build up. The term comes from a 1024 entry table in
+ * block RAM or from a copy of one of the ADC inputs, times a signed gain
+ * of 1/4096 steps (0x1000 = 1).
+ *
+ * The table is indexed by the upper 10 bits of a phase accumulator that
+ * adds STEP every clock. Periodic tables (mains pickup, say) run freely at
+ * f = STEP * f_clk / 2^32 per table; a trigger only aligns them to entry
+ * 0. One-shot tables (a coil ramp of a sequence) hold their entry, play
+ * once from entry 0 on each trigger and stop on the last entry; triggers
+ * are a write to TRIG or the rising edge of a DIO_P pin.
+ *
+ * Table values are in output counts of the channel, 16 bit signed. ADC
+ * inputs cross between fast and slow channels as in red_pitaya_pid_route.v.
+ * The term is registered a few clocks after the phase; CFG = 0 (the reset
+ * value) adds 0.
+ *
+ * Registers (channel index n as in red_pitaya_pid.v):
+ *   0x880 + 0x10*n  CFG: [1:0] source (0 off, 1 table, 2 ADC input),
+ *                   [4] one-shot, [5] DIO_P trigger, [10:8] DIO_P pin,
+ *                   [14:12] ADC input (SRC 0 - 5 of red_pitaya_pid_route.v)
+ *   0x884 + 0x10*n  STEP, phase increment per clock
+ *   0x888 + 0x10*n  GAIN, [15:0] signed, 0x1000 = 1
+ *   0x88C + 0x10*n  TRIG, write: restart at entry 0; read: [31] one-shot
+ *                   playing, [9:0] table entry
+ *   0x20000 + 0x1000*n  table of channel n, 1024 words, [15:0] signed
+ */
+
+
+
+module red_pitaya_pid_ff
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   input    [2*14-1: 0]  fast_adc_i,  // fast ADC A, B
+   input    [4*12-1: 0]  slow_adc_i,  // slow ADC A - D
+   input    [   8-1: 0]  dio_i     ,  // DIO_P pins
+   output   [8*16-1: 0]  ff_o      ,  // feedforward terms, channel n at [16*n +: 16]
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the feedforward registers
+);
+
+`include "red_pitaya_pid_map.vh"
+
+localparam AW = 10 ;                  // table address
+
+wire [8*32-1: 0] ch_rdata ;
+
+
+genvar n ;
+generate for (n = 0; n < 8; n = n + 1) begin : ch
+
+   //---------------------------------------------------------------------------------
+   //  Settings
+
+   reg  [ 2-1: 0] cfg_src  ;
+   reg            cfg_shot ;
+   reg            cfg_ext  ;
+   reg  [ 3-1: 0] cfg_dio  ;
+   reg  [ 3-1: 0] cfg_in   ;
+   reg  [32-1: 0] set_step ;
+   reg  [16-1: 0] set_gain ;
+
+   wire           sw_trig  = wen_i && (addr_i[19:0] == REG_FF + 20'hC + REG_CH*n) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         {cfg_in, cfg_dio, cfg_ext, cfg_shot, cfg_src} <= 10'd0 ;
+         set_step <= 32'd0 ;
+         set_gain <= 16'd0 ;
+      end
+      else if (wen_i) begin
+         if (addr_i[19:0] == REG_FF + 20'h0 + REG_CH*n)
+            {cfg_in, cfg_dio, cfg_ext, cfg_shot, cfg_src} <= {wdata_i[14:12], wdata_i[10:8], wdata_i[5:4], wdata_i[1:0]} ;
+         if (addr_i[19:0] == REG_FF + 20'h4 + REG_CH*n)  set_step <= wdata_i ;
+         if (addr_i[19:0] == REG_FF + 20'h8 + REG_CH*n)  set_gain <= wdata_i[16-1:0] ;
+      end
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Phase
+
+   reg  [32-1: 0] phase  ;
+   reg            run    ;
+   reg            dio_r  ;
+
+   wire [33-1: 0] phase_nxt = phase + set_step ;
+   wire           ext_trig  = cfg_ext && dio_i[cfg_dio] && !dio_r ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         phase <= 32'd0 ;
+         run   <= 1'b0 ;
+         dio_r <= 1'b0 ;
+      end
+      else begin
+         dio_r <= dio_i[cfg_dio] ;
+
+         if (sw_trig || ext_trig) begin
+            phase <= 32'd0 ;
+            run   <= cfg_shot ;
+         end
+         else if (!cfg_shot)
+            phase <= phase_nxt[32-1:0] ;
+         else if (run) begin
+            if (phase_nxt[32]) begin         // end of the table, hold the last entry
+               phase <= 32'hFFFFFFFF ;
+               run   <= 1'b0 ;
+            end
+            else
+               phase <= phase_nxt[32-1:0] ;
+         end
+      end
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Table, written and read back by the bus on port A
+
+   reg  [16-1: 0] tbl [0:(1<<AW)-1] ;
+   reg  [16-1: 0] tbl_q   ;
+   reg  [16-1: 0] tbl_rd  ;
+   reg            tbl_sel ;
+
+   always @(posedge clk_i) begin
+      if (wen_i && (addr_i[19:12] == 8'h20 + n))
+         tbl[addr_i[AW+2-1:2]] <= wdata_i[16-1:0] ;
+      tbl_rd  <= tbl[addr_i[AW+2-1:2]] ;
+      tbl_sel <= (addr_i[19:12] == 8'h20 + n) ;
+   end
+
+   always @(posedge clk_i) begin
+      tbl_q <= tbl[phase[32-1:32-AW]] ;
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Source and gain
+
+   // ADC input in counts of this channel
+   reg  [16-1: 0] adc ;
+
+   always @(*) begin
+      case (cfg_in)
+         3'd0, 3'd1 : adc = (n < 4) ? {{2{fast_adc_i[14*cfg_in[0]+13]}}, fast_adc_i[14*cfg_in[0] +: 14]} :
+                                      {{4{fast_adc_i[14*cfg_in[0]+13]}}, fast_adc_i[14*cfg_in[0]+2 +: 12]} ;
+         3'd2, 3'd3, 3'd4, 3'd5 :
+                      adc = (n < 4) ? {{2{slow_adc_i[12*(cfg_in-2)+11]}}, slow_adc_i[12*(cfg_in-2) +: 12], 2'b00} :
+                                      {{4{slow_adc_i[12*(cfg_in-2)+11]}}, slow_adc_i[12*(cfg_in-2) +: 12]} ;
+         default :    adc = 16'h0 ;
+      endcase
+   end
+
+   reg  [16-1: 0] src ;
+   (* use_dsp48 = "yes" *) reg [32-1: 0] prd ;
+   reg  [16-1: 0] ff  ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         src <= 16'h0 ;
+         prd <= 32'h0 ;
+         ff  <= 16'h0 ;
+      end
+      else begin
+         src <= (cfg_src == 2'd1) ? tbl_q : (cfg_src == 2'd2) ? adc : 16'h0 ;
+         prd <= $signed(src) * $signed(set_gain) ;
+         // product / 4096, saturated to 16 bits
+         if (prd[32-1:12+16-1] == {5{prd[32-1]}})
+            ff <= prd[12 +: 16] ;
+         else
+            ff <= prd[32-1] ? 16'h8000 : 16'h7FFF ;
+      end
+   end
+
+   assign ff_o[16*n +: 16] = ff ;
+
+   assign ch_rdata[32*n +: 32] =
+      tbl_sel                              ? {{16{tbl_rd[16-1]}}, tbl_rd} :
+      (addr_i[19:0] == REG_FF + 20'h0 + REG_CH*n)  ? {{32-15{1'b0}}, cfg_in, 1'b0, cfg_dio, 2'b0, cfg_ext, cfg_shot, 2'b0, cfg_src} :
+      (addr_i[19:0] == REG_FF + 20'h4 + REG_CH*n)  ? set_step :
+      (addr_i[19:0] == REG_FF + 20'h8 + REG_CH*n)  ? {{16{set_gain[16-1]}}, set_gain} :
+      (addr_i[19:0] == REG_FF + 20'hC + REG_CH*n)  ? {run, {32-1-AW{1'b0}}, phase[32-1:32-AW]} :
+                                             32'h0 ;
+
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+// The tables are read synchronously, as the capture buffer: the bus bridge
+// holds the address for two clocks before it asserts the read.
+
+integer j ;
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   for (j = 0; j < 8; j = j + 1)
+      rdata_o = rdata_o | ch_rdata[32*j +: 32] ;
+end
+
+endmodule
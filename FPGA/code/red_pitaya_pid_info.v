@@ -0,0 +1,125 @@
+/**
+Title: Red Pitaya PID Discovery ROM
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Read only description of the PID channels of this bitstream.
+ *
+ *
+ *   addr ---> | ROM | ---> rdata
+ *
+ *
+ * Tools read the whole ROM once and build their channel table from it, so
+ * one binary drives bitstreams with other channel counts, widths or
+ * register maps. The register offsets come from red_pitaya_pid_map.vh, the
+ * include the decoders of red_pitaya_pid.v use, the widths, features and
+ * channel flags from the parameters red_pitaya_pid.v sets.
+ *
+ * Registers:
+ *   0xE00           magic 0x44495052 ("RPID" in memory order)
+ *   0xE04           [7:0] layout version (2), [15:8] channels,
+ *                   [23:16] descriptor size in bytes
+ *   0xE08           features, [0] shadow registers and commit, [1] telemetry,
+ *                   [2] capture, [3] loop analyzer, [4] set point ramps,
+ *                   [5] derivative divider and filter, [6] anti-windup,
+ *                   [7] routing crossbar, [8] feedforward, [9] parameter
+ *                   banks
+ *   0xE0C           processing clock in Hz
+ *   0xE10           offset of the descriptor table in the PID window
+ *                   (0x40000), page aligned
+ *   0x40000 + 0x20*n descriptor of channel n:
+ *     +0x00         [3:0] type (0 fast, 1 slow), [7:4] fine gain bits,
+ *                   [15:8] input width, [23:16] gain width, [31:24]
+ *                   flags: [24] set point
+ *                   ramp, [25] analyzer source, [26] capture source,
+ *                   [27] time multiplexed, [28] derivative filter,
+ *                   [29] anti-windup, [30] feedforward, [31] parameter
+ *                   banks (CFG at 0x900 + 4*n, HOLD at 0x920 + 4*n, banks
+ *                   at 0x30000 + 0x100*n)
+ *     +0x04 - 0x14  register offsets in the PID window, two per word (low
+ *                   half first) in the order sp kp ki kd irst psr isr dsr
+ *                   icd tol
+ *     +0x18         [15:0] telemetry snapshot, [31:16] ramp registers
+ *     +0x1C         [15:0] derivative filter and anti-windup registers,
+ *                   0 if none (only the anti-windup register at +0x8
+ *                   without flag [28]; FINE at +0xC with fine gain bits),
+ *                   [31:16] feedforward registers
+ * The table has a 4 KiB page to itself, room for 128 descriptors. A
+ * bitstream has at most 32 channels, the width of the commit register
+ * (0x150) and of the channel masks of the tools. Everything else reads 0.
+ */
+
+
+
+module red_pitaya_pid_info #(
+   parameter FAST_NUM = 4  ,          // fast channels, first in the channel order
+   parameter SLOW_NUM = 4  ,          // slow channels
+   parameter FAST_RES = 14 ,          // fast input width
+   parameter SLOW_RES = 12 ,          // slow input width
+   parameter FAST_GAIN = 14 ,         // fast gain width
+   parameter FAST_FRAC = 0  ,         // fractional gain bits below it, FINE set
+   parameter SLOW_GAIN = 12 ,         // slow gain width
+   parameter FEATURES = 32'h0 ,       // FEAT_* of red_pitaya_pid_map.vh
+   parameter FAST_FLAGS = 8'h0 ,      // CH_* of the fast channels
+   parameter SLOW_FLAGS = 8'h0 ,      // CH_* of the slow channels
+   parameter CLOCK    = 125000000
+)
+(
+   input      [ 32-1: 0] addr_i    ,  // address
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the ROM
+);
+
+`include "red_pitaya_pid_map.vh"
+
+localparam NUM  = FAST_NUM + SLOW_NUM ;
+
+wire [ 20-1: 0] rel  = addr_i[19:0] - REG_INFO_DESC ;
+wire [ 20-1: 0] n    = {13'h0, rel[11:5]} ;            // channel of a descriptor word
+wire            slow = (n >= FAST_NUM) ;
+
+// register offsets of channel n
+wire [ 16-1: 0] o_sp   = REG_SP   + REG_CH     * n ;
+wire [ 16-1: 0] o_kp   = REG_KP   + REG_CH     * n ;
+wire [ 16-1: 0] o_ki   = REG_KI   + REG_CH     * n ;
+wire [ 16-1: 0] o_kd   = REG_KD   + REG_CH     * n ;
+wire [ 16-1: 0] o_irst = REG_IRST + REG_CH4    * n ;
+wire [ 16-1: 0] o_psr  = REG_PSR  + REG_CH     * n ;
+wire [ 16-1: 0] o_isr  = REG_ISR  + REG_CH     * n ;
+wire [ 16-1: 0] o_dsr  = REG_DSR  + REG_CH     * n ;
+wire [ 16-1: 0] o_icd  = REG_ICD  + REG_CH     * n ;
+wire [ 16-1: 0] o_tol  = REG_TOL  + REG_CH4    * n ;
+wire [ 16-1: 0] o_tlm  = REG_TLM  + REG_TLM_CH * n ;
+wire [ 16-1: 0] o_ramp = REG_RAMP + REG_CH     * n ;
+wire [ 16-1: 0] o_dcd  = REG_DCD  + REG_CH     * n ;
+wire [ 16-1: 0] o_ff   = REG_FF   + REG_CH     * n ;
+
+wire [  8-1: 0] flags  = slow ? SLOW_FLAGS : FAST_FLAGS ;
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   case (addr_i[19:0])
+      REG_INFO + 20'h00 : rdata_o = 32'h44495052 ;
+      REG_INFO + 20'h04 : rdata_o = {8'd0, 8'd32, NUM[7:0], 8'd2} ;
+      REG_INFO + 20'h08 : rdata_o = FEATURES ;
+      REG_INFO + 20'h0C : rdata_o = CLOCK ;
+      REG_INFO + 20'h10 : rdata_o = REG_INFO_DESC ;
+   endcase
+
+   if (addr_i[19:0] >= REG_INFO_DESC && addr_i[19:0] < REG_INFO_DESC + 32*NUM) begin
+      case (rel[4:2])
+         3'd0 : rdata_o = {flags, slow ? SLOW_GAIN[7:0] : FAST_GAIN[7:0], slow ? SLOW_RES[7:0] : FAST_RES[7:0], slow ? 4'd0 : FAST_FRAC[3:0], 3'd0, slow} ;
+         3'd1 : rdata_o = {o_kp,   o_sp}   ;
+         3'd2 : rdata_o = {o_kd,   o_ki}   ;
+         3'd3 : rdata_o = {o_psr,  o_irst} ;
+         3'd4 : rdata_o = {o_dsr,  o_isr}  ;
+         3'd5 : rdata_o = {o_tol,  o_icd}  ;
+         3'd6 : rdata_o = {o_ramp, o_tlm}  ;
+         3'd7 : rdata_o = {o_ff,   o_dcd}  ;   // derivative and anti-windup registers from DCD
+      endcase
+   end
+end
+
+endmodule
@@ -0,0 +1,87 @@
+/**
+Title: Red Pitaya PID Register Map
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Register offsets in the PID window and feature bits of the discovery
+ * ROM, included in the body of every module that decodes them
+ * (red_pitaya_pid.v, the ramp, feedforward and bank modules) and of
+ * red_pitaya_pid_info.v, which describes them. A register moves here and
+ * nowhere else.
+ *
+ * Channel n (0 - 3 for 11, 12, 21, 22, then the slow channels) has its
+ * parameter at the base + REG_CH * n, IRST, TOL, the bank selection and
+ * the hold pin at the base + REG_CH4 * n, its telemetry snapshot at REG_TLM +
+ * REG_TLM_CH * n. The shadow copy of a parameter is at + REG_SHADOW.
+ */
+
+
+
+// channel parameters
+localparam REG_SP        = 20'h010 ;
+localparam REG_KP        = 20'h014 ;
+localparam REG_KI        = 20'h018 ;
+localparam REG_KD        = 20'h01C ;
+localparam REG_IRST      = 20'h090 ;
+localparam REG_PSR       = 20'h0B0 ;
+localparam REG_ISR       = 20'h0B4 ;
+localparam REG_DSR       = 20'h0B8 ;
+localparam REG_ICD       = 20'h0BC ;
+localparam REG_TOL       = 20'h130 ;
+localparam REG_CH        = 20'h010 ;   // channel stride
+localparam REG_CH4       = 20'h004 ;   // channel stride of IRST, TOL, the bank selection and the hold pin
+
+// shadow copy and commit
+localparam REG_SHADOW    = 20'h200 ;
+localparam REG_COMMIT    = 20'h150 ;
+
+// telemetry
+localparam REG_TLM_TRIG  = 20'h400 ;
+localparam REG_TLM       = 20'h420 ;
+localparam REG_TLM_CH    = 20'h020 ;
+
+// set point ramps, + REG_CH * n
+localparam REG_RAMP      = 20'h600 ;
+localparam REG_RAMP_DONE = 20'h680 ;
+
+// derivative divider and filter, anti-windup, fine gains, + REG_CH * n
+localparam REG_DCD       = 20'h700 ;
+localparam REG_DFL       = 20'h704 ;
+localparam REG_AW        = 20'h708 ;
+localparam REG_FINE      = 20'h70C ;
+
+// feedforward, + REG_CH * n
+localparam REG_FF        = 20'h880 ;
+
+// parameter bank selection and integrator hold pin, + REG_CH4 * n
+localparam REG_BANK      = 20'h900 ;
+localparam REG_HOLD      = 20'h920 ;
+
+// discovery ROM header and descriptor table
+localparam REG_INFO      = 20'hE00 ;
+localparam REG_INFO_DESC = 20'h40000 ;
+
+// features of the bitstream, ROM word 0xE08
+localparam FEAT_SHADOW   = 32'h001 ;   // shadow registers and commit
+localparam FEAT_TLM      = 32'h002 ;   // telemetry snapshots
+localparam FEAT_CAPTURE  = 32'h004 ;   // capture buffer
+localparam FEAT_BODE     = 32'h008 ;   // loop analyzer
+localparam FEAT_RAMP     = 32'h010 ;   // set point ramps
+localparam FEAT_DERIV    = 32'h020 ;   // derivative divider and filter
+localparam FEAT_AWINDUP  = 32'h040 ;   // anti-windup
+localparam FEAT_ROUTE    = 32'h080 ;   // routing crossbar
+localparam FEAT_FF       = 32'h100 ;   // feedforward
+localparam FEAT_BANK     = 32'h200 ;   // parameter banks
+
+// channel flags, descriptor word 0 [31:24]
+localparam CH_RAMP       = 8'h01 ;     // set point ramp
+localparam CH_BODE       = 8'h02 ;     // loop analyzer source
+localparam CH_CAPTURE    = 8'h04 ;     // capture source
+localparam CH_TM         = 8'h08 ;     // time multiplexed engine
+localparam CH_DERIV      = 8'h10 ;     // derivative divider and filter
+localparam CH_AWINDUP    = 8'h20 ;     // anti-windup
+localparam CH_FF         = 8'h40 ;     // feedforward
+localparam CH_BANK       = 8'h80 ;     // parameter banks
@@ -0,0 +1,186 @@
+/**
+Title: Red Pitaya PID Set Point Ramp
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Slew limited set points of the eight PID channels.
+ *
+ *
+ *                 /------\     /----------\
+ *   set point --> | RAMP | --> | + EXC/SAT| ---> PID block set point
+ *   register      \------/     \----------/
+ *
+ * The set point register of a channel is the target; the set point the PID
+ * block sees moves towards it by at most RATE counts every DIV + 1 clocks,
+ * so one write moves a set point across the whole range without kicking
+ * the P and D terms. RATE 0 (the reset value) passes the register through
+ * unchanged, as before.
+ *
+ * With the S-curve profile the step grows by ACC/256 counts per tick from
+ * rest up to RATE and shrinks again before the target: the distance used
+ * to accelerate is summed, and deceleration starts when the remaining
+ * distance gets down to it. A target change against the current motion
+ * stops the ramp and starts it again from rest. The loop analyzer
+ * excitation is added after the ramp and is not slew limited.
+ *
+ * Positions carry 8 fractional bits; a ramp always ends exactly on the
+ * target. Slow channels ramp on their 12 bit values, sign extended.
+ *
+ * Registers (channel index n as in red_pitaya_pid.v):
+ *   0x600 + 0x10*n  RATE, counts per tick, 0 = no ramp
+ *   0x604 + 0x10*n  DIV, clocks per tick minus 1 (24 bit)
+ *   0x608 + 0x10*n  [0] S-curve, [31:16] ACC, 1/256 counts per tick per tick
+ *   0x60C + 0x10*n  current set point, sign extended (read only)
+ *   0x680           [7:0] done, set point at the target (read only)
+ */
+
+
+
+module red_pitaya_pid_ramp
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   input    [8*14-1: 0]  sp_i      ,  // set point registers, channel n at [14*n +: 14]
+   output   [8*14-1: 0]  sp_o      ,  // ramped set points
+   output   [   8-1: 0]  done_o    ,  // set point at the target
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the ramp registers
+);
+
+`include "red_pitaya_pid_map.vh"
+
+localparam FW = 8 ;                   // fractional bits of the position
+localparam PW = 14 + FW ;             // position
+localparam DW = PW + 2 ;              // distance and summed distance
+
+wire [8*16-1: 0] rate_w ;
+wire [8*24-1: 0] div_w  ;
+wire [8*32-1: 0] cfg_w  ;
+
+
+genvar n ;
+generate for (n = 0; n < 8; n = n + 1) begin : ch
+
+   //---------------------------------------------------------------------------------
+   //  Settings
+
+   reg  [ 16-1: 0] set_rate  ;
+   reg  [ 24-1: 0] set_div   ;
+   reg             set_scrv  ;
+   reg  [ 16-1: 0] set_acc   ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         set_rate <= 16'd0 ;
+         set_div  <= 24'd0 ;
+         set_scrv <=  1'b0 ;
+         set_acc  <= 16'd0 ;
+      end
+      else if (wen_i) begin
+         if (addr_i[19:0] == REG_RAMP + 20'h0 + REG_CH*n)  set_rate <= wdata_i[16-1:0] ;
+         if (addr_i[19:0] == REG_RAMP + 20'h4 + REG_CH*n)  set_div  <= wdata_i[24-1:0] ;
+         if (addr_i[19:0] == REG_RAMP + 20'h8 + REG_CH*n)  {set_acc, set_scrv} <= {wdata_i[31:16], wdata_i[0]} ;
+      end
+   end
+
+   //---------------------------------------------------------------------------------
+   //  Ramp
+
+   reg  [ PW-1: 0] pos       ;        // signed, FW fractional bits
+   reg  [ 24-1: 0] vel       ;        // step of the last tick, FW fractional bits
+   reg  [ DW-1: 0] brk       ;        // distance covered while accelerating
+   reg             dir       ;        // 1 = downwards
+   reg  [ 24-1: 0] cnt       ;
+
+   wire [ PW-1: 0] tgt      = {sp_i[14*n +: 14], {FW{1'b0}}} ;
+   wire [ DW-1: 0] dist     = $signed(tgt) - $signed(pos) ;
+   wire [ DW-1: 0] dist_abs = dist[DW-1] ? -dist : dist ;
+   wire [ 24-1: 0] vmax     = {set_rate, {FW{1'b0}}} ;
+   wire [ 24-1: 0] acc      = (set_acc == 16'd0) ? 24'd1 : {8'd0, set_acc} ;
+   wire            tick     = (cnt >= set_div) ;
+
+   // S-curve step of this tick: brake, accelerate or cruise
+   wire            brake    = (dist_abs <= brk) ;
+   wire [ 25-1: 0] vel_up   = vel + acc ;
+   wire [ 24-1: 0] vel_nxt  = brake ? ((vel > acc) ? vel - acc : acc) :
+                              (vel_up >= vmax) ? vmax : vel_up[24-1:0] ;
+   wire [ 24-1: 0] step     = set_scrv ? vel_nxt : vmax ;
+   wire            reverse  = set_scrv && (vel != 24'd0) && (dist != {DW{1'b0}}) && (dist[DW-1] != dir) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         pos <= {PW{1'b0}} ;
+         vel <= 24'd0 ;
+         brk <= {DW{1'b0}} ;
+         dir <= 1'b0 ;
+         cnt <= 24'd0 ;
+      end
+      else if (set_rate == 16'd0) begin
+         pos <= tgt ;
+         vel <= 24'd0 ;
+         brk <= {DW{1'b0}} ;
+         cnt <= 24'd0 ;
+      end
+      else begin
+         cnt <= tick ? 24'd0 : cnt + 24'd1 ;
+
+         if (tick) begin
+            if (reverse) begin                   // stop, the next tick starts the other way
+               vel <= 24'd0 ;
+               brk <= {DW{1'b0}} ;
+            end
+            else if (dist_abs <= step) begin     // last step
+               pos <= tgt ;
+               vel <= 24'd0 ;
+               brk <= {DW{1'b0}} ;
+            end
+            else begin
+               pos <= dist[DW-1] ? pos - step : pos + step ;
+               dir <= dist[DW-1] ;
+               vel <= step ;
+               if (brake)
+                  brk <= (brk > vel) ? brk - vel : {DW{1'b0}} ;
+               else if (vel_nxt > vel)
+                  brk <= brk + vel_nxt ;
+            end
+         end
+      end
+   end
+
+   assign sp_o[14*n +: 14] = (set_rate == 16'd0) ? sp_i[14*n +: 14] : pos[PW-1:FW] ;
+   assign done_o[n]        = (set_rate == 16'd0) || (pos == tgt) ;
+
+   assign rate_w[16*n +: 16] = set_rate ;
+   assign div_w [24*n +: 24] = set_div ;
+   assign cfg_w [32*n +: 32] = {set_acc, {16-1{1'b0}}, set_scrv} ;
+
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+integer j ;
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   if (addr_i[19:0] == REG_RAMP_DONE)  rdata_o = {{32-8{1'b0}}, done_o} ;
+   for (j = 0; j < 8; j = j + 1) begin
+      if (addr_i[19:0] == REG_RAMP + 20'h0 + REG_CH*j)  rdata_o = {{32-16{1'b0}}, rate_w[16*j +: 16]} ;
+      if (addr_i[19:0] == REG_RAMP + 20'h4 + REG_CH*j)  rdata_o = {{32-24{1'b0}}, div_w[24*j +: 24]} ;
+      if (addr_i[19:0] == REG_RAMP + 20'h8 + REG_CH*j)  rdata_o = cfg_w[32*j +: 32] ;
+      if (addr_i[19:0] == REG_RAMP + 20'hC + REG_CH*j)  rdata_o = {{32-14{sp_o[14*j+13]}}, sp_o[14*j +: 14]} ;
+   end
+end
+
+endmodule
@@ -0,0 +1,303 @@
+/**
+Title: Red Pitaya PID Routing Crossbar
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Input and output routing of the eight PID channels.
+ *
+ *
+ *   fast ADC A, B   --\      /-------\                /---------\
+ *   slow ADC A - D  ---+---> | INPUT | --> PID n ---+-| OUTPUT  | ---> fast DAC A, B
+ *   PID outputs     --/      \-------/              | | SUM/SAT | ---> slow DAC A - D
+ *                        set point (or register)    | \---------/
+ *                                                   \---> sources
+ *
+ * Every channel takes its input from one source and, optionally, its set
+ * point from another instead of the set point register, so a loop can run
+ * on a slow ADC, on another loop's output, or as the inner loop of a
+ * cascade whose outer loop sets its set point each clock. Every output is
+ * a signed sum of any of the channel outputs, saturated to its range.
+ *
+ * Sources (SRC):
+ *   0, 1   fast ADC A, B
+ *   2 - 5  slow ADC A - D
+ *   6, 7   zero
+ *   8 + n  output of PID channel n (index as in red_pitaya_pid.v)
+ *
+ * Values cross between the 14 bit fast and the 12 bit slow channels at the
+ * same fraction of full scale: slow values are shifted up by two bits into
+ * a fast channel, fast values down by two bits into a slow one. The paths
+ * are combinational; a loop output is one clock old, as the PID blocks
+ * register it.
+ *
+ * The loop analyzer excitation of output injection is added once to each
+ * output that sums the injected channel, with the sign of that channel.
+ * The anti-windup excess of a channel is that of the first output that
+ * sums it (fast DAC A, B, then slow DAC A - D), with the sign of the
+ * channel; 0 if it feeds no output. It is in fast counts for the fast
+ * channels and in slow counts for the slow ones.
+ *
+ * The reset values are the fixed wiring of before: 11 and 21 on fast ADC
+ * A, 12 and 22 on fast ADC B, slow channel n on slow ADC n; fast DAC A is
+ * 11 + 12, fast DAC B 21 + 22 and slow DAC n slow channel n.
+ *
+ * Registers:
+ *   0x800 + 0x4*n  input of channel n: [3:0] input SRC, [11:8] set point
+ *                  SRC, [16] set point from its SRC instead of the register
+ *   0x820 + 0x4*m  output m (0, 1 fast DAC A, B; 2 - 5 slow DAC A - D):
+ *                  [2*n+1:2*n] term of channel n, 1 = +, 3 = -, 0 or 2 = none
+ */
+
+
+
+module red_pitaya_pid_route
+(
+   input                 clk_i     ,  // clock
+   input                 rstn_i    ,  // reset - active low
+
+   input    [2*14-1: 0]  fast_adc_i,  // fast ADC A, B
+   input    [4*12-1: 0]  slow_adc_i,  // slow ADC A - D
+   input    [4*14-1: 0]  fast_pid_i,  // outputs of the fast channels
+   input    [4*12-1: 0]  slow_pid_i,  // outputs of the slow channels
+   input    [8*14-1: 0]  sp_i      ,  // set points from the registers, channel n at [14*n +: 14]
+   input    [  16-1: 0]  exc_i     ,  // loop analyzer excitation
+   input    [   8-1: 0]  inj_i     ,  // output injection per channel
+
+   output   [8*14-1: 0]  dat_o     ,  // channel inputs, slow channels sign extended
+   output   [8*14-1: 0]  sp_o      ,  // channel set points, slow channels sign extended
+   output   [2*14-1: 0]  dac_o     ,  // fast DAC A, B
+   output   [4*12-1: 0]  pwm_o     ,  // slow DAC A - D
+   output   [8*17-1: 0]  exc_o     ,  // anti-windup excess, slow channels in slow counts
+
+   // system bus
+   input    [ 32-1: 0]   addr_i    ,  // address
+   input    [ 32-1: 0]   wdata_i   ,  // write data
+   input                 wen_i     ,  // write enable
+   output reg [ 32-1: 0] rdata_o      // read data, 0 outside the routing registers
+);
+
+localparam SW = 20 ;                  // output sum, eight terms and the excitation
+
+
+
+//---------------------------------------------------------------------------------
+//  Settings
+
+reg  [ 4-1: 0] in_src  [0:8-1] ;
+reg  [ 4-1: 0] sp_src  [0:8-1] ;
+reg            sp_sel  [0:8-1] ;
+reg  [16-1: 0] out_trm [0:6-1] ;
+
+integer i ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      for (i = 0; i < 8; i = i + 1) begin
+         in_src[i] <= (i < 4) ? i % 2 : i - 2 ;
+         sp_src[i] <= 4'd0 ;
+         sp_sel[i] <= 1'b0 ;
+      end
+      out_trm[0] <= 16'h0005 ;        // 11 + 12
+      out_trm[1] <= 16'h0050 ;        // 21 + 22
+      out_trm[2] <= 16'h0100 ;
+      out_trm[3] <= 16'h0400 ;
+      out_trm[4] <= 16'h1000 ;
+      out_trm[5] <= 16'h4000 ;
+   end
+   else if (wen_i) begin
+      for (i = 0; i < 8; i = i + 1) begin
+         if (addr_i[19:0] == 20'h800 + 4*i)
+            {sp_sel[i], sp_src[i], in_src[i]} <= {wdata_i[16], wdata_i[11:8], wdata_i[3:0]} ;
+      end
+      for (i = 0; i < 6; i = i + 1) begin
+         if (addr_i[19:0] == 20'h820 + 4*i)
+            out_trm[i] <= wdata_i[16-1:0] ;
+      end
+   end
+end
+
+
+
+//---------------------------------------------------------------------------------
+//  Sources, in fast and in slow counts
+
+wire [16*14-1: 0] src14 ;
+wire [16*12-1: 0] src12 ;
+
+genvar s ;
+generate for (s = 0; s < 16; s = s + 1) begin : src
+   if (s < 2) begin
+      assign src14[14*s +: 14] = fast_adc_i[14*s +: 14] ;
+      assign src12[12*s +: 12] = fast_adc_i[14*s+2 +: 12] ;
+   end
+   else if (s < 6) begin
+      assign src14[14*s +: 14] = {slow_adc_i[12*(s-2) +: 12], 2'b00} ;
+      assign src12[12*s +: 12] = slow_adc_i[12*(s-2) +: 12] ;
+   end
+   else if (s < 8) begin
+      assign src14[14*s +: 14] = 14'h0 ;
+      assign src12[12*s +: 12] = 12'h0 ;
+   end
+   else if (s < 12) begin
+      assign src14[14*s +: 14] = fast_pid_i[14*(s-8) +: 14] ;
+      assign src12[12*s +: 12] = fast_pid_i[14*(s-8)+2 +: 12] ;
+   end
+   else begin
+      assign src14[14*s +: 14] = {slow_pid_i[12*(s-12) +: 12], 2'b00} ;
+      assign src12[12*s +: 12] = slow_pid_i[12*(s-12) +: 12] ;
+   end
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Channel inputs and set points
+
+genvar n ;
+generate for (n = 0; n < 8; n = n + 1) begin : ch
+   if (n < 4) begin
+      assign dat_o[14*n +: 14] = src14[14*in_src[n] +: 14] ;
+      assign sp_o [14*n +: 14] = sp_sel[n] ? src14[14*sp_src[n] +: 14] : sp_i[14*n +: 14] ;
+   end
+   else begin
+      wire [12-1: 0] dat = src12[12*in_src[n] +: 12] ;
+      wire [12-1: 0] sp  = sp_sel[n] ? src12[12*sp_src[n] +: 12] : sp_i[14*n +: 12] ;
+      assign dat_o[14*n +: 14] = {{2{dat[12-1]}}, dat} ;
+      assign sp_o [14*n +: 14] = {{2{sp[12-1]}}, sp} ;
+   end
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Output sums and saturation
+
+wire [6*17-1: 0] out_exc ;            // clamped - unclamped sum, fast counts
+
+genvar m ;
+generate for (m = 0; m < 6; m = m + 1) begin : out
+
+   // plus and minus terms, the excitation once with the sign of the injected channel
+   wire [8-1: 0] pos ;
+   wire [8-1: 0] neg ;
+   reg  [SW-1: 0] sum ;
+   integer k ;
+
+   for (s = 0; s < 8; s = s + 1) begin : trm
+      assign pos[s] = (out_trm[m][2*s +: 2] == 2'b01) ;
+      assign neg[s] = (out_trm[m][2*s +: 2] == 2'b11) ;
+   end
+
+   always @(*) begin
+      sum = {SW{1'b0}} ;
+      for (k = 0; k < 8; k = k + 1) begin
+         if (m < 2) begin
+            if (pos[k])  sum = $signed(sum) + $signed(src14[14*(8+k) +: 14]) ;
+            if (neg[k])  sum = $signed(sum) - $signed(src14[14*(8+k) +: 14]) ;
+         end
+         else begin
+            if (pos[k])  sum = $signed(sum) + $signed(src12[12*(8+k) +: 12]) ;
+            if (neg[k])  sum = $signed(sum) - $signed(src12[12*(8+k) +: 12]) ;
+         end
+      end
+      if (|(inj_i & pos))
+         sum = $signed(sum) + $signed(exc_i) ;
+      else if (|(inj_i & neg))
+         sum = $signed(sum) - $signed(exc_i) ;
+   end
+
+   if (m < 2) begin
+      // registered, as the output stage of before
+      reg  [14-1: 0] sat ;
+      reg  [17-1: 0] exc ;
+
+      always @(posedge clk_i) begin
+         if (rstn_i == 1'b0) begin
+            sat <= 14'd0 ;
+            exc <= 17'd0 ;
+         end
+         else if (sum[SW-1:14-1] == {SW-14+1{sum[SW-1]}}) begin  // in range
+            sat <= sum[14-1:0] ;
+            exc <= 17'd0 ;
+         end
+         else if (sum[SW-1]) begin                               // negative sat
+            sat <= 14'h2000 ;
+            exc <= sat17($signed(20'hFE000) - $signed(sum)) ;
+         end
+         else begin                                              // positive sat
+            sat <= 14'h1FFF ;
+            exc <= sat17($signed(20'h01FFF) - $signed(sum)) ;
+         end
+      end
+
+      assign dac_o  [14*m +: 14] = sat ;
+      assign out_exc[17*m +: 17] = exc ;
+   end
+   else begin
+      // the DAC converter registers the slow outputs
+      wire           in_rng = (sum[SW-1:12-1] == {SW-12+1{sum[SW-1]}}) ;
+      wire [SW-1: 0] exc    = in_rng    ? {SW{1'b0}} :
+                              sum[SW-1] ? $signed(20'hFF800) - $signed(sum) :
+                                          $signed(20'h007FF) - $signed(sum) ;
+
+      assign pwm_o  [12*(m-2) +: 12] = in_rng ? sum[12-1:0] : sum[SW-1] ? 12'h800 : 12'h7FF ;
+      assign out_exc[17*m +: 17]     = sat17($signed({exc, 2'b00})) ;
+   end
+end endgenerate
+
+// signed excess limited to 17 bits
+function [17-1:0] sat17 ;
+   input [SW+2-1:0] a_val ;
+   begin
+      if (a_val[SW+2-1:17-1] == {SW+2-17+1{a_val[SW+2-1]}})
+         sat17 = a_val[17-1:0] ;
+      else
+         sat17 = a_val[SW+2-1] ? 17'h10000 : 17'h0FFFF ;
+   end
+endfunction
+
+
+
+//---------------------------------------------------------------------------------
+//  Anti-windup excess of the channels
+
+generate for (n = 0; n < 8; n = n + 1) begin : aw
+   reg  [17-1: 0] exc ;
+   integer k ;
+
+   always @(*) begin
+      exc = 17'd0 ;
+      for (k = 5; k >= 0; k = k - 1) begin
+         if (out_trm[k][2*n +: 2] == 2'b01)  exc = out_exc[17*k +: 17] ;
+         if (out_trm[k][2*n +: 2] == 2'b11)  exc = -$signed(out_exc[17*k +: 17]) ;
+      end
+   end
+
+   if (n < 4)
+      assign exc_o[17*n +: 17] = exc ;
+   else
+      assign exc_o[17*n +: 17] = $signed(exc) >>> 2 ;
+end endgenerate
+
+
+
+//---------------------------------------------------------------------------------
+//  Register read back
+//---------------------------------------------------------------------------------
+
+integer j ;
+
+always @(*) begin
+   rdata_o = 32'h0 ;
+   for (j = 0; j < 8; j = j + 1) begin
+      if (addr_i[19:0] == 20'h800 + 4*j)  rdata_o = {{32-17{1'b0}}, sp_sel[j], 4'h0, sp_src[j], 4'h0, in_src[j]} ;
+   end
+   for (j = 0; j < 6; j = j + 1) begin
+      if (addr_i[19:0] == 20'h820 + 4*j)  rdata_o = {{32-16{1'b0}}, out_trm[j]} ;
+   end
+end
+
+endmodule
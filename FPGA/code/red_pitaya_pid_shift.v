@@ -0,0 +1,45 @@
+/**
+Title: Red Pitaya PID Term Resolution Shifter
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Arithmetic right shift of a PID term by its resolution setting.
+ *
+ *
+ *              /---------\
+ *   dat_i ---> | >>> sh  | ---> dat_o
+ *              \---------/
+ *                   ^
+ *   sh_i --> clamp -+- + OFS
+ *
+ *
+ * One barrel shifter serves the P, I and D resolutions of any width in place
+ * of a case table per term. Settings from LO to HI shift by their value,
+ * anything else by DEF, as the tables did. OFS is added to every setting so a
+ * datapath with OFS extra fractional gain bits keeps the meaning of the
+ * resolution registers.
+ */
+
+
+
+module red_pitaya_pid_shift #(
+   parameter W   = 29 ,               // data width
+   parameter LO  =  5 ,               // lowest valid setting
+   parameter HI  = 15 ,               // highest valid setting
+   parameter DEF = 12 ,               // shift of invalid settings
+   parameter OFS =  0                 // added to every shift
+)
+(
+   input    [ W-1: 0] dat_i ,         // signed input
+   input    [ 5-1: 0] sh_i  ,         // resolution setting
+   output   [ W-1: 0] dat_o           // signed output
+);
+
+wire [ 6-1: 0] sh = ((sh_i >= LO && sh_i <= HI) ? sh_i : DEF) + OFS ;
+
+assign dat_o = $signed(dat_i) >>> sh ;
+
+endmodule
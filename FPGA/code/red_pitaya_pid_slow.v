@@ -0,0 +1,480 @@
+/**
+Title: Red Pitaya Slow PID Engine
+Author: Lewis Woolfson
+*/
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Time multiplexed PID controller of the slow analog channels.
+ *
+ *
+ *            /-----\     /---------\     /-------\     /-----------\
+ *   IN n --> | MUX | --> | - & TOL | --> | x Kp  | --> | SUM & SAT | --> OUT n
+ *   set n    \-----/     \---------/     | x Ki  |     \-----------/
+ *               ^                        | x Kd  |           ^
+ *               |                        \-------/           |
+ *             slot                           |     /-------\ |
+ *                                            +---> | STATE | +
+ *                                                  \-------/
+ *
+ * One pipeline serves NUM channels round-robin, one channel per clock. A
+ * channel is sampled every SLOTS clocks (NUM rounded up to a power of two),
+ * far faster than the XADC updates the slow inputs, so a loop behaves as the
+ * per-channel red_pitaya_pid_block did while the whole engine uses three
+ * multipliers whatever the number of channels.
+ *
+ * Integrator, last derivative sample and integrator clock divider of every
+ * channel live in distributed RAM and are read, updated and written back in
+ * one pipeline stage. Only the outputs, telemetry and saturation flags are
+ * kept in registers per channel.
+ *
+ * The integrator divider still counts clocks: every visit advances it by
+ * SLOTS. With ICD below SLOTS the integrator runs on every visit with the
+ * product weighted by SLOTS / (ICD + 1), rounded down to a power of two:
+ * with ICD + 1 not a power of two the integral gain comes out low, by up to
+ * a factor of two (ICD = 2 with SLOTS = 4 weights by 1 instead of 4/3, 3/4
+ * of the gain asked for). ICD + 1 a power of two up to SLOTS is exact, and
+ * so is a multiple of SLOTS, one integration every (ICD + 1) / SLOTS
+ * visits; other values above SLOTS integrate on the first visit after
+ * every ICD + 1 clocks, to the visit granularity. red_pitaya_pid_slow_tb
+ * checks both against the per-channel blocks.
+ *
+ * The derivative is the difference of the scaled Kd product since the last
+ * visit, SLOTS clocks back, and is divided by SLOTS (DSR + CW), so a slope
+ * gives the D term of the one clock difference of red_pitaya_pid_block
+ * with the same Kd and DSR. The term is held for the SLOTS clocks until
+ * the next visit.
+ *
+ * The tolerance and the resolutions behave as in red_pitaya_pid_block, and so
+ * do the feedforward term ff_i, added to the sum before the saturation, and
+ * the bumpless ISR changes of int_scale_i: the ISR of the last visit is
+ * kept with the state, and a visit with another ISR rescales the integrator
+ * instead of integrating.
+ *
+ * The anti-windup (awm_i, awk_i) is that of red_pitaya_pid_block: the
+ * excess of the output after every clamp, the saturation of the sum here
+ * plus the excess of the output stage (sat_exc_i, slow counts), holds the
+ * integrator (conditional integration) or is bled back into it at 2^-AWK
+ * per integrator update (back-calculation). A visit sees the excess its
+ * channel left on the previous visit, one visit late with SLOTS = 2; AWK
+ * below 3 acts as 3 as in the fast blocks.
+ */
+
+
+
+module red_pitaya_pid_slow #(
+   parameter NUM = 4                        // channels, 1 - 64
+)
+(
+   input                     clk_i       ,  // clock
+   input                     rstn_i      ,  // reset - active low
+
+   // data, channel n at [w*n +: w]
+   input      [NUM*12-1: 0]  dat_i       ,  // input data
+   output     [NUM*12-1: 0]  dat_o       ,  // output data
+
+   // PID parameters
+   input      [NUM*12-1: 0]  set_sp_i    ,  // set point
+   input      [NUM*12-1: 0]  set_kp_i    ,  // Kp
+   input      [NUM*12-1: 0]  set_ki_i    ,  // Ki
+   input      [NUM*12-1: 0]  set_kd_i    ,  // Kd
+   input      [NUM   -1: 0]  int_rst_i   ,  // integrator reset
+   input      [NUM   -1: 0]  int_hold_i  ,  // sample and hold
+   input      [NUM   -1: 0]  int_scale_i ,  // rescale the integrator on ISR changes
+   input      [NUM* 5-1: 0]  psr_i       ,  // proportional signal resolution
+   input      [NUM* 5-1: 0]  isr_i       ,  // integral signal resolution
+   input      [NUM* 5-1: 0]  dsr_i       ,  // derivative signal resolution
+   input      [NUM*30-1: 0]  icd_i       ,  // integral clock divider
+   input      [NUM* 9-1: 0]  tol_i       ,  // tolerance
+   input      [NUM*16-1: 0]  ff_i        ,  // feedforward term, output counts
+   input      [NUM* 2-1: 0]  awm_i       ,  // anti-windup mode, [0] conditional integration, [1] back-calculation
+   input      [NUM* 5-1: 0]  awk_i       ,  // anti-windup tracking gain, 2^-AWK
+   input      [NUM*15-1: 0]  sat_exc_i   ,  // excess of the output stage, clamped - unclamped sum
+
+   // telemetry, as red_pitaya_pid_block
+   input                     tlm_clr_i   ,  // clear sticky saturation flags
+   output     [NUM*32-1: 0]  tlm_err_o   ,  // error, sign extended
+   output     [NUM*32-1: 0]  tlm_int_o   ,  // integrator register
+   output     [NUM*32-1: 0]  tlm_p_o     ,  // proportional term, sign extended
+   output     [NUM*32-1: 0]  tlm_i_o     ,  // integral term
+   output     [NUM*32-1: 0]  tlm_d_o     ,  // derivative term, sign extended
+   output     [NUM* 2-1: 0]  tlm_sat_o   ,  // sticky saturation {output, integrator}
+   output     [NUM* 2-1: 0]  sat_o          // saturation of the last update {output, integrator}
+);
+
+localparam CW    = (NUM <= 2) ? 1 : (NUM <= 4) ? 2 : (NUM <= 8) ? 3 :
+                   (NUM <= 16) ? 4 : (NUM <= 32) ? 5 : 6 ;   // slot counter
+localparam SLOTS = 1 << CW ;
+localparam EW    = 12 + 1 ;                                 // error
+localparam MW    = EW + 12 ;                                // error times gain
+localparam XW    = 12 + 3 ;                                 // anti-windup excess
+localparam TW    = XW + 24 + 1 ;                            // tracking term
+
+// ceil(log2(a_val)) of 1 - 64
+function [3-1:0] log2c ;
+   input [7-1:0] a_val ;
+   integer k ;
+   begin
+      log2c = 3'd0 ;
+      for (k = 1; k < 7; k = k + 1)
+         if (a_val > (7'd1 << (k - 1)))
+            log2c = k ;
+   end
+endfunction
+
+
+
+
+//---------------------------------------------------------------------------------
+//  Channel select and error
+//---------------------------------------------------------------------------------
+
+reg  [ CW-1: 0] slot    ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0)
+      slot <= {CW{1'b0}} ;
+   else
+      slot <= slot + 1'b1 ;
+end
+
+reg             s1_vld  ;
+reg  [ CW-1: 0] s1_ch   ;
+reg  [ EW-1: 0] s1_err  ;
+reg  [ 12-1: 0] s1_kp   ;
+reg  [ 12-1: 0] s1_ki   ;
+reg  [ 12-1: 0] s1_kd   ;
+reg  [  5-1: 0] s1_psr  ;
+reg  [  5-1: 0] s1_isr  ;
+reg  [  5-1: 0] s1_dsr  ;
+reg  [ 30-1: 0] s1_icd  ;
+reg  [  9-1: 0] s1_tol  ;
+reg             s1_rst  ;
+reg             s1_hold ;
+reg             s1_scl  ;
+reg  [  2-1: 0] s1_awm  ;
+reg  [  5-1: 0] s1_awk  ;
+
+always @(posedge clk_i) begin
+   s1_vld  <= rstn_i && (slot < NUM) ;
+   s1_ch   <= slot ;
+   s1_err  <= $signed(set_sp_i[12*slot +: 12]) - $signed(dat_i[12*slot +: 12]) ;
+   s1_kp   <= set_kp_i[12*slot +: 12] ;
+   s1_ki   <= set_ki_i[12*slot +: 12] ;
+   s1_kd   <= set_kd_i[12*slot +: 12] ;
+   s1_psr  <= psr_i[5*slot +: 5] ;
+   s1_isr  <= isr_i[5*slot +: 5] ;
+   s1_dsr  <= dsr_i[5*slot +: 5] ;
+   s1_icd  <= icd_i[30*slot +: 30] ;
+   s1_tol  <= tol_i[9*slot +: 9] ;
+   s1_rst  <= int_rst_i[slot] ;
+   s1_hold <= int_hold_i[slot] ;
+   s1_scl  <= int_scale_i[slot] ;
+   s1_awm  <= awm_i[2*slot +: 2] ;
+   s1_awk  <= awk_i[5*slot +: 5] ;
+end
+
+
+
+
+//---------------------------------------------------------------------------------
+//  Gain products
+//---------------------------------------------------------------------------------
+
+// errors inside the tolerance clear the products (DSP48 M register reset)
+wire [ EW-1: 0] s1_abs  = s1_err[EW-1] ? -s1_err : s1_err ;
+wire            s1_zero = (s1_abs < s1_tol) ;
+
+// anti-windup: excess the channel left on its last visit (out of the
+// summation stage one clock before, with SLOTS of 4 or more), limited to
+// XW bits and scaled to integrator units by ISR and AWK
+wire [NUM*XW-1: 0] ch_exc ;
+wire [ XW  : 0] s1_exc  = $signed(ch_exc[XW*s1_ch +: XW]) + $signed(sat_exc_i[XW*s1_ch +: XW]) ;
+wire [ XW-1: 0] s1_xlim = (s1_exc[XW:XW-1] == 2'b01) ? {1'b0, {XW-1{1'b1}}} :
+                          (s1_exc[XW:XW-1] == 2'b10) ? {1'b1, {XW-1{1'b0}}} : s1_exc[XW-1:0] ;
+wire [  5-1: 0] s1_isrv = (s1_isr >= 14 && s1_isr <= 24) ? s1_isr : 5'd18 ;
+wire signed [TW-1: 0] s1_xext = $signed(s1_xlim) ;
+wire [ TW-1: 0] trk_shr ;
+
+red_pitaya_pid_shift #(.W (TW), .LO (3), .HI (31), .DEF (3)) i_trk_shr
+(
+  .dat_i  (  s1_xext <<< s1_isrv  ),
+  .sh_i   (  s1_awk               ),
+  .dat_o  (  trk_shr              )
+);
+
+reg             s2_vld  ;
+reg  [ CW-1: 0] s2_ch   ;
+reg  [ EW-1: 0] s2_err  ;
+(* use_dsp48 = "yes" *) reg  [ MW-1: 0] s2_kp ;
+(* use_dsp48 = "yes" *) reg  [ MW-1: 0] s2_ki ;
+(* use_dsp48 = "yes" *) reg  [ MW-1: 0] s2_kd ;
+reg  [  5-1: 0] s2_psr  ;
+reg  [  5-1: 0] s2_isr  ;
+reg  [  5-1: 0] s2_dsr  ;
+reg  [ 30-1: 0] s2_icd  ;
+reg             s2_rst  ;
+reg             s2_hold ;
+reg             s2_scl  ;
+reg  [ TW-1: 0] s2_trk  ;             // back-calculation term
+reg             s2_chi  ;             // clamped at the top, conditional integration
+reg             s2_clo  ;             // clamped at the bottom
+
+always @(posedge clk_i) begin
+   if (s1_zero) begin
+      s2_err <= {EW{1'b0}} ;
+      s2_kp  <= {MW{1'b0}} ;
+      s2_ki  <= {MW{1'b0}} ;
+      s2_kd  <= {MW{1'b0}} ;
+   end
+   else begin
+      s2_err <= s1_err ;
+      s2_kp  <= $signed(s1_err) * $signed(s1_kp) ;
+      s2_ki  <= $signed(s1_err) * $signed(s1_ki) ;
+      s2_kd  <= $signed(s1_err) * $signed(s1_kd) ;
+   end
+   s2_vld  <= s1_vld  ;
+   s2_ch   <= s1_ch   ;
+   s2_psr  <= s1_psr  ;
+   s2_isr  <= s1_isr  ;
+   s2_dsr  <= s1_dsr  ;
+   s2_icd  <= s1_icd  ;
+   s2_rst  <= s1_rst  ;
+   s2_hold <= s1_hold ;
+   s2_scl  <= s1_scl  ;
+   s2_trk  <= s1_awm[1] ? trk_shr : {TW{1'b0}} ;
+   s2_chi  <= s1_awm[0] && ($signed(s1_exc) < 0) ;
+   s2_clo  <= s1_awm[0] && ($signed(s1_exc) > 0) ;
+end
+
+
+
+
+//---------------------------------------------------------------------------------
+//  Channel state
+//---------------------------------------------------------------------------------
+
+// distributed RAM, invalid until the first write after reset
+reg  [ 32-1: 0] st_int [0:SLOTS-1] ;  // integrator
+reg  [ MW-1: 0] st_kd  [0:SLOTS-1] ;  // last shifted derivative product
+reg  [ 27-1: 0] st_cnt [0:SLOTS-1] ;  // clocks since the last integration
+reg  [  5-1: 0] st_isr [0:SLOTS-1] ;  // ISR of the last visit, 14 - 24
+reg  [SLOTS-1:0] st_vld ;
+
+wire            s2_stv  = st_vld[s2_ch] ;
+wire [ 32-1: 0] s2_int  = s2_stv ? st_int[s2_ch] : 32'h0 ;
+wire [ MW-1: 0] s2_kdr  = s2_stv ? st_kd[s2_ch]  : {MW{1'b0}} ;
+wire [ 27-1: 0] s2_cnt  = s2_stv ? st_cnt[s2_ch] : 27'h0 ;
+
+// bumpless ISR changes, int_nxt >> s2_isr stays what the last visit gave
+wire [  5-1: 0] isr_new = (s2_isr >= 14 && s2_isr <= 24) ? s2_isr : 5'd18 ;
+wire [  5-1: 0] isr_old = st_isr[s2_ch] ;
+wire            int_scl = s2_scl && s2_stv && (isr_new != isr_old) ;
+wire [ 42-1: 0] int_up  = {{10{s2_int[32-1]}}, s2_int} << (isr_new - isr_old) ;
+wire [ 32-1: 0] int_dn  = $signed(s2_int) >>> (isr_old - isr_new) ;
+wire            int_ovf = (int_up[42-1:32-1] != {11{s2_int[32-1]}}) ;
+
+// integrator clock division
+wire            icd_short = (s2_icd < SLOTS) ;
+wire [ 28-1: 0] cnt_sum   = s2_cnt + SLOTS ;
+wire            int_due   = icd_short || (cnt_sum > s2_icd) ;
+wire [ 27-1: 0] cnt_nxt   = icd_short ? 27'h0 : int_due ? cnt_sum - s2_icd - 28'd1 : cnt_sum ;
+wire [  3-1: 0] int_w     = icd_short ? CW - log2c(s2_icd[6:0] + 7'd1) : 3'd0 ;  // floor(log2(SLOTS / (ICD + 1)))
+
+wire [ 32-1: 0] ki_w      = $signed(s2_ki) <<< int_w ;
+
+// conditional integration: no integral step that drives further into the clamp
+wire            int_frz   = (s2_chi && $signed(ki_w) > 0) || (s2_clo && $signed(ki_w) < 0) ;
+wire [ 32-1: 0] ki_step   = int_frz ? 32'h0 : ki_w ;
+wire [TW+2-1: 0] int_sum  = $signed(ki_step) + $signed(s2_int) + $signed(s2_trk) ;
+
+reg  [ 32-1: 0] int_nxt   ;
+reg             int_lim   ;
+
+always @(*) begin
+   int_lim = 1'b0 ;
+   if (s2_rst)                           // integrator reset
+      int_nxt = 32'h0 ;
+   else if (int_scl && isr_new < isr_old)  // rescale to the new ISR
+      int_nxt = int_dn ;
+   else if (int_scl)
+      int_nxt = !int_ovf ? int_up[32-1:0] : s2_int[32-1] ? 32'h80000000 : 32'h7FFFFFFF ;
+   else if (s2_hold || !int_due)         // sample-and-hold, clock division
+      int_nxt = s2_int ;
+   else if ($signed(int_sum) > $signed(32'h7FFFFFFF)) begin
+      int_nxt = 32'h7FFFFFFF ;           // max positive
+      int_lim = 1'b1 ;
+   end
+   else if ($signed(int_sum) < $signed(32'h80000000)) begin
+      int_nxt = 32'h80000000 ;           // max negative
+      int_lim = 1'b1 ;
+   end
+   else
+      int_nxt = int_sum[32-1:0] ;
+end
+
+wire [ MW-1: 0] kp_shr ;
+wire [ MW-1: 0] kd_shr ;
+
+red_pitaya_pid_shift #(.W (MW), .LO (5), .HI (15), .DEF (12)) i_kp_shr
+(
+  .dat_i  (  s2_kp   ),
+  .sh_i   (  s2_psr  ),
+  .dat_o  (  kp_shr  )
+);
+
+red_pitaya_pid_shift #(.W (MW), .LO (3), .HI (13), .DEF (10), .OFS (CW)) i_kd_shr
+(
+  .dat_i  (  s2_kd   ),
+  .sh_i   (  s2_dsr  ),
+  .dat_o  (  kd_shr  )
+);
+
+always @(posedge clk_i) begin
+   if (s2_vld) begin
+      st_int[s2_ch] <= int_nxt ;
+      st_kd [s2_ch] <= kd_shr  ;
+      st_cnt[s2_ch] <= cnt_nxt ;
+      st_isr[s2_ch] <= isr_new ;
+   end
+end
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0)
+      st_vld <= {SLOTS{1'b0}} ;
+   else if (s2_vld)
+      st_vld[s2_ch] <= 1'b1 ;
+end
+
+reg             s3_vld  ;
+reg  [ CW-1: 0] s3_ch   ;
+reg  [ EW-1: 0] s3_err  ;
+reg  [ MW-1: 0] s3_p    ;
+reg  [ MW  : 0] s3_d    ;
+reg  [ 32-1: 0] s3_int  ;
+reg             s3_ilim ;
+reg  [  5-1: 0] s3_isr  ;
+
+always @(posedge clk_i) begin
+   s3_vld  <= s2_vld ;
+   s3_ch   <= s2_ch  ;
+   s3_err  <= s2_err ;
+   s3_p    <= kp_shr ;
+   s3_d    <= $signed(kd_shr) - $signed(s2_kdr) ;
+   s3_int  <= int_nxt ;
+   s3_ilim <= int_lim ;
+   s3_isr  <= s2_isr ;
+end
+
+
+
+
+//---------------------------------------------------------------------------------
+//  Integral term resolution
+//---------------------------------------------------------------------------------
+
+wire [ 32-1: 0] ki_shr ;
+
+red_pitaya_pid_shift #(.W (32), .LO (14), .HI (24), .DEF (18)) i_ki_shr
+(
+  .dat_i  (  s3_int  ),
+  .sh_i   (  s3_isr  ),
+  .dat_o  (  ki_shr  )
+);
+
+reg             s4_vld  ;
+reg  [ CW-1: 0] s4_ch   ;
+reg  [ EW-1: 0] s4_err  ;
+reg  [ MW-1: 0] s4_p    ;
+reg  [ MW  : 0] s4_d    ;
+reg  [ 32-1: 0] s4_i    ;
+reg  [ 32-1: 0] s4_int  ;
+reg             s4_ilim ;
+
+always @(posedge clk_i) begin
+   s4_vld  <= s3_vld  ;
+   s4_ch   <= s3_ch   ;
+   s4_err  <= s3_err  ;
+   s4_p    <= s3_p    ;
+   s4_d    <= s3_d    ;
+   s4_i    <= ki_shr  ;
+   s4_int  <= s3_int  ;
+   s4_ilim <= s3_ilim ;
+end
+
+
+
+
+//---------------------------------------------------------------------------------
+//  Summation, saturation and channel outputs
+//---------------------------------------------------------------------------------
+
+wire [ 34-1: 0] pid_sum = $signed(s4_p) + $signed(s4_i) + $signed(s4_d) + $signed(ff_i[16*s4_ch +: 16]) ;
+wire            pos_ovf = ({pid_sum[34-1], |pid_sum[34-2:11]} == 2'b01) ;
+wire            neg_ovf = ({pid_sum[34-1], &pid_sum[34-2:11]} == 2'b10) ;
+wire [ 12-1: 0] pid_sat = pos_ovf ? 12'h7FF : neg_ovf ? 12'h800 : pid_sum[12-1:0] ;
+wire [ 35-1: 0] sum_exc = $signed(pid_sat) - $signed(pid_sum) ;  // clamped - unclamped sum
+wire [ XW-1: 0] sat_exc = (sum_exc[35-1:XW-1] == {35-XW+1{sum_exc[35-1]}}) ? sum_exc[XW-1:0] :
+                          sum_exc[35-1] ? {1'b1, {XW-1{1'b0}}} : {1'b0, {XW-1{1'b1}}} ;
+
+genvar n ;
+generate for (n = 0; n < NUM; n = n + 1) begin : ch
+
+   reg  [ 12-1: 0] out     ;
+   reg  [  2-1: 0] sat     ;
+   reg  [  2-1: 0] lim     ;
+   reg  [ 32-1: 0] t_err   ;
+   reg  [ 32-1: 0] t_int   ;
+   reg  [ 32-1: 0] t_p     ;
+   reg  [ 32-1: 0] t_i     ;
+   reg  [ 32-1: 0] t_d     ;
+   reg  [ XW-1: 0] exc     ;
+
+   wire            upd = s4_vld && (s4_ch == n) ;
+
+   always @(posedge clk_i) begin
+      if (rstn_i == 1'b0) begin
+         out   <= 12'h0 ;
+         sat   <=  2'h0 ;
+         lim   <=  2'h0 ;
+         t_err <= 32'h0 ;
+         t_int <= 32'h0 ;
+         t_p   <= 32'h0 ;
+         t_i   <= 32'h0 ;
+         t_d   <= 32'h0 ;
+         exc   <= {XW{1'b0}} ;
+      end
+      else begin
+         if (tlm_clr_i)
+            sat <= 2'h0 ;
+         if (upd) begin
+            out   <= pid_sat ;
+            lim   <= {pos_ovf || neg_ovf, s4_ilim} ;
+            t_err <= $signed(s4_err) ;
+            t_int <= s4_int ;
+            t_p   <= $signed(s4_p) ;
+            t_i   <= s4_i ;
+            t_d   <= $signed(s4_d) ;
+            exc   <= sat_exc ;
+            if (pos_ovf || neg_ovf)
+               sat[1] <= 1'b1 ;
+            if (s4_ilim)
+               sat[0] <= 1'b1 ;
+         end
+      end
+   end
+
+   assign dat_o    [12*n +: 12] = out   ;
+   assign tlm_err_o[32*n +: 32] = t_err ;
+   assign tlm_int_o[32*n +: 32] = t_int ;
+   assign tlm_p_o  [32*n +: 32] = t_p   ;
+   assign tlm_i_o  [32*n +: 32] = t_i   ;
+   assign tlm_d_o  [32*n +: 32] = t_d   ;
+   assign tlm_sat_o[ 2*n +:  2] = sat   ;
+   assign sat_o    [ 2*n +:  2] = lim   ;
+   assign ch_exc   [XW*n +: XW] = exc   ;
+
+end endgenerate
+
+endmodule
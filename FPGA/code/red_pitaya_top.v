@@ -497,6 +497,7 @@ wire [24-1:0] ams_dac_a ;
 wire [24-1:0] ams_dac_b ;
 wire [24-1:0] ams_dac_c ;
 wire [24-1:0] ams_dac_d ;
+wire [ 4-1:0] ams_dac_act ;  // waveform playback, owns the DAC whatever the word
 
 red_pitaya_ams i_ams
 (
@@ -511,6 +512,8 @@ red_pitaya_ams i_ams
     .dac_b_o ( ams_dac_b ), // conversion into PWM signal
     .dac_c_o ( ams_dac_c ),
     .dac_d_o ( ams_dac_d ),
+    .dac_act_o ( ams_dac_act ), // waveform generator drives the DAC
+    .dio_i ( exp_p_in ), // waveform triggers
     
     .adc_temp_r(adc_temp),
     .adc_pint_r(adc_pint), 
@@ -544,24 +547,27 @@ red_pitaya_ams i_ams
 // Sumation of ASG and PID signal
 // 
 
+// a playing waveform drives its DAC even through 0 words, otherwise a
+// nonzero static AMS register overrides the PID as before
+
 always @(*) begin
 
-    if (ams_dac_a) 
+    if (ams_dac_act[0] || ams_dac_a) 
         dac_pwm_a <= ams_dac_a;
     else 
         dac_pwm_a <= pid_slow_a;
         
-    if (ams_dac_b) 
+    if (ams_dac_act[1] || ams_dac_b) 
         dac_pwm_b <= ams_dac_b;
     else 
         dac_pwm_b <= pid_slow_b;       
         
-    if (ams_dac_c) 
+    if (ams_dac_act[2] || ams_dac_c) 
          dac_pwm_c <= ams_dac_c;
     else 
          dac_pwm_c <= pid_slow_c;
  
-    if (ams_dac_d) 
+    if (ams_dac_act[3] || ams_dac_d) 
          dac_pwm_d <= ams_dac_d;
      else 
          dac_pwm_d <= pid_slow_d;     
@@ -0,0 +1,317 @@
+/**
+ * @brief AMS watch command of the monitor utility.
+ *
+ * Samples the temperature, the supply rails, the auxiliary inputs and the
+ * slow DAC outputs at a fixed rate for drift studies:
+ *
+ *   monitor -ams --watch rate=500 dec=5 time=3600 --output=drift.csv
+ *
+ * Each sample copies the whole AMS register block once and converts all
+ * channels with one table of scale and offset per channel (the constants
+ * of AmsConversion()). Rows hold the mean of 'dec' samples and go out as
+ * csv (time in seconds and the values in C and V), binary rows (see
+ * ams_cli.h) or nowhere. Minimum, maximum, mean and standard deviation of
+ * every channel over all samples are printed to stderr at the end.
+ *
+ * Parameters: rate in Hz (up to RP_AMS_WATCH_RATE_MAX), dec, count (rows)
+ * and time in seconds; without count and time it runs until interrupted.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <math.h>
+
+#include "monitor_io.h"
+#include "ams_cli.h"
+
+/* flushed at least this often, so a reader following the file keeps up */
+#define FLUSH_NS 100000000LL
+
+#define WORD(field) (offsetof(amsReg_t, field) / sizeof(uint32_t))
+
+typedef enum {
+	eOutCsv=0,
+	eOutBin,
+	eOutNone
+} outFormat_t;
+
+/* linear conversion of one AMS channel, see AmsConversion() */
+typedef struct {
+	int word;          // register index in amsReg_t
+	int shift;         // of the reading in the register
+	uint32_t limit;    // larger readings are negative inputs and read as 0
+	float scale;
+	float offset;
+} amsConv_t;
+
+/* running statistics of one channel (Welford) */
+typedef struct {
+	double min, max;
+	double mean, m2;
+} amsStat_t;
+
+static const char *chanName[eSendNum] = {
+	"temp", "ai0", "ai1", "ai2", "ai3", "ai4",
+	"vccpint", "vccpaux", "vccbram", "vccint", "vccaux", "vccddr",
+	"ao0", "ao1", "ao2", "ao3"
+};
+
+#define AI_SCALE   (0.5 / ADC_POS_RANGE_CNT * (30.0 + 4.99) / 4.99)
+#define VCC_SCALE  (3.0 / ADC_FULL_RANGE_CNT)
+#define AO_SCALE   (1.8 / SLOW_DAC_RANGE_CNT)
+
+static const amsConv_t conv[eSendNum] = {
+	[eAmsTemp]    = { WORD(temp),    0, 0xffffffff, 503.975 / ADC_FULL_RANGE_CNT, -273.15 },
+	[eAmsAI0]     = { WORD(aif[0]),  0, ADC_POS_RANGE_CNT, AI_SCALE, 0 },
+	[eAmsAI1]     = { WORD(aif[1]),  0, ADC_POS_RANGE_CNT, AI_SCALE, 0 },
+	[eAmsAI2]     = { WORD(aif[2]),  0, ADC_POS_RANGE_CNT, AI_SCALE, 0 },
+	[eAmsAI3]     = { WORD(aif[3]),  0, ADC_POS_RANGE_CNT, AI_SCALE, 0 },
+	[eAmsAI4]     = { WORD(aif[4]),  0, 0xffffffff, 1.0 / ADC_FULL_RANGE_CNT * (56.0 + 4.99) / 4.99, 0 },
+	[eAmsVCCPINT] = { WORD(vccPint), 0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsVCCPAUX] = { WORD(vccPaux), 0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsVCCBRAM] = { WORD(vccBram), 0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsVCCINT]  = { WORD(vccInt),  0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsVCCAUX]  = { WORD(vccAux),  0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsVCCDDR]  = { WORD(vccDddr), 0, 0xffffffff, VCC_SCALE, 0 },
+	[eAmsAO0]     = { WORD(dac[0]), 16, 0xffffffff, AO_SCALE, 0 },
+	[eAmsAO1]     = { WORD(dac[1]), 16, 0xffffffff, AO_SCALE, 0 },
+	[eAmsAO2]     = { WORD(dac[2]), 16, 0xffffffff, AO_SCALE, 0 },
+	[eAmsAO3]     = { WORD(dac[3]), 16, 0xffffffff, AO_SCALE, 0 },
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int a_sig)
+{
+	running = 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"\t-ams --watch [rate=Hz] [dec=n] [count=rows] [time=s] [--format=csv|bin|none]\n"
+		"\t             [--output=file|-]\n"
+		"rate up to %d Hz, default 100; statistics go to stderr at the end\n", RP_AMS_WATCH_RATE_MAX);
+}
+
+static int parse_double(const char *a_str, double *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtod(a_str, &end);
+	return (end == a_str || *end != '\0' || errno || !isfinite(*a_val)) ? -1 : 0;
+}
+
+static int64_t ns(const struct timespec *a_t)
+{
+	return (int64_t)a_t->tv_sec * 1000000000LL + a_t->tv_nsec;
+}
+
+/* one snapshot of the register block, converted */
+static void sample(const rpRegs_t *a_regs, float *a_val)
+{
+	amsReg_t snap;
+	const uint32_t *word = (const uint32_t *)&snap;
+
+	memcpy(&snap, (const void *)a_regs->ams, sizeof(snap));
+	for (int i = 0; i < eSendNum; ++i) {
+		uint32_t raw = word[conv[i].word] >> conv[i].shift;
+		if (raw > conv[i].limit) {
+			raw = 0;
+		}
+		a_val[i] = raw * conv[i].scale + conv[i].offset;
+	}
+}
+
+static void stat_add(amsStat_t *a_stat, long a_n, double a_val)
+{
+	double delta = a_val - a_stat->mean;
+
+	if (a_n == 1) {
+		a_stat->min = a_stat->max = a_val;
+	}
+	a_stat->min = fmin(a_stat->min, a_val);
+	a_stat->max = fmax(a_stat->max, a_val);
+	a_stat->mean += delta / a_n;
+	a_stat->m2 += delta * (a_val - a_stat->mean);
+}
+
+int ams_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	outFormat_t fmt = eOutCsv;
+	const char *output = "-";
+	double rate = 100, dec = 1, count = 0, duration = 0;
+
+	if (a_argc < 1 || strcmp(a_argv[0], "--watch") != 0) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	for (int i = 1; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		double val;
+
+		if (strncmp(a_argv[i], "--output=", 9) == 0) {
+			output = a_argv[i] + 9;
+		} else if (strncmp(a_argv[i], "--format=", 9) == 0) {
+			const char *name = a_argv[i] + 9;
+			if (strcmp(name, "csv") == 0) {
+				fmt = eOutCsv;
+			} else if (strcmp(name, "bin") == 0) {
+				fmt = eOutBin;
+			} else if (strcmp(name, "none") == 0) {
+				fmt = eOutNone;
+			} else {
+				fprintf(stderr, "ams: unknown format '%s'\n", name);
+				return EXIT_FAILURE;
+			}
+		} else if (eq == NULL || parse_double(eq + 1, &val) == -1 || val < 0) {
+			fprintf(stderr, "ams: expected par=val, got '%s'\n", a_argv[i]);
+			usage();
+			return EXIT_FAILURE;
+		} else if (strncasecmp(a_argv[i], "rate=", 5) == 0) {
+			rate = val;
+		} else if (strncasecmp(a_argv[i], "dec=", 4) == 0) {
+			dec = val;
+		} else if (strncasecmp(a_argv[i], "count=", 6) == 0) {
+			count = val;
+		} else if (strncasecmp(a_argv[i], "time=", 5) == 0) {
+			duration = val;
+		} else {
+			fprintf(stderr, "ams: unknown parameter '%s'\n", a_argv[i]);
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (!(rate > 0) || rate > RP_AMS_WATCH_RATE_MAX || dec < 1 || dec != floor(dec) || count != floor(count)) {
+		fprintf(stderr, "ams: value out of range\n");
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	FILE *fp = strcmp(output, "-") ? fopen(output, "w") : stdout;
+	if (fp == NULL) {
+		fprintf(stderr, "ams: %s: %s\n", output, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (fmt == eOutCsv) {
+		fprintf(fp, "time");
+		for (int i = 0; i < eSendNum; ++i) {
+			fprintf(fp, ",%s", chanName[i]);
+		}
+		fprintf(fp, "\n");
+	} else if (fmt == eOutBin) {
+		amsWatchHeader_t hdr = {
+			.version = RP_AMS_WATCH_VERSION, .headerSize = sizeof(hdr), .chanNum = eSendNum,
+			.dec = dec, .rate = rate / dec
+		};
+		memcpy(hdr.magic, RP_AMS_WATCH_MAGIC, sizeof(hdr.magic));
+		fwrite(&hdr, sizeof(hdr), 1, fp);
+	}
+	fflush(fp);
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	amsStat_t stat[eSendNum];
+	double sum[eSendNum];
+	float val[eSendNum];
+	struct {
+		int64_t time;
+		float val[eSendNum];
+	} row;
+	int64_t period = 1e9 / rate;
+	struct timespec next, now, wall;
+	int64_t tStart, tFlush, tRow = 0;
+	unsigned long rows = 0, overruns = 0;
+	long samples = 0, n = 0;
+
+	memset(stat, 0, sizeof(stat));
+	memset(sum, 0, sizeof(sum));
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	tStart = tFlush = ns(&next);
+
+	while (running && (count == 0 || rows < count)) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (duration > 0 && ns(&now) - tStart >= duration * 1e9) {
+			break;
+		}
+		if (n == 0) {
+			clock_gettime(CLOCK_REALTIME, &wall);
+			tRow = ns(&wall);
+		}
+		sample(a_regs, val);
+		++samples;
+		for (int i = 0; i < eSendNum; ++i) {
+			stat_add(&stat[i], samples, val[i]);
+			sum[i] += val[i];
+		}
+		if (++n == dec) {
+			row.time = tRow;
+			for (int i = 0; i < eSendNum; ++i) {
+				row.val[i] = sum[i] / dec;
+				sum[i] = 0;
+			}
+			n = 0;
+			++rows;
+			if (fmt == eOutCsv) {
+				fprintf(fp, "%.6f", tRow * 1e-9);
+				for (int i = 0; i < eSendNum; ++i) {
+					fprintf(fp, ",%.4f", row.val[i]);
+				}
+				fprintf(fp, "\n");
+			} else if (fmt == eOutBin) {
+				fwrite(&row, sizeof(row), 1, fp);
+			}
+			if (ns(&now) - tFlush >= FLUSH_NS) {
+				fflush(fp);
+				tFlush = ns(&now);
+			}
+		}
+
+		// absolute schedule, a late sample does not shift the ones after it
+		next.tv_nsec += period;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			++next.tv_sec;
+		}
+		if (ns(&next) < ns(&now)) {
+			++overruns;
+			next = now;
+			continue;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+
+	int err = ferror(fp);
+	if ((fp != stdout && fclose(fp) != 0) || (fp == stdout && fflush(fp) != 0) || err) {
+		fprintf(stderr, "ams: %s: write failed\n", output);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "#%ld samples, %lu rows, %lu overruns\n", samples, rows, overruns);
+	fprintf(stderr, "#ID\tName\tMin\tMax\tMean\tStd\n");
+	for (int i = 0; samples > 0 && i < eSendNum; ++i) {
+		double std = (samples > 1) ? sqrt(stat[i].m2 / (samples - 1)) : 0;
+		fprintf(stderr, "%d\t%s\t%.4f\t%.4f\t%.5f\t%.5f\n", i, chanName[i], stat[i].min, stat[i].max,
+		        stat[i].mean, std);
+	}
+	return EXIT_SUCCESS;
+}
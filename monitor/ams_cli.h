@@ -0,0 +1,51 @@
+/**
+ * @brief AMS watch command of the monitor utility.
+ *
+ * monitor -ams --watch [par=val ...] [--format=csv|bin|none] [--output=file]
+ *
+ * Binary output is an amsWatchHeader_t followed by rows of an int64_t
+ * CLOCK_REALTIME time stamp in nanoseconds and eSendNum floats in ams_t
+ * order, little endian.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef AMS_CLI_H
+#define AMS_CLI_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#define RP_AMS_WATCH_MAGIC   "RPAW"
+#define RP_AMS_WATCH_VERSION 1
+
+/*
+ * Highest watch rate: the XADC sequencer shares its 1 MS/s between the
+ * temperature, the supply rails and the auxiliary inputs, so a channel is
+ * converted again about every 20 us.
+ */
+#define RP_AMS_WATCH_RATE_MAX 50000
+
+/* binary output header */
+typedef struct {
+	char magic[4];        // RP_AMS_WATCH_MAGIC
+	uint16_t version;     // RP_AMS_WATCH_VERSION
+	uint16_t headerSize;  // sizeof(amsWatchHeader_t), offset of the first row
+	uint16_t chanNum;     // floats per row
+	uint16_t reserved;
+	uint32_t dec;         // samples averaged per row
+	double rate;          // rows per second
+} amsWatchHeader_t;
+
+/*
+ * Samples the AMS block at a fixed rate until the count or time is reached
+ * or SIGINT, a_argv[0] is "--watch". Returns EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int ams_cli(rpRegs_t *a_regs, int a_argc, char **a_argv);
+
+#endif /* AMS_CLI_H */
@@ -0,0 +1,409 @@
+/**
+ * @brief Relay feedback autotuning of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include "autotune.h"
+#include "capture.h"
+
+/* capture decimations tried, each 16 times the previous one */
+#define DEC_MAX      65536
+/* fewest samples per limit cycle period for a usable fundamental */
+#define PERIOD_MIN   16
+/* the integrator runs at least this many times per integral time */
+#define INT_STEPS    200
+
+/* the tuned parameters, in staging order */
+static const pidPar_t tunePar[] = {
+	ePidKp, ePidKi, ePidKd, ePidPSR, ePidISR, ePidDSR, ePidICD
+};
+#define TUNE_PAR_NUM (sizeof(tunePar) / sizeof(tunePar[0]))
+
+static const char *ruleName[eTuneRuleNum] = {
+	"zn", "tl", "simc"
+};
+
+static capSample_t samples[RP_CAP_DEPTH];
+static uint32_t cross[RP_CAP_DEPTH];
+
+const char *rp_tune_rule_name(tuneRule_t a_rule)
+{
+	return (a_rule >= 0 && a_rule < eTuneRuleNum) ? ruleName[a_rule] : "?";
+}
+
+tuneRule_t rp_tune_rule_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eTuneRuleNum && strcasecmp(a_name, ruleName[i]); ++i) {
+	}
+	return i;
+}
+
+void rp_tune_defaults(tuneConfig_t *a_cfg)
+{
+	memset(a_cfg, 0, sizeof(*a_cfg));
+	a_cfg->amp = 1024;
+	a_cfg->sign = 1;
+	a_cfg->periods = 8;
+	a_cfg->timeoutMs = 30000;
+}
+
+/* largest gain register value of the channel, the gains are signed on all channels */
+static int32_t gain_max(int a_ch)
+{
+	return (1L << (rp_pid_width(a_ch, ePidKp) - 1)) - 1;
+}
+
+static int32_t sign_extend(uint32_t a_raw, int a_width)
+{
+	a_raw &= (1UL << a_width) - 1;
+	return (a_raw >> (a_width - 1)) ? (int32_t)a_raw - (1L << a_width) : (int32_t)a_raw;
+}
+
+static void stage_raw(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, uint32_t a_raw)
+{
+	a_regs->pid[(RP_PID_SHADOW + rp_pid_offset(a_ch, a_par)) >> 2] = a_raw & ((1UL << rp_pid_width(a_ch, a_par)) - 1);
+}
+
+static int64_t elapsed_ms(const struct timespec *a_t0)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (t.tv_sec - a_t0->tv_sec) * 1000 + (t.tv_nsec - a_t0->tv_nsec) / 1000000;
+}
+
+/* fills the buffer with traces A and B of channel a_ch */
+static int record(rpRegs_t *a_regs, int a_ch, capSig_t a_sigA, capSig_t a_sigB, uint32_t a_dec)
+{
+	capConfig_t cfg;
+	capHeader_t hdr;
+
+	rp_cap_defaults(&cfg);
+	cfg.ch = a_ch;
+	cfg.sig[0] = a_sigA;
+	cfg.sig[1] = a_sigB;
+	cfg.dec = a_dec;
+	if (rp_cap_arm(a_regs, &cfg) != 0) {
+		return -EINVAL;
+	}
+	if (rp_cap_wait(a_regs, 1000 + RP_CAP_DEPTH * 1000.0 * a_dec / RP_CAP_CLOCK) != 0) {
+		rp_cap_stop(a_regs);
+		return -ETIMEDOUT;
+	}
+	return (rp_cap_read(a_regs, &hdr, samples) == RP_CAP_DEPTH) ? 0 : -EIO;
+}
+
+/*
+ * Trace A from the ADC input to the error ahead of the dead band, the
+ * relay acts on the error but the tolerance hides part of it.
+ */
+static void to_error(int32_t a_sp)
+{
+	for (int i = 0; i < RP_CAP_DEPTH; ++i) {
+		int32_t err = a_sp - samples[i].a;
+		samples[i].a = (err > 32767) ? 32767 : (err < -32768) ? -32768 : err;
+	}
+}
+
+/*
+ * Rising zero crossings of the error in trace A, with a hysteresis of a
+ * tenth of its amplitude. Returns their number.
+ */
+static int crossings(void)
+{
+	int min = samples[0].a, max = samples[0].a;
+	int num = 0;
+
+	for (int i = 1; i < RP_CAP_DEPTH; ++i) {
+		min = (samples[i].a < min) ? samples[i].a : min;
+		max = (samples[i].a > max) ? samples[i].a : max;
+	}
+	if (min >= 0 || max <= 0) {
+		return 0;
+	}
+	int hyst = (max - min) / 20 + 1;
+	int low = samples[0].a < 0;
+	for (int i = 1; i < RP_CAP_DEPTH; ++i) {
+		if (low && samples[i].a > hyst) {
+			cross[num++] = i;
+			low = 0;
+		} else if (samples[i].a < -hyst) {
+			low = 1;
+		}
+	}
+	return num;
+}
+
+/* fundamental of the last a_periods periods of both traces */
+static void fundamental(int a_num, int a_periods, tuneResult_t *a_res, double *a_errMean)
+{
+	uint32_t first = cross[a_num - 1 - a_periods];
+	uint32_t last = cross[a_num - 1];
+	double period = (double)(last - first) / a_periods;
+	double ur = 0, ui = 0, er = 0, ei = 0, um = 0, em = 0;
+
+	for (uint32_t k = first; k < last; ++k) {
+		double ph = 2 * M_PI * (k - first) / period;
+		ur += samples[k].b * cos(ph);
+		ui -= samples[k].b * sin(ph);
+		er += samples[k].a * cos(ph);
+		ei -= samples[k].a * sin(ph);
+		um += samples[k].b;
+		em += samples[k].a;
+	}
+	a_res->periods = a_periods;
+	a_res->pu = period * a_res->dec / RP_CAP_CLOCK;
+	a_res->amp = 2 * hypot(ur, ui) / (last - first);
+	a_res->errAmp = 2 * hypot(er, ei) / (last - first);
+	a_res->ku = a_res->amp / a_res->errAmp;
+	a_res->bias = um / (last - first);
+	*a_errMean = em / (last - first);
+}
+
+/*
+ * First order plus dead time model through the ultimate point, with the
+ * static gain from the biased relay: |G(jw)| = 1/Ku and arg G(jw) = -pi.
+ */
+static void plant_model(tuneResult_t *a_res, double a_y0, double a_yMean)
+{
+	double kuk, w = 2 * M_PI / a_res->pu;
+
+	a_res->k = (a_yMean - a_y0) / a_res->bias;
+	kuk = a_res->ku * fabs(a_res->k);
+	if (kuk <= 1) {
+		a_res->k = NAN;
+		return;
+	}
+	a_res->tau = sqrt(kuk * kuk - 1) / w;
+	a_res->theta = (M_PI - atan(w * a_res->tau)) / w;
+}
+
+int rp_tune_relay(rpRegs_t *a_regs, const tuneConfig_t *a_cfg, tuneResult_t *a_res)
+{
+	int ch = a_cfg->ch;
+	uint32_t saved[ePidParNum];
+	struct timespec t0;
+	double errMean;
+	int32_t sp;
+	int ret, num = 0;
+
+	if (ch < 0 || ch >= rp_pid_num() || (a_cfg->sign != 1 && a_cfg->sign != -1)) {
+		return -EINVAL;
+	}
+	int isr = 31 - (int)lround(log2(a_cfg->amp > 0 ? a_cfg->amp : 1));
+	if (a_cfg->amp < 1 || isr < 14 || isr > 24 || a_cfg->periods < 1 ||
+	    rp_pid_check(ch, ePidTol, a_cfg->tol) != 0) {
+		return -ERANGE;
+	}
+	memset(a_res, 0, sizeof(*a_res));
+	a_res->k = a_res->tau = a_res->theta = NAN;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	for (int par = 0; par < ePidParNum; ++par) {
+		saved[par] = rp_pid_read_raw(a_regs, ch, par);
+	}
+	sp = sign_extend(saved[ePidSp], rp_pid_width(ch, ePidSp));
+
+	// relay: the integrator alone, full gain and rate, saturating at +-2^(31-ISR)
+	stage_raw(a_regs, ch, ePidKp, 0);
+	stage_raw(a_regs, ch, ePidKd, 0);
+	stage_raw(a_regs, ch, ePidKi, a_cfg->sign * gain_max(ch));
+	stage_raw(a_regs, ch, ePidISR, isr);
+	stage_raw(a_regs, ch, ePidICD, 0);
+	stage_raw(a_regs, ch, ePidTol, a_cfg->tol);
+	stage_raw(a_regs, ch, ePidIrst, 1);
+	rp_pid_commit(a_regs, 1UL << ch);
+	stage_raw(a_regs, ch, ePidIrst, 0);
+	rp_pid_commit(a_regs, 1UL << ch);
+
+	// shortest decimation that holds the periods asked for
+	for (a_res->dec = 1; a_res->dec <= DEC_MAX; a_res->dec *= 16) {
+		if (elapsed_ms(&t0) > a_cfg->timeoutMs) {
+			ret = -ETIMEDOUT;
+			goto restore;
+		}
+		if ((ret = record(a_regs, ch, eCapAdc, eCapOut, a_res->dec)) != 0) {
+			goto restore;
+		}
+		to_error(sp);
+		num = crossings();
+		if (num > a_cfg->periods) {
+			break;
+		}
+	}
+	if (a_res->dec > DEC_MAX || (double)(cross[num - 1] - cross[0]) / (num - 1) < PERIOD_MIN) {
+		ret = -EAGAIN;
+		goto restore;
+	}
+	// the limit cycle has settled by now, measure on a fresh record
+	if ((ret = record(a_regs, ch, eCapAdc, eCapOut, a_res->dec)) != 0) {
+		goto restore;
+	}
+	to_error(sp);
+	num = crossings();
+	if (num <= a_cfg->periods) {
+		ret = -EAGAIN;
+		goto restore;
+	}
+	fundamental(num, a_cfg->periods, a_res, &errMean);
+
+	// a biased relay gives the static gain, with the plant output at zero PID output
+	if (fabs(a_res->bias) > 0.05 * a_res->amp) {
+		stage_raw(a_regs, ch, ePidKi, 0);
+		stage_raw(a_regs, ch, ePidIrst, 1);
+		rp_pid_commit(a_regs, 1UL << ch);
+		usleep(fmin(20 * a_res->pu, 5.0) * 1e6);
+		if (record(a_regs, ch, eCapAdc, eCapOut, a_res->dec) == 0) {
+			double y0 = 0;
+			for (int k = 0; k < RP_CAP_DEPTH; ++k) {
+				y0 += samples[k].a;
+			}
+			plant_model(a_res, y0 / RP_CAP_DEPTH, sp - errMean);
+		}
+	}
+	ret = 0;
+
+restore:
+	for (int par = 0; par < ePidParNum; ++par) {
+		stage_raw(a_regs, ch, par, saved[par]);
+	}
+	rp_pid_commit(a_regs, 1UL << ch);
+	return ret;
+}
+
+int rp_tune_gains(const tuneResult_t *a_res, tuneRule_t a_rule, int a_pi, int a_sign, tuneGains_t *a_gains)
+{
+	switch (a_rule) {
+		case eTuneZN:
+			a_gains->kc = a_pi ? 0.45 * a_res->ku : 0.6 * a_res->ku;
+			a_gains->ti = a_pi ? a_res->pu / 1.2 : a_res->pu / 2;
+			a_gains->td = a_pi ? 0 : a_res->pu / 8;
+			break;
+		case eTuneTL:
+			a_gains->kc = a_pi ? a_res->ku / 3.2 : a_res->ku / 2.2;
+			a_gains->ti = 2.2 * a_res->pu;
+			a_gains->td = a_pi ? 0 : a_res->pu / 6.3;
+			break;
+		case eTuneSIMC:
+			// PI for the first order model, closed loop time constant = dead time
+			if (isnan(a_res->k)) {
+				return -EINVAL;
+			}
+			a_gains->kc = a_res->tau / (fabs(a_res->k) * 2 * a_res->theta);
+			a_gains->ti = fmin(a_res->tau, 8 * a_res->theta);
+			a_gains->td = 0;
+			break;
+		default:
+			return -EINVAL;
+	}
+	a_gains->kc *= a_sign;
+	return 0;
+}
+
+void rp_tune_fit(int a_ch, const tuneGains_t *a_gains, tuneFit_t *a_fit)
+{
+	int32_t max = gain_max(a_ch);
+	int frac = rp_pid_width(a_ch, ePidKp) - rp_pid_width(a_ch, ePidSp);  // gain bits below the set point
+	double kp = 0, ki = 0, kd = 0;
+	int psr, isr, dsr;
+	uint32_t icd = 0;
+
+	memset(a_fit, 0, sizeof(*a_fit));
+
+	// proportional: kp / 2^PSR, the finest shift that keeps kp in range
+	for (psr = 15; psr >= 5; --psr) {
+		kp = round(a_gains->kc * ldexp(1, psr + frac));
+		if (fabs(kp) <= max) {
+			break;
+		}
+	}
+	if (psr < 5) {
+		psr = 5;
+		kp = copysign(max, a_gains->kc);
+		a_fit->clip |= RP_TUNE_CLIP_P;
+	}
+
+	// integral: ki * f / 2^ISR per second, f = clock / (ICD + 1); the
+	// integrator must span the output range, 2^(31-ISR) >= full scale
+	double kint = (a_gains->ti > 0) ? a_gains->kc / a_gains->ti : 0;
+	int isrMax = 32 - rp_pid_width(a_ch, ePidSp);
+	for (isr = isrMax; isr >= 14; --isr) {
+		ki = round(kint * ldexp(1, isr + frac) / RP_PID_CLOCK);
+		if (fabs(ki) <= max) {
+			break;
+		}
+	}
+	if (isr < 14) {
+		isr = 14;
+		ki = copysign(max, kint);
+		a_fit->clip |= RP_TUNE_CLIP_I;
+	} else if (isr == isrMax && kint != 0 && fabs(ki) < max / 2) {
+		// small gains lose their bits, slow the integrator down instead
+		double div = floor(max * RP_PID_CLOCK / (fabs(kint) * ldexp(1, isr + frac)));
+		div = fmin(div, RP_PID_CLOCK * a_gains->ti / INT_STEPS);
+		if (div > 1) {
+			// a divider the monitor shows and sets as a whole frequency
+			icd = rp_pid_encode(a_ch, ePidICD, rp_pid_decode(a_ch, ePidICD, div - 1) + 1);
+		}
+		ki = round(kint * ldexp(1, isr + frac) * (icd + 1) / RP_PID_CLOCK);
+	}
+
+	// derivative: kd / 2^DSR per error count and clock
+	double kder = a_gains->kc * a_gains->td;
+	for (dsr = 13; dsr >= 3; --dsr) {
+		kd = round(kder * RP_PID_CLOCK * ldexp(1, dsr + frac));
+		if (fabs(kd) <= max) {
+			break;
+		}
+	}
+	if (dsr < 3) {
+		dsr = 3;
+		kd = copysign(max, kder);
+		a_fit->clip |= RP_TUNE_CLIP_D;
+	}
+
+	a_fit->raw[ePidKp] = (uint32_t)(int32_t)kp;
+	a_fit->raw[ePidKi] = (uint32_t)(int32_t)ki;
+	a_fit->raw[ePidKd] = (uint32_t)(int32_t)kd;
+	a_fit->raw[ePidPSR] = psr;
+	a_fit->raw[ePidISR] = isr;
+	a_fit->raw[ePidDSR] = dsr;
+	a_fit->raw[ePidICD] = icd;
+	for (size_t i = 0; i < TUNE_PAR_NUM; ++i) {
+		a_fit->raw[tunePar[i]] &= (1UL << rp_pid_width(a_ch, tunePar[i])) - 1;
+	}
+
+	// what the registers realise
+	double kc = ldexp(kp, -psr - frac);
+	double kir = ldexp(ki, -isr - frac) * RP_PID_CLOCK / (icd + 1);
+	a_fit->gains.kc = kc;
+	a_fit->gains.ti = (kir != 0) ? kc / kir : 0;
+	a_fit->gains.td = (kc != 0) ? ldexp(kd, -dsr - frac) / RP_PID_CLOCK / kc : 0;
+}
+
+void rp_tune_apply(rpRegs_t *a_regs, int a_ch, const tuneFit_t *a_fit)
+{
+	for (size_t i = 0; i < TUNE_PAR_NUM; ++i) {
+		stage_raw(a_regs, a_ch, tunePar[i], a_fit->raw[tunePar[i]]);
+	}
+	stage_raw(a_regs, a_ch, ePidIrst, 0);
+	rp_pid_commit(a_regs, 1UL << a_ch);
+}
@@ -0,0 +1,114 @@
+/**
+ * @brief Relay feedback autotuning of the PID channels.
+ *
+ * The channel is turned into a relay (Astrom-Hagglund experiment): P and D
+ * are off and the integrator runs at full gain and full rate, so it swings
+ * between its saturation limits +-2^(31-ISR) whenever the error changes
+ * sign. The loop settles into a limit cycle at the ultimate period of the
+ * plant; the ADC input and the output are recorded with the capture buffer
+ * and the ultimate gain is the ratio of the fundamentals of output and
+ * error.
+ *
+ * A tuning rule turns the ultimate gain and period into continuous gains,
+ * which are then fitted to the register set of the channel: the resolution
+ * shifts (PSR, ISR, DSR) and the integrator divider (ICD) are chosen so the
+ * gain registers keep as many significant bits as their width allows.
+ *
+ * Gains are in output counts per error count, times in seconds.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	eTuneZN=0,    // Ziegler-Nichols
+	eTuneTL,      // Tyreus-Luyben
+	eTuneSIMC,    // Skogestad, needs a biased relay for the plant model
+	eTuneRuleNum
+} tuneRule_t;
+
+/* register terms limited by their range, see tuneFit_t */
+#define RP_TUNE_CLIP_P 0x1
+#define RP_TUNE_CLIP_I 0x2
+#define RP_TUNE_CLIP_D 0x4
+
+typedef struct {
+	int ch;           // channel index 0-7
+	int32_t amp;      // relay amplitude in output counts, rounded to a power of two
+	int sign;         // 1 if the plant input rises with the PID output, -1 if it falls
+	int32_t tol;      // error dead band in counts, for noisy inputs
+	int periods;      // limit cycle periods to average over
+	int timeoutMs;
+} tuneConfig_t;
+
+typedef struct {
+	double ku;        // ultimate gain
+	double pu;        // ultimate period
+	double amp;       // fundamental amplitude of the output
+	double errAmp;    // fundamental amplitude of the error
+	double bias;      // mean output over the measured periods
+	int periods;      // periods measured
+	uint32_t dec;     // capture decimation used
+	/* first order plus dead time model, NAN unless the relay was biased */
+	double k;
+	double tau;
+	double theta;
+} tuneResult_t;
+
+typedef struct {
+	double kc;        // proportional gain
+	double ti;        // integral time, 0 for none
+	double td;        // derivative time
+} tuneGains_t;
+
+typedef struct {
+	uint32_t raw[ePidParNum];  // gain and resolution registers, sp, irst and tol unused
+	tuneGains_t gains;         // gains the registers realise
+	uint32_t clip;             // RP_TUNE_CLIP_* of terms out of range
+} tuneFit_t;
+
+/* Rule names used on the command line: zn, tl, simc */
+const char *rp_tune_rule_name(tuneRule_t a_rule);
+tuneRule_t rp_tune_rule_lookup(const char *a_name);
+
+/* Default configuration: channel 1, amplitude 1024, 8 periods, 30 s */
+void rp_tune_defaults(tuneConfig_t *a_cfg);
+
+/*
+ * Runs the relay experiment and restores the channel parameters after it.
+ * Returns 0, -EINVAL or -ERANGE for a bad configuration, -ETIMEDOUT if no
+ * capture completed and -EAGAIN if the loop did not oscillate.
+ */
+int rp_tune_relay(rpRegs_t *a_regs, const tuneConfig_t *a_cfg, tuneResult_t *a_res);
+
+/*
+ * Gains of a_rule for the result, PI only if a_pi is set. Returns 0,
+ * -EINVAL if the rule needs the plant model and the result has none.
+ */
+int rp_tune_gains(const tuneResult_t *a_res, tuneRule_t a_rule, int a_pi, int a_sign, tuneGains_t *a_gains);
+
+/* Best register set of channel a_ch for a_gains */
+void rp_tune_fit(int a_ch, const tuneGains_t *a_gains, tuneFit_t *a_fit);
+
+/* Writes a fit to channel a_ch with one commit and releases the integrator */
+void rp_tune_apply(rpRegs_t *a_regs, int a_ch, const tuneFit_t *a_fit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOTUNE_H */
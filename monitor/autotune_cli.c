@@ -0,0 +1,181 @@
+/**
+ * @brief Autotune command of the monitor utility.
+ *
+ * Runs the relay experiment on one channel, prints the ultimate gain and
+ * period, the gains of the chosen rule and the register set that realises
+ * them, as a 'pid set' line:
+ *
+ *   monitor autotune 1 rule=tl type=pi amp=512 --apply
+ *
+ * Parameters: rule (zn tl simc), type (pid pi), amp (relay amplitude in
+ * output counts), sign (-1 if the plant input falls with the PID output),
+ * tol (error dead band), periods and timeout in seconds. The channel
+ * parameters are restored after the experiment, --apply writes the tuned
+ * set and releases the integrator.
+ *
+ * The relay swings the output by +-amp around zero. The simc rule needs the
+ * static gain of the plant, which only a biased relay shows: the set point
+ * must be away from the input the plant settles at with zero output.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <math.h>
+
+#include "autotune.h"
+#include "autotune_cli.h"
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"\tautotune <1-%d> [rule=zn|tl|simc] [type=pid|pi] [amp=n] [sign=1|-1]\n"
+		"\t         [tol=n] [periods=n] [timeout=s] [--apply]\n", rp_pid_num());
+}
+
+static int parse_long(const char *a_str, long *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtol(a_str, &end, 0);
+	return (end == a_str || *end != '\0' || errno) ? -1 : 0;
+}
+
+/* one par=val token */
+static int parse_assign(tuneConfig_t *a_cfg, tuneRule_t *a_rule, int *a_pi, char *a_tok)
+{
+	char *eq = strchr(a_tok, '=');
+	long val = 0;
+
+	if (eq == NULL) {
+		fprintf(stderr, "autotune: expected par=val, got '%s'\n", a_tok);
+		return -1;
+	}
+	*eq++ = '\0';
+
+	if (strcasecmp(a_tok, "rule") == 0) {
+		*a_rule = rp_tune_rule_lookup(eq);
+		if (*a_rule == eTuneRuleNum) {
+			fprintf(stderr, "autotune: unknown rule '%s'\n", eq);
+			return -1;
+		}
+		return 0;
+	}
+	if (strcasecmp(a_tok, "type") == 0) {
+		if (strcasecmp(eq, "pid") && strcasecmp(eq, "pi")) {
+			fprintf(stderr, "autotune: unknown type '%s'\n", eq);
+			return -1;
+		}
+		*a_pi = strcasecmp(eq, "pi") == 0;
+		return 0;
+	}
+	if (parse_long(eq, &val) == -1 || val < INT32_MIN || val > INT32_MAX) {
+		fprintf(stderr, "autotune: invalid value '%s' for %s\n", eq, a_tok);
+		return -1;
+	}
+	if (strcasecmp(a_tok, "amp") == 0) {
+		a_cfg->amp = val;
+	} else if (strcasecmp(a_tok, "sign") == 0) {
+		a_cfg->sign = val;
+	} else if (strcasecmp(a_tok, "tol") == 0) {
+		a_cfg->tol = val;
+	} else if (strcasecmp(a_tok, "periods") == 0) {
+		a_cfg->periods = val;
+	} else if (strcasecmp(a_tok, "timeout") == 0) {
+		a_cfg->timeoutMs = val * 1000;
+	} else {
+		fprintf(stderr, "autotune: unknown parameter '%s'\n", a_tok);
+		return -1;
+	}
+	return 0;
+}
+
+int autotune_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	tuneConfig_t cfg;
+	tuneRule_t rule = eTuneZN;
+	tuneResult_t res;
+	tuneGains_t gains;
+	tuneFit_t fit;
+	int pi = 0, apply = 0;
+	long num;
+	int ret;
+
+	rp_tune_defaults(&cfg);
+	if (a_argc < 1 || parse_long(a_argv[0], &num) == -1 || num < 1 || num > rp_pid_num()) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	cfg.ch = num - 1;
+
+	for (int i = 1; i < a_argc; ++i) {
+		if (strcmp(a_argv[i], "--apply") == 0) {
+			apply = 1;
+		} else if (parse_assign(&cfg, &rule, &pi, a_argv[i]) == -1) {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	ret = rp_tune_relay(a_regs, &cfg, &res);
+	switch (ret) {
+		case 0:
+			break;
+		case -EINVAL:
+		case -ERANGE:
+			fprintf(stderr, "autotune: %s\n", (ret == -EINVAL) ? "invalid configuration" :
+			        "amp must be 128-131072, periods > 0 and tol 0-511");
+			usage();
+			return EXIT_FAILURE;
+		case -EAGAIN:
+			fprintf(stderr, "autotune: no limit cycle, check sign=, the set point and the loop wiring\n");
+			return EXIT_FAILURE;
+		default:
+			fprintf(stderr, "autotune: %s\n", strerror(-ret));
+			return EXIT_FAILURE;
+	}
+
+	printf("relay\tamp %.0f\terror %.1f\tbias %.1f\t%d periods at decimation %u\n",
+	       res.amp, res.errAmp, res.bias, res.periods, res.dec);
+	printf("ultimate\tKu %.4g\tPu %.4g s\n", res.ku, res.pu);
+	if (!isnan(res.k)) {
+		printf("plant\tK %.4g\ttau %.4g s\ttheta %.4g s\n", res.k, res.tau, res.theta);
+	}
+	if (rp_tune_gains(&res, rule, pi, cfg.sign, &gains) != 0) {
+		fprintf(stderr, "autotune: rule %s needs the plant model, move the set point off the "
+		        "zero output input\n", rp_tune_rule_name(rule));
+		return EXIT_FAILURE;
+	}
+	printf("%s %s\tKc %.4g\tTi %.4g s\tTd %.4g s\n", rp_tune_rule_name(rule), pi ? "pi" : "pid",
+	       gains.kc, gains.ti, gains.td);
+
+	rp_tune_fit(cfg.ch, &gains, &fit);
+	printf("registers\tpid set %d", cfg.ch + 1);
+	for (pidPar_t par = ePidKp; par <= ePidICD; ++par) {
+		if (par != ePidIrst) {
+			printf(" %s=%d", rp_pid_par_name(par), rp_pid_decode(cfg.ch, par, fit.raw[par]));
+		}
+	}
+	printf("\nrealised\tKc %.4g\tTi %.4g s\tTd %.4g s%s%s%s\n", fit.gains.kc, fit.gains.ti, fit.gains.td,
+	       (fit.clip & RP_TUNE_CLIP_P) ? "\tP limited" : "",
+	       (fit.clip & RP_TUNE_CLIP_I) ? "\tI limited" : "",
+	       (fit.clip & RP_TUNE_CLIP_D) ? "\tD limited" : "");
+
+	if (apply) {
+		rp_tune_apply(a_regs, cfg.ch, &fit);
+		printf("applied to channel %d\n", cfg.ch + 1);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+/**
+ * @brief Autotune command of the monitor utility.
+ *
+ * monitor autotune <1-8> [par=val ...] [--apply]
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef AUTOTUNE_CLI_H
+#define AUTOTUNE_CLI_H
+
+#include "rp_regs.h"
+
+/*
+ * Tunes one channel, a_argv[0] is the channel. Returns EXIT_SUCCESS or
+ * EXIT_FAILURE.
+ */
+int autotune_cli(rpRegs_t *a_regs, int a_argc, char **a_argv);
+
+#endif /* AUTOTUNE_CLI_H */
@@ -0,0 +1,138 @@
+/**
+ * @brief Parameter banks of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "bank.h"
+#include "codec.h"
+#include "info.h"
+
+const pidPar_t rpBankPar[RP_BANK_PAR_NUM] = {
+	ePidSp, ePidKp, ePidKi, ePidKd, ePidPSR, ePidISR, ePidDSR, ePidICD, ePidTol
+};
+
+int rp_bank_present(int a_ch)
+{
+	return a_ch >= 0 && a_ch < rp_pid_num() && a_ch < RP_BANK_CH_NUM && (rpChan[a_ch].flags & RP_INFO_CH_BANK);
+}
+
+uint32_t rp_bank_hold_reset(int a_ch)
+{
+	// 21 and 12 swap their pins, as in the original design
+	return RP_BANK_HOLD_EN | ((a_ch == 1) ? 2 : (a_ch == 2) ? 1 : a_ch);
+}
+
+int rp_bank_check(const bankConfig_t *a_cfg)
+{
+	if (a_cfg->bank < 0 || a_cfg->bank >= RP_BANK_NUM || a_cfg->dio < 0 || a_cfg->dio > RP_BANK_DIO_MAX ||
+	    a_cfg->hold < -1 || a_cfg->hold > RP_BANK_DIO_MAX) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+int rp_bank_set(rpRegs_t *a_regs, int a_ch, const bankConfig_t *a_cfg)
+{
+	if (!rp_bank_present(a_ch)) {
+		return -ENODEV;
+	}
+	int ret = rp_bank_check(a_cfg);
+	if (ret) {
+		return ret;
+	}
+	a_regs->pid[RP_BANK_CFG(a_ch) >> 2] = a_cfg->bank | (a_cfg->pin ? RP_BANK_PIN : 0) | (a_cfg->dio << 8) |
+	                                      (a_cfg->scale ? RP_BANK_SCALE : 0);
+	// a hold turned off keeps its pin
+	uint32_t hold = a_regs->pid[RP_BANK_HOLD(a_ch) >> 2] & RP_BANK_DIO_MAX;
+	a_regs->pid[RP_BANK_HOLD(a_ch) >> 2] = (a_cfg->hold < 0) ? hold : RP_BANK_HOLD_EN | a_cfg->hold;
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_bank_get(const rpRegs_t *a_regs, int a_ch, bankConfig_t *a_cfg)
+{
+	if (!rp_bank_present(a_ch)) {
+		return -ENODEV;
+	}
+	uint32_t cfg = a_regs->pid[RP_BANK_CFG(a_ch) >> 2];
+	uint32_t hold = a_regs->pid[RP_BANK_HOLD(a_ch) >> 2];
+
+	a_cfg->bank = cfg & (RP_BANK_NUM - 1);
+	a_cfg->pin = (cfg & RP_BANK_PIN) != 0;
+	a_cfg->dio = (cfg >> 8) & RP_BANK_DIO_MAX;
+	a_cfg->scale = (cfg & RP_BANK_SCALE) != 0;
+	a_cfg->hold = (hold & RP_BANK_HOLD_EN) ? (int)(hold & RP_BANK_DIO_MAX) : -1;
+	return 0;
+}
+
+int rp_bank_active(const rpRegs_t *a_regs, int a_ch)
+{
+	if (!rp_bank_present(a_ch)) {
+		return -ENODEV;
+	}
+	return (a_regs->pid[RP_BANK_CFG(a_ch) >> 2] >> RP_BANK_ACTIVE_SH) & (RP_BANK_NUM - 1);
+}
+
+int rp_bank_reload(rpRegs_t *a_regs, int a_ch)
+{
+	volatile uint32_t *cfg = &a_regs->pid[RP_BANK_CFG(a_ch) >> 2];
+
+	if (!rp_bank_present(a_ch)) {
+		return -ENODEV;
+	}
+	// the active bank field is read only, writing it back does no harm
+	*cfg = *cfg | RP_BANK_RELOAD;
+	rp_sync(a_regs);
+	return 0;
+}
+
+void rp_bank_encode(int a_ch, const pidParams_t *a_par, uint32_t *a_word)
+{
+	for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+		a_word[p] = rp_pid_encode(a_ch, rpBankPar[p], a_par->val[rpBankPar[p]]);
+	}
+}
+
+void rp_bank_decode(int a_ch, const uint32_t *a_word, pidParams_t *a_par)
+{
+	for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+		a_par->val[rpBankPar[p]] = rp_pid_decode(a_ch, rpBankPar[p], a_word[p]);
+	}
+}
+
+static volatile void *bank_window(rpRegs_t *a_regs)
+{
+	return rp_map_block(a_regs, RP_ADDR_PID + RP_BANK_WIN, sizeof(bankImage_t));
+}
+
+int rp_bank_download(rpRegs_t *a_regs, bankImage_t *a_img)
+{
+	volatile void *win = bank_window(a_regs);
+
+	if (win == NULL) {
+		return -errno;
+	}
+	memcpy(a_img, (const void *)win, sizeof(*a_img));
+	return 0;
+}
+
+int rp_bank_upload(rpRegs_t *a_regs, const bankImage_t *a_img)
+{
+	volatile void *win = bank_window(a_regs);
+
+	if (win == NULL) {
+		return -errno;
+	}
+	// whole words in one pass, the banks ignore the bus byte selects
+	memcpy((void *)win, a_img, sizeof(*a_img));
+	rp_sync(a_regs);
+	return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @brief Parameter banks of the PID channels.
+ *
+ * Drives red_pitaya_pid_bank.v: every channel holds RP_BANK_NUM complete
+ * parameter sets (sp, kp, ki, kd, psr, isr, dsr, icd, tol) and runs with
+ * the one selected by register or by a pair of DIO_P pins. A new selection
+ * loads the whole set into the live and staged registers on one clock
+ * edge, so switching between the phases of an experiment needs no bus
+ * writes, or one.
+ *
+ * Banks hold raw register values, laid out as in the FPGA, so a complete
+ * schedule of every channel goes in with a single bulk copy
+ * (rp_bank_upload()). A bank written while it runs takes effect on the
+ * next switch to it or on rp_bank_reload().
+ *
+ * The integrator holds come from the same DIO_P pins (HOLD register). A
+ * pin that selects banks is taken off hold duty by moving the holds on it
+ * to another pin, or by turning them off (hold = -1). After reset channel
+ * 1 holds on pin 0, 2 on pin 2, 3 on pin 1, 4 on pin 3 and the slow
+ * channels on pins 4 - 7.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef BANK_H
+#define BANK_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* registers in the PID window, channel index n */
+#define RP_BANK_CFG(n)      (0x900 + 0x4 * (n))
+#define RP_BANK_HOLD(n)     (0x920 + 0x4 * (n))
+#define RP_BANK_WIN         0x30000
+#define RP_BANK_ADDR(n, b)  (RP_BANK_WIN + 0x100 * (n) + 0x40 * (b))
+
+#define RP_BANK_CH_NUM      8           /* channels of the window */
+#define RP_BANK_NUM         4
+#define RP_BANK_PAR_NUM     9           /* words of a bank, in rpBankPar order */
+#define RP_BANK_STRIDE      16          /* words from one bank to the next */
+#define RP_BANK_DIO_MAX     7
+/* CFG fields */
+#define RP_BANK_PIN         0x10        /* select by the DIO_P pins */
+#define RP_BANK_SCALE       0x1000      /* bumpless ISR changes */
+#define RP_BANK_ACTIVE_SH   16
+#define RP_BANK_RELOAD      0x80000000
+/* HOLD fields, pin in [2:0] */
+#define RP_BANK_HOLD_EN     0x10
+
+/* parameter of each bank word */
+extern const pidPar_t rpBankPar[RP_BANK_PAR_NUM];
+
+/* the bank window of every channel, as the FPGA lays it out */
+typedef struct {
+	uint32_t word[RP_BANK_CH_NUM][RP_BANK_NUM][RP_BANK_STRIDE];
+} bankImage_t;
+
+typedef struct {
+	int bank;         // bank selected by register, 0 - RP_BANK_NUM - 1
+	int pin;          // select by DIO_P pins dio + 1 (msb) and dio instead
+	int dio;          // 0 - RP_BANK_DIO_MAX, pin 7 pairs with pin 0
+	int scale;        // rescale the integrator on ISR changes
+	int hold;         // DIO_P pin of the integrator hold, -1 for none
+} bankConfig_t;
+
+/* 1 if channel a_ch has parameter banks */
+int rp_bank_present(int a_ch);
+/* HOLD of channel a_ch after reset */
+uint32_t rp_bank_hold_reset(int a_ch);
+/* 0 if a_cfg is valid, -ERANGE otherwise */
+int rp_bank_check(const bankConfig_t *a_cfg);
+
+/* -ENODEV on channels without banks */
+int rp_bank_set(rpRegs_t *a_regs, int a_ch, const bankConfig_t *a_cfg);
+/* Also returns the bank the channel runs with */
+int rp_bank_get(const rpRegs_t *a_regs, int a_ch, bankConfig_t *a_cfg);
+int rp_bank_active(const rpRegs_t *a_regs, int a_ch);
+/* Loads the selected bank again, after it was rewritten */
+int rp_bank_reload(rpRegs_t *a_regs, int a_ch);
+
+/* Parameters in user units (rp_pid_decode()) to bank words and back */
+void rp_bank_encode(int a_ch, const pidParams_t *a_par, uint32_t *a_word);
+void rp_bank_decode(int a_ch, const uint32_t *a_word, pidParams_t *a_par);
+
+/*
+ * Reads or writes the banks of all channels with one bulk copy. Returns 0,
+ * or -errno if the window cannot be mapped.
+ */
+int rp_bank_download(rpRegs_t *a_regs, bankImage_t *a_img);
+int rp_bank_upload(rpRegs_t *a_regs, const bankImage_t *a_img);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BANK_H */
@@ -0,0 +1,201 @@
+/**
+ * @brief Sample decoding throughput benchmark and kernel self-check.
+ *
+ * Checks every decoding kernel the CPU supports against the scalar code,
+ * bit for bit, on random words and all buffer lengths and alignments up to
+ * a few blocks, then times each of them on a large buffer:
+ *
+ *   counts14   eDecS14 words to sign extended counts
+ *   volts14    eDecS14 words to volts, two interleaved channels
+ *   volts12    eDecS12 words to volts, four interleaved channels
+ *   pwm        slow DAC words to volts, four interleaved channels
+ *
+ * Usage: bench_decode [-n samples] [-r repeats]
+ *
+ * Exits with failure if any kernel differs from the scalar results.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "decode.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+/* lengths and offsets of the self-check, a few vector blocks */
+#define CHECK_LEN 80
+#define CHECK_OFS 8
+
+typedef enum {
+	eOpCounts14=0,
+	eOpVolts14,
+	eOpVolts12,
+	eOpPwm,
+	eOpNum
+} op_t;
+
+static const char *opName[eOpNum] = {
+	"counts14", "volts14", "volts12", "pwm"
+};
+
+/* calibration of up to four channels, all different */
+static const decCal_t cal[4] = {
+	{ 1.0f,    0.0f   },
+	{ 0.987f, -0.012f },
+	{ 1.021f,  0.0031f },
+	{ 0.9993f, 0.25f  },
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* xorshift, the same words on every run */
+static uint32_t rnd(void)
+{
+	static uint32_t x = 2463534242UL;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+static void run(op_t a_op, const uint16_t *a_w16, const uint32_t *a_w32, void *a_dst, size_t a_num)
+{
+	switch (a_op) {
+		case eOpCounts14:
+			rp_dec_counts(eDecS14, a_w16, a_dst, a_num);
+			break;
+		case eOpVolts14:
+			rp_dec_volts(eDecS14, a_w16, a_dst, a_num, cal, 2);
+			break;
+		case eOpVolts12:
+			rp_dec_volts(eDecS12, a_w16, a_dst, a_num, cal, 4);
+			break;
+		case eOpPwm:
+			rp_dec_pwm(a_w32, a_dst, a_num, cal, 4);
+			break;
+		case eOpNum:
+			break;
+	}
+}
+
+static size_t out_size(op_t a_op)
+{
+	return (a_op == eOpCounts14) ? sizeof(int16_t) : sizeof(float);
+}
+
+/* number of mismatching outputs of a_kernel against the scalar code */
+static long check(decKernel_t a_kernel, op_t a_op, const uint16_t *a_w16, const uint32_t *a_w32)
+{
+	float ref[CHECK_LEN], out[CHECK_LEN];
+	size_t size = out_size(a_op);
+	long bad = 0;
+
+	for (size_t ofs = 0; ofs < CHECK_OFS; ++ofs) {
+		for (size_t len = 0; len <= CHECK_LEN - CHECK_OFS; ++len) {
+			memset(ref, 0xa5, sizeof(ref));
+			memset(out, 0xa5, sizeof(out));
+			rp_dec_set_kernel(eDecScalar);
+			run(a_op, a_w16 + ofs, a_w32 + ofs, ref, len);
+			rp_dec_set_kernel(a_kernel);
+			run(a_op, a_w16 + ofs, a_w32 + ofs, out, len);
+			// also catches writes past the end
+			if (memcmp(ref, out, sizeof(ref)) != 0) {
+				++bad;
+				if (bad == 1) {
+					fprintf(stderr, "%s %s: differs at offset %zu, length %zu (%zu byte outputs)\n",
+					        rp_dec_kernel_name(a_kernel), opName[a_op], ofs, len, size);
+				}
+			}
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char **argv)
+{
+	long num = 1 << 20;
+	long rep = 20;
+	long failures = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+		switch (opt) {
+			case 'n':
+				num = strtol(optarg, 0, 0);
+				break;
+			case 'r':
+				rep = strtol(optarg, 0, 0);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n samples] [-r repeats]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (num < CHECK_LEN || rep < 1) {
+		fprintf(stderr, "%s: at least %d samples and one repeat\n", argv[0], CHECK_LEN);
+		return EXIT_FAILURE;
+	}
+
+	uint16_t *w16 = malloc(num * sizeof(*w16));
+	uint32_t *w32 = malloc(num * sizeof(*w32));
+	float *dst = malloc(num * sizeof(*dst));
+	if (w16 == NULL || w32 == NULL || dst == NULL) FATAL;
+
+	// random upper bits too, the decoders must ignore them
+	for (long i = 0; i < num; ++i) {
+		w16[i] = rnd();
+		w32[i] = rnd();
+	}
+	// full scale ends and zero of all formats at the start of the check buffer
+	static const uint16_t edge[] = { 0x0000, 0x1fff, 0x2000, 0x3fff, 0x07ff, 0x0800, 0x0fff, 0xffff };
+	memcpy(w16, edge, sizeof(edge));
+	w32[0] = 0;
+	w32[1] = (RP_DEC_PWM_FULL << 16) | 0xffff;
+	w32[2] = 0xffffffffUL;
+
+	decKernel_t best = rp_dec_kernel();
+
+	printf("#Kernel\tOp\tSamples\tTime[s]\tMS/s\tCheck\n");
+	for (int k = 0; k < eDecKernelNum; ++k) {
+		if (!rp_dec_kernel_supported(k)) {
+			continue;
+		}
+		for (int op = 0; op < eOpNum; ++op) {
+			long bad = (k == eDecScalar) ? 0 : check(k, op, w16, w32);
+			failures += bad;
+
+			rp_dec_set_kernel(k);
+			double t0 = now();
+			for (long r = 0; r < rep; ++r) {
+				run(op, w16, w32, dst, num);
+			}
+			double t = now() - t0;
+			printf("%s\t%s\t%ld\t%.4f\t%.1f\t%s\n", rp_dec_kernel_name(k), opName[op], num * rep, t,
+			       num * rep / t * 1e-6, (k == eDecScalar) ? "ref" : bad ? "FAIL" : "ok");
+		}
+	}
+	printf("#Default kernel %s\n", rp_dec_kernel_name(best));
+
+	free(w16);
+	free(w32);
+	free(dst);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
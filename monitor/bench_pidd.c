@@ -0,0 +1,158 @@
+/**
+ * @brief PID control daemon client benchmark.
+ *
+ * Measures request latency of synchronous calls and the throughput of
+ * pipelined and batched requests against a running pidd.
+ *
+ * Usage: bench_pidd [-s socket] [-f image_file [-d pidd]] [-n requests] [-w window]
+ *
+ * With -f the benchmark starts its own daemon (./pidd unless -d is given)
+ * on a register image file, so it can be measured off-board.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "rp_regs.h"
+#include "pidd.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmp_double(const void *a_a, const void *a_b)
+{
+	double a = *(const double *)a_a;
+	double b = *(const double *)a_b;
+	return (a > b) - (a < b);
+}
+
+static pid_t start_daemon(const char *a_pidd, const char *a_sock, const char *a_img)
+{
+	char spec[256];
+
+	snprintf(spec, sizeof(spec), "file:%s", a_img);
+	pid_t pid = fork();
+	if (pid == -1) FATAL;
+	if (pid == 0) {
+		execl(a_pidd, a_pidd, "-s", a_sock, "-b", spec, (char *)NULL);
+		FATAL;
+	}
+	return pid;
+}
+
+int main(int argc, char **argv)
+{
+	static piddClient_t cl;
+	const char *sock = PIDD_SOCKET;
+	const char *img = NULL;
+	const char *pidd = "./pidd";
+	long num = 100000;
+	int window = 64;
+	pid_t daemon = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:f:d:n:w:")) != -1) {
+		switch (opt) {
+			case 's': sock = optarg; break;
+			case 'f': img = optarg; break;
+			case 'd': pidd = optarg; break;
+			case 'n': num = strtol(optarg, 0, 0); break;
+			case 'w': window = strtol(optarg, 0, 0); break;
+			default:
+				fprintf(stderr, "Usage: %s [-s socket] [-f image_file [-d pidd]] [-n requests] [-w window]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (img) {
+		daemon = start_daemon(pidd, sock, img);
+	}
+	for (int retry = 0; pidd_connect(&cl, sock) == -1; ++retry) {
+		if (retry == 100) FATAL;
+		usleep(10000);
+	}
+
+	// synchronous round trips
+	double *lat = malloc(num * sizeof(double));
+	int32_t val;
+	double t0 = now();
+	for (long i = 0; i < num; ++i) {
+		double t = now();
+		if (pidd_get(&cl, i % RP_PID_NUM, ePidSp, &val) != 0) FATAL;
+		lat[i] = now() - t;
+	}
+	double tSync = now() - t0;
+	qsort(lat, num, sizeof(double), cmp_double);
+
+	// pipelined requests, up to 'window' in flight
+	piddReq_t req = { .op = ePiddSet, .par = ePidSp };
+	piddResp_t resp;
+	long sent = 0;
+	long recvd = 0;
+	t0 = now();
+	while (recvd < num) {
+		// refill in bursts once half the window is answered, so one send covers many requests
+		if (sent - recvd <= window / 2) {
+			while (sent < num && sent - recvd < window) {
+				req.ch = sent % RP_PID_NUM;
+				req.val = sent & 0xfff;
+				if (pidd_send(&cl, &req, NULL) == -1) FATAL;
+				++sent;
+			}
+		}
+		if (pidd_recv(&cl, &resp, NULL, 0) == -1 || resp.status != 0) FATAL;
+		++recvd;
+	}
+	double tPipe = now() - t0;
+
+	// complete parameter sets of all channels, committed atomically
+	piddItem_t items[RP_PID_NUM * 5];
+	for (int i = 0; i < RP_PID_NUM * 5; ++i) {
+		items[i].ch = i / 5;
+		items[i].par = i % 5;
+		items[i].val = 0;
+	}
+	long batches = num / 10;
+	t0 = now();
+	for (long i = 0; i < batches; ++i) {
+		if (pidd_set_batch(&cl, RP_PID_NUM * 5, items) != 0) FATAL;
+	}
+	double tBatch = now() - t0;
+
+	printf("#Mode\t\tRequests\tTime[s]\tRequests/s\tLatency p50/p99[us]\n");
+	printf("synchronous\t%ld\t%.3f\t%.0f\t%.1f/%.1f\n", num, tSync, num / tSync,
+	       lat[num / 2] * 1e6, lat[num * 99 / 100] * 1e6);
+	printf("pipelined(%d)\t%ld\t%.3f\t%.0f\n", window, num, tPipe, num / tPipe);
+	printf("batch(%d)\t%ld\t%.3f\t%.0f params/s\n", RP_PID_NUM * 5, batches, tBatch,
+	       batches * RP_PID_NUM * 5 / tBatch);
+
+	pidd_disconnect(&cl);
+	free(lat);
+	if (daemon) {
+		kill(daemon, SIGTERM);
+		waitpid(daemon, NULL, 0);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/**
+ * @brief Register access micro-benchmark.
+ *
+ * Compares the register access path used by the original monitor program
+ * (address parsed from a string, one mmap()/munmap() pair per access) with
+ * the persistent mappings of the rp_regs library.
+ *
+ * Usage: bench_regs [-f image_file] [-n iterations]
+ *
+ * Without -f the benchmark runs against /dev/mem on the board. With -f it
+ * uses a register image file (file: backend), so it can be run on any
+ * Linux machine.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "rp_regs.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* one register read the way write_pid_values() used to do it */
+static uint32_t legacy_read(const rpRegs_t *a_regs, const char *a_addr)
+{
+	unsigned long addr = strtoul(a_addr, 0, 0);
+	unsigned long *val = calloc(4*1024, sizeof(unsigned long));
+	void *map_base = mmap(0, RP_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, a_regs->fd, rp_offset(a_regs, addr & ~RP_MAP_MASK));
+	uint32_t res;
+
+	if (map_base == MAP_FAILED) FATAL;
+	res = *((volatile uint32_t *)((uint8_t *)map_base + (addr & RP_MAP_MASK)));
+	if (munmap(map_base, RP_MAP_SIZE) == -1) FATAL;
+	free(val);
+	return res;
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = RP_DEV_MEM;
+	long iter = 20000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:n:")) != -1) {
+		switch (opt) {
+			case 'f':
+				dev = optarg;
+				break;
+			case 'n':
+				iter = strtol(optarg, 0, 0);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-f image_file] [-n iterations]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	char spec[256];
+	snprintf(spec, sizeof(spec), "%s%s", strcmp(dev, RP_DEV_MEM) ? "file:" : "", dev);
+
+	rpRegs_t regs;
+	if (rp_open(&regs, spec) == -1) FATAL;
+
+	char addr[ePidParNum][16];
+	for (int p = 0; p < ePidParNum; ++p) {
+		snprintf(addr[p], sizeof(addr[p]), "0x%08lx", RP_ADDR_PID + rp_pid_offset(0, p));
+	}
+
+	volatile uint32_t sink = 0;
+	long acc = iter * ePidParNum;
+
+	// one full channel dump per iteration, as in the pid menu
+	double t0 = now();
+	for (long i = 0; i < iter; ++i) {
+		for (int p = 0; p < ePidParNum; ++p) {
+			sink += legacy_read(&regs, addr[p]);
+		}
+	}
+	double tLegacy = now() - t0;
+
+	t0 = now();
+	for (long i = 0; i < iter; ++i) {
+		for (int p = 0; p < ePidParNum; ++p) {
+			sink += rp_pid_get(&regs, 0, p);
+		}
+	}
+	double tPersistent = now() - t0;
+
+	printf("#Path\t\tAccesses\tTime[s]\tAccesses/s\n");
+	printf("mmap per access\t%ld\t%.3f\t%.0f\n", acc, tLegacy, acc / tLegacy);
+	printf("persistent\t%ld\t%.3f\t%.0f\n", acc, tPersistent, acc / tPersistent);
+	printf("speedup\t%.1fx\n", tLegacy / tPersistent);
+
+	rp_close(&regs);
+	(void)sink;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/**
+ * @brief Register streaming throughput benchmark.
+ *
+ * Replays generated register scripts through the text and binary streaming
+ * engines, and through the original stdin path of the monitor program
+ * (getline(), strtok(), calloc() and one mmap()/munmap() pair per access)
+ * for reference.
+ *
+ * Usage: bench_stream [-f image_file] [-n entries]
+ *
+ * With -f a register image file (file: backend) is used instead of /dev/mem.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "rp_regs.h"
+#include "stream.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* register address of entry a_i, cycling over all PID parameter registers */
+static uint32_t entry_addr(long a_i)
+{
+	return RP_ADDR_PID + rp_pid_offset((a_i / ePidParNum) % RP_PID_NUM, a_i % ePidParNum);
+}
+
+/* unlinked temporary file holding a generated script */
+static FILE *script(void)
+{
+	FILE *fp = tmpfile();
+	if (fp == NULL) FATAL;
+	return fp;
+}
+
+static int rewind_fd(FILE *a_fp)
+{
+	fflush(a_fp);
+	if (lseek(fileno(a_fp), 0, SEEK_SET) == -1) FATAL;
+	return fileno(a_fp);
+}
+
+/* the stdin loop of the original monitor program, one script pass */
+static long legacy_replay(const rpRegs_t *a_regs, FILE *a_in, FILE *a_out)
+{
+	char *line = NULL;
+	size_t len = 0;
+	long num = 0;
+
+	while (getline(&line, &len, a_in) != -1) {
+		unsigned long *val = calloc(4*1024, sizeof(unsigned long));
+		char *token = strtok(line, " \t");
+		unsigned long addr = strtoul(token, 0, 0);
+		int count = 0;
+
+		token = strtok(NULL, " \t");
+		if (token != NULL) {
+			while ((token = strtok(NULL, " \t")) != NULL) {
+				val[count++] = strtoul(token, 0, 0);
+			}
+		}
+		void *map_base = mmap(0, RP_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, a_regs->fd, rp_offset(a_regs, addr & ~RP_MAP_MASK));
+		if (map_base == MAP_FAILED) FATAL;
+		volatile uint32_t *reg = (volatile uint32_t *)((uint8_t *)map_base + (addr & RP_MAP_MASK));
+		if (count == 0) {
+			fprintf(a_out, "0x%08x\n", *reg);
+			fflush(a_out);
+		}
+		for (int i = 0; i < count; ++i) {
+			*reg = val[i];
+		}
+		if (munmap(map_base, RP_MAP_SIZE) == -1) FATAL;
+		free(val);
+		++num;
+	}
+	free(line);
+	return num;
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = RP_DEV_MEM;
+	long num = 200000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:n:")) != -1) {
+		switch (opt) {
+			case 'f':
+				dev = optarg;
+				break;
+			case 'n':
+				num = strtol(optarg, 0, 0);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-f image_file] [-n entries]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	char spec[256];
+	snprintf(spec, sizeof(spec), "%s%s", strcmp(dev, RP_DEV_MEM) ? "file:" : "", dev);
+
+	rpRegs_t regs;
+	if (rp_open(&regs, spec) == -1) FATAL;
+	int null = open("/dev/null", O_WRONLY);
+	FILE *nullFp = fdopen(null, "w");
+	if (null == -1 || nullFp == NULL) FATAL;
+
+	// text scripts: one write block or one read line per entry
+	FILE *textWr = script();
+	FILE *textRd = script();
+	FILE *binWr = script();
+	FILE *binRd = script();
+	for (long i = 0; i < num; ++i) {
+		uint32_t addr = entry_addr(i);
+		rpRecord_t rec = { .addr = addr, .width = 4, .value = i & 0xfff };
+
+		fprintf(textWr, "0x%08x w %ld\n\n", addr, i & 0xfff);
+		fprintf(textRd, "0x%08x\n", addr);
+		if (fwrite(&rec, sizeof(rec), 1, binWr) != 1) FATAL;
+		rec.flags = RP_REC_READ;
+		if (fwrite(&rec, sizeof(rec), 1, binRd) != 1) FATAL;
+	}
+
+	double t0, t[5];
+	long n[5];
+
+	t0 = now();
+	n[0] = legacy_replay(&regs, fdopen(dup(rewind_fd(textRd)), "r"), nullFp);
+	t[0] = now() - t0;
+
+	t0 = now();
+	n[1] = rp_stream_text(&regs, rewind_fd(textWr), null);
+	t[1] = now() - t0;
+
+	t0 = now();
+	n[2] = rp_stream_text(&regs, rewind_fd(textRd), null);
+	t[2] = now() - t0;
+
+	t0 = now();
+	n[3] = rp_stream_binary(&regs, rewind_fd(binWr), null);
+	t[3] = now() - t0;
+
+	t0 = now();
+	n[4] = rp_stream_binary(&regs, rewind_fd(binRd), null);
+	t[4] = now() - t0;
+
+	static const char *name[5] = {
+		"legacy read", "text write", "text read", "binary write", "binary read"
+	};
+	printf("#Mode\t\tEntries\tTime[s]\tEntries/s\n");
+	for (int i = 0; i < 5; ++i) {
+		if (n[i] != num) {
+			fprintf(stderr, "%s: %ld of %ld entries executed\n", name[i], n[i], num);
+			return EXIT_FAILURE;
+		}
+		printf("%s\t%ld\t%.3f\t%.0f\n", name[i], n[i], t[i], n[i] / t[i]);
+	}
+	printf("speedup text read\t%.1fx\n", t[0] / t[2]);
+
+	fclose(textWr);
+	fclose(textRd);
+	fclose(binWr);
+	fclose(binRd);
+	fclose(nullFp);
+	rp_close(&regs);
+	return EXIT_SUCCESS;
+}
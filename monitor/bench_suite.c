@@ -0,0 +1,295 @@
+/**
+ * @brief Register access benchmark suite of the monitor utility.
+ *
+ * Times the code paths of the monitor commands one operation at a time
+ * and reports throughput and latency percentiles per case and backend:
+ *
+ *   read_value     single register read ('monitor addr')
+ *   write_values   single register write ('monitor addr value')
+ *   pid_dump       all parameters of one channel, as the pid menu shows them
+ *   ams_list       'monitor -ams'
+ *   dac_write      'monitor -sdac' with all four outputs
+ *   pid_status     'monitor -status', snapshot and telemetry of all channels
+ *   stream_text    replay of a text script ('monitor -'), per script
+ *   stream_binary  replay of a binary script ('monitor -b'), per script
+ *
+ * Usage: bench_suite [-b backend ...] [-n iterations] [-s script_entries] [-o tsv|json]
+ *
+ * Every -b adds a backend (see rp_regs.h), default file:/tmp/bench_suite.img.
+ * Writes only go to a staging register, restored at the end, and the slow
+ * DACs are rewritten with their current values, so the suite can run on a
+ * board in operation (pid_status only restarts the sticky saturation flags).
+ *
+ * The tsv output has one line per case. The json output has one object per
+ * line, including a histogram of the latencies in power of two nanosecond
+ * buckets ("1024": number of operations taking 512-1023 ns).
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "rp_regs.h"
+#include "stream.h"
+#include "monitor_io.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+#define BACKEND_MAX 4
+#define HIST_NUM    40
+
+typedef enum {
+	eCaseRead=0,
+	eCaseWrite,
+	eCasePidDump,
+	eCaseAmsList,
+	eCaseDacWrite,
+	eCaseStatus,
+	eCaseStreamText,
+	eCaseStreamBinary,
+	eCaseNum
+} case_t;
+
+static const char *caseName[eCaseNum] = {
+	"read_value",
+	"write_values",
+	"pid_dump",
+	"ams_list",
+	"dac_write",
+	"pid_status",
+	"stream_text",
+	"stream_binary"
+};
+
+// staged (not active) set point of the last slow PID, safe to write at any time
+static const uint32_t BENCH_ADDR = RP_ADDR_PID + RP_PID_SHADOW + 0x80;
+
+static FILE *out;
+static int devNull;
+static int textFd;
+static int binFd;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a_a, const void *a_b)
+{
+	uint64_t a = *(const uint64_t *)a_a;
+	uint64_t b = *(const uint64_t *)a_b;
+	return (a > b) - (a < b);
+}
+
+/* unlinked temporary script: reads of all PID parameters, writes to BENCH_ADDR */
+static int script(int a_binary, long a_num)
+{
+	FILE *fp = tmpfile();
+	if (fp == NULL) FATAL;
+
+	for (long i = 0; i < a_num; ++i) {
+		uint32_t addr = RP_ADDR_PID + rp_pid_offset((i / ePidParNum) % RP_PID_NUM, i % ePidParNum);
+		int wr = i & 1;
+		if (a_binary) {
+			rpRecord_t rec = {
+				.addr = wr ? BENCH_ADDR : addr,
+				.width = 4,
+				.flags = wr ? 0 : RP_REC_READ,
+				.value = i & 0xfff
+			};
+			if (fwrite(&rec, sizeof(rec), 1, fp) != 1) FATAL;
+		} else if (wr) {
+			fprintf(fp, "0x%08x w %ld\n\n", (unsigned)BENCH_ADDR, i & 0xfff);
+		} else {
+			fprintf(fp, "0x%08x\n", addr);
+		}
+	}
+	fflush(fp);
+	return dup(fileno(fp));
+}
+
+static void run_op(case_t a_case, long a_i)
+{
+	unsigned long val = a_i & 0xfff;
+	double dac[SLOW_DAC_NUM];
+
+	switch (a_case) {
+		case eCaseRead:
+			read_value(BENCH_ADDR);
+			break;
+		case eCaseWrite:
+			write_values(BENCH_ADDR, 'w', &val, 1);
+			break;
+		case eCasePidDump:
+			for (int par = 0; par < ePidParNum; ++par) {
+				read_pid_value(RP_PID_NUM, par);
+			}
+			break;
+		case eCaseAmsList:
+			AmsList(regs.ams);
+			break;
+		case eCaseDacWrite:
+			for (int i = 0; i < SLOW_DAC_NUM; ++i) {
+				dac[i] = AmsConversion(eAmsAO0 + i, regs.ams->dac[i]);
+			}
+			DacWrite(regs.ams, dac, SLOW_DAC_NUM);
+			break;
+		case eCaseStatus:
+			PidStatus(&regs);
+			break;
+		case eCaseStreamText:
+			if (lseek(textFd, 0, SEEK_SET) == -1 || rp_stream_text(&regs, textFd, devNull) == -1) FATAL;
+			break;
+		case eCaseStreamBinary:
+			if (lseek(binFd, 0, SEEK_SET) == -1 || rp_stream_binary(&regs, binFd, devNull) == -1) FATAL;
+			break;
+		case eCaseNum:
+			break;
+	}
+}
+
+static void report(const char *a_backend, case_t a_case, long a_num, long a_items, uint64_t *a_lat, int a_json)
+{
+	uint64_t total = 0;
+	long hist[HIST_NUM] = { 0 };
+
+	for (long i = 0; i < a_num; ++i) {
+		int b = 0;
+		total += a_lat[i];
+		while (b < HIST_NUM - 1 && (1ULL << b) <= a_lat[i]) {
+			++b;
+		}
+		++hist[b];
+	}
+	qsort(a_lat, a_num, sizeof(a_lat[0]), cmp_u64);
+
+	double opsPerSec = a_num / (total * 1e-9);
+	uint64_t p50 = a_lat[a_num / 2];
+	uint64_t p99 = a_lat[a_num * 99 / 100];
+	uint64_t p999 = a_lat[a_num * 999 / 1000];
+	uint64_t max = a_lat[a_num - 1];
+
+	if (!a_json) {
+		fprintf(out, "%s\t%s\t%ld\t%ld\t%.0f\t%llu\t%llu\t%llu\t%llu\n", caseName[a_case], a_backend,
+		        a_num, a_items, opsPerSec, (unsigned long long)p50, (unsigned long long)p99,
+		        (unsigned long long)p999, (unsigned long long)max);
+		return;
+	}
+
+	fprintf(out, "{\"case\":\"%s\",\"backend\":\"%s\",\"ops\":%ld,\"items_per_op\":%ld,"
+	        "\"ops_per_s\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu,\"hist\":{",
+	        caseName[a_case], a_backend, a_num, a_items, opsPerSec, (unsigned long long)p50,
+	        (unsigned long long)p99, (unsigned long long)p999, (unsigned long long)max);
+	const char *sep = "";
+	for (int b = 0; b < HIST_NUM; ++b) {
+		if (hist[b]) {
+			fprintf(out, "%s\"%llu\":%ld", sep, 1ULL << b, hist[b]);
+			sep = ",";
+		}
+	}
+	fprintf(out, "}}\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *backend[BACKEND_MAX];
+	int backendNum = 0;
+	long iter = 20000;
+	long entries = 256;
+	int json = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:n:s:o:")) != -1) {
+		switch (opt) {
+			case 'b':
+				if (backendNum == BACKEND_MAX) {
+					fprintf(stderr, "%s: at most %d backends\n", argv[0], BACKEND_MAX);
+					return EXIT_FAILURE;
+				}
+				backend[backendNum++] = optarg;
+				break;
+			case 'n':
+				iter = strtol(optarg, 0, 0);
+				break;
+			case 's':
+				entries = strtol(optarg, 0, 0);
+				break;
+			case 'o':
+				json = (strcmp(optarg, "json") == 0);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-b backend ...] [-n iterations] [-s script_entries] [-o tsv|json]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+	if (backendNum == 0) {
+		backend[backendNum++] = "file:/tmp/bench_suite.img";
+	}
+	if (iter < 1 || entries < 1) {
+		fprintf(stderr, "%s: iterations and script entries must be positive\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// the monitor paths print to stdout, results go to the original stdout
+	out = fdopen(dup(STDOUT_FILENO), "w");
+	devNull = open("/dev/null", O_WRONLY);
+	if (out == NULL || devNull == -1 || freopen("/dev/null", "w", stdout) == NULL) FATAL;
+
+	textFd = script(0, entries);
+	binFd = script(1, entries);
+
+	uint64_t *lat = malloc(iter * sizeof(uint64_t));
+	if (lat == NULL) FATAL;
+
+	if (!json) {
+		fprintf(out, "#case\tbackend\tops\titems_per_op\tops_per_s\tp50_ns\tp99_ns\tp999_ns\tmax_ns\n");
+	}
+	for (int b = 0; b < backendNum; ++b) {
+		if (rp_open(&regs, backend[b]) == -1) {
+			fprintf(stderr, "%s: %s: %s\n", argv[0], backend[b], strerror(errno));
+			return EXIT_FAILURE;
+		}
+		volatile uint32_t *staged = rp_map(&regs, BENCH_ADDR);
+		if (staged == NULL) FATAL;
+		uint32_t saved = *staged;
+
+		for (int c = 0; c < eCaseNum; ++c) {
+			long items = (c == eCaseStreamText || c == eCaseStreamBinary) ? entries : 1;
+			// warm up caches and mappings
+			for (long i = 0; i < iter / 10 + 1; ++i) {
+				run_op(c, i);
+			}
+			for (long i = 0; i < iter; ++i) {
+				uint64_t t0 = now_ns();
+				run_op(c, i);
+				lat[i] = now_ns() - t0;
+			}
+			report(backend[b], c, iter, items, lat, json);
+		}
+
+		// a later commit of the channel must not pick up benchmark values
+		*staged = saved;
+		rp_close(&regs);
+	}
+
+	free(lat);
+	close(textFd);
+	close(binFd);
+	fclose(out);
+	return EXIT_SUCCESS;
+}
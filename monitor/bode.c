@@ -0,0 +1,227 @@
+/**
+ * @brief Swept-sine loop analyzer of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <complex.h>
+
+#include "bode.h"
+
+static const char *injName[eBodeInjNum] = {
+	"none", "sp", "out"
+};
+
+static const char *measName[eBodeMeasNum] = {
+	"loop", "closed", "sens", "raw"
+};
+
+const char *rp_bode_sig_name(int a_sig)
+{
+	return (a_sig == RP_BODE_SIG_EXC) ? "exc" : rp_cap_sig_name(a_sig);
+}
+
+int rp_bode_sig_lookup(const char *a_name)
+{
+	capSig_t sig = rp_cap_sig_lookup(a_name);
+
+	if (sig == eCapSigNum && strcasecmp(a_name, "exc")) {
+		return RP_BODE_SIG_NUM;
+	}
+	return sig;
+}
+
+const char *rp_bode_inj_name(bodeInj_t a_inj)
+{
+	return (a_inj >= 0 && a_inj < eBodeInjNum) ? injName[a_inj] : "?";
+}
+
+bodeInj_t rp_bode_inj_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eBodeInjNum && strcasecmp(a_name, injName[i]); ++i) {
+	}
+	return i;
+}
+
+const char *rp_bode_meas_name(bodeMeas_t a_meas)
+{
+	return (a_meas >= 0 && a_meas < eBodeMeasNum) ? measName[a_meas] : "?";
+}
+
+bodeMeas_t rp_bode_meas_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eBodeMeasNum && strcasecmp(a_name, measName[i]); ++i) {
+	}
+	return i;
+}
+
+void rp_bode_preset(bodeConfig_t *a_cfg, bodeMeas_t a_meas)
+{
+	static const struct {
+		bodeInj_t inj;
+		int sig[2];
+	} preset[eBodeRaw] = {
+		[eBodeLoop]   = { eBodeInjOut, { eCapOut, RP_BODE_SIG_EXC } },
+		[eBodeClosed] = { eBodeInjSp,  { eCapAdc, RP_BODE_SIG_EXC } },
+		[eBodeSens]   = { eBodeInjSp,  { eCapErr, RP_BODE_SIG_EXC } },
+	};
+
+	a_cfg->meas = a_meas;
+	if (a_meas >= 0 && a_meas < eBodeRaw) {
+		a_cfg->inj = preset[a_meas].inj;
+		a_cfg->sig[0] = preset[a_meas].sig[0];
+		a_cfg->sig[1] = preset[a_meas].sig[1];
+	}
+}
+
+void rp_bode_defaults(bodeConfig_t *a_cfg)
+{
+	memset(a_cfg, 0, sizeof(*a_cfg));
+	rp_bode_preset(a_cfg, eBodeLoop);
+	a_cfg->amp = 256;
+	a_cfg->start = 10;
+	a_cfg->stop = 100e3;
+	a_cfg->points = 40;
+	a_cfg->cycles = 10;
+	a_cfg->minTime = 0.01;
+	a_cfg->settle = 3;
+	a_cfg->timeoutMs = 1000;
+}
+
+int rp_bode_check(const bodeConfig_t *a_cfg)
+{
+	if (a_cfg->ch < 0 || a_cfg->ch >= rp_pid_num() ||
+	    a_cfg->meas < 0 || a_cfg->meas >= eBodeMeasNum ||
+	    a_cfg->inj < 0 || a_cfg->inj >= eBodeInjNum ||
+	    a_cfg->sig[0] < 0 || a_cfg->sig[0] >= RP_BODE_SIG_NUM ||
+	    a_cfg->sig[1] < 0 || a_cfg->sig[1] >= RP_BODE_SIG_NUM) {
+		return -EINVAL;
+	}
+	// the set point and slow DAC injections saturate at the channel range
+	int32_t max = (1L << (rp_pid_width(a_cfg->ch, ePidSp) - 1)) - 1;
+	if (a_cfg->amp < 1 || a_cfg->amp > max ||
+	    !(a_cfg->start > 0) || !(a_cfg->stop >= a_cfg->start) || a_cfg->stop > RP_PID_CLOCK / 8 ||
+	    a_cfg->points < 1 || (a_cfg->points == 1 && a_cfg->stop != a_cfg->start) ||
+	    !(a_cfg->cycles >= 1) || a_cfg->minTime < 0 || a_cfg->settle < 0 || a_cfg->timeoutMs < 0) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+double rp_bode_freq(const bodeConfig_t *a_cfg, int a_n)
+{
+	if (a_cfg->points < 2) {
+		return a_cfg->start;
+	}
+	return a_cfg->start * pow(a_cfg->stop / a_cfg->start, (double)a_n / (a_cfg->points - 1));
+}
+
+void rp_bode_stop(rpRegs_t *a_regs)
+{
+	a_regs->pid[RP_BODE_CTRL >> 2] = RP_BODE_STOP;
+	rp_sync(a_regs);
+}
+
+static int64_t read_acc(const rpRegs_t *a_regs, int a_n)
+{
+	volatile uint32_t *acc = &a_regs->pid[(RP_BODE_ACC + 8 * a_n) >> 2];
+
+	return (int64_t)(acc[0] | ((uint64_t)acc[1] << 32));
+}
+
+int rp_bode_point(rpRegs_t *a_regs, const bodeConfig_t *a_cfg, double a_freq, bodePoint_t *a_pt)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	double fw = round(a_freq * 4294967296.0 / RP_PID_CLOCK);
+
+	if (fw < 1 || fw > 0xffffffffUL) {
+		return -ERANGE;
+	}
+	// whole periods of the realised frequency, so the products average out
+	double freq = fw * RP_PID_CLOCK / 4294967296.0;
+	double cycles = ceil(fmax(a_cfg->cycles, a_cfg->minTime * freq));
+	double len = round(cycles * RP_PID_CLOCK / freq);
+	double settle = round(a_cfg->settle * RP_PID_CLOCK / freq);
+	if (len > 0xffffffffUL || settle > 0xffffffffUL) {
+		return -ERANGE;
+	}
+
+	pid[RP_BODE_SRC >> 2] = a_cfg->ch | (a_cfg->inj << 4) | (a_cfg->sig[0] << 8) | (a_cfg->sig[1] << 12);
+	pid[RP_BODE_AMP >> 2] = a_cfg->amp;
+	pid[RP_BODE_FREQ >> 2] = fw;
+	pid[RP_BODE_SETTLE >> 2] = settle;
+	pid[RP_BODE_LEN >> 2] = len;
+	pid[RP_BODE_CTRL >> 2] = RP_BODE_START;
+	rp_sync(a_regs);
+
+	struct timespec t0, t;
+	long timeoutMs = (settle + len) / RP_PID_CLOCK * 1000 + a_cfg->timeoutMs;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (!(pid[RP_BODE_CTRL >> 2] & RP_BODE_DONE)) {
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if ((t.tv_sec - t0.tv_sec) * 1000 + (t.tv_nsec - t0.tv_nsec) / 1000000 >= timeoutMs) {
+			return -ETIMEDOUT;
+		}
+		usleep(100);
+	}
+
+	// x = |x| sin(wt + phi) sums to I = N |x| cos(phi) / 2, Q = N |x| sin(phi) / 2
+	double scale = 2.0 / (len * RP_BODE_SINE);
+	a_pt->freq = freq;
+	a_pt->len = len;
+	a_pt->a[0] = read_acc(a_regs, 0) * scale;
+	a_pt->a[1] = read_acc(a_regs, 1) * scale;
+	a_pt->b[0] = read_acc(a_regs, 2) * scale;
+	a_pt->b[1] = read_acc(a_regs, 3) * scale;
+	return 0;
+}
+
+int rp_bode_sweep(rpRegs_t *a_regs, const bodeConfig_t *a_cfg, bodePoint_t *a_pts,
+                  void (*a_cb)(const bodePoint_t *a_pt, void *a_arg), void *a_arg)
+{
+	int ret = rp_bode_check(a_cfg);
+	int n;
+
+	if (ret) {
+		return ret;
+	}
+	for (n = 0; n < a_cfg->points; ++n) {
+		if ((ret = rp_bode_point(a_regs, a_cfg, rp_bode_freq(a_cfg, n), &a_pts[n])) != 0) {
+			break;
+		}
+		if (a_cb) {
+			a_cb(&a_pts[n], a_arg);
+		}
+	}
+	rp_bode_stop(a_regs);
+	return ret ? ret : n;
+}
+
+void rp_bode_response(bodeMeas_t a_meas, const bodePoint_t *a_pt, double a_resp[2])
+{
+	double complex a = a_pt->a[0] + I * a_pt->a[1];
+	double complex b = a_pt->b[0] + I * a_pt->b[1];
+	// the PID output is driven by the negated input, A + B is the plant input
+	double complex r = (a_meas == eBodeLoop) ? -a / (a + b) : a / b;
+
+	a_resp[0] = creal(r);
+	a_resp[1] = cimag(r);
+}
@@ -0,0 +1,147 @@
+/**
+ * @brief Swept-sine loop analyzer of the PID channels.
+ *
+ * Drives red_pitaya_pid_bode.v: a sine of the synthesizer is added to the
+ * set point or the output of one channel, two of its loop signals are
+ * demodulated in the FPGA and only the four accumulators are read per
+ * frequency point. A sweep steps the frequency over a logarithmic grid,
+ * the excitation stays on between the points.
+ *
+ * Measurements, ratios of the complex amplitudes of traces A and B:
+ *   loop    output injection, A = PID output, B = excitation,
+ *           loop gain L = -A / (A + B)
+ *   closed  set point injection, A = input, B = excitation, T = A / B
+ *   sens    set point injection, A = error, B = excitation, S = A / B
+ *   raw     injection and traces as configured, A / B
+ *
+ * Amplitudes are in counts, frequencies in Hz.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef BODE_H
+#define BODE_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+#include "capture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* registers in the PID window, see red_pitaya_pid_bode.v */
+#define RP_BODE_CTRL    0x580
+#define RP_BODE_SRC     0x584
+#define RP_BODE_FREQ    0x588
+#define RP_BODE_AMP     0x58C
+#define RP_BODE_SETTLE  0x590
+#define RP_BODE_LEN     0x594
+#define RP_BODE_COUNT   0x598
+/* 64 bit accumulators A I, A Q, B I, B Q, lower word first */
+#define RP_BODE_ACC     0x5A0
+
+/* control bits (written) and status bits (read) of RP_BODE_CTRL */
+#define RP_BODE_START   0x1
+#define RP_BODE_STOP    0x2
+#define RP_BODE_RUNNING 0x1
+#define RP_BODE_DONE    0x2
+#define RP_BODE_EXC     0x4
+
+/* full scale of the synthesizer sine */
+#define RP_BODE_SINE    32767
+#define RP_BODE_AMP_MAX 32767
+
+/* trace of the excitation itself, the other traces are capSig_t */
+#define RP_BODE_SIG_EXC eCapSigNum
+#define RP_BODE_SIG_NUM (eCapSigNum + 1)
+
+typedef enum {
+	eBodeInjNone=0,
+	eBodeInjSp,       // added to the set point
+	eBodeInjOut,      // added to the output
+	eBodeInjNum
+} bodeInj_t;
+
+typedef enum {
+	eBodeLoop=0,
+	eBodeClosed,
+	eBodeSens,
+	eBodeRaw,
+	eBodeMeasNum
+} bodeMeas_t;
+
+typedef struct {
+	int ch;           // channel index 0-7
+	bodeMeas_t meas;
+	bodeInj_t inj;
+	int sig[2];       // traces A and B, capSig_t or RP_BODE_SIG_EXC
+	int32_t amp;      // excitation amplitude in counts
+	double start;     // first and last frequency
+	double stop;
+	int points;       // log spaced points, start and stop included
+	double cycles;    // excitation periods accumulated per point, at least
+	double minTime;   // accumulation time per point in seconds, at least
+	double settle;    // periods to settle before each point
+	int timeoutMs;    // per point, on top of the expected time
+} bodeConfig_t;
+
+typedef struct {
+	double freq;           // as realised by the phase increment
+	uint32_t len;          // samples accumulated
+	/* amplitudes of the traces relative to the excitation phase, {re, im} */
+	double a[2];
+	double b[2];
+} bodePoint_t;
+
+/* Names used on the command line: adc ... int, exc / none, sp, out / loop, ... */
+const char *rp_bode_sig_name(int a_sig);
+int rp_bode_sig_lookup(const char *a_name);
+const char *rp_bode_inj_name(bodeInj_t a_inj);
+bodeInj_t rp_bode_inj_lookup(const char *a_name);
+const char *rp_bode_meas_name(bodeMeas_t a_meas);
+bodeMeas_t rp_bode_meas_lookup(const char *a_name);
+
+/* Default configuration: loop gain of channel 1, 10 Hz - 100 kHz, 40 points */
+void rp_bode_defaults(bodeConfig_t *a_cfg);
+/* Injection and traces of a measurement other than eBodeRaw */
+void rp_bode_preset(bodeConfig_t *a_cfg, bodeMeas_t a_meas);
+/* 0 if a_cfg is valid, -EINVAL for an unknown channel, signal or injection, -ERANGE otherwise */
+int rp_bode_check(const bodeConfig_t *a_cfg);
+
+/* Frequency of point a_n of the sweep */
+double rp_bode_freq(const bodeConfig_t *a_cfg, int a_n);
+
+/*
+ * Measures one point at a_freq: starts the synthesizer, waits for the
+ * settling and accumulation and reads the amplitudes. The configuration
+ * must have passed rp_bode_check(). Returns 0, -ERANGE if the point does
+ * not fit the counters and -ETIMEDOUT.
+ */
+int rp_bode_point(rpRegs_t *a_regs, const bodeConfig_t *a_cfg, double a_freq, bodePoint_t *a_pt);
+
+/*
+ * Runs the sweep into a_pts (a_cfg->points entries) and switches the
+ * excitation off after it, a_cb (if set) is called after each point.
+ * Returns the number of points measured or a negative rp_bode_check() /
+ * rp_bode_point() error.
+ */
+int rp_bode_sweep(rpRegs_t *a_regs, const bodeConfig_t *a_cfg, bodePoint_t *a_pts,
+                  void (*a_cb)(const bodePoint_t *a_pt, void *a_arg), void *a_arg);
+
+/* Switches the excitation off */
+void rp_bode_stop(rpRegs_t *a_regs);
+
+/* Response {re, im} of a measurement at one point, see above */
+void rp_bode_response(bodeMeas_t a_meas, const bodePoint_t *a_pt, double a_resp[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BODE_H */
@@ -0,0 +1,270 @@
+/**
+ * @brief Bode command of the monitor utility.
+ *
+ * Sweeps the loop analyzer over a log spaced frequency grid and prints a
+ * table of magnitude and phase of the chosen measurement (see bode.h), one
+ * line per point as it is measured:
+ *
+ *   monitor bode 1 measure=loop start=100 stop=50000 points=30 amp=200 --output=loop.tsv
+ *
+ * Parameters: measure (loop closed sens raw), inj (none sp out) and a, b
+ * (adc err p i d out int exc) for raw measurements, start, stop, points,
+ * amp in counts, cycles and time (periods and seconds accumulated per point,
+ * at least), settle in periods and timeout in seconds per point.
+ *
+ * Columns: frequency in Hz, magnitude in dB, unwrapped phase in degrees and
+ * the amplitudes of traces A and B in counts. Loop measurements end with the
+ * crossover frequency, phase and gain margins as comment lines.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+
+#include "bode.h"
+#include "bode_cli.h"
+
+typedef struct {
+	FILE *fp;
+	bodeMeas_t meas;
+	int num;
+	double mag[2];       // dB of the previous and this point
+	double phase[2];     // unwrapped degrees
+	double freq[2];
+	double fc, pm;       // first gain crossover and phase margin
+	double f180, gm;     // first phase crossover and gain margin
+} sweepOut_t;
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"\tbode <1-%d> [measure=loop|closed|sens|raw] [inj=none|sp|out] [a=sig] [b=sig]\n"
+		"\t     [start=Hz] [stop=Hz] [points=n] [amp=n] [cycles=n] [time=s] [settle=n]\n"
+		"\t     [timeout=s] [--output=file|-]\n"
+		"Signals:", rp_pid_num());
+	for (int i = 0; i < RP_BODE_SIG_NUM; ++i) {
+		fprintf(stderr, " %s", rp_bode_sig_name(i));
+	}
+	fprintf(stderr, "\ninj, a and b apply to measure=raw\n");
+}
+
+static int parse_long(const char *a_str, long *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtol(a_str, &end, 0);
+	return (end == a_str || *end != '\0' || errno) ? -1 : 0;
+}
+
+static int parse_double(const char *a_str, double *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtod(a_str, &end);
+	return (end == a_str || *end != '\0' || errno || !isfinite(*a_val)) ? -1 : 0;
+}
+
+/* one par=val token */
+static int parse_assign(bodeConfig_t *a_cfg, char *a_tok)
+{
+	char *eq = strchr(a_tok, '=');
+	double val = 0;
+
+	if (eq == NULL) {
+		fprintf(stderr, "bode: expected par=val, got '%s'\n", a_tok);
+		return -1;
+	}
+	*eq++ = '\0';
+
+	if (strcasecmp(a_tok, "measure") == 0) {
+		bodeMeas_t meas = rp_bode_meas_lookup(eq);
+		if (meas == eBodeMeasNum) {
+			fprintf(stderr, "bode: unknown measurement '%s'\n", eq);
+			return -1;
+		}
+		rp_bode_preset(a_cfg, meas);
+		return 0;
+	}
+	if (strcasecmp(a_tok, "inj") == 0) {
+		a_cfg->inj = rp_bode_inj_lookup(eq);
+		if (a_cfg->inj == eBodeInjNum) {
+			fprintf(stderr, "bode: unknown injection '%s'\n", eq);
+			return -1;
+		}
+		return 0;
+	}
+	if (strcasecmp(a_tok, "a") == 0 || strcasecmp(a_tok, "b") == 0) {
+		int sig = rp_bode_sig_lookup(eq);
+		if (sig == RP_BODE_SIG_NUM) {
+			fprintf(stderr, "bode: unknown signal '%s'\n", eq);
+			return -1;
+		}
+		a_cfg->sig[tolower((unsigned char)*a_tok) - 'a'] = sig;
+		return 0;
+	}
+	if (parse_double(eq, &val) == -1 || fabs(val) > INT32_MAX) {
+		fprintf(stderr, "bode: invalid value '%s' for %s\n", eq, a_tok);
+		return -1;
+	}
+	if (strcasecmp(a_tok, "start") == 0) {
+		a_cfg->start = val;
+	} else if (strcasecmp(a_tok, "stop") == 0) {
+		a_cfg->stop = val;
+	} else if (strcasecmp(a_tok, "points") == 0) {
+		a_cfg->points = val;
+	} else if (strcasecmp(a_tok, "amp") == 0) {
+		a_cfg->amp = val;
+	} else if (strcasecmp(a_tok, "cycles") == 0) {
+		a_cfg->cycles = val;
+	} else if (strcasecmp(a_tok, "time") == 0) {
+		a_cfg->minTime = val;
+	} else if (strcasecmp(a_tok, "settle") == 0) {
+		a_cfg->settle = val;
+	} else if (strcasecmp(a_tok, "timeout") == 0) {
+		a_cfg->timeoutMs = val * 1000;
+	} else {
+		fprintf(stderr, "bode: unknown parameter '%s'\n", a_tok);
+		return -1;
+	}
+	return 0;
+}
+
+/* log-frequency interpolation of the point where a_y crosses a_level */
+static double cross(const double *a_f, const double *a_y, double a_level)
+{
+	double t = (a_level - a_y[0]) / (a_y[1] - a_y[0]);
+
+	return a_f[0] * pow(a_f[1] / a_f[0], t);
+}
+
+static void on_point(const bodePoint_t *a_pt, void *a_arg)
+{
+	sweepOut_t *out = a_arg;
+	double resp[2];
+
+	rp_bode_response(out->meas, a_pt, resp);
+	double mag = 20 * log10(hypot(resp[0], resp[1]));
+	double phase = atan2(resp[1], resp[0]) * 180 / M_PI;
+	// unwrap against the previous point
+	if (out->num > 0) {
+		phase -= 360 * round((phase - out->phase[1]) / 360);
+	}
+	out->mag[0] = out->mag[1];
+	out->phase[0] = out->phase[1];
+	out->freq[0] = out->freq[1];
+	out->mag[1] = mag;
+	out->phase[1] = phase;
+	out->freq[1] = a_pt->freq;
+
+	if (out->meas == eBodeLoop && out->num > 0 && isfinite(out->mag[0]) && isfinite(mag)) {
+		if (isnan(out->fc) && out->mag[0] >= 0 && mag < 0) {
+			double t = out->mag[0] / (out->mag[0] - mag);
+			out->fc = cross(out->freq, out->mag, 0);
+			out->pm = 180 + out->phase[0] + t * (phase - out->phase[0]);
+		}
+		// the phase crossover nearest to -180 degrees of the unwrapped phase
+		double p180 = -180 + 360 * round((out->phase[0] + 180) / 360);
+		if (isnan(out->f180) && (out->phase[0] - p180) * (phase - p180) <= 0 && phase != out->phase[0]) {
+			double t = (p180 - out->phase[0]) / (phase - out->phase[0]);
+			out->f180 = cross(out->freq, out->phase, p180);
+			out->gm = -(out->mag[0] + t * (mag - out->mag[0]));
+		}
+	}
+	++out->num;
+
+	fprintf(out->fp, "%.6g\t%.3f\t%.2f\t%.3f\t%.3f\n", a_pt->freq, mag, phase,
+	        hypot(a_pt->a[0], a_pt->a[1]), hypot(a_pt->b[0], a_pt->b[1]));
+	fflush(out->fp);
+}
+
+int bode_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	bodeConfig_t cfg;
+	const char *output = "-";
+	long num;
+	int ret;
+
+	rp_bode_defaults(&cfg);
+	if (a_argc < 1 || parse_long(a_argv[0], &num) == -1 || num < 1 || num > rp_pid_num()) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	cfg.ch = num - 1;
+
+	for (int i = 1; i < a_argc; ++i) {
+		if (strncmp(a_argv[i], "--output=", 9) == 0) {
+			output = a_argv[i] + 9;
+		} else if (parse_assign(&cfg, a_argv[i]) == -1) {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if ((ret = rp_bode_check(&cfg)) != 0) {
+		fprintf(stderr, "bode: %s\n", (ret == -EINVAL) ? "invalid configuration" : "value out of range");
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	bodePoint_t *pts = calloc(cfg.points, sizeof(*pts));
+	FILE *fp = strcmp(output, "-") ? fopen(output, "w") : stdout;
+	if (pts == NULL || fp == NULL) {
+		fprintf(stderr, "bode: %s: %s\n", output, strerror(errno));
+		free(pts);
+		return EXIT_FAILURE;
+	}
+
+	sweepOut_t out = { .fp = fp, .meas = cfg.meas, .fc = NAN, .pm = NAN, .f180 = NAN, .gm = NAN };
+	fprintf(fp, "# channel %d %s, injection %s, A %s, B %s, amplitude %d\n", cfg.ch + 1,
+	        rp_bode_meas_name(cfg.meas), rp_bode_inj_name(cfg.inj), rp_bode_sig_name(cfg.sig[0]),
+	        rp_bode_sig_name(cfg.sig[1]), cfg.amp);
+	fprintf(fp, "# freq_hz\tmag_db\tphase_deg\ta_amp\tb_amp\n");
+
+	ret = rp_bode_sweep(a_regs, &cfg, pts, on_point, &out);
+
+	if (cfg.meas == eBodeLoop && ret > 0) {
+		for (int pass = 0; pass < 2; ++pass) {
+			FILE *sfp = pass ? stdout : fp;
+			if (pass && fp == stdout) {
+				break;
+			}
+			if (isnan(out.fc)) {
+				fprintf(sfp, "# no gain crossover in the sweep\n");
+			} else {
+				fprintf(sfp, "# crossover %.6g Hz\tphase margin %.1f deg\n", out.fc, out.pm);
+			}
+			if (!isnan(out.f180)) {
+				fprintf(sfp, "# phase crossover %.6g Hz\tgain margin %.1f dB\n", out.f180, out.gm);
+			}
+		}
+	}
+	free(pts);
+	if (fp != stdout && fclose(fp) != 0) {
+		fprintf(stderr, "bode: %s: %s\n", output, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (ret < 0) {
+		fprintf(stderr, "bode: %s\n", (ret == -ETIMEDOUT) ? "no point completed, is the analyzer in the bitstream?" :
+		        (ret == -ERANGE) ? "point too long for the counters, raise start or lower cycles and time" :
+		        strerror(-ret));
+		return EXIT_FAILURE;
+	}
+	if (fp != stdout) {
+		printf("%d points written to %s\n", ret, output);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+/**
+ * @brief Bode command of the monitor utility.
+ *
+ * monitor bode <1-8> [par=val ...] [--output=file]
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef BODE_CLI_H
+#define BODE_CLI_H
+
+#include "rp_regs.h"
+
+/*
+ * Sweeps one channel, a_argv[0] is the channel. Returns EXIT_SUCCESS or
+ * EXIT_FAILURE.
+ */
+int bode_cli(rpRegs_t *a_regs, int a_argc, char **a_argv);
+
+#endif /* BODE_CLI_H */
@@ -0,0 +1,172 @@
+/**
+ * @brief Capture buffer of the PID controller loop signals.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+
+#include "capture.h"
+
+static const char *sigName[eCapSigNum] = {
+	"adc", "err", "p", "i", "d", "out", "int"
+};
+
+static const char *trigName[eCapTrigNum] = {
+	"now", "rise", "fall", "isat", "osat", "dio-rise", "dio-fall"
+};
+
+const char *rp_cap_sig_name(capSig_t a_sig)
+{
+	return (a_sig >= 0 && a_sig < eCapSigNum) ? sigName[a_sig] : "?";
+}
+
+capSig_t rp_cap_sig_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eCapSigNum && strcasecmp(a_name, sigName[i]); ++i) {
+	}
+	return i;
+}
+
+const char *rp_cap_trig_name(capTrig_t a_trig)
+{
+	return (a_trig >= 0 && a_trig < eCapTrigNum) ? trigName[a_trig] : "?";
+}
+
+capTrig_t rp_cap_trig_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eCapTrigNum && strcasecmp(a_name, trigName[i]); ++i) {
+	}
+	return i;
+}
+
+void rp_cap_defaults(capConfig_t *a_cfg)
+{
+	memset(a_cfg, 0, sizeof(*a_cfg));
+	a_cfg->sig[0] = eCapErr;
+	a_cfg->sig[1] = eCapOut;
+	a_cfg->trig = eCapTrigNow;
+	a_cfg->dec = 1;
+	a_cfg->post = RP_CAP_DEPTH;
+}
+
+int rp_cap_check(const capConfig_t *a_cfg)
+{
+	if (a_cfg->ch < 0 || a_cfg->ch >= rp_pid_num() ||
+	    a_cfg->sig[0] < 0 || a_cfg->sig[0] >= eCapSigNum ||
+	    a_cfg->sig[1] < 0 || a_cfg->sig[1] >= eCapSigNum ||
+	    a_cfg->trig < 0 || a_cfg->trig >= eCapTrigNum) {
+		return -EINVAL;
+	}
+	if (a_cfg->level < -32768 || a_cfg->level > 32767 ||
+	    a_cfg->dio < 0 || a_cfg->dio > 7 || a_cfg->dec < 1 ||
+	    a_cfg->pre > RP_CAP_DEPTH || a_cfg->post > RP_CAP_DEPTH - a_cfg->pre ||
+	    a_cfg->pre + a_cfg->post == 0) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+int rp_cap_arm(rpRegs_t *a_regs, const capConfig_t *a_cfg)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	int ret = rp_cap_check(a_cfg);
+
+	if (ret) {
+		return ret;
+	}
+	pid[RP_CAP_CTRL >> 2]  = RP_CAP_STOP;
+	pid[RP_CAP_SRC >> 2]   = a_cfg->ch | (a_cfg->sig[0] << 4) | (a_cfg->sig[1] << 8);
+	pid[RP_CAP_TRIG >> 2]  = a_cfg->trig | (a_cfg->dio << 8);
+	pid[RP_CAP_LEVEL >> 2] = a_cfg->level & 0xffff;
+	pid[RP_CAP_DEC >> 2]   = a_cfg->dec;
+	pid[RP_CAP_PRE >> 2]   = a_cfg->pre;
+	pid[RP_CAP_POST >> 2]  = a_cfg->post;
+	pid[RP_CAP_CTRL >> 2]  = RP_CAP_ARM;
+	rp_sync(a_regs);
+	return 0;
+}
+
+void rp_cap_trigger(rpRegs_t *a_regs)
+{
+	a_regs->pid[RP_CAP_CTRL >> 2] = RP_CAP_SWTRIG;
+	rp_sync(a_regs);
+}
+
+void rp_cap_stop(rpRegs_t *a_regs)
+{
+	a_regs->pid[RP_CAP_CTRL >> 2] = RP_CAP_STOP;
+	rp_sync(a_regs);
+}
+
+uint32_t rp_cap_status(const rpRegs_t *a_regs)
+{
+	return a_regs->pid[RP_CAP_CTRL >> 2];
+}
+
+int rp_cap_wait(rpRegs_t *a_regs, int a_timeoutMs)
+{
+	struct timespec t0, t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while (!(rp_cap_status(a_regs) & RP_CAP_DONE)) {
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if ((t.tv_sec - t0.tv_sec) * 1000 + (t.tv_nsec - t0.tv_nsec) / 1000000 >= a_timeoutMs) {
+			return -ETIMEDOUT;
+		}
+		usleep(100);
+	}
+	return 0;
+}
+
+long rp_cap_read(rpRegs_t *a_regs, capHeader_t *a_hdr, capSample_t *a_samples)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	uint32_t src = pid[RP_CAP_SRC >> 2];
+	uint32_t trig = pid[RP_CAP_TRIG >> 2];
+
+	memset(a_hdr, 0, sizeof(*a_hdr));
+	memcpy(a_hdr->magic, RP_CAP_MAGIC, sizeof(a_hdr->magic));
+	a_hdr->version = RP_CAP_VERSION;
+	a_hdr->headerSize = sizeof(*a_hdr);
+	a_hdr->ch = src & 0x7;
+	a_hdr->sig[0] = (src >> 4) & 0x7;
+	a_hdr->sig[1] = (src >> 8) & 0x7;
+	a_hdr->trig = trig & 0x7;
+	a_hdr->dio = (trig >> 8) & 0x7;
+	a_hdr->level = (int16_t)pid[RP_CAP_LEVEL >> 2];
+	a_hdr->dec = pid[RP_CAP_DEC >> 2];
+	a_hdr->pre = pid[RP_CAP_PRE >> 2];
+	a_hdr->post = pid[RP_CAP_POST >> 2];
+	a_hdr->trigTime = pid[RP_CAP_TIME >> 2] | ((uint64_t)pid[(RP_CAP_TIME + 4) >> 2] << 32);
+	a_hdr->sampleRate = RP_CAP_CLOCK / (a_hdr->dec ? a_hdr->dec : 1);
+
+	long num = a_hdr->pre + a_hdr->post;
+	if (num > RP_CAP_DEPTH) {
+		errno = EINVAL;
+		return -1;
+	}
+	// the window reads in time order from the first pre-trigger sample on
+	volatile void *buf = rp_map_block(a_regs, RP_ADDR_PID + RP_CAP_BUF, RP_CAP_DEPTH * sizeof(uint32_t));
+	if (buf == NULL) {
+		return -1;
+	}
+	memcpy(a_samples, (const void *)buf, num * sizeof(capSample_t));
+	return num;
+}
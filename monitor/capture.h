@@ -0,0 +1,142 @@
+/**
+ * @brief Capture buffer of the PID controller loop signals.
+ *
+ * Drives the triggered block RAM capture of red_pitaya_pid_capture.v: two
+ * traces of one channel, 16 bit each, at up to 125 MS/s around a trigger.
+ * The buffer window reads in time order, a finished capture is copied out
+ * of the mapped window in one go.
+ *
+ * Capture files (monitor capture) hold a capHeader_t followed by pre + post
+ * capSample_t in little endian byte order; sample 'pre' is the trigger.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* registers in the PID window, see red_pitaya_pid_capture.v */
+#define RP_CAP_CTRL    0x540
+#define RP_CAP_SRC     0x544
+#define RP_CAP_TRIG    0x548
+#define RP_CAP_LEVEL   0x54C
+#define RP_CAP_DEC     0x550
+#define RP_CAP_PRE     0x554
+#define RP_CAP_POST    0x558
+#define RP_CAP_START   0x55C
+#define RP_CAP_TIME    0x560
+#define RP_CAP_BUF     0x10000
+
+/* samples in the buffer */
+#define RP_CAP_DEPTH   16384
+#define RP_CAP_CLOCK   125000000.0
+
+/* control bits (written) and status bits (read) of RP_CAP_CTRL */
+#define RP_CAP_ARM       0x1
+#define RP_CAP_SWTRIG    0x2
+#define RP_CAP_STOP      0x4
+#define RP_CAP_RUNNING   0x1
+#define RP_CAP_TRIGGERED 0x2
+#define RP_CAP_DONE      0x4
+
+#define RP_CAP_MAGIC   "RPCP"
+#define RP_CAP_VERSION 1
+
+typedef enum {
+	eCapAdc=0,
+	eCapErr,
+	eCapP,
+	eCapI,
+	eCapD,
+	eCapOut,
+	eCapInt,   // upper 16 bits of the integrator register
+	eCapSigNum
+} capSig_t;
+
+typedef enum {
+	eCapTrigNow=0,
+	eCapTrigRise,     // trace A crosses the level upwards
+	eCapTrigFall,     // trace A crosses the level downwards
+	eCapTrigIntSat,
+	eCapTrigOutSat,
+	eCapTrigDioRise,
+	eCapTrigDioFall,
+	eCapTrigNum
+} capTrig_t;
+
+typedef struct {
+	int ch;           // channel index 0-7
+	capSig_t sig[2];  // traces A and B
+	capTrig_t trig;
+	int32_t level;    // -32768 - 32767
+	int dio;          // DIO_P pin 0-7 of the DIO triggers
+	uint32_t dec;     // decimation, 1 = every clock
+	uint32_t pre;     // samples before the trigger
+	uint32_t post;    // samples from the trigger on, pre + post <= RP_CAP_DEPTH
+} capConfig_t;
+
+typedef struct {
+	int16_t a;
+	int16_t b;
+} capSample_t;
+
+/* capture file header */
+typedef struct {
+	char magic[4];        // RP_CAP_MAGIC
+	uint16_t version;     // RP_CAP_VERSION
+	uint16_t headerSize;  // sizeof(capHeader_t), offset of the first sample
+	uint8_t ch;
+	uint8_t sig[2];
+	uint8_t trig;
+	uint8_t dio;
+	uint8_t reserved[3];
+	int32_t level;
+	uint32_t dec;
+	uint32_t pre;
+	uint32_t post;
+	uint64_t trigTime;    // FPGA clock cycles since reset
+	double sampleRate;    // Hz
+} capHeader_t;
+
+/* Names used on the command line: adc, err, p, i, d, out, int / now, rise, ... */
+const char *rp_cap_sig_name(capSig_t a_sig);
+capSig_t rp_cap_sig_lookup(const char *a_name);
+const char *rp_cap_trig_name(capTrig_t a_trig);
+capTrig_t rp_cap_trig_lookup(const char *a_name);
+
+/* Default configuration: channel 1 error and output, immediate trigger, full buffer */
+void rp_cap_defaults(capConfig_t *a_cfg);
+/* 0 if a_cfg is valid, -EINVAL for an unknown channel, signal or trigger, -ERANGE otherwise */
+int rp_cap_check(const capConfig_t *a_cfg);
+
+/* Configures and arms a capture, returns rp_cap_check() */
+int rp_cap_arm(rpRegs_t *a_regs, const capConfig_t *a_cfg);
+void rp_cap_trigger(rpRegs_t *a_regs);
+void rp_cap_stop(rpRegs_t *a_regs);
+uint32_t rp_cap_status(const rpRegs_t *a_regs);
+/* Waits for the end of the capture, 0 when done, -ETIMEDOUT */
+int rp_cap_wait(rpRegs_t *a_regs, int a_timeoutMs);
+
+/*
+ * Header and samples of the last capture; a_samples must hold pre + post
+ * entries. Returns the number of samples, -1 with errno set on failure.
+ */
+long rp_cap_read(rpRegs_t *a_regs, capHeader_t *a_hdr, capSample_t *a_samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CAPTURE_H */
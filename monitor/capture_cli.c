@@ -0,0 +1,180 @@
+/**
+ * @brief Capture command of the monitor utility.
+ *
+ * Arms the capture buffer on one channel, waits for the trigger and the
+ * post-trigger samples and writes the result as a capture file (see
+ * capture.h):
+ *
+ *   monitor capture 1 a=err b=out trig=rise level=200 pre=1000 post=4000 --output=lock.cap
+ *
+ * Parameters: a, b (adc err p i d out int), trig (now rise fall isat osat
+ * dio-rise dio-fall), level, dio, dec, pre, post and timeout in seconds.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "capture.h"
+#include "capture_cli.h"
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"\tcapture <1-%d> [a=sig] [b=sig] [trig=src] [level=n] [dio=0-7] [dec=n]\n"
+		"\t        [pre=n] [post=n] [timeout=s] --output=file|-\n"
+		"Signals:", rp_pid_num());
+	for (int i = 0; i < eCapSigNum; ++i) {
+		fprintf(stderr, " %s", rp_cap_sig_name(i));
+	}
+	fprintf(stderr, "\nTriggers:");
+	for (int i = 0; i < eCapTrigNum; ++i) {
+		fprintf(stderr, " %s", rp_cap_trig_name(i));
+	}
+	fprintf(stderr, "\npre + post <= %d samples\n", RP_CAP_DEPTH);
+}
+
+static int parse_long(const char *a_str, long *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtol(a_str, &end, 0);
+	return (end == a_str || *end != '\0' || errno) ? -1 : 0;
+}
+
+/* one par=val token */
+static int parse_assign(capConfig_t *a_cfg, int *a_timeout, char *a_tok)
+{
+	char *eq = strchr(a_tok, '=');
+	long val = 0;
+
+	if (eq == NULL) {
+		fprintf(stderr, "capture: expected par=val, got '%s'\n", a_tok);
+		return -1;
+	}
+	*eq++ = '\0';
+
+	if (strcasecmp(a_tok, "a") == 0 || strcasecmp(a_tok, "b") == 0) {
+		capSig_t sig = rp_cap_sig_lookup(eq);
+		if (sig == eCapSigNum) {
+			fprintf(stderr, "capture: unknown signal '%s'\n", eq);
+			return -1;
+		}
+		a_cfg->sig[tolower((unsigned char)*a_tok) - 'a'] = sig;
+		return 0;
+	}
+	if (strcasecmp(a_tok, "trig") == 0) {
+		a_cfg->trig = rp_cap_trig_lookup(eq);
+		if (a_cfg->trig == eCapTrigNum) {
+			fprintf(stderr, "capture: unknown trigger '%s'\n", eq);
+			return -1;
+		}
+		return 0;
+	}
+	if (parse_long(eq, &val) == -1) {
+		fprintf(stderr, "capture: invalid value '%s' for %s\n", eq, a_tok);
+		return -1;
+	}
+	if (strcasecmp(a_tok, "level") == 0) {
+		a_cfg->level = val;
+	} else if (strcasecmp(a_tok, "dio") == 0) {
+		a_cfg->dio = val;
+	} else if (strcasecmp(a_tok, "dec") == 0) {
+		a_cfg->dec = val;
+	} else if (strcasecmp(a_tok, "pre") == 0) {
+		a_cfg->pre = val;
+	} else if (strcasecmp(a_tok, "post") == 0) {
+		a_cfg->post = val;
+	} else if (strcasecmp(a_tok, "timeout") == 0) {
+		*a_timeout = val * 1000;
+	} else {
+		fprintf(stderr, "capture: unknown parameter '%s'\n", a_tok);
+		return -1;
+	}
+	if (val < INT32_MIN || val > INT32_MAX || (val < 0 && strcasecmp(a_tok, "level"))) {
+		fprintf(stderr, "capture: %s out of range: %ld\n", a_tok, val);
+		return -1;
+	}
+	return 0;
+}
+
+int capture_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static capSample_t samples[RP_CAP_DEPTH];
+	capConfig_t cfg;
+	capHeader_t hdr;
+	const char *output = NULL;
+	int timeout = 10000;
+	long num;
+	int ret;
+
+	rp_cap_defaults(&cfg);
+	if (a_argc < 1 || parse_long(a_argv[0], &num) == -1 || num < 1 || num > rp_pid_num()) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	cfg.ch = num - 1;
+	// the default post-trigger depth fills what the pre-trigger part leaves
+	cfg.post = 0;
+
+	for (int i = 1; i < a_argc; ++i) {
+		if (strncmp(a_argv[i], "--output=", 9) == 0) {
+			output = a_argv[i] + 9;
+		} else if (parse_assign(&cfg, &timeout, a_argv[i]) == -1) {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (cfg.post == 0 && cfg.pre < RP_CAP_DEPTH) {
+		cfg.post = RP_CAP_DEPTH - cfg.pre;
+	}
+	if (output == NULL) {
+		fprintf(stderr, "capture: no --output file given\n");
+		return EXIT_FAILURE;
+	}
+	if ((ret = rp_cap_arm(a_regs, &cfg)) != 0) {
+		fprintf(stderr, "capture: %s\n", (ret == -EINVAL) ? "invalid configuration" : "value out of range");
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (rp_cap_wait(a_regs, timeout) != 0) {
+		rp_cap_stop(a_regs);
+		fprintf(stderr, "capture: no trigger within %d s\n", timeout / 1000);
+		return EXIT_FAILURE;
+	}
+	if ((num = rp_cap_read(a_regs, &hdr, samples)) == -1) {
+		fprintf(stderr, "capture: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	FILE *fp = strcmp(output, "-") ? fopen(output, "wb") : stdout;
+	if (fp == NULL) {
+		fprintf(stderr, "capture: %s: %s\n", output, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 || fwrite(samples, sizeof(samples[0]), num, fp) != num ||
+	    (fp != stdout && fclose(fp) != 0)) {
+		fprintf(stderr, "capture: %s: %s\n", output, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (fp == stdout) {
+		fflush(stdout);
+	} else {
+		printf("%ld samples at %.0f S/s, trigger at sample %u, clock %llu\n", num, hdr.sampleRate, hdr.pre,
+		       (unsigned long long)hdr.trigTime);
+	}
+	return EXIT_SUCCESS;
+}
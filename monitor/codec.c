@@ -0,0 +1,250 @@
+/**
+ * @brief Register codec of the PID channel parameters.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "codec.h"
+#include "info.h"
+#include "ramp.h"
+#include "ff.h"
+
+/* register map of the default bitstream, see red_pitaya_pid.v */
+#define CHAN(n, t, w, f, tm, d) { \
+	.type = t, \
+	.gainWidth = w, \
+	.gainFrac = f, \
+	.flags = RP_INFO_CH_RAMP | RP_INFO_CH_BODE | RP_INFO_CH_CAPTURE | (tm) | RP_INFO_CH_FF | RP_INFO_CH_BANK | RP_INFO_CH_AWINDUP | ((d) ? RP_INFO_CH_DERIV : 0), \
+	.off = { \
+		[ePidSp]   = 0x010 + 0x10 * (n), \
+		[ePidKp]   = 0x014 + 0x10 * (n), \
+		[ePidKi]   = 0x018 + 0x10 * (n), \
+		[ePidKd]   = 0x01C + 0x10 * (n), \
+		[ePidIrst] = 0x090 + 0x04 * (n), \
+		[ePidPSR]  = 0x0B0 + 0x10 * (n), \
+		[ePidISR]  = 0x0B4 + 0x10 * (n), \
+		[ePidDSR]  = 0x0B8 + 0x10 * (n), \
+		[ePidICD]  = 0x0BC + 0x10 * (n), \
+		[ePidTol]  = 0x130 + 0x04 * (n), \
+	}, \
+	.tlm = RP_PID_TLM_BASE + RP_PID_TLM_STRIDE * (n), \
+	.ramp = RP_RAMP_BASE(n), \
+	.deriv = 0x700 + 0x10 * (n), \
+	.ff = RP_FF_BASE(n), \
+}
+
+#define DEFAULT_MAP { \
+	CHAN(0, RP_CHAN_FAST, 14, 11, 0, 1), CHAN(1, RP_CHAN_FAST, 14, 11, 0, 1), \
+	CHAN(2, RP_CHAN_FAST, 14, 11, 0, 1), CHAN(3, RP_CHAN_FAST, 14, 11, 0, 1), \
+	CHAN(4, RP_CHAN_SLOW, 12, 0, RP_INFO_CH_TM, 0), CHAN(5, RP_CHAN_SLOW, 12, 0, RP_INFO_CH_TM, 0), \
+	CHAN(6, RP_CHAN_SLOW, 12, 0, RP_INFO_CH_TM, 0), CHAN(7, RP_CHAN_SLOW, 12, 0, RP_INFO_CH_TM, 0), \
+}
+
+static const rpChan_t defaultChan[RP_PID_NUM] = DEFAULT_MAP;
+
+rpChan_t rpChan[RP_PID_MAX] = DEFAULT_MAP;
+int rpChanNum = RP_PID_NUM;
+
+static const char *unitName[eUnitNum] = {
+	[eUnitVolt] = "V",
+	[eUnitHz]   = "Hz",
+};
+
+static inline uint32_t mask(int a_width)
+{
+	return (a_width < 32) ? ((1UL << a_width) - 1) : 0xffffffffUL;
+}
+
+/* two's complement field of a_width bits */
+static inline int32_t sign_extend(uint32_t a_raw, int a_width)
+{
+	a_raw &= mask(a_width);
+	return (a_raw >> (a_width - 1)) ? (int32_t)a_raw - (int32_t)(1L << a_width) : (int32_t)a_raw;
+}
+
+void rp_codec_defaults(void)
+{
+	memcpy(rpChan, defaultChan, sizeof(defaultChan));
+	rpChanNum = RP_PID_NUM;
+}
+
+const char *rp_codec_unit(pidPar_t a_par)
+{
+	const char *name = (a_par >= 0 && a_par < ePidParNum) ? unitName[rpParDesc[a_par].unit] : NULL;
+
+	return name ? name : "";
+}
+
+int32_t rp_codec_decode(int a_ch, pidPar_t a_par, uint32_t a_raw)
+{
+	const rpChanType_t *type = rp_chan_type(a_ch);
+	int width = rp_codec_width(a_ch, a_par);
+
+	if (rpParDesc[a_par].width == 0) {
+		// two's complement of the ADC resolution on the fast PIDs, the
+		// slow PIDs are set in plain counts (0-4095) like in the menus
+		return (type->min < 0) ? sign_extend(a_raw, width) : (int32_t)(a_raw & mask(width));
+	}
+	if (a_par == ePidICD) {
+		// integrator clock divider, shown as frequency
+		return type->icdClock / ((a_raw & mask(width)) + 1);
+	}
+	return a_raw;
+}
+
+uint32_t rp_codec_encode(int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	if (a_par == ePidICD) {
+		// subtracting 1 so that it becomes a true divider (ICD = 0 at full speed)
+		if (a_val < 1) {
+			a_val = 1;
+		}
+		a_val = rp_chan_type(a_ch)->icdClock / a_val - 1;
+	}
+	return (uint32_t)a_val & mask(rp_codec_width(a_ch, a_par));
+}
+
+void rp_codec_range(int a_ch, pidPar_t a_par, int32_t *a_min, int32_t *a_max)
+{
+	const rpChanType_t *type = rp_chan_type(a_ch);
+
+	if (rpParDesc[a_par].width == 0) {
+		// full register width, signed like the set point of the channel type
+		int width = rp_codec_width(a_ch, a_par);
+		*a_min = (type->min < 0) ? -(int32_t)(1L << (width - 1)) : 0;
+		*a_max = (type->min < 0) ? (int32_t)(1L << (width - 1)) - 1 : (int32_t)mask(width);
+	} else {
+		*a_min = rpParDesc[a_par].min;
+		*a_max = (a_par == ePidICD) ? type->icdClock : rpParDesc[a_par].max;
+	}
+}
+
+double rp_codec_to_phys(int a_ch, pidPar_t a_par, uint32_t a_raw)
+{
+	const rpChanType_t *type = rp_chan_type(a_ch);
+	int width = rp_codec_width(a_ch, a_par);
+
+	switch (rpParDesc[a_par].unit) {
+		case eUnitVolt:
+			// the hardware compares signed values on both channel types
+			return sign_extend(a_raw, width) * type->volt;
+		case eUnitHz:
+			return (double)type->icdClock / ((a_raw & mask(width)) + 1);
+		default:
+			return rp_codec_decode(a_ch, a_par, a_raw);
+	}
+}
+
+uint32_t rp_codec_from_phys(int a_ch, pidPar_t a_par, double a_val)
+{
+	const rpChanType_t *type = rp_chan_type(a_ch);
+	int width = rp_codec_width(a_ch, a_par);
+	double min, max;
+	int32_t umin, umax;
+
+	switch (rpParDesc[a_par].unit) {
+		case eUnitVolt:
+			a_val /= type->volt;
+			min = -(double)(1L << (width - 1));
+			max = (double)(1L << (width - 1)) - 1;
+			break;
+		case eUnitHz:
+			// f = clock / (ICD + 1), the nearest divider
+			a_val = (a_val > 0) ? (double)type->icdClock / a_val - 1 : INFINITY;
+			min = 0;
+			max = mask(width);
+			break;
+		default:
+			rp_codec_range(a_ch, a_par, &umin, &umax);
+			a_val = fmin(fmax(round(a_val), umin), umax);
+			return rp_codec_encode(a_ch, a_par, a_val);
+	}
+	if (isnan(a_val)) {
+		a_val = 0;
+	}
+	return (uint32_t)(int32_t)fmin(fmax(round(a_val), min), max) & mask(width);
+}
+
+void rp_codec_phys_range(int a_ch, pidPar_t a_par, double *a_min, double *a_max)
+{
+	const rpChanType_t *type = rp_chan_type(a_ch);
+	int width = rp_codec_width(a_ch, a_par);
+	int32_t min, max;
+
+	switch (rpParDesc[a_par].unit) {
+		case eUnitVolt:
+			*a_min = -(double)(1L << (width - 1)) * type->volt;
+			*a_max = ((double)(1L << (width - 1)) - 1) * type->volt;
+			return;
+		case eUnitHz:
+			*a_min = (double)type->icdClock / ((double)mask(width) + 1);
+			*a_max = type->icdClock;
+			return;
+		default:
+			rp_codec_range(a_ch, a_par, &min, &max);
+			*a_min = min;
+			*a_max = max;
+	}
+}
+
+int rp_codec_check_phys(int a_ch, pidPar_t a_par, double a_val)
+{
+	double min, max, lsb;
+
+	rp_codec_phys_range(a_ch, a_par, &min, &max);
+	// values rounding to the end points are still in range
+	lsb = (rpParDesc[a_par].unit == eUnitVolt) ? rp_chan_type(a_ch)->volt / 2 : 0;
+	return (a_val >= min - lsb && a_val <= max + lsb) ? 0 : -ERANGE;
+}
+
+void rp_codec_read_set(const rpRegs_t *a_regs, int a_ch, uint32_t *a_raw)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_raw[i] = a_regs->pid[rp_codec_offset(a_ch, i) >> 2];
+	}
+}
+
+void rp_codec_write_set(rpRegs_t *a_regs, int a_ch, const uint32_t *a_raw)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		rp_pid_write_raw(a_regs, a_ch, i, a_raw[i]);
+	}
+}
+
+void rp_codec_decode_set(int a_ch, const uint32_t *a_raw, pidParams_t *a_par)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_par->val[i] = rp_codec_decode(a_ch, i, a_raw[i]);
+	}
+}
+
+void rp_codec_encode_set(int a_ch, const pidParams_t *a_par, uint32_t *a_raw)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_raw[i] = rp_codec_encode(a_ch, i, a_par->val[i]);
+	}
+}
+
+void rp_codec_to_phys_set(int a_ch, const uint32_t *a_raw, pidPhys_t *a_phys)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_phys->val[i] = rp_codec_to_phys(a_ch, i, a_raw[i]);
+	}
+}
+
+void rp_codec_from_phys_set(int a_ch, const pidPhys_t *a_phys, uint32_t *a_raw)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_raw[i] = rp_codec_from_phys(a_ch, i, a_phys->val[i]);
+	}
+}
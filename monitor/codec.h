@@ -0,0 +1,176 @@
+/**
+ * @brief Register codec of the PID channel parameters.
+ *
+ * Descriptors of the two channel types (fast: 14 bit signed, slow: 12 bit),
+ * of every parameter register (width and unit) and the channel table
+ * (type, widths and register offsets of every channel) drive all
+ * conversions between register words and the two value domains of the
+ * tools:
+ *
+ *   user counts  what the menus and 'pid set' take: signed counts for the
+ *                fast channels, plain counts 0-4095 for the slow ones,
+ *                ICD as integrator frequency in Hz (integer)
+ *   physical     volts for the set point, Hz for ICD (exact, double),
+ *                counts for the gains and TOL, plain values otherwise
+ *
+ * The set point volts follow the inputs the channel compares against: the
+ * fast ADC (+-1 V over 14 bits, LV jumper setting) and the slow XADC
+ * inputs (3.5 V at 0x7ff, see AmsConversion()). The integrator of the fast
+ * channels runs at 125 MHz / (ICD + 1), the slow channels keep the
+ * 100 kHz / (ICD + 1) convention of the menus.
+ *
+ * The channel table holds the register map of the default bitstream until
+ * rp_open() replaces it with the one read from the discovery ROM (info.h).
+ * The gains of a channel with fine gains count in 1 / 2^gainFrac of a gain
+ * count while they are on, see rp_fine_set().
+ *
+ * Conversions are table lookups and integer arithmetic, with no allocation
+ * or string handling; the set routines convert a whole parameter set at once.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	eUnitCount=0,
+	eUnitVolt,
+	eUnitHz,
+	eUnitFlag,
+	eUnitShift,
+	eUnitNum
+} rpUnit_t;
+
+typedef enum {
+	eChanFast=0,
+	eChanSlow,
+	eChanTypeNum
+} rpChanTypeId_t;
+
+/* channel type */
+typedef struct {
+	const char *name;
+	int width;             // set point and gain registers
+	int32_t min, max;      // set point and gains in user counts
+	int32_t icdClock;      // integrator clock in Hz, f = clock / (ICD + 1)
+	double volt;           // set point volts per count
+} rpChanType_t;
+
+/* parameter register */
+typedef struct {
+	const char *name;      // command line name
+	uint8_t width;         // implemented bits, 0 for the width of the channel
+	uint8_t unit;          // rpUnit_t of the physical value
+	int32_t min, max;      // user range of fixed width registers
+} rpParDesc_t;
+
+/* one channel of the register map */
+typedef struct {
+	rpChanType_t type;     // set point width and range, units
+	uint8_t gainWidth;     // gain registers
+	uint8_t gainFrac;      // gain bits below them with fine gains (deriv.h), 0 if none
+	uint8_t fine;          // fine gains on, the gain registers are gainFrac bits wider
+	uint8_t flags;         // RP_INFO_CH_* of info.h
+	uint16_t off[ePidParNum];  // parameter registers in the PID window
+	uint16_t tlm;          // telemetry snapshot
+	uint16_t ramp;         // set point ramp registers
+	uint16_t deriv;        // derivative divider and filter, 0 if none
+	uint16_t ff;           // feedforward, 0 if none
+} rpChan_t;
+
+/* all parameters of one channel in physical units */
+typedef struct {
+	double val[ePidParNum];
+} pidPhys_t;
+
+#define RP_CHAN_FAST { "fast", 14, -8192, 8191, 125000000, 1.0 / 8192 }
+#define RP_CHAN_SLOW { "slow", 12,     0, 4095,    100000, 3.5 / 0x7ff }
+
+static const rpChanType_t rpChanType[eChanTypeNum] = {
+	[eChanFast] = RP_CHAN_FAST,
+	[eChanSlow] = RP_CHAN_SLOW,
+};
+
+/* PID parameter registers, see red_pitaya_pid.v */
+static const rpParDesc_t rpParDesc[ePidParNum] = {
+	[ePidSp]   = { "sp",    0, eUnitVolt,  0, 0   },
+	[ePidKp]   = { "kp",    0, eUnitCount, 0, 0   },
+	[ePidKi]   = { "ki",    0, eUnitCount, 0, 0   },
+	[ePidKd]   = { "kd",    0, eUnitCount, 0, 0   },
+	[ePidIrst] = { "irst",  1, eUnitFlag,  0, 1   },
+	[ePidPSR]  = { "psr",   5, eUnitShift, 5, 15  },
+	[ePidISR]  = { "isr",   5, eUnitShift, 14, 24 },
+	[ePidDSR]  = { "dsr",   5, eUnitShift, 3, 13  },
+	[ePidICD]  = { "icd",  30, eUnitHz,    1, 0   },  // up to the clock
+	[ePidTol]  = { "tol",   9, eUnitCount, 0, 511 },
+};
+
+/* channel table, rp_pid_num() entries are valid */
+extern rpChan_t rpChan[RP_PID_MAX];
+extern int rpChanNum;
+
+/* Loads the register map of the default bitstream into the channel table */
+void rp_codec_defaults(void);
+
+static inline const rpChanType_t *rp_chan_type(int a_ch)
+{
+	return &rpChan[a_ch].type;
+}
+
+static inline uint32_t rp_codec_offset(int a_ch, pidPar_t a_par)
+{
+	return rpChan[a_ch].off[a_par];
+}
+
+static inline int rp_codec_width(int a_ch, pidPar_t a_par)
+{
+	if (rpParDesc[a_par].width) {
+		return rpParDesc[a_par].width;
+	}
+	if (a_par == ePidSp) {
+		return rpChan[a_ch].type.width;
+	}
+	return rpChan[a_ch].gainWidth + (rpChan[a_ch].fine ? rpChan[a_ch].gainFrac : 0);
+}
+
+/* Unit symbol of a parameter: "V", "Hz" or "" */
+const char *rp_codec_unit(pidPar_t a_par);
+
+/* Register word <-> user counts, see rp_pid_decode() */
+int32_t rp_codec_decode(int a_ch, pidPar_t a_par, uint32_t a_raw);
+uint32_t rp_codec_encode(int a_ch, pidPar_t a_par, int32_t a_val);
+void rp_codec_range(int a_ch, pidPar_t a_par, int32_t *a_min, int32_t *a_max);
+
+/* Register word <-> physical value, out of range values are clamped */
+double rp_codec_to_phys(int a_ch, pidPar_t a_par, uint32_t a_raw);
+uint32_t rp_codec_from_phys(int a_ch, pidPar_t a_par, double a_val);
+/* Representable physical range, rp_codec_check_phys() returns 0 or -ERANGE */
+void rp_codec_phys_range(int a_ch, pidPar_t a_par, double *a_min, double *a_max);
+int rp_codec_check_phys(int a_ch, pidPar_t a_par, double a_val);
+
+/* Whole parameter sets of channel a_ch, a_raw holds ePidParNum register words */
+void rp_codec_read_set(const rpRegs_t *a_regs, int a_ch, uint32_t *a_raw);
+void rp_codec_write_set(rpRegs_t *a_regs, int a_ch, const uint32_t *a_raw);
+void rp_codec_decode_set(int a_ch, const uint32_t *a_raw, pidParams_t *a_par);
+void rp_codec_encode_set(int a_ch, const pidParams_t *a_par, uint32_t *a_raw);
+void rp_codec_to_phys_set(int a_ch, const uint32_t *a_raw, pidPhys_t *a_phys);
+void rp_codec_from_phys_set(int a_ch, const pidPhys_t *a_phys, uint32_t *a_raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CODEC_H */
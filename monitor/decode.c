@@ -0,0 +1,416 @@
+/**
+ * @brief Bulk decoding of sample buffers to counts and volts.
+ *
+ * Every kernel sign extends with a shift pair, converts the exact integer
+ * counts to float and applies the calibration as one multiply and one add,
+ * in this order; the Makefile builds this file without floating point
+ * contraction so the scalar code cannot fuse them either. Vector kernels
+ * work on blocks of 8 words starting at word 0, so lane n of a block is
+ * channel n % a_chans for every supported channel count, and leave the
+ * tail to the scalar code.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEC_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DEC_NEON 1
+#include <arm_neon.h>
+#endif
+
+#ifdef __arm__
+#include <sys/auxv.h>
+#endif
+
+#include "decode.h"
+
+/* lanes of the calibration patterns, one block of the vector kernels */
+#define LANES RP_DEC_CHAN_MAX
+
+typedef struct {
+	void (*counts)(const uint16_t *a_src, int16_t *a_dst, size_t a_num, int a_shift);
+	void (*volts)(const uint16_t *a_src, float *a_dst, size_t a_num, int a_shift,
+	              const float *a_gain, const float *a_offset);
+	void (*pwm)(const uint32_t *a_src, float *a_dst, size_t a_num,
+	            const float *a_gain, const float *a_offset);
+} decOps_t;
+
+static const char *kernelName[eDecKernelNum] = {
+	"scalar", "neon", "sse2", "avx2"
+};
+
+// width of the samples in their 16 bit words
+static const int formatBits[eDecFormatNum] = { 14, 12 };
+
+// nominal full scale, see rpChanType in codec.h
+static const double formatLsb[eDecFormatNum] = { 1.0 / 8192, 3.5 / 0x7ff };
+
+// slow DAC output at 100 % duty cycle
+static const double PWM_VOLTS = 1.8;
+
+static decKernel_t kernel = eDecKernelNum;
+
+//---------------------------------------------------------------------------------
+//  scalar reference
+
+static inline int16_t sext(uint16_t a_word, int a_shift)
+{
+	return (int16_t)(uint16_t)(a_word << a_shift) >> a_shift;
+}
+
+/* PWM clocks per 16 periods: 16 coarse counts plus the stretched periods */
+static inline int32_t pwm_count(uint32_t a_word)
+{
+	return 16 * ((a_word >> 16) & 0xff) + __builtin_popcount(a_word & 0xffff);
+}
+
+static void counts_scalar(const uint16_t *a_src, int16_t *a_dst, size_t a_num, int a_shift)
+{
+	for (size_t i = 0; i < a_num; ++i) {
+		a_dst[i] = sext(a_src[i], a_shift);
+	}
+}
+
+/* word a_first on, a_first a multiple of LANES for the tails of the vector kernels */
+static void volts_from(const uint16_t *a_src, float *a_dst, size_t a_first, size_t a_num, int a_shift,
+                       const float *a_gain, const float *a_offset)
+{
+	for (size_t i = a_first; i < a_num; ++i) {
+		a_dst[i] = (float)sext(a_src[i], a_shift) * a_gain[i % LANES] + a_offset[i % LANES];
+	}
+}
+
+static void pwm_from(const uint32_t *a_src, float *a_dst, size_t a_first, size_t a_num,
+                     const float *a_gain, const float *a_offset)
+{
+	for (size_t i = a_first; i < a_num; ++i) {
+		a_dst[i] = (float)pwm_count(a_src[i]) * a_gain[i % LANES] + a_offset[i % LANES];
+	}
+}
+
+static void volts_scalar(const uint16_t *a_src, float *a_dst, size_t a_num, int a_shift,
+                         const float *a_gain, const float *a_offset)
+{
+	volts_from(a_src, a_dst, 0, a_num, a_shift, a_gain, a_offset);
+}
+
+static void pwm_scalar(const uint32_t *a_src, float *a_dst, size_t a_num,
+                       const float *a_gain, const float *a_offset)
+{
+	pwm_from(a_src, a_dst, 0, a_num, a_gain, a_offset);
+}
+
+//---------------------------------------------------------------------------------
+//  NEON, Zynq A9
+
+#ifdef DEC_NEON
+
+static void counts_neon(const uint16_t *a_src, int16_t *a_dst, size_t a_num, int a_shift)
+{
+	int16x8_t l = vdupq_n_s16(a_shift);
+	int16x8_t r = vdupq_n_s16(-a_shift);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		uint16x8_t w = vshlq_u16(vld1q_u16(a_src + i), l);
+		vst1q_s16(a_dst + i, vshlq_s16(vreinterpretq_s16_u16(w), r));
+	}
+	counts_scalar(a_src + i, a_dst + i, a_num - i, a_shift);
+}
+
+static void volts_neon(const uint16_t *a_src, float *a_dst, size_t a_num, int a_shift,
+                       const float *a_gain, const float *a_offset)
+{
+	int16x8_t l = vdupq_n_s16(a_shift);
+	int16x8_t r = vdupq_n_s16(-a_shift);
+	float32x4_t g0 = vld1q_f32(a_gain), g1 = vld1q_f32(a_gain + 4);
+	float32x4_t o0 = vld1q_f32(a_offset), o1 = vld1q_f32(a_offset + 4);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		uint16x8_t w = vshlq_u16(vld1q_u16(a_src + i), l);
+		int16x8_t s = vshlq_s16(vreinterpretq_s16_u16(w), r);
+		float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+		float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+		vst1q_f32(a_dst + i, vaddq_f32(vmulq_f32(lo, g0), o0));
+		vst1q_f32(a_dst + i + 4, vaddq_f32(vmulq_f32(hi, g1), o1));
+	}
+	volts_from(a_src, a_dst, i, a_num, a_shift, a_gain, a_offset);
+}
+
+static inline float32x4_t pwm_neon4(uint32x4_t a_w)
+{
+	uint32x4_t coarse = vandq_u32(vshrq_n_u32(a_w, 16), vdupq_n_u32(0xff));
+	uint8x16_t bits = vcntq_u8(vreinterpretq_u8_u32(vandq_u32(a_w, vdupq_n_u32(0xffff))));
+	uint32x4_t fine = vpaddlq_u16(vpaddlq_u8(bits));
+
+	return vcvtq_f32_u32(vaddq_u32(vshlq_n_u32(coarse, 4), fine));
+}
+
+static void pwm_neon(const uint32_t *a_src, float *a_dst, size_t a_num,
+                     const float *a_gain, const float *a_offset)
+{
+	float32x4_t g0 = vld1q_f32(a_gain), g1 = vld1q_f32(a_gain + 4);
+	float32x4_t o0 = vld1q_f32(a_offset), o1 = vld1q_f32(a_offset + 4);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		vst1q_f32(a_dst + i, vaddq_f32(vmulq_f32(pwm_neon4(vld1q_u32(a_src + i)), g0), o0));
+		vst1q_f32(a_dst + i + 4, vaddq_f32(vmulq_f32(pwm_neon4(vld1q_u32(a_src + i + 4)), g1), o1));
+	}
+	pwm_from(a_src, a_dst, i, a_num, a_gain, a_offset);
+}
+
+#endif /* DEC_NEON */
+
+//---------------------------------------------------------------------------------
+//  SSE2 and AVX2, hosts
+
+#ifdef DEC_X86
+
+__attribute__((target("sse2")))
+static void counts_sse2(const uint16_t *a_src, int16_t *a_dst, size_t a_num, int a_shift)
+{
+	__m128i sh = _mm_cvtsi32_si128(a_shift);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		__m128i w = _mm_loadu_si128((const __m128i *)(a_src + i));
+		_mm_storeu_si128((__m128i *)(a_dst + i), _mm_sra_epi16(_mm_sll_epi16(w, sh), sh));
+	}
+	counts_scalar(a_src + i, a_dst + i, a_num - i, a_shift);
+}
+
+__attribute__((target("sse2")))
+static void volts_sse2(const uint16_t *a_src, float *a_dst, size_t a_num, int a_shift,
+                       const float *a_gain, const float *a_offset)
+{
+	__m128i sh = _mm_cvtsi32_si128(a_shift);
+	__m128 g0 = _mm_loadu_ps(a_gain), g1 = _mm_loadu_ps(a_gain + 4);
+	__m128 o0 = _mm_loadu_ps(a_offset), o1 = _mm_loadu_ps(a_offset + 4);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		__m128i w = _mm_loadu_si128((const __m128i *)(a_src + i));
+		__m128i s = _mm_sra_epi16(_mm_sll_epi16(w, sh), sh);
+		// the sample in the upper half of each 32 bit lane, shifted down with its sign
+		__m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+		__m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+		_mm_storeu_ps(a_dst + i, _mm_add_ps(_mm_mul_ps(lo, g0), o0));
+		_mm_storeu_ps(a_dst + i + 4, _mm_add_ps(_mm_mul_ps(hi, g1), o1));
+	}
+	volts_from(a_src, a_dst, i, a_num, a_shift, a_gain, a_offset);
+}
+
+/* bit count of the fine cycles, SWAR within each 32 bit lane */
+__attribute__((target("sse2")))
+static inline __m128 pwm_sse2_4(__m128i a_w)
+{
+	__m128i coarse = _mm_and_si128(_mm_srli_epi32(a_w, 16), _mm_set1_epi32(0xff));
+	__m128i b = _mm_and_si128(a_w, _mm_set1_epi32(0xffff));
+
+	b = _mm_sub_epi32(b, _mm_and_si128(_mm_srli_epi32(b, 1), _mm_set1_epi32(0x5555)));
+	b = _mm_add_epi32(_mm_and_si128(b, _mm_set1_epi32(0x3333)),
+	                  _mm_and_si128(_mm_srli_epi32(b, 2), _mm_set1_epi32(0x3333)));
+	b = _mm_and_si128(_mm_add_epi32(b, _mm_srli_epi32(b, 4)), _mm_set1_epi32(0x0f0f));
+	b = _mm_and_si128(_mm_add_epi32(b, _mm_srli_epi32(b, 8)), _mm_set1_epi32(0x1f));
+	return _mm_cvtepi32_ps(_mm_add_epi32(_mm_slli_epi32(coarse, 4), b));
+}
+
+__attribute__((target("sse2")))
+static void pwm_sse2(const uint32_t *a_src, float *a_dst, size_t a_num,
+                     const float *a_gain, const float *a_offset)
+{
+	__m128 g0 = _mm_loadu_ps(a_gain), g1 = _mm_loadu_ps(a_gain + 4);
+	__m128 o0 = _mm_loadu_ps(a_offset), o1 = _mm_loadu_ps(a_offset + 4);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		__m128 lo = pwm_sse2_4(_mm_loadu_si128((const __m128i *)(a_src + i)));
+		__m128 hi = pwm_sse2_4(_mm_loadu_si128((const __m128i *)(a_src + i + 4)));
+		_mm_storeu_ps(a_dst + i, _mm_add_ps(_mm_mul_ps(lo, g0), o0));
+		_mm_storeu_ps(a_dst + i + 4, _mm_add_ps(_mm_mul_ps(hi, g1), o1));
+	}
+	pwm_from(a_src, a_dst, i, a_num, a_gain, a_offset);
+}
+
+__attribute__((target("avx2")))
+static void counts_avx2(const uint16_t *a_src, int16_t *a_dst, size_t a_num, int a_shift)
+{
+	__m128i sh = _mm_cvtsi32_si128(a_shift);
+	size_t i;
+
+	for (i = 0; i + 16 <= a_num; i += 16) {
+		__m256i w = _mm256_loadu_si256((const __m256i *)(a_src + i));
+		_mm256_storeu_si256((__m256i *)(a_dst + i), _mm256_sra_epi16(_mm256_sll_epi16(w, sh), sh));
+	}
+	counts_scalar(a_src + i, a_dst + i, a_num - i, a_shift);
+}
+
+__attribute__((target("avx2")))
+static void volts_avx2(const uint16_t *a_src, float *a_dst, size_t a_num, int a_shift,
+                       const float *a_gain, const float *a_offset)
+{
+	__m128i sh = _mm_cvtsi32_si128(a_shift);
+	__m256 g = _mm256_loadu_ps(a_gain);
+	__m256 o = _mm256_loadu_ps(a_offset);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		__m128i w = _mm_loadu_si128((const __m128i *)(a_src + i));
+		__m128i s = _mm_sra_epi16(_mm_sll_epi16(w, sh), sh);
+		__m256 f = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(s));
+		_mm256_storeu_ps(a_dst + i, _mm256_add_ps(_mm256_mul_ps(f, g), o));
+	}
+	volts_from(a_src, a_dst, i, a_num, a_shift, a_gain, a_offset);
+}
+
+__attribute__((target("avx2")))
+static void pwm_avx2(const uint32_t *a_src, float *a_dst, size_t a_num,
+                     const float *a_gain, const float *a_offset)
+{
+	__m256 g = _mm256_loadu_ps(a_gain);
+	__m256 o = _mm256_loadu_ps(a_offset);
+	size_t i;
+
+	for (i = 0; i + 8 <= a_num; i += 8) {
+		__m256i w = _mm256_loadu_si256((const __m256i *)(a_src + i));
+		__m256i coarse = _mm256_and_si256(_mm256_srli_epi32(w, 16), _mm256_set1_epi32(0xff));
+		__m256i b = _mm256_and_si256(w, _mm256_set1_epi32(0xffff));
+		b = _mm256_sub_epi32(b, _mm256_and_si256(_mm256_srli_epi32(b, 1), _mm256_set1_epi32(0x5555)));
+		b = _mm256_add_epi32(_mm256_and_si256(b, _mm256_set1_epi32(0x3333)),
+		                     _mm256_and_si256(_mm256_srli_epi32(b, 2), _mm256_set1_epi32(0x3333)));
+		b = _mm256_and_si256(_mm256_add_epi32(b, _mm256_srli_epi32(b, 4)), _mm256_set1_epi32(0x0f0f));
+		b = _mm256_and_si256(_mm256_add_epi32(b, _mm256_srli_epi32(b, 8)), _mm256_set1_epi32(0x1f));
+		__m256 f = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_slli_epi32(coarse, 4), b));
+		_mm256_storeu_ps(a_dst + i, _mm256_add_ps(_mm256_mul_ps(f, g), o));
+	}
+	pwm_from(a_src, a_dst, i, a_num, a_gain, a_offset);
+}
+
+#endif /* DEC_X86 */
+
+//---------------------------------------------------------------------------------
+//  dispatch
+
+static const decOps_t ops[eDecKernelNum] = {
+	[eDecScalar] = { counts_scalar, volts_scalar, pwm_scalar },
+#ifdef DEC_NEON
+	[eDecNeon]   = { counts_neon, volts_neon, pwm_neon },
+#endif
+#ifdef DEC_X86
+	[eDecSse2]   = { counts_sse2, volts_sse2, pwm_sse2 },
+	[eDecAvx2]   = { counts_avx2, volts_avx2, pwm_avx2 },
+#endif
+};
+
+const char *rp_dec_kernel_name(decKernel_t a_kernel)
+{
+	return (a_kernel >= 0 && a_kernel < eDecKernelNum) ? kernelName[a_kernel] : "?";
+}
+
+int rp_dec_kernel_supported(decKernel_t a_kernel)
+{
+	if (a_kernel < 0 || a_kernel >= eDecKernelNum || ops[a_kernel].counts == NULL) {
+		return 0;
+	}
+	switch (a_kernel) {
+#if defined(DEC_NEON) && defined(__arm__)
+		case eDecNeon:
+			// built with -mfpu=neon, check the core anyway (HWCAP_NEON)
+			return (getauxval(AT_HWCAP) & (1 << 12)) != 0;
+#endif
+#ifdef DEC_X86
+		case eDecSse2:
+			return __builtin_cpu_supports("sse2");
+		case eDecAvx2:
+			return __builtin_cpu_supports("avx2");
+#endif
+		default:
+			return 1;
+	}
+}
+
+decKernel_t rp_dec_kernel(void)
+{
+	if (kernel == eDecKernelNum) {
+		int k;
+		for (k = eDecKernelNum - 1; k > eDecScalar && !rp_dec_kernel_supported(k); --k) {
+		}
+		kernel = k;
+	}
+	return kernel;
+}
+
+int rp_dec_set_kernel(decKernel_t a_kernel)
+{
+	if (!rp_dec_kernel_supported(a_kernel)) {
+		return -ENOTSUP;
+	}
+	kernel = a_kernel;
+	return 0;
+}
+
+double rp_dec_lsb(decFormat_t a_fmt)
+{
+	return (a_fmt >= 0 && a_fmt < eDecFormatNum) ? formatLsb[a_fmt] : 0;
+}
+
+void rp_dec_counts(decFormat_t a_fmt, const uint16_t *a_src, int16_t *a_dst, size_t a_num)
+{
+	if (a_fmt < 0 || a_fmt >= eDecFormatNum) {
+		return;
+	}
+	ops[rp_dec_kernel()].counts(a_src, a_dst, a_num, 16 - formatBits[a_fmt]);
+}
+
+/* calibration of every lane of a block, volts per count */
+static int lanes(const decCal_t *a_cal, int a_chans, double a_lsb, float *a_gain, float *a_offset)
+{
+	if (a_chans < 1 || a_chans > LANES || (a_chans & (a_chans - 1))) {
+		return -EINVAL;
+	}
+	for (int n = 0; n < LANES; ++n) {
+		const decCal_t *cal = a_cal ? &a_cal[n % a_chans] : NULL;
+		a_gain[n] = (cal ? cal->gain : 1.0) * a_lsb;
+		a_offset[n] = cal ? cal->offset : 0;
+	}
+	return 0;
+}
+
+int rp_dec_volts(decFormat_t a_fmt, const uint16_t *a_src, float *a_dst, size_t a_num,
+                 const decCal_t *a_cal, int a_chans)
+{
+	float gain[LANES], offset[LANES];
+
+	if (a_fmt < 0 || a_fmt >= eDecFormatNum || lanes(a_cal, a_chans, formatLsb[a_fmt], gain, offset)) {
+		return -EINVAL;
+	}
+	ops[rp_dec_kernel()].volts(a_src, a_dst, a_num, 16 - formatBits[a_fmt], gain, offset);
+	return 0;
+}
+
+int rp_dec_pwm(const uint32_t *a_src, float *a_dst, size_t a_num, const decCal_t *a_cal, int a_chans)
+{
+	float gain[LANES], offset[LANES];
+
+	if (lanes(a_cal, a_chans, PWM_VOLTS / (16 * RP_DEC_PWM_FULL), gain, offset)) {
+		return -EINVAL;
+	}
+	ops[rp_dec_kernel()].pwm(a_src, a_dst, a_num, gain, offset);
+	return 0;
+}
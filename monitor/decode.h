@@ -0,0 +1,95 @@
+/**
+ * @brief Bulk decoding of sample buffers to counts and volts.
+ *
+ * Converts whole buffers of board samples, as the capture buffer, the ADC
+ * registers and the slow DAC registers deliver them:
+ *
+ *   eDecS14  16 bit words, the lower 14 bits a two's complement sample
+ *            (fast ADC and DAC), +-1 V full scale
+ *   eDecS12  16 bit words, the lower 12 bits a two's complement sample
+ *            (slow PID and XADC values), 3.5 V at 0x7ff
+ *   PWM      32 bit slow DAC words of slow_dac_converter.v: 8 bit coarse
+ *            count (bits 23:16, 156 = 100 %) and 16 fine cycles (15:0)
+ *            stretched by one clock, 1.8 V at 100 %
+ *
+ * Upper bits of the words are ignored. Interleaved buffers (the two traces
+ * of a capture, the four slow DACs) take one calibration per channel,
+ * applied as volts = gain * nominal volts + offset.
+ *
+ * The kernels use NEON on the Zynq A9 and SSE2 or AVX2 on x86 hosts and
+ * give results identical to the scalar code, bit for bit; the best one
+ * the CPU supports is selected on first use.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef DECODE_H
+#define DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* interleaved channels of one buffer, 1, 2, 4 or 8 */
+#define RP_DEC_CHAN_MAX 8
+
+/* PWM counts per period of the slow DACs, see red_pitaya_analog.v */
+#define RP_DEC_PWM_FULL 156
+
+typedef enum {
+	eDecS14=0,
+	eDecS12,
+	eDecFormatNum
+} decFormat_t;
+
+typedef enum {
+	eDecScalar=0,
+	eDecNeon,
+	eDecSse2,
+	eDecAvx2,
+	eDecKernelNum
+} decKernel_t;
+
+typedef struct {
+	float gain;       // relative, 1 for the nominal scale
+	float offset;     // volts
+} decCal_t;
+
+/* Kernel names: scalar, neon, sse2, avx2 */
+const char *rp_dec_kernel_name(decKernel_t a_kernel);
+/* 1 if a_kernel is built in and the CPU supports it */
+int rp_dec_kernel_supported(decKernel_t a_kernel);
+/* Kernel in use, the best supported one unless rp_dec_set_kernel() chose another */
+decKernel_t rp_dec_kernel(void);
+/* Selects a kernel, -ENOTSUP if it is not supported */
+int rp_dec_set_kernel(decKernel_t a_kernel);
+
+/* Nominal volts per count of a format */
+double rp_dec_lsb(decFormat_t a_fmt);
+
+/* Sign extended samples of a_num words */
+void rp_dec_counts(decFormat_t a_fmt, const uint16_t *a_src, int16_t *a_dst, size_t a_num);
+
+/*
+ * Volts of a_num words holding a_chans interleaved channels, word n
+ * belongs to channel n % a_chans and uses a_cal[n % a_chans]. a_cal NULL
+ * for the nominal scale. Returns 0 or -EINVAL for an unsupported a_chans.
+ */
+int rp_dec_volts(decFormat_t a_fmt, const uint16_t *a_src, float *a_dst, size_t a_num,
+                 const decCal_t *a_cal, int a_chans);
+
+/* Output volts of a_num slow DAC words, as rp_dec_volts() */
+int rp_dec_pwm(const uint32_t *a_src, float *a_dst, size_t a_num, const decCal_t *a_cal, int a_chans);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECODE_H */
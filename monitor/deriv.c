@@ -0,0 +1,225 @@
+/**
+ * @brief Derivative divider and filter of the fast PID channels, anti-windup
+ * and fine gains.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "deriv.h"
+#include "codec.h"
+#include "info.h"
+#include "bank.h"
+
+int rp_deriv_present(int a_ch)
+{
+	return a_ch >= 0 && a_ch < rp_pid_num() && rpChan[a_ch].deriv != 0 &&
+	       (rpChan[a_ch].flags & RP_INFO_CH_DERIV);
+}
+
+int rp_deriv_check(const derivConfig_t *a_cfg)
+{
+	if (a_cfg->div < 1 || a_cfg->div > RP_DERIV_DIV_MAX || a_cfg->shift < 0 ||
+	    a_cfg->shift > RP_DERIV_SHIFT_MAX || (a_cfg->order != 1 && a_cfg->order != 2)) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+double rp_deriv_rate(const derivConfig_t *a_cfg)
+{
+	return (double)rp_info_clock() / (a_cfg->div ? a_cfg->div : 1);
+}
+
+void rp_deriv_from_rate(derivConfig_t *a_cfg, double a_rate)
+{
+	double div = round(rp_info_clock() / a_rate);
+
+	a_cfg->div = (div < 1) ? 1 : (div > RP_DERIV_DIV_MAX) ? RP_DERIV_DIV_MAX : div;
+}
+
+/* -3 dB point of y += a (x - y) at the update rate a_fs */
+static double corner(double a_fs, int a_shift)
+{
+	double a = ldexp(1.0, -a_shift);
+	double p = 1 - a;
+
+	return a_fs * acos((1 + p * p - 2 * a * a) / (2 * p)) / (2 * M_PI);
+}
+
+double rp_deriv_corner(const derivConfig_t *a_cfg)
+{
+	return a_cfg->shift ? corner(rp_deriv_rate(a_cfg), a_cfg->shift) : 0;
+}
+
+void rp_deriv_from_corner(derivConfig_t *a_cfg, double a_corner)
+{
+	double fs = rp_deriv_rate(a_cfg);
+	double best = INFINITY;
+
+	// the shifts are octaves apart, pick the nearest on a log scale
+	for (int k = 1; k <= RP_DERIV_SHIFT_MAX; ++k) {
+		double dist = fabs(log(corner(fs, k) / a_corner));
+		if (dist < best) {
+			best = dist;
+			a_cfg->shift = k;
+		}
+	}
+}
+
+int rp_deriv_set(rpRegs_t *a_regs, int a_ch, const derivConfig_t *a_cfg)
+{
+	if (!rp_deriv_present(a_ch)) {
+		return -ENODEV;
+	}
+	volatile uint32_t *reg = &a_regs->pid[rpChan[a_ch].deriv >> 2];
+
+	reg[RP_DERIV_DCD >> 2] = a_cfg->div - 1;
+	reg[RP_DERIV_DFL >> 2] = a_cfg->shift | ((a_cfg->order == 2) ? RP_DERIV_ORDER2 : 0);
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_deriv_get(const rpRegs_t *a_regs, int a_ch, derivConfig_t *a_cfg)
+{
+	if (!rp_deriv_present(a_ch)) {
+		return -ENODEV;
+	}
+	volatile uint32_t *reg = &a_regs->pid[rpChan[a_ch].deriv >> 2];
+	uint32_t dfl = reg[RP_DERIV_DFL >> 2];
+
+	a_cfg->div = (reg[RP_DERIV_DCD >> 2] & (RP_DERIV_DIV_MAX - 1)) + 1;
+	a_cfg->shift = dfl & 0xf;
+	a_cfg->order = (dfl & RP_DERIV_ORDER2) ? 2 : 1;
+	return 0;
+}
+
+static const char *windupName[eWindupNum] = { "off", "cond", "back", "both" };
+
+int rp_windup_present(int a_ch)
+{
+	return a_ch >= 0 && a_ch < rp_pid_num() && rpChan[a_ch].deriv != 0 &&
+	       (rpChan[a_ch].flags & RP_INFO_CH_AWINDUP);
+}
+
+const char *rp_windup_name(windupMode_t a_mode)
+{
+	return (a_mode >= 0 && a_mode < eWindupNum) ? windupName[a_mode] : "?";
+}
+
+int rp_windup_mode(const char *a_name)
+{
+	for (int i = 0; i < eWindupNum; ++i) {
+		if (strcmp(a_name, windupName[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int rp_windup_set(rpRegs_t *a_regs, int a_ch, const windupConfig_t *a_cfg)
+{
+	if (!rp_windup_present(a_ch)) {
+		return -ENODEV;
+	}
+	if (a_cfg->mode < 0 || a_cfg->mode >= eWindupNum || a_cfg->track < RP_WINDUP_TRACK_MIN ||
+	    a_cfg->track > RP_WINDUP_TRACK_MAX) {
+		return -ERANGE;
+	}
+	a_regs->pid[(rpChan[a_ch].deriv + RP_DERIV_AW) >> 2] = a_cfg->mode | (a_cfg->track << RP_WINDUP_TRACK_SH);
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_windup_get(const rpRegs_t *a_regs, int a_ch, windupConfig_t *a_cfg)
+{
+	if (!rp_windup_present(a_ch)) {
+		return -ENODEV;
+	}
+	uint32_t aw = a_regs->pid[(rpChan[a_ch].deriv + RP_DERIV_AW) >> 2];
+
+	a_cfg->mode = aw & eWindupBoth;
+	a_cfg->track = (aw >> RP_WINDUP_TRACK_SH) & RP_WINDUP_TRACK_MAX;
+	// what the block runs with, lower settings act as the minimum
+	if (a_cfg->track < RP_WINDUP_TRACK_MIN) {
+		a_cfg->track = RP_WINDUP_TRACK_MIN;
+	}
+	return 0;
+}
+
+int rp_fine_present(int a_ch)
+{
+	return a_ch >= 0 && a_ch < rp_pid_num() && rpChan[a_ch].deriv != 0 && rpChan[a_ch].gainFrac != 0;
+}
+
+int rp_fine_bits(int a_ch)
+{
+	return rp_fine_present(a_ch) ? rpChan[a_ch].gainFrac : 0;
+}
+
+/* gain word of the other view, a_word in the width of the current one */
+static uint32_t fine_word(int a_ch, uint32_t a_word, int a_on)
+{
+	int frac = rpChan[a_ch].gainFrac;
+
+	a_word &= (1UL << rp_pid_width(a_ch, ePidKp)) - 1;
+	return a_on ? a_word << frac : a_word >> frac;
+}
+
+int rp_fine_set(rpRegs_t *a_regs, int a_ch, int a_on)
+{
+	static const pidPar_t gain[] = { ePidKp, ePidKi, ePidKd };
+
+	if (!rp_fine_present(a_ch)) {
+		return -ENODEV;
+	}
+	a_on = a_on ? 1 : 0;
+	rpChan[a_ch].fine = rp_fine_get(a_regs, a_ch);
+	if (a_regs->backend != eRpDevMem && a_on != rpChan[a_ch].fine) {
+		// the images hold what the bus reads, move the gains to the new view
+		volatile uint32_t *win = rp_bank_present(a_ch) ?
+		                         rp_map_block(a_regs, RP_ADDR_PID + RP_BANK_WIN, sizeof(bankImage_t)) : NULL;
+
+		for (int i = 0; i < sizeof(gain) / sizeof(gain[0]); ++i) {
+			uint32_t off = rp_pid_offset(a_ch, gain[i]);
+
+			a_regs->pid[off >> 2] = fine_word(a_ch, a_regs->pid[off >> 2], a_on);
+			a_regs->pid[(RP_PID_SHADOW + off) >> 2] = fine_word(a_ch, a_regs->pid[(RP_PID_SHADOW + off) >> 2], a_on);
+		}
+		for (int b = 0; win && b < RP_BANK_NUM; ++b) {
+			volatile uint32_t *word = &win[(RP_BANK_ADDR(a_ch, b) - RP_BANK_WIN) >> 2];
+
+			for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+				if (rpBankPar[p] >= ePidKp && rpBankPar[p] <= ePidKd) {
+					word[p] = fine_word(a_ch, word[p], a_on);
+				}
+			}
+		}
+	}
+	a_regs->pid[(rpChan[a_ch].deriv + RP_DERIV_FINE) >> 2] = a_on;
+	rpChan[a_ch].fine = a_on;
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_fine_get(const rpRegs_t *a_regs, int a_ch)
+{
+	if (!rp_fine_present(a_ch)) {
+		return -ENODEV;
+	}
+	return a_regs->pid[(rpChan[a_ch].deriv + RP_DERIV_FINE) >> 2] & 1;
+}
+
+void rp_fine_load(const rpRegs_t *a_regs)
+{
+	for (int ch = 0; ch < rp_pid_num(); ++ch) {
+		rpChan[ch].fine = rp_fine_present(ch) && rp_fine_get(a_regs, ch) == 1;
+	}
+}
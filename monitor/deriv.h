@@ -0,0 +1,130 @@
+/**
+ * @brief Derivative divider and filter of the fast PID channels, and the
+ * anti-windup of all channels.
+ *
+ * Drives the DCD and DFL registers of red_pitaya_pid_block.v: the
+ * derivative is the difference of the scaled Kd product over div clocks,
+ * updated every div clocks, and optionally low-pass filtered with one or
+ * two sections of y += (x - y) / 2^shift per update. div 1 with the filter
+ * off is the one clock difference of the plain PID block.
+ *
+ * A longer time base scales the derivative of a slope by div, DSR or Kd
+ * have to be lowered by as much to keep the same D gain.
+ *
+ * The same block holds the anti-windup of the channel (AW register), on
+ * the slow channels without the derivative registers: the
+ * integrator follows the clamp of the final output, after the sum of the
+ * two blocks of an output. Conditional integration holds the integrator
+ * while the clamp is active and the integral pushes into it,
+ * back-calculation bleeds the clamp excess back into the integrator at
+ * 2^-track of the excess per integrator update, in output counts. The
+ * excess arrives a few clocks late, so track starts at 3: a larger share
+ * per update corrects the same excess several times and limit-cycles.
+ *
+ * The fast channels also hold FINE there: their blocks run with gains
+ * rpChan[n].gainFrac bits finer than the gain registers show after reset.
+ * With FINE set Kp/Ki/Kd, their shadows and banks read and write the full
+ * gains, 2^gainFrac times the plain value for the same loop. The mode only
+ * changes what the bus sees, the running loop keeps its gains.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef DERIV_H
+#define DERIV_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * registers in the PID window: the block of channel n starts at
+ * rpChan[n].deriv (codec.h), 0 on channels with neither a derivative filter
+ * nor anti-windup; RP_INFO_CH_DERIV and RP_INFO_CH_AWINDUP tell which of
+ * the registers exist
+ */
+#define RP_DERIV_DCD       0x0
+#define RP_DERIV_DFL       0x4
+#define RP_DERIV_AW        0x8
+#define RP_DERIV_FINE      0xC
+
+#define RP_DERIV_DIV_MAX   (1UL << 30)
+#define RP_DERIV_SHIFT_MAX 15
+#define RP_DERIV_ORDER2    0x10
+
+/* AW register: [1:0] mode, [12:8] tracking shift */
+#define RP_WINDUP_COND      0x1
+#define RP_WINDUP_BACK      0x2
+#define RP_WINDUP_TRACK_SH  8
+#define RP_WINDUP_TRACK_MIN 3         /* lower settings act as 3 */
+#define RP_WINDUP_TRACK_MAX 31
+
+typedef struct {
+	uint32_t div;     // clocks per derivative update, 1 - RP_DERIV_DIV_MAX
+	int shift;        // filter coefficient 1 / 2^shift, 0 = no filter
+	int order;        // filter sections, 1 or 2
+} derivConfig_t;
+
+typedef enum {
+	eWindupOff = 0,
+	eWindupCond = RP_WINDUP_COND,
+	eWindupBack = RP_WINDUP_BACK,
+	eWindupBoth = RP_WINDUP_COND | RP_WINDUP_BACK,
+	eWindupNum
+} windupMode_t;
+
+typedef struct {
+	windupMode_t mode;
+	int track;        // back-calculation gain 1 / 2^track, RP_WINDUP_TRACK_MIN - RP_WINDUP_TRACK_MAX
+} windupConfig_t;
+
+/* 1 if channel a_ch has the derivative registers */
+int rp_deriv_present(int a_ch);
+/* 0 if a_cfg is valid, -ERANGE otherwise */
+int rp_deriv_check(const derivConfig_t *a_cfg);
+
+/* Update rate in Hz, and the divider closest to a_rate */
+double rp_deriv_rate(const derivConfig_t *a_cfg);
+void rp_deriv_from_rate(derivConfig_t *a_cfg, double a_rate);
+/* -3 dB corner of one filter section in Hz (0 without a filter), and the closest shift */
+double rp_deriv_corner(const derivConfig_t *a_cfg);
+void rp_deriv_from_corner(derivConfig_t *a_cfg, double a_corner);
+
+/* -ENODEV on channels without the registers */
+int rp_deriv_set(rpRegs_t *a_regs, int a_ch, const derivConfig_t *a_cfg);
+int rp_deriv_get(const rpRegs_t *a_regs, int a_ch, derivConfig_t *a_cfg);
+
+/* 1 if channel a_ch has the anti-windup register */
+int rp_windup_present(int a_ch);
+/* Name of a mode ("off", "cond", "back", "both"), and the mode of a name, -1 if unknown */
+const char *rp_windup_name(windupMode_t a_mode);
+int rp_windup_mode(const char *a_name);
+/* -ENODEV on channels without the register, -ERANGE for a bad a_cfg */
+int rp_windup_set(rpRegs_t *a_regs, int a_ch, const windupConfig_t *a_cfg);
+int rp_windup_get(const rpRegs_t *a_regs, int a_ch, windupConfig_t *a_cfg);
+
+/* 1 if channel a_ch has fine gains, and the bits they add (0 without) */
+int rp_fine_present(int a_ch);
+int rp_fine_bits(int a_ch);
+/*
+ * Fine gains on (1) or off (0), -ENODEV on channels without. The channel
+ * table follows, so the gain widths and ranges of codec.h change with it.
+ */
+int rp_fine_set(rpRegs_t *a_regs, int a_ch, int a_on);
+int rp_fine_get(const rpRegs_t *a_regs, int a_ch);
+/* Reads the mode of every channel into the channel table, rp_open() and rp_sync() call it */
+void rp_fine_load(const rpRegs_t *a_regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DERIV_H */
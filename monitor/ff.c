@@ -0,0 +1,184 @@
+/**
+ * @brief Feedforward of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "ff.h"
+#include "codec.h"
+#include "info.h"
+
+static const char *srcName[eFfSrcNum] = { "off", "table", "input" };
+
+int rp_ff_present(int a_ch)
+{
+	return a_ch >= 0 && a_ch < rp_pid_num() && rpChan[a_ch].ff != 0;
+}
+
+int rp_ff_check(const ffConfig_t *a_cfg)
+{
+	if (a_cfg->src < 0 || a_cfg->src >= eFfSrcNum || a_cfg->dio < 0 || a_cfg->dio > RP_FF_DIO_MAX ||
+	    a_cfg->input < 0 || a_cfg->input >= RP_FF_INPUT_NUM || a_cfg->gain < INT16_MIN || a_cfg->gain > INT16_MAX) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+const char *rp_ff_src_name(ffSrc_t a_src)
+{
+	return (a_src >= 0 && a_src < eFfSrcNum) ? srcName[a_src] : "?";
+}
+
+int rp_ff_src_lookup(const char *a_name)
+{
+	for (int i = 0; i < eFfSrcNum; ++i) {
+		if (strcmp(a_name, srcName[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+double rp_ff_freq(const ffConfig_t *a_cfg)
+{
+	return ldexp((double)a_cfg->step * rp_info_clock(), -32);
+}
+
+void rp_ff_from_freq(ffConfig_t *a_cfg, double a_freq)
+{
+	double step = round(ldexp(a_freq / rp_info_clock(), 32));
+
+	a_cfg->step = (step < 0) ? 0 : (step > UINT32_MAX) ? UINT32_MAX : (uint32_t)step;
+}
+
+static volatile uint32_t *ff_regs(const rpRegs_t *a_regs, int a_ch)
+{
+	return &a_regs->pid[rpChan[a_ch].ff >> 2];
+}
+
+int rp_ff_set(rpRegs_t *a_regs, int a_ch, const ffConfig_t *a_cfg)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	int ret = rp_ff_check(a_cfg);
+	if (ret) {
+		return ret;
+	}
+	volatile uint32_t *reg = ff_regs(a_regs, a_ch);
+
+	reg[RP_FF_STEP >> 2] = a_cfg->step;
+	reg[RP_FF_GAIN >> 2] = (uint16_t)a_cfg->gain;
+	reg[RP_FF_CFG >> 2]  = a_cfg->src | (a_cfg->oneShot ? RP_FF_SHOT : 0) | (a_cfg->ext ? RP_FF_EXT : 0) |
+	                       (a_cfg->dio << 8) | (a_cfg->input << 12);
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_ff_get(const rpRegs_t *a_regs, int a_ch, ffConfig_t *a_cfg)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	volatile uint32_t *reg = ff_regs(a_regs, a_ch);
+	uint32_t cfg = reg[RP_FF_CFG >> 2];
+
+	a_cfg->src = ((cfg & 3) < eFfSrcNum) ? (ffSrc_t)(cfg & 3) : eFfOff;
+	a_cfg->oneShot = (cfg & RP_FF_SHOT) != 0;
+	a_cfg->ext = (cfg & RP_FF_EXT) != 0;
+	a_cfg->dio = (cfg >> 8) & 7;
+	a_cfg->input = (cfg >> 12) & 7;
+	a_cfg->step = reg[RP_FF_STEP >> 2];
+	a_cfg->gain = (int16_t)reg[RP_FF_GAIN >> 2];
+	return 0;
+}
+
+int rp_ff_trigger(rpRegs_t *a_regs, int a_ch)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	ff_regs(a_regs, a_ch)[RP_FF_TRIG >> 2] = 1;
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_ff_position(const rpRegs_t *a_regs, int a_ch, int *a_playing)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	uint32_t trig = ff_regs(a_regs, a_ch)[RP_FF_TRIG >> 2];
+
+	if (a_playing) {
+		*a_playing = (trig & RP_FF_PLAYING) != 0;
+	}
+	return trig & (RP_FF_DEPTH - 1);
+}
+
+/*
+ * Table of channel a_ch, all tables share one window: rp_map_block() only
+ * holds a few and the capture buffer and the slow DAC tables need theirs
+ */
+static volatile uint32_t *ff_table(rpRegs_t *a_regs, int a_ch)
+{
+	volatile uint32_t *tbl = rp_map_block(a_regs, RP_ADDR_PID + RP_FF_TABLES,
+	                                      RP_FF_NUM * RP_FF_DEPTH * sizeof(uint32_t));
+	int k = (rpChan[a_ch].ff - RP_FF_BASE(0)) / 0x10;
+
+	if (tbl == NULL) {
+		return NULL;
+	}
+	if (k < 0 || k >= RP_FF_NUM) {
+		errno = ENXIO;
+		return NULL;
+	}
+	return tbl + k * (RP_FF_TABLE(1) - RP_FF_TABLE(0)) / sizeof(uint32_t);
+}
+
+int rp_ff_load(rpRegs_t *a_regs, int a_ch, const int16_t *a_tbl, int a_num)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	if (a_num < 1 || a_num > RP_FF_DEPTH) {
+		return -ERANGE;
+	}
+	volatile uint32_t *dst = ff_table(a_regs, a_ch);
+	uint32_t buf[RP_FF_DEPTH];
+
+	if (dst == NULL) {
+		return -errno;
+	}
+	for (int i = 0; i < RP_FF_DEPTH; ++i) {
+		buf[i] = (uint16_t)a_tbl[(i < a_num) ? i : a_num - 1];
+	}
+	// whole words in one pass, the table ignores the bus byte selects
+	memcpy((void *)dst, buf, sizeof(buf));
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_ff_read(rpRegs_t *a_regs, int a_ch, int16_t *a_tbl)
+{
+	if (!rp_ff_present(a_ch)) {
+		return -ENODEV;
+	}
+	volatile uint32_t *src = ff_table(a_regs, a_ch);
+
+	if (src == NULL) {
+		return -errno;
+	}
+	for (int i = 0; i < RP_FF_DEPTH; ++i) {
+		a_tbl[i] = (int16_t)src[i];
+	}
+	return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @brief Feedforward of the PID channels.
+ *
+ * Drives red_pitaya_pid_ff.v: every channel adds a feedforward term to its
+ * PID sum before the output saturation, from a 1024 entry table or from a
+ * copy of an ADC input, times a gain. A table runs periodically at
+ * RP_FF_DEPTH entries per period, or plays once per trigger (a write of
+ * rp_ff_trigger() or the rising edge of a DIO_P pin) and stops on its last
+ * entry. Tables hold output counts of the channel and are loaded with one
+ * bulk copy into the mapped table window.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef FF_H
+#define FF_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * registers in the PID window: the block of channel n starts at
+ * rpChan[n].ff (codec.h), RP_FF_BASE(n) on the default bitstream; the
+ * table of the block at RP_FF_BASE(k) is at RP_FF_TABLE(k)
+ */
+#define RP_FF_BASE(n)     (0x880 + 0x10 * (n))
+#define RP_FF_CFG         0x0
+#define RP_FF_STEP        0x4
+#define RP_FF_GAIN        0x8
+#define RP_FF_TRIG        0xC
+#define RP_FF_TABLES      0x20000
+#define RP_FF_TABLE(k)    (RP_FF_TABLES + 0x1000 * (k))
+#define RP_FF_NUM         8
+
+#define RP_FF_DEPTH       1024
+#define RP_FF_GAIN_ONE    0x1000
+#define RP_FF_DIO_MAX     7
+/* CFG fields */
+#define RP_FF_SHOT        0x10
+#define RP_FF_EXT         0x20
+#define RP_FF_PLAYING     0x80000000
+/* ADC inputs, as the sources 0 - 5 of route.h */
+#define RP_FF_INPUT_NUM   6
+
+typedef enum {
+	eFfOff = 0,
+	eFfTable,
+	eFfInput,
+	eFfSrcNum
+} ffSrc_t;
+
+typedef struct {
+	ffSrc_t src;
+	int oneShot;      // play the table once per trigger instead of periodically
+	int ext;          // trigger on the rising edge of DIO_P pin dio
+	int dio;          // 0 - RP_FF_DIO_MAX
+	int input;        // ADC input of eFfInput, 0 - RP_FF_INPUT_NUM - 1
+	uint32_t step;    // phase increment per clock, 2^32 = one table per clock
+	int32_t gain;     // RP_FF_GAIN_ONE = 1, signed 16 bit
+} ffConfig_t;
+
+/* 1 if channel a_ch has a feedforward */
+int rp_ff_present(int a_ch);
+/* 0 if a_cfg is valid, -ERANGE otherwise */
+int rp_ff_check(const ffConfig_t *a_cfg);
+/* Name of a source ("off", "table", "input"), and the source of a name, -1 if unknown */
+const char *rp_ff_src_name(ffSrc_t a_src);
+int rp_ff_src_lookup(const char *a_name);
+
+/* Table periods per second, and the step closest to a_freq */
+double rp_ff_freq(const ffConfig_t *a_cfg);
+void rp_ff_from_freq(ffConfig_t *a_cfg, double a_freq);
+
+/* -ENODEV on channels without a feedforward */
+int rp_ff_set(rpRegs_t *a_regs, int a_ch, const ffConfig_t *a_cfg);
+int rp_ff_get(const rpRegs_t *a_regs, int a_ch, ffConfig_t *a_cfg);
+/* Restarts the table at entry 0 */
+int rp_ff_trigger(rpRegs_t *a_regs, int a_ch);
+/* Table entry played, and 1 while a one-shot table plays */
+int rp_ff_position(const rpRegs_t *a_regs, int a_ch, int *a_playing);
+
+/*
+ * Loads a_num entries (up to RP_FF_DEPTH) with one bulk copy, the rest of
+ * the table repeats the last one. -ENODEV, -ERANGE or -errno of the mapping.
+ */
+int rp_ff_load(rpRegs_t *a_regs, int a_ch, const int16_t *a_tbl, int a_num);
+/* Reads the whole table back, RP_FF_DEPTH entries */
+int rp_ff_read(rpRegs_t *a_regs, int a_ch, int16_t *a_tbl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FF_H */
@@ -0,0 +1,180 @@
+/**
+ * @brief Register map discovery of the PID controller.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include "info.h"
+#include "codec.h"
+
+#define WORDS (RP_INFO_SIZE / 4)
+#define DESC_WORDS (RP_INFO_DESC_SIZE / 4)
+/* word of the descriptor of channel n in the table copy */
+#define DESC(tbl, n, ofs) ((tbl)[(n) * DESC_WORDS + ((ofs) >> 2)])
+
+/* features of the default bitstream */
+static const uint32_t FEATURES_DEFAULT = RP_INFO_SHADOW | RP_INFO_TLM | RP_INFO_CAPTURE |
+                                         RP_INFO_BODE | RP_INFO_RAMP | RP_INFO_DERIV |
+                                         RP_INFO_AWINDUP | RP_INFO_ROUTE | RP_INFO_FF | RP_INFO_BANK;
+
+static uint32_t features = FEATURES_DEFAULT;
+static uint32_t clockHz = RP_PID_CLOCK;
+static int found;
+
+/* register offsets a tool may use, with the shadow copy in the same page */
+static inline int valid_offset(uint32_t a_off, uint32_t a_len)
+{
+	return (a_off & 3) == 0 && a_off >= 0x10 && a_off + a_len <= RP_MAP_SIZE;
+}
+
+/* channel n of the table copy a_tbl, -EPROTO if it does not fit the tools */
+static int parse_channel(const uint32_t *a_tbl, int a_n, rpChan_t *a_chan)
+{
+	uint32_t head = DESC(a_tbl, a_n, 0);
+	uint32_t type = head & 0xf;
+	int width = (head >> 8) & 0xff;
+	int gainWidth = (head >> 16) & 0xff;
+	int gainFrac = (head >> 4) & 0xf;
+
+	if (type >= eChanTypeNum || width < 2 || width > 31 || gainWidth < 2 || gainWidth + gainFrac > 31) {
+		return -EPROTO;
+	}
+	// the unit scaling of the type, for the range of this width
+	a_chan->type = rpChanType[type];
+	a_chan->type.width = width;
+	if (type == eChanFast) {
+		a_chan->type.min = -(int32_t)(1L << (width - 1));
+		a_chan->type.max = (int32_t)(1L << (width - 1)) - 1;
+		a_chan->type.icdClock = clockHz;
+		a_chan->type.volt = 1.0 / (1L << (width - 1));
+	} else {
+		a_chan->type.min = 0;
+		a_chan->type.max = (int32_t)(1L << width) - 1;
+		a_chan->type.volt = 3.5 / ((1L << (width - 1)) - 1);
+	}
+	a_chan->gainWidth = gainWidth;
+	a_chan->gainFrac = gainFrac;
+	a_chan->fine = 0;
+	a_chan->flags = head >> 24;
+
+	for (int i = 0; i < ePidParNum; ++i) {
+		a_chan->off[i] = DESC(a_tbl, a_n, 4 + 4 * (i / 2)) >> (16 * (i % 2));
+		if (!valid_offset(a_chan->off[i], 4 + RP_PID_SHADOW)) {
+			return -EPROTO;
+		}
+	}
+	a_chan->tlm = DESC(a_tbl, a_n, 0x18);
+	a_chan->ramp = DESC(a_tbl, a_n, 0x18) >> 16;
+	a_chan->deriv = DESC(a_tbl, a_n, 0x1C);
+	a_chan->ff = DESC(a_tbl, a_n, 0x1C) >> 16;
+	if (!valid_offset(a_chan->tlm, sizeof(pidTlm_t)) || !valid_offset(a_chan->ramp, 0x10) ||
+	    (a_chan->deriv && !valid_offset(a_chan->deriv, gainFrac ? 0x10 : 0xC)) ||
+	    (gainFrac && !a_chan->deriv) ||
+	    (a_chan->ff && !valid_offset(a_chan->ff, 0x10))) {
+		return -EPROTO;
+	}
+	return 0;
+}
+
+int rp_info_load(rpRegs_t *a_regs)
+{
+	volatile const uint32_t *src = &a_regs->pid[RP_INFO_BASE >> 2];
+	uint32_t rom[WORDS];
+	uint32_t tbl[RP_PID_MAX * DESC_WORDS];
+	rpChan_t chan[RP_PID_MAX];
+	int num;
+
+	// one pass over the ROM, everything else works on the copy
+	for (int i = 0; i < WORDS; ++i) {
+		rom[i] = src[i];
+	}
+	if (rom[0] != RP_INFO_MAGIC) {
+		return -ENODEV;
+	}
+	num = (rom[1] >> 8) & 0xff;
+	if ((rom[1] & 0xff) != RP_INFO_VERSION || ((rom[1] >> 16) & 0xff) != RP_INFO_DESC_SIZE ||
+	    num < 1 || num > RP_INFO_DESC_MAX || num > RP_PID_MAX ||
+	    (rom[4] & RP_MAP_MASK) || rom[4] >= RP_SECTION_SIZE) {
+		return -EPROTO;
+	}
+	// the table has a page of its own
+	src = rp_map(a_regs, RP_ADDR_PID + rom[4]);
+	if (!src) {
+		return -errno;
+	}
+	for (int i = 0; i < num * DESC_WORDS; ++i) {
+		tbl[i] = src[i];
+	}
+	clockHz = rom[3] ? rom[3] : clockHz;
+	for (int n = 0; n < num; ++n) {
+		if (parse_channel(tbl, n, &chan[n]) != 0) {
+			return -EPROTO;
+		}
+	}
+
+	memcpy(rpChan, chan, num * sizeof(rpChan_t));
+	rpChanNum = num;
+	features = rom[2];
+	found = 1;
+	return num;
+}
+
+uint32_t rp_info_features(void)
+{
+	return features;
+}
+
+uint32_t rp_info_clock(void)
+{
+	return clockHz;
+}
+
+int rp_info_found(void)
+{
+	return found;
+}
+
+void rp_info_write(rpRegs_t *a_regs)
+{
+	volatile uint32_t *rom = &a_regs->pid[RP_INFO_BASE >> 2];
+	volatile uint32_t *tbl;
+
+	if (a_regs->backend == eRpDevMem) {
+		return;
+	}
+	tbl = rp_map(a_regs, RP_ADDR_PID + RP_INFO_TABLE);
+	if (!tbl) {
+		return;
+	}
+	rp_codec_defaults();
+	for (int i = 0; i < WORDS; ++i) {
+		rom[i] = 0;
+	}
+	for (int i = 0; i < RP_INFO_DESC_MAX * DESC_WORDS; ++i) {
+		tbl[i] = 0;
+	}
+	rom[0] = RP_INFO_MAGIC;
+	rom[1] = RP_INFO_VERSION | (RP_PID_NUM << 8) | (RP_INFO_DESC_SIZE << 16);
+	rom[2] = FEATURES_DEFAULT;
+	rom[3] = RP_PID_CLOCK;
+	rom[4] = RP_INFO_TABLE;
+	for (int n = 0; n < RP_PID_NUM; ++n) {
+		const rpChan_t *chan = &rpChan[n];
+		volatile uint32_t *desc = &tbl[n * DESC_WORDS];
+
+		desc[0] = (chan->type.min < 0 ? eChanFast : eChanSlow) | (chan->gainFrac << 4) |
+		          (chan->type.width << 8) | (chan->gainWidth << 16) | ((uint32_t)chan->flags << 24);
+		for (int i = 0; i < ePidParNum; i += 2) {
+			desc[1 + i / 2] = chan->off[i] | ((uint32_t)chan->off[i + 1] << 16);
+		}
+		desc[6] = chan->tlm | ((uint32_t)chan->ramp << 16);
+		desc[7] = chan->deriv | ((uint32_t)chan->ff << 16);
+	}
+}
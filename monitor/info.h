@@ -0,0 +1,86 @@
+/**
+ * @brief Register map discovery of the PID controller.
+ *
+ * Reads the discovery ROM of red_pitaya_pid_info.v: the number of PID
+ * channels, their type, widths and register offsets, and the features of
+ * the bitstream. rp_open() reads the whole ROM once and builds the channel
+ * table of codec.h from it, so every later access is a plain table lookup.
+ * Bitstreams without the ROM keep the built-in map of the default
+ * bitstream (RP_PID_NUM channels), and so do those with more channels
+ * than the tools hold (RP_PID_MAX).
+ *
+ * The stand-in images hold the ROM of the default bitstream, written by
+ * rp_reset().
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef INFO_H
+#define INFO_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ROM in the PID window, see red_pitaya_pid_info.v */
+#define RP_INFO_BASE      0xE00
+#define RP_INFO_SIZE      0x20        /* header */
+#define RP_INFO_MAGIC     0x44495052  /* "RPID" */
+#define RP_INFO_VERSION   2
+/* descriptor table, its offset is in the header at RP_INFO_BASE + 0x10 */
+#define RP_INFO_TABLE     0x40000     /* of the default bitstream */
+#define RP_INFO_DESC_SIZE 0x20
+#define RP_INFO_DESC_MAX  (RP_MAP_SIZE / RP_INFO_DESC_SIZE)  /* one page */
+
+/* features of the bitstream, FEAT_* of red_pitaya_pid_map.vh */
+#define RP_INFO_SHADOW    0x01        /* shadow registers and commit */
+#define RP_INFO_TLM       0x02        /* telemetry snapshots */
+#define RP_INFO_CAPTURE   0x04        /* capture buffer */
+#define RP_INFO_BODE      0x08        /* loop analyzer */
+#define RP_INFO_RAMP      0x10        /* set point ramps */
+#define RP_INFO_DERIV     0x20        /* derivative divider and filter */
+#define RP_INFO_AWINDUP   0x40        /* anti-windup on the output clamp */
+#define RP_INFO_ROUTE     0x80        /* input and output routing crossbar */
+#define RP_INFO_FF        0x100       /* feedforward tables */
+#define RP_INFO_BANK      0x200       /* parameter banks */
+
+/* channel flags, CH_* of red_pitaya_pid_map.vh */
+#define RP_INFO_CH_RAMP    0x01       /* set point ramp */
+#define RP_INFO_CH_BODE    0x02       /* loop analyzer source */
+#define RP_INFO_CH_CAPTURE 0x04       /* capture source */
+#define RP_INFO_CH_TM      0x08       /* runs on the time multiplexed engine */
+#define RP_INFO_CH_DERIV   0x10       /* derivative divider and filter */
+#define RP_INFO_CH_AWINDUP 0x20       /* anti-windup, AW register of the derivative block */
+#define RP_INFO_CH_FF      0x40       /* feedforward */
+#define RP_INFO_CH_BANK    0x80       /* parameter banks */
+
+/*
+ * Reads the ROM and loads the channel table from it. Returns the number
+ * of channels, or -ENODEV without a ROM and -EPROTO for a ROM this
+ * version does not understand; the built-in map stays in use then.
+ */
+int rp_info_load(rpRegs_t *a_regs);
+
+/* Features of the open bitstream, those of the default one without a ROM */
+uint32_t rp_info_features(void);
+/* Processing clock in Hz as the ROM gives it */
+uint32_t rp_info_clock(void);
+/* 1 if the channel table was read from the ROM */
+int rp_info_found(void);
+
+/* Stand-in images only: writes the ROM of the default bitstream */
+void rp_info_write(rpRegs_t *a_regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFO_H */
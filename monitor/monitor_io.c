@@ -0,0 +1,243 @@
+/**
+ * @brief Register and analog mixed signal (AMS) helpers of the monitor utility.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "monitor_io.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+rpRegs_t regs;
+
+const uint8_t amsDesc[eSendNum][20]={
+	"Temp(0C-85C)",
+	"AI0(0-3.5V)",
+	"AI1(0-3.5V)",
+	"AI2(0-3.5V)",
+	"AI3(0-3.5V)",
+	"AI4(5V0)",
+	"VCCPINT(1V0)",
+	"VCCPAUX(1V8)",
+	"VCCBRAM(1V0)",
+	"VCCINT(1V0)",
+	"VCCAUX(1V8)",
+	"VCCDDR(1V5)",
+	"AO0(0-1.8V)",
+	"AO1(0-1.8V)",
+	"AO2(0-1.8V)",
+	"AO3(0-1.8V)",
+};
+
+float AmsConversion(ams_t a_ch, unsigned int a_raw)
+{
+	float uAdc;
+	float val=0;
+	switch(a_ch){
+		case eAmsAI0:
+		case eAmsAI1:
+		case eAmsAI2:
+		case eAmsAI3:{
+			if(a_raw>0x7ff){
+				a_raw=0;
+			}
+			uAdc=(float)a_raw/0x7ff*0.5;
+			val=uAdc*(30.0+4.99)/4.99;
+		}
+		break;
+		case eAmsAI4:{
+			uAdc=(float)a_raw/ADC_FULL_RANGE_CNT*1.0;
+			val=uAdc*(56.0+4.99)/4.99;
+		}
+		break;
+		case eAmsTemp:{
+			val=((float)a_raw*503.975) / ADC_FULL_RANGE_CNT - 273.15;
+		}
+		break;
+		case eAmsVCCPINT:
+		case eAmsVCCPAUX:
+		case eAmsVCCBRAM:
+		case eAmsVCCINT:
+		case eAmsVCCAUX:
+		case eAmsVCCDDR:{
+			val=((float)a_raw/ADC_FULL_RANGE_CNT)*3.0;
+		}
+		break;
+		case eAmsAO0:
+		case eAmsAO1:
+		case eAmsAO2:
+		case eAmsAO3:
+			val=((float)(a_raw>>16)/SLOW_DAC_RANGE_CNT)*1.8;
+		break;
+		case eSendNum:
+			break;
+	}
+	return val;
+}
+
+void AmsList(volatile amsReg_t * a_amsReg)
+{
+	uint32_t i,raw;
+	float val;
+	printf("#ID\tDesc\t\tRaw\tVal\n");
+	for(i=0;i<eSendNum;i++){
+		switch(i){
+			case eAmsTemp:
+			    raw=a_amsReg->temp;
+			break;
+			case eAmsAI0:
+				raw=a_amsReg->aif[0];
+			break;
+			case eAmsAI1:
+				raw=a_amsReg->aif[1];
+			break;
+			case eAmsAI2:
+				raw=a_amsReg->aif[2];
+			break;
+			case eAmsAI3:
+				raw=a_amsReg->aif[3];
+				break;
+			case eAmsAI4:
+				raw=a_amsReg->aif[4];
+				break;
+			case eAmsVCCPINT:
+				raw=a_amsReg->vccPint;
+				break;
+			case eAmsVCCPAUX:
+				raw=a_amsReg->vccPaux;
+				break;
+			case eAmsVCCBRAM:
+				raw=a_amsReg->vccBram;
+				break;
+			case eAmsVCCINT:
+				raw=a_amsReg->vccInt;
+				break;
+			case eAmsVCCAUX:
+				raw=a_amsReg->vccAux;
+				break;
+			case eAmsVCCDDR:
+				raw=a_amsReg->vccDddr;
+				break;
+			case eAmsAO0:
+				raw=a_amsReg->dac[0];
+				break;
+			case eAmsAO1:
+				raw=a_amsReg->dac[1];
+				break;
+			case eAmsAO2:
+				raw=a_amsReg->dac[2];
+				break;
+			case eAmsAO3:
+				raw=a_amsReg->dac[3];
+				break;
+			case eSendNum:
+				break;
+		}
+		val=AmsConversion(i, raw);
+		printf("%d\t%s\t%x\t%.3f\n",i,&amsDesc[i][0],raw,val);
+	}
+}
+
+void DacRead(volatile amsReg_t * a_amsReg)
+{
+	uint32_t i;
+	uint32_t raw;
+	float val=0;
+	for(i=0;i<SLOW_DAC_NUM;i++){
+		raw=a_amsReg->dac[i];
+		val=AmsConversion(eAmsAO0+i, raw);
+		printf("%f\n",val);
+	}
+}
+
+void DacWrite(volatile amsReg_t * a_amsReg, double * a_val, ssize_t a_cnt)
+{
+	uint32_t i;
+	for(i=0;i<a_cnt;i++){
+		uint32_t dacCnt;
+		if(a_val[i]<0){
+		   a_val[i]=0;
+		}
+		if(a_val[i]>1.8){
+		   a_val[i]=1.8;
+		}
+		dacCnt=(a_val[i]/1.8)*SLOW_DAC_RANGE_CNT;
+		//dacCnt&=0x9c;
+		dacCnt*=256*256; // dacCnt=dacCnt<<16;
+		a_amsReg->dac[i]=dacCnt;
+	}
+}
+
+void PidStatus(rpRegs_t * a_regs)
+{
+	static const char *satDesc[4] = { "-", "I", "O", "IO" };
+	pidTlm_t tlm[RP_PID_MAX];
+	uint32_t num = rp_pid_status(a_regs, tlm);
+
+	printf("#Snapshot %u\n", num);
+	printf("#PID\tError\tInteg\tP\tI\tD\tOutput\tSat\n");
+	for (int ch = 0; ch < rp_pid_num(); ++ch) {
+		printf("%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s\n", ch + 1, tlm[ch].err, tlm[ch].integ,
+		       tlm[ch].p, tlm[ch].i, tlm[ch].d, tlm[ch].out, satDesc[tlm[ch].flags & 3]);
+	}
+}
+
+int32_t read_pid_value(int a_pidNum, pidPar_t a_par) {
+	// set point and gains are signed, the integrator divider is shown as frequency
+	int32_t read_result = rp_pid_get(&regs, a_pidNum-1, a_par);
+
+	printf("%d\n", read_result);
+	fflush(stdout);
+
+	return read_result;
+}
+
+uint32_t read_value(uint32_t a_addr) {
+	volatile void* virt_addr = rp_map(&regs, a_addr);
+	uint32_t read_result = 0;
+	if (virt_addr == NULL) FATAL;
+	read_result = *((volatile uint32_t *) virt_addr);
+	printf("0x%08x\n", read_result);
+	fflush(stdout);
+	return read_result;
+}
+
+void write_values(unsigned long a_addr, int a_type, unsigned long* a_values, ssize_t a_len) {
+	volatile void* virt_addr = rp_map(&regs, a_addr);
+	if (virt_addr == NULL) FATAL;
+
+	for (ssize_t i = 0; i < a_len; ++i) {
+		switch(a_type) {
+			case 'b':
+				*((volatile unsigned char *) virt_addr) = a_values[i];
+				break;
+			case 'h':
+				*((volatile unsigned short *) virt_addr) = a_values[i];
+				break;
+			case 'w':
+				*((volatile uint32_t *) virt_addr) = a_values[i];
+				break;
+		}
+	}
+	/*
+	if (a_len == 1) {
+		printf("Written 0x%lX\n", a_values[0]);
+	}
+	else {
+		printf("Written %d values\n", a_len);
+	}
+	*/
+	fflush(stdout);
+}
@@ -0,0 +1,64 @@
+/**
+ * @brief Register and analog mixed signal (AMS) helpers of the monitor utility.
+ *
+ * The commands of the monitor program work on the global register handle
+ * 'regs'. They live here so the benchmark suite can time exactly the code
+ * paths the monitor runs.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef MONITOR_IO_H
+#define MONITOR_IO_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "rp_regs.h"
+
+typedef enum {
+	eAmsTemp=0,
+	eAmsAI0,
+	eAmsAI1,
+	eAmsAI2,
+	eAmsAI3,
+	eAmsAI4,
+	eAmsVCCPINT,
+	eAmsVCCPAUX,
+	eAmsVCCBRAM,
+	eAmsVCCINT,
+	eAmsVCCAUX,
+	eAmsVCCDDR,
+	eAmsAO0,
+	eAmsAO1,
+	eAmsAO2,
+	eAmsAO3,
+	eSendNum
+} ams_t;
+
+extern const uint8_t amsDesc[eSendNum][20];
+
+#define ADC_FULL_RANGE_CNT 0xfff
+#define ADC_POS_RANGE_CNT  0x7ff
+
+#define SLOW_DAC_RANGE_CNT 0x9c
+
+// register windows stay mapped for the whole run
+extern rpRegs_t regs;
+
+float AmsConversion(ams_t a_ch, unsigned int a_raw);
+void AmsList(volatile amsReg_t * a_amsReg);
+void DacRead(volatile amsReg_t * a_amsReg);
+void DacWrite(volatile amsReg_t * a_amsReg, double * a_val, ssize_t a_cnt);
+
+void PidStatus(rpRegs_t * a_regs);
+
+int32_t read_pid_value(int a_pidNum, pidPar_t a_par);
+uint32_t read_value(uint32_t a_addr);
+void write_values(unsigned long a_addr, int a_type, unsigned long* a_values, ssize_t a_len);
+
+#endif /* MONITOR_IO_H */
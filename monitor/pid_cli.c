@@ -0,0 +1,1499 @@
+/**
+ * @brief Non-interactive PID commands of the monitor utility.
+ *
+ * All values are validated with the same limits as the interactive menus
+ * (rp_pid_check()) before anything is written. Updates are staged in the
+ * shadow registers and activated with a single commit, so a set or an apply
+ * file takes effect on all of its channels at once.
+ *
+ * Apply files hold one channel per line in the set syntax, or the csv
+ * written by 'pid get --format=csv':
+ *
+ *   # channel  parameters
+ *   3    sp=-120 kp=800 ki=40 psr=12
+ *   all  irst=0
+ *
+ * Set points and ICD may also be given in physical units with the unit
+ * appended (sp=0.25V, icd=2.5e4Hz), converted per channel type by the
+ * register codec (codec.h). 'pid get --units=phys' prints the values that
+ * way, rounded to what the registers hold.
+ *
+ * 'pid ramp' configures the set point ramps (ramp.h): with a rate set, a
+ * new set point is approached at that slew rate instead of in one step.
+ * Without assignments it prints the ramps and the set points the loops
+ * currently run with.
+ *
+ * 'pid route' shows or changes the routing crossbar (route.h): the input
+ * and set point source of a channel, and the signed sum of channel outputs
+ * that drives a DAC output, e.g. 'pid route 3 sp=pid5' for a cascade or
+ * 'pid route out1 sum=pid1-pid3'.
+ *
+ * 'pid ff' configures the feedforward of a channel (ff.h): a table played
+ * periodically (freq=) or once per trigger (shot=1), or a copy of an ADC
+ * input, times gain (1 = unity). --load= reads the table from a file of
+ * one value in output counts per line, '#' starts a comment.
+ *
+ * 'pid bank' selects the parameter bank a channel runs with (bank.h), by
+ * register or by a pair of DIO_P pins, and the pin of its integrator hold
+ * (hold=off frees a pin for bank selection). 'pid bank load' fills the banks
+ * from a file of one channel and bank per line, written with a single bulk
+ * copy; parameters not given keep their value, or take the running one
+ * while the bank holds none in range (a bank never written). irst is not
+ * part of a bank:
+ *
+ *   # channel  bank  parameters
+ *   1    0     sp=0 kp=800 ki=40
+ *   1    1     kp=1600 ki=80 isr=17
+ *
+ * 'pid bank dump' prints the banks in that format, banks with values out of
+ * range (never written) commented out.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "pid_cli.h"
+#include "codec.h"
+#include "ramp.h"
+#include "info.h"
+#include "deriv.h"
+#include "route.h"
+#include "ff.h"
+#include "bank.h"
+
+typedef enum {
+	eFmtTable=0,
+	eFmtCsv,
+	eFmtPlain
+} format_t;
+
+/* new values and the parameters given for every channel */
+typedef struct {
+	pidParams_t par[RP_PID_MAX];
+	uint32_t mask[RP_PID_MAX];
+} pidUpdate_t;
+
+static void usage(void)
+{
+	int n = rp_pid_num();
+
+	fprintf(stderr,
+		"Usage:\n"
+		"\tpid set <1-%d|all> par=val [par=val ...]\n"
+		"\tpid get <1-%d|all> [par ...] [--format=table|csv|plain] [--units=user|phys]\n"
+		"\tpid apply <file> [--check]\n"
+		"\tpid ramp <1-%d|all> [rate=n div=n | slew=counts/s] [scurve=0|1] [acc=n] [--wait[=ms]]\n"
+		"\tpid deriv <1-4|all> [div=n | rate=Hz] [shift=n | corner=Hz] [order=1|2]\n"
+		"\tpid windup <1-%d|all> [mode=off|cond|back|both] [track=n]\n"
+		"\tpid fine <1-4|all> [on|off]\n"
+		"\tpid route [<1-%d|all> [in=src] [sp=src|reg] | <out1|out2|ao0-ao3> sum=[-]pidN[+pidN...]|none]\n"
+		"\tpid ff <1-%d|all> [src=off|table|input] [input=in1|in2|ai0-ai3] [gain=x] [freq=Hz|step=n]\n"
+		"\t       [shot=0|1] [dio=0-7|sw] [--load=file] [--trigger]\n"
+		"\tpid bank <1-%d|all> [bank=0-3] [dio=0-7|reg] [scale=0|1] [hold=0-7|off] [--reload]\n"
+		"\tpid bank load <file> [--check] [--reload]\n"
+		"\tpid bank dump <1-%d|all>\n"
+		"\tpid info\n"
+		"Parameters:", n, n, n, n, n, n, n, n);
+	for (int i = 0; i < ePidParNum; ++i) {
+		fprintf(stderr, " %s", rp_pid_par_name(i));
+	}
+	fprintf(stderr, "\n");
+}
+
+/* prints an error, prefixed with the file position when parsing an apply file */
+static int error(const char *a_file, int a_line, const char *a_fmt, ...)
+{
+	va_list ap;
+
+	if (a_file) {
+		fprintf(stderr, "%s:%d: ", a_file, a_line);
+	} else {
+		fprintf(stderr, "pid: ");
+	}
+	va_start(ap, a_fmt);
+	vfprintf(stderr, a_fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+	return -1;
+}
+
+static int parse_int(const char *a_str, int32_t *a_val)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(a_str, &end, 0);
+	if (end == a_str || *end != '\0' || errno || val < INT32_MIN || val > INT32_MAX) {
+		return -1;
+	}
+	*a_val = val;
+	return 0;
+}
+
+/* channel number as in the menus (1 - rp_pid_num()) or "all", converted to index range */
+static int parse_channel(const char *a_str, int *a_first, int *a_last)
+{
+	int32_t num;
+
+	if (strcasecmp(a_str, "all") == 0) {
+		*a_first = 0;
+		*a_last = rp_pid_num() - 1;
+		return 0;
+	}
+	if (parse_int(a_str, &num) == -1 || num < 1 || num > rp_pid_num()) {
+		return -1;
+	}
+	*a_first = *a_last = num - 1;
+	return 0;
+}
+
+/* value with the unit of the parameter appended, e.g. 0.25V */
+static int parse_phys(const char *a_str, pidPar_t a_par, double *a_val)
+{
+	const char *unit = rp_codec_unit(a_par);
+	char *end;
+
+	errno = 0;
+	*a_val = strtod(a_str, &end);
+	return (end == a_str || *unit == '\0' || strcasecmp(end, unit) || errno || !isfinite(*a_val)) ? -1 : 0;
+}
+
+static int add_value(pidUpdate_t *a_upd, int a_first, int a_last, pidPar_t a_par, const char *a_val,
+                     const char *a_file, int a_line)
+{
+	int32_t val, min, max;
+	double phys = 0;
+	int isPhys = 0;
+
+	if (parse_int(a_val, &val) == -1) {
+		if (parse_phys(a_val, a_par, &phys) == -1) {
+			return error(a_file, a_line, "invalid value '%s' for %s", a_val, rp_pid_par_name(a_par));
+		}
+		isPhys = 1;
+	}
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		if (isPhys) {
+			double pmin, pmax;
+			if (rp_codec_check_phys(ch, a_par, phys) != 0) {
+				rp_codec_phys_range(ch, a_par, &pmin, &pmax);
+				return error(a_file, a_line, "PID %d: %s out of range (%g to %g %s): %s",
+				             ch + 1, rp_pid_par_name(a_par), pmin, pmax, rp_codec_unit(a_par), a_val);
+			}
+			val = rp_pid_decode(ch, a_par, rp_codec_from_phys(ch, a_par, phys));
+		}
+		if (rp_pid_check(ch, a_par, val) != 0) {
+			rp_pid_range(ch, a_par, &min, &max);
+			return error(a_file, a_line, "PID %d: %s out of range (%d to %d): %d",
+			             ch + 1, rp_pid_par_name(a_par), min, max, val);
+		}
+		a_upd->par[ch].val[a_par] = val;
+		a_upd->mask[ch] |= 1UL << a_par;
+	}
+	return 0;
+}
+
+/* one par=val token */
+static int add_assign(pidUpdate_t *a_upd, int a_first, int a_last, char *a_tok, const char *a_file, int a_line)
+{
+	char *eq = strchr(a_tok, '=');
+	pidPar_t par;
+
+	if (eq == NULL) {
+		return error(a_file, a_line, "expected par=val, got '%s'", a_tok);
+	}
+	*eq = '\0';
+	par = rp_pid_par_lookup(a_tok);
+	if (par == ePidParNum) {
+		return error(a_file, a_line, "unknown parameter '%s'", a_tok);
+	}
+	return add_value(a_upd, a_first, a_last, par, eq + 1, a_file, a_line);
+}
+
+/* stages all given parameters and activates the touched channels with one commit */
+static void write_update(rpRegs_t *a_regs, const pidUpdate_t *a_upd)
+{
+	uint32_t commit = 0;
+
+	// set the P digital input output pins for reading in the voltages, as the menus do
+	a_regs->hk[0x10 >> 2] = 0xff;
+
+	for (int ch = 0; ch < rp_pid_num(); ++ch) {
+		for (int par = 0; par < ePidParNum; ++par) {
+			if (a_upd->mask[ch] & (1UL << par)) {
+				rp_pid_stage(a_regs, ch, par, a_upd->par[ch].val[par]);
+			}
+		}
+		if (a_upd->mask[ch]) {
+			commit |= 1UL << ch;
+		}
+	}
+	rp_pid_commit(a_regs, commit);
+}
+
+static int cmd_set(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static pidUpdate_t upd;
+	int first, last;
+
+	if (a_argc < 3) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		if (add_assign(&upd, first, last, a_argv[i], NULL, 0) == -1) {
+			return EXIT_FAILURE;
+		}
+	}
+	write_update(a_regs, &upd);
+	return EXIT_SUCCESS;
+}
+
+static int cmd_get(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	pidPar_t par[ePidParNum];
+	int parNum = 0;
+	format_t fmt = eFmtTable;
+	int phys = 0;
+	int first, last;
+	int i;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	for (i = 2; i < a_argc; ++i) {
+		if (strncmp(a_argv[i], "--format=", 9) == 0) {
+			const char *name = a_argv[i] + 9;
+			if (strcmp(name, "table") == 0) {
+				fmt = eFmtTable;
+			} else if (strcmp(name, "csv") == 0) {
+				fmt = eFmtCsv;
+			} else if (strcmp(name, "plain") == 0) {
+				fmt = eFmtPlain;
+			} else {
+				error(NULL, 0, "unknown format '%s'", name);
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		if (strncmp(a_argv[i], "--units=", 8) == 0) {
+			const char *name = a_argv[i] + 8;
+			if (strcmp(name, "user") == 0 || strcmp(name, "phys") == 0) {
+				phys = (*name == 'p');
+			} else {
+				error(NULL, 0, "unknown units '%s'", name);
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		if (parNum == ePidParNum) {
+			error(NULL, 0, "too many parameters");
+			return EXIT_FAILURE;
+		}
+		par[parNum] = rp_pid_par_lookup(a_argv[i]);
+		if (par[parNum] == ePidParNum) {
+			error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		++parNum;
+	}
+	if (parNum == 0) {
+		for (parNum = 0; parNum < ePidParNum; ++parNum) {
+			par[parNum] = parNum;
+		}
+	}
+
+	const char *sep = (fmt == eFmtCsv) ? "," : "\t";
+	if (fmt == eFmtTable) {
+		printf("#PID");
+	} else if (fmt == eFmtCsv) {
+		printf("ch");
+	}
+	for (i = 0; fmt != eFmtPlain && i < parNum; ++i) {
+		const char *unit = rp_codec_unit(par[i]);
+		printf((phys && *unit) ? "%s%s[%s]" : "%s%s", sep, rp_pid_par_name(par[i]), unit);
+	}
+	if (fmt != eFmtPlain) {
+		printf("\n");
+	}
+
+	for (int ch = first; ch <= last; ++ch) {
+		uint32_t raw[ePidParNum];
+		pidParams_t user;
+		pidPhys_t val;
+
+		rp_codec_read_set(a_regs, ch, raw);
+		rp_codec_decode_set(ch, raw, &user);
+		rp_codec_to_phys_set(ch, raw, &val);
+		if (fmt != eFmtPlain) {
+			printf("%d%s", ch + 1, sep);
+		}
+		for (i = 0; i < parNum; ++i) {
+			if (phys) {
+				printf("%.6g", val.val[par[i]]);
+			} else {
+				printf("%d", user.val[par[i]]);
+			}
+			printf("%s", (i + 1 < parNum) ? sep : "\n");
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+/* one line of an apply file, csv once a header has been seen */
+static int apply_line(pidUpdate_t *a_upd, char *a_line, pidPar_t *a_col, int *a_colNum,
+                      const char *a_file, int a_lineNum)
+{
+	char *save;
+	char *tok;
+	int first, last;
+
+	if (*a_colNum == 0 && strncasecmp(a_line, "ch,", 3) == 0) {
+		// csv header: ch,par,par,...
+		strtok_r(a_line, ",", &save);
+		while ((tok = strtok_r(NULL, ",", &save)) != NULL) {
+			pidPar_t par = rp_pid_par_lookup(tok);
+			if (par == ePidParNum) {
+				return error(a_file, a_lineNum, "unknown parameter '%s'", tok);
+			}
+			a_col[(*a_colNum)++] = par;
+			if (*a_colNum == ePidParNum) {
+				break;
+			}
+		}
+		return 0;
+	}
+
+	const char *delim = *a_colNum ? "," : " \t";
+	tok = strtok_r(a_line, delim, &save);
+	if (parse_channel(tok, &first, &last) == -1) {
+		return error(a_file, a_lineNum, "invalid PID number '%s' (1-%d or all)", tok, rp_pid_num());
+	}
+
+	if (*a_colNum) {
+		for (int i = 0; i < *a_colNum; ++i) {
+			tok = strtok_r(NULL, delim, &save);
+			if (tok == NULL) {
+				return error(a_file, a_lineNum, "missing value for %s", rp_pid_par_name(a_col[i]));
+			}
+			if (add_value(a_upd, first, last, a_col[i], tok, a_file, a_lineNum) == -1) {
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	while ((tok = strtok_r(NULL, delim, &save)) != NULL) {
+		if (add_assign(a_upd, first, last, tok, a_file, a_lineNum) == -1) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int cmd_apply(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static pidUpdate_t upd;
+	pidPar_t col[ePidParNum];
+	int colNum = 0;
+	int check = 0;
+	int errors = 0;
+	int lineNum = 0;
+	char *line = NULL;
+	size_t len = 0;
+	FILE *fp;
+
+	if (a_argc < 2 || a_argc > 3 || (a_argc == 3 && strcmp(a_argv[2], "--check") != 0)) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	check = (a_argc == 3);
+
+	fp = (strcmp(a_argv[1], "-") == 0) ? stdin : fopen(a_argv[1], "r");
+	if (fp == NULL) {
+		error(NULL, 0, "%s: %s", a_argv[1], strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	while (getline(&line, &len, fp) != -1) {
+		++lineNum;
+		line[strcspn(line, "#\r\n")] = '\0';
+		char *start = line + strspn(line, " \t");
+		if (*start == '\0') {
+			continue;
+		}
+		// keep going to report every bad line at once
+		if (apply_line(&upd, start, col, &colNum, a_argv[1], lineNum) == -1) {
+			++errors;
+		}
+	}
+	free(line);
+	if (fp != stdin) {
+		fclose(fp);
+	}
+
+	if (errors) {
+		fprintf(stderr, "%s: %d error(s), nothing written\n", a_argv[1], errors);
+		return EXIT_FAILURE;
+	}
+	if (!check) {
+		write_update(a_regs, &upd);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_ramps(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	uint32_t done = rp_ramp_done(a_regs);
+
+	printf("#PID\trate\tdiv\tslew[1/s]\tscurve\tacc\tsp\tdone\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		rampConfig_t cfg;
+
+		rp_ramp_get(a_regs, ch, &cfg);
+		printf("%d\t%u\t%u\t%.6g\t%d\t%u\t%d\t%d\n", ch + 1, cfg.rate, cfg.div, rp_ramp_slew(&cfg),
+		       cfg.scurve, cfg.acc, rp_ramp_setpoint(a_regs, ch), (done >> ch) & 1);
+	}
+}
+
+static int cmd_ramp(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	rampConfig_t cfg[RP_PID_MAX];
+	int timeoutMs = -1;
+	int changed = 0;
+	int first, last;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		rp_ramp_get(a_regs, ch, &cfg[ch]);
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int32_t val;
+		double slew;
+
+		if (strcmp(a_argv[i], "--wait") == 0) {
+			timeoutMs = 10000;
+			continue;
+		}
+		if (strncmp(a_argv[i], "--wait=", 7) == 0) {
+			if (parse_int(a_argv[i] + 7, &timeoutMs) == -1 || timeoutMs < 0) {
+				error(NULL, 0, "invalid timeout '%s'", a_argv[i] + 7);
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "slew") == 0) {
+			char *end;
+			slew = strtod(eq + 1, &end);
+			if (end == eq + 1 || *end != '\0' || !(slew > 0) || !isfinite(slew)) {
+				error(NULL, 0, "invalid value '%s' for slew", eq + 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				rp_ramp_from_slew(&cfg[ch], slew);
+			}
+			changed = 1;
+			continue;
+		}
+		if (parse_int(eq + 1, &val) == -1 || val < 0) {
+			error(NULL, 0, "invalid value '%s' for %s", eq + 1, a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		for (int ch = first; ch <= last; ++ch) {
+			if (strcmp(a_argv[i], "rate") == 0) {
+				cfg[ch].rate = val;
+			} else if (strcmp(a_argv[i], "div") == 0) {
+				cfg[ch].div = val;
+			} else if (strcmp(a_argv[i], "scurve") == 0) {
+				cfg[ch].scurve = val;
+			} else if (strcmp(a_argv[i], "acc") == 0) {
+				cfg[ch].acc = val;
+			} else {
+				error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		changed = 1;
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		if (rp_ramp_check(&cfg[ch]) != 0) {
+			error(NULL, 0, "PID %d: ramp out of range (rate 0-%u, div 1-%lu, scurve 0-1, acc 0-%u)",
+			      ch + 1, RP_RAMP_RATE_MAX, RP_RAMP_DIV_MAX, RP_RAMP_ACC_MAX);
+			return EXIT_FAILURE;
+		}
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_ramp_set(a_regs, ch, &cfg[ch]);
+	}
+
+	if (timeoutMs >= 0) {
+		uint32_t mask = rp_pid_mask(first, last);
+		if (rp_ramp_wait(a_regs, mask, timeoutMs) != 0) {
+			error(NULL, 0, "ramps not done after %d ms", timeoutMs);
+			return EXIT_FAILURE;
+		}
+	}
+	if (!changed) {
+		print_ramps(a_regs, first, last);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_deriv(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	printf("#PID\tdiv\trate[Hz]\tshift\torder\tcorner[Hz]\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		derivConfig_t cfg;
+
+		if (rp_deriv_get(a_regs, ch, &cfg) == 0) {
+			printf("%d\t%u\t%.6g\t%d\t%d\t%.6g\n", ch + 1, cfg.div, rp_deriv_rate(&cfg),
+			       cfg.shift, cfg.order, rp_deriv_corner(&cfg));
+		}
+	}
+}
+
+static int cmd_deriv(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	derivConfig_t cfg[RP_PID_MAX];
+	double corner[RP_PID_MAX] = { 0 };
+	int changed = 0;
+	int first, last;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	// 'all' takes the channels that have the filter
+	while (first <= last && !rp_deriv_present(first)) {
+		++first;
+	}
+	while (last >= first && !rp_deriv_present(last)) {
+		--last;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		if (rp_deriv_get(a_regs, ch, &cfg[ch]) != 0) {
+			error(NULL, 0, "PID %d has no derivative filter", ch + 1);
+			return EXIT_FAILURE;
+		}
+	}
+	if (first > last) {
+		error(NULL, 0, "no derivative filter on PID %s", a_argv[1]);
+		return EXIT_FAILURE;
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int32_t val;
+
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "rate") == 0 || strcmp(a_argv[i], "corner") == 0) {
+			char *end;
+			double hz = strtod(eq + 1, &end);
+			if (end == eq + 1 || *end != '\0' || !(hz > 0) || !isfinite(hz)) {
+				error(NULL, 0, "invalid value '%s' for %s", eq + 1, a_argv[i]);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				if (a_argv[i][0] == 'r') {
+					rp_deriv_from_rate(&cfg[ch], hz);
+				} else {
+					corner[ch] = hz;
+				}
+			}
+			changed = 1;
+			continue;
+		}
+		if (parse_int(eq + 1, &val) == -1 || val < 0) {
+			error(NULL, 0, "invalid value '%s' for %s", eq + 1, a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		for (int ch = first; ch <= last; ++ch) {
+			if (strcmp(a_argv[i], "div") == 0) {
+				cfg[ch].div = val;
+			} else if (strcmp(a_argv[i], "shift") == 0) {
+				cfg[ch].shift = val;
+			} else if (strcmp(a_argv[i], "order") == 0) {
+				cfg[ch].order = val;
+			} else {
+				error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		changed = 1;
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		// the corner depends on the update rate, so it is resolved last
+		if (corner[ch] > 0) {
+			rp_deriv_from_corner(&cfg[ch], corner[ch]);
+		}
+		if (rp_deriv_check(&cfg[ch]) != 0) {
+			error(NULL, 0, "PID %d: derivative filter out of range (div 1-%lu, shift 0-%d, order 1-2)",
+			      ch + 1, RP_DERIV_DIV_MAX, RP_DERIV_SHIFT_MAX);
+			return EXIT_FAILURE;
+		}
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_deriv_set(a_regs, ch, &cfg[ch]);
+	}
+	if (!changed) {
+		print_deriv(a_regs, first, last);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_windup(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	printf("#PID\tmode\ttrack\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		windupConfig_t cfg;
+
+		if (rp_windup_get(a_regs, ch, &cfg) == 0) {
+			printf("%d\t%s\t%d\n", ch + 1, rp_windup_name(cfg.mode), cfg.track);
+		}
+	}
+}
+
+static int cmd_windup(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	windupConfig_t cfg[RP_PID_MAX];
+	int changed = 0;
+	int first, last;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	// 'all' takes the channels that have the anti-windup
+	while (first <= last && !rp_windup_present(first)) {
+		++first;
+	}
+	while (last >= first && !rp_windup_present(last)) {
+		--last;
+	}
+	if (first > last) {
+		error(NULL, 0, "no anti-windup on PID %s", a_argv[1]);
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		if (rp_windup_get(a_regs, ch, &cfg[ch]) != 0) {
+			error(NULL, 0, "PID %d has no anti-windup", ch + 1);
+			return EXIT_FAILURE;
+		}
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int32_t val;
+
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "mode") == 0) {
+			int mode = rp_windup_mode(eq + 1);
+			if (mode < 0) {
+				error(NULL, 0, "invalid mode '%s' (off, cond, back or both)", eq + 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].mode = mode;
+			}
+		} else if (strcmp(a_argv[i], "track") == 0) {
+			if (parse_int(eq + 1, &val) == -1 || val < RP_WINDUP_TRACK_MIN || val > RP_WINDUP_TRACK_MAX) {
+				error(NULL, 0, "invalid value '%s' for track (%d-%d)", eq + 1, RP_WINDUP_TRACK_MIN,
+				      RP_WINDUP_TRACK_MAX);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].track = val;
+			}
+		} else {
+			error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		changed = 1;
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_windup_set(a_regs, ch, &cfg[ch]);
+	}
+	if (!changed) {
+		print_windup(a_regs, first, last);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_fine(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	printf("#PID\tfine\tbits\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		int on = rp_fine_get(a_regs, ch);
+
+		if (on >= 0) {
+			printf("%d\t%s\t%d\n", ch + 1, on ? "on" : "off", rp_fine_bits(ch));
+		}
+	}
+}
+
+static int cmd_fine(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	int first, last;
+	int on;
+
+	if (a_argc < 2 || a_argc > 3) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	// 'all' takes the channels that have fine gains
+	while (first <= last && !rp_fine_present(first)) {
+		++first;
+	}
+	while (last >= first && !rp_fine_present(last)) {
+		--last;
+	}
+	if (first > last) {
+		error(NULL, 0, "no fine gains on PID %s", a_argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (a_argc == 2) {
+		print_fine(a_regs, first, last);
+		return EXIT_SUCCESS;
+	}
+	if (strcmp(a_argv[2], "on") == 0) {
+		on = 1;
+	} else if (strcmp(a_argv[2], "off") == 0) {
+		on = 0;
+	} else {
+		error(NULL, 0, "expected on or off, got '%s'", a_argv[2]);
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		if (rp_fine_set(a_regs, ch, on) != 0) {
+			error(NULL, 0, "PID %d has no fine gains", ch + 1);
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_route(const rpRegs_t *a_regs, int a_first, int a_last, int a_out)
+{
+	char buf[64];
+
+	if (a_first <= a_last) {
+		printf("#PID\tin\tsp\n");
+	}
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		routeIn_t in;
+
+		rp_route_get_in(a_regs, ch, &in);
+		printf("%d\t%s\t%s\n", ch + 1, rp_route_src_name(in.in),
+		       (in.sp == RP_ROUTE_SP_REG) ? "reg" : rp_route_src_name(in.sp));
+	}
+	if (a_out) {
+		printf("#Out\tsum\n");
+	}
+	for (int m = 0; a_out && m < RP_ROUTE_OUT_NUM; ++m) {
+		routeOut_t sum;
+
+		rp_route_get_out(a_regs, m, &sum);
+		printf("%s\t%s\n", rp_route_out_name(m), rp_route_sum_format(&sum, buf));
+	}
+}
+
+static int cmd_route(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	int num = (rp_pid_num() < RP_ROUTE_CH_NUM) ? rp_pid_num() : RP_ROUTE_CH_NUM;
+	int changed = 0;
+	int first, last, out;
+
+	if (!rp_route_present()) {
+		error(NULL, 0, "no routing crossbar in this bitstream");
+		return EXIT_FAILURE;
+	}
+	if (a_argc < 2) {
+		print_route(a_regs, 0, num - 1, 1);
+		return EXIT_SUCCESS;
+	}
+
+	// an output and its sum
+	out = rp_route_out_lookup(a_argv[1]);
+	if (out >= 0) {
+		routeOut_t sum;
+
+		for (int i = 2; i < a_argc; ++i) {
+			if (strncmp(a_argv[i], "sum=", 4) != 0) {
+				error(NULL, 0, "expected sum=..., got '%s'", a_argv[i]);
+				return EXIT_FAILURE;
+			}
+			if (rp_route_sum_parse(a_argv[i] + 4, &sum) != 0) {
+				error(NULL, 0, "invalid sum '%s' (e.g. pid1+pid2-pid5, or none)", a_argv[i] + 4);
+				return EXIT_FAILURE;
+			}
+			changed = 1;
+		}
+		if (changed) {
+			rp_route_set_out(a_regs, out, &sum);
+		} else {
+			char buf[64];
+
+			rp_route_get_out(a_regs, out, &sum);
+			printf("%s\t%s\n", rp_route_out_name(out), rp_route_sum_format(&sum, buf));
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// the input and set point of channels
+	routeIn_t in[RP_ROUTE_CH_NUM];
+
+	if (parse_channel(a_argv[1], &first, &last) == -1 || last >= num) {
+		error(NULL, 0, "invalid PID number or output '%s' (1-%d, all, out1, out2 or ao0-ao3)",
+		      a_argv[1], num);
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		rp_route_get_in(a_regs, ch, &in[ch]);
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int src;
+
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "sp") == 0 && strcmp(eq + 1, "reg") == 0) {
+			src = RP_ROUTE_SP_REG;
+		} else if ((src = rp_route_src_lookup(eq + 1)) < 0) {
+			error(NULL, 0, "invalid source '%s' (in1, in2, ai0-ai3, pid1-pid8 or zero)", eq + 1);
+			return EXIT_FAILURE;
+		}
+		for (int ch = first; ch <= last; ++ch) {
+			if (strcmp(a_argv[i], "in") == 0) {
+				in[ch].in = src;
+			} else if (strcmp(a_argv[i], "sp") == 0) {
+				in[ch].sp = src;
+			} else {
+				error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		changed = 1;
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_route_set_in(a_regs, ch, &in[ch]);
+	}
+	if (!changed) {
+		print_route(a_regs, first, last, 0);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_ff(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	printf("#PID\tsrc\tinput\tgain\tfreq\tshot\ttrig\tentry\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		ffConfig_t cfg;
+		char trig[8] = "sw";
+		int playing;
+
+		if (rp_ff_get(a_regs, ch, &cfg) == 0) {
+			if (cfg.ext) {
+				snprintf(trig, sizeof(trig), "dio%d", cfg.dio);
+			}
+			int entry = rp_ff_position(a_regs, ch, &playing);
+			printf("%d\t%s\t%s\t%g\t%g\t%d\t%s\t%d%s\n", ch + 1, rp_ff_src_name(cfg.src),
+			       rp_route_src_name(cfg.input), (double)cfg.gain / RP_FF_GAIN_ONE, rp_ff_freq(&cfg),
+			       cfg.oneShot, trig, entry, playing ? " playing" : "");
+		}
+	}
+}
+
+/* table file: one value in output counts per line, '#' starts a comment */
+static int read_ff_table(const char *a_file, int16_t *a_tbl)
+{
+	FILE *fp = fopen(a_file, "r");
+	char line[256];
+	int num = 0, lineNo = 0;
+
+	if (fp == NULL) {
+		return error(NULL, 0, "cannot open %s: %s", a_file, strerror(errno));
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		char *hash = strchr(line, '#');
+		char *tok;
+		int32_t val;
+
+		++lineNo;
+		if (hash) {
+			*hash = '\0';
+		}
+		tok = strtok(line, " \t\r\n");
+		if (tok == NULL) {
+			continue;
+		}
+		if (parse_int(tok, &val) == -1 || val < INT16_MIN || val > INT16_MAX || strtok(NULL, " \t\r\n")) {
+			fclose(fp);
+			return error(a_file, lineNo, "expected one value from %d to %d", INT16_MIN, INT16_MAX);
+		}
+		if (num == RP_FF_DEPTH) {
+			fclose(fp);
+			return error(a_file, lineNo, "more than %d entries", RP_FF_DEPTH);
+		}
+		a_tbl[num++] = val;
+	}
+	fclose(fp);
+	if (num == 0) {
+		return error(a_file, 0, "empty table");
+	}
+	return num;
+}
+
+static int cmd_ff(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	ffConfig_t cfg[RP_PID_MAX];
+	int16_t tbl[RP_FF_DEPTH];
+	int tblNum = 0, trigger = 0;
+	int changed = 0;
+	int first, last;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_channel(a_argv[1], &first, &last) == -1) {
+		error(NULL, 0, "invalid PID number '%s' (1-%d or all)", a_argv[1], rp_pid_num());
+		return EXIT_FAILURE;
+	}
+	// 'all' takes the channels that have a feedforward
+	while (first <= last && !rp_ff_present(first)) {
+		++first;
+	}
+	while (last >= first && !rp_ff_present(last)) {
+		--last;
+	}
+	if (first > last) {
+		error(NULL, 0, "no feedforward on PID %s", a_argv[1]);
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		if (rp_ff_get(a_regs, ch, &cfg[ch]) != 0) {
+			error(NULL, 0, "PID %d has no feedforward", ch + 1);
+			return EXIT_FAILURE;
+		}
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int32_t val = 0;
+
+		if (strncmp(a_argv[i], "--load=", 7) == 0) {
+			if ((tblNum = read_ff_table(a_argv[i] + 7, tbl)) == -1) {
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		if (strcmp(a_argv[i], "--trigger") == 0) {
+			trigger = 1;
+			continue;
+		}
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "src") == 0) {
+			int src = rp_ff_src_lookup(eq + 1);
+			if (src < 0) {
+				error(NULL, 0, "invalid source '%s' (off, table or input)", eq + 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].src = src;
+			}
+		} else if (strcmp(a_argv[i], "input") == 0) {
+			int src = rp_route_src_lookup(eq + 1);
+			if (src < 0 || src >= RP_FF_INPUT_NUM) {
+				error(NULL, 0, "invalid input '%s' (in1, in2 or ai0-ai3)", eq + 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].input = src;
+			}
+		} else if (strcmp(a_argv[i], "gain") == 0 || strcmp(a_argv[i], "freq") == 0) {
+			char *end;
+			double x = strtod(eq + 1, &end);
+			int isGain = a_argv[i][0] == 'g';
+			if (end == eq + 1 || *end != '\0' || !isfinite(x) || (isGain && fabs(x * RP_FF_GAIN_ONE) > INT16_MAX) ||
+			    (!isGain && (x < 0 || x > rp_info_clock() / 2))) {
+				error(NULL, 0, "invalid value '%s' for %s", eq + 1, a_argv[i]);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				if (isGain) {
+					cfg[ch].gain = lround(x * RP_FF_GAIN_ONE);
+				} else {
+					rp_ff_from_freq(&cfg[ch], x);
+				}
+			}
+		} else if (strcmp(a_argv[i], "dio") == 0) {
+			int ext = strcmp(eq + 1, "sw") != 0;
+			if (ext && (parse_int(eq + 1, &val) == -1 || val < 0 || val > RP_FF_DIO_MAX)) {
+				error(NULL, 0, "invalid value '%s' for dio (0-%d or sw)", eq + 1, RP_FF_DIO_MAX);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].ext = ext;
+				cfg[ch].dio = ext ? val : cfg[ch].dio;
+			}
+		} else if (strcmp(a_argv[i], "step") == 0 || strcmp(a_argv[i], "shot") == 0) {
+			char *end;
+			unsigned long long num;
+			errno = 0;
+			num = strtoull(eq + 1, &end, 0);
+			if (end == eq + 1 || *end != '\0' || errno || eq[1] == '-' || num > UINT32_MAX ||
+			    (a_argv[i][1] == 'h' && num > 1)) {
+				error(NULL, 0, "invalid value '%s' for %s", eq + 1, a_argv[i]);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				if (a_argv[i][1] == 'h') {
+					cfg[ch].oneShot = num;
+				} else {
+					cfg[ch].step = num;
+				}
+			}
+		} else {
+			error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		changed = 1;
+	}
+	// the table first, so a new source starts on the new values
+	for (int ch = first; tblNum && ch <= last; ++ch) {
+		int ret = rp_ff_load(a_regs, ch, tbl, tblNum);
+		if (ret) {
+			error(NULL, 0, "PID %d: cannot load the table: %s", ch + 1, strerror(-ret));
+			return EXIT_FAILURE;
+		}
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_ff_set(a_regs, ch, &cfg[ch]);
+	}
+	for (int ch = first; trigger && ch <= last; ++ch) {
+		rp_ff_trigger(a_regs, ch);
+	}
+	if (!changed && !tblNum && !trigger) {
+		print_ff(a_regs, first, last);
+	}
+	return EXIT_SUCCESS;
+}
+
+static void print_bank(const rpRegs_t *a_regs, int a_first, int a_last)
+{
+	printf("#PID\tbank\tselect\tscale\tactive\thold\n");
+	for (int ch = a_first; ch <= a_last; ++ch) {
+		bankConfig_t cfg;
+		char sel[8] = "reg";
+		char hold[8] = "off";
+
+		if (rp_bank_get(a_regs, ch, &cfg) == 0) {
+			if (cfg.pin) {
+				snprintf(sel, sizeof(sel), "dio%d", cfg.dio);
+			}
+			if (cfg.hold >= 0) {
+				snprintf(hold, sizeof(hold), "dio%d", cfg.hold);
+			}
+			printf("%d\t%d\t%s\t%d\t%d\t%s\n", ch + 1, cfg.bank, sel, cfg.scale, rp_bank_active(a_regs, ch),
+			       hold);
+		}
+	}
+}
+
+/* channel range of the banks, 'all' takes the channels that have them */
+static int parse_bank_channel(const char *a_str, int *a_first, int *a_last, const char *a_file, int a_line)
+{
+	if (parse_channel(a_str, a_first, a_last) == -1) {
+		return error(a_file, a_line, "invalid PID number '%s' (1-%d or all)", a_str, rp_pid_num());
+	}
+	while (*a_first <= *a_last && !rp_bank_present(*a_first)) {
+		++*a_first;
+	}
+	while (*a_last >= *a_first && !rp_bank_present(*a_last)) {
+		--*a_last;
+	}
+	if (*a_first > *a_last) {
+		return error(a_file, a_line, "no parameter banks on PID %s", a_str);
+	}
+	return 0;
+}
+
+/* one line of a bank file: channel, bank, par=val ... */
+static int bank_line(pidUpdate_t *a_upd, char *a_line, const char *a_file, int a_lineNum)
+{
+	char *save;
+	char *tok = strtok_r(a_line, " \t", &save);
+	int first, last;
+	int32_t bank;
+
+	if (parse_bank_channel(tok, &first, &last, a_file, a_lineNum) == -1) {
+		return -1;
+	}
+	tok = strtok_r(NULL, " \t", &save);
+	if (tok == NULL || parse_int(tok, &bank) == -1 || bank < 0 || bank >= RP_BANK_NUM) {
+		return error(a_file, a_lineNum, "expected a bank from 0 to %d", RP_BANK_NUM - 1);
+	}
+	while ((tok = strtok_r(NULL, " \t", &save)) != NULL) {
+		if (add_assign(&a_upd[bank], first, last, tok, a_file, a_lineNum) == -1) {
+			return -1;
+		}
+		if (a_upd[bank].mask[first] & (1UL << ePidIrst)) {
+			return error(a_file, a_lineNum, "irst is not part of a bank");
+		}
+	}
+	return 0;
+}
+
+static int cmd_bank_load(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static pidUpdate_t upd[RP_BANK_NUM];
+	static bankImage_t img;
+	int check = 0, reload = 0;
+	int errors = 0;
+	int lineNum = 0;
+	char *line = NULL;
+	size_t len = 0;
+	FILE *fp;
+	int ret;
+
+	if (a_argc < 3) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	for (int i = 3; i < a_argc; ++i) {
+		if (strcmp(a_argv[i], "--check") == 0) {
+			check = 1;
+		} else if (strcmp(a_argv[i], "--reload") == 0) {
+			reload = 1;
+		} else {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	fp = (strcmp(a_argv[2], "-") == 0) ? stdin : fopen(a_argv[2], "r");
+	if (fp == NULL) {
+		error(NULL, 0, "%s: %s", a_argv[2], strerror(errno));
+		return EXIT_FAILURE;
+	}
+	while (getline(&line, &len, fp) != -1) {
+		++lineNum;
+		line[strcspn(line, "#\r\n")] = '\0';
+		char *start = line + strspn(line, " \t");
+		if (*start == '\0') {
+			continue;
+		}
+		if (bank_line(upd, start, a_argv[2], lineNum) == -1) {
+			++errors;
+		}
+	}
+	free(line);
+	if (fp != stdin) {
+		fclose(fp);
+	}
+
+	if (errors) {
+		fprintf(stderr, "%s: %d error(s), nothing written\n", a_argv[2], errors);
+		return EXIT_FAILURE;
+	}
+	if (check) {
+		return EXIT_SUCCESS;
+	}
+
+	// merge into the banks as they are and write them back in one go
+	if ((ret = rp_bank_download(a_regs, &img)) != 0) {
+		error(NULL, 0, "cannot map the banks: %s", strerror(-ret));
+		return EXIT_FAILURE;
+	}
+	for (int b = 0; b < RP_BANK_NUM; ++b) {
+		for (int ch = 0; ch < RP_BANK_CH_NUM; ++ch) {
+			pidParams_t par;
+
+			if (upd[b].mask[ch] == 0) {
+				continue;
+			}
+			rp_bank_decode(ch, img.word[ch][b], &par);
+			for (int p = 0; p < ePidParNum; ++p) {
+				if (upd[b].mask[ch] & (1UL << p)) {
+					par.val[p] = upd[b].par[ch].val[p];
+				} else if (rp_pid_check(ch, p, par.val[p]) != 0) {
+					par.val[p] = rp_pid_get(a_regs, ch, p);
+				}
+			}
+			rp_bank_encode(ch, &par, img.word[ch][b]);
+		}
+	}
+	if ((ret = rp_bank_upload(a_regs, &img)) != 0) {
+		error(NULL, 0, "cannot map the banks: %s", strerror(-ret));
+		return EXIT_FAILURE;
+	}
+	for (int ch = 0; reload && ch < RP_BANK_CH_NUM; ++ch) {
+		for (int b = 0; b < RP_BANK_NUM; ++b) {
+			if (upd[b].mask[ch] && rp_bank_active(a_regs, ch) == b) {
+				rp_bank_reload(a_regs, ch);
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+static int cmd_bank_dump(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static bankImage_t img;
+	int first, last;
+	int ret;
+
+	if (a_argc != 3) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (parse_bank_channel(a_argv[2], &first, &last, NULL, 0) == -1) {
+		return EXIT_FAILURE;
+	}
+	if ((ret = rp_bank_download(a_regs, &img)) != 0) {
+		error(NULL, 0, "cannot map the banks: %s", strerror(-ret));
+		return EXIT_FAILURE;
+	}
+	printf("# channel  bank  parameters\n");
+	for (int ch = first; ch <= last; ++ch) {
+		for (int b = 0; b < RP_BANK_NUM; ++b) {
+			pidParams_t par;
+
+			int valid = 1;
+
+			rp_bank_decode(ch, img.word[ch][b], &par);
+			for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+				valid &= rp_pid_check(ch, rpBankPar[p], par.val[rpBankPar[p]]) == 0;
+			}
+			printf("%s%d\t%d\t", valid ? "" : "# ", ch + 1, b);
+			for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+				printf("%s=%d%s", rp_pid_par_name(rpBankPar[p]), par.val[rpBankPar[p]],
+				       (p + 1 < RP_BANK_PAR_NUM) ? " " : "\n");
+			}
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+static int cmd_bank(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	bankConfig_t cfg[RP_PID_MAX];
+	int reload = 0;
+	int changed = 0;
+	int first, last;
+
+	if (a_argc < 2) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (strcmp(a_argv[1], "load") == 0) {
+		return cmd_bank_load(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[1], "dump") == 0) {
+		return cmd_bank_dump(a_regs, a_argc, a_argv);
+	}
+	if (parse_bank_channel(a_argv[1], &first, &last, NULL, 0) == -1) {
+		return EXIT_FAILURE;
+	}
+	for (int ch = first; ch <= last; ++ch) {
+		rp_bank_get(a_regs, ch, &cfg[ch]);
+	}
+	for (int i = 2; i < a_argc; ++i) {
+		char *eq = strchr(a_argv[i], '=');
+		int32_t val = 0;
+
+		if (strcmp(a_argv[i], "--reload") == 0) {
+			reload = 1;
+			continue;
+		}
+		if (eq == NULL) {
+			error(NULL, 0, "expected par=val, got '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		*eq = '\0';
+		if (strcmp(a_argv[i], "bank") == 0) {
+			if (parse_int(eq + 1, &val) == -1 || val < 0 || val >= RP_BANK_NUM) {
+				error(NULL, 0, "invalid value '%s' for bank (0-%d)", eq + 1, RP_BANK_NUM - 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].bank = val;
+				cfg[ch].pin = 0;
+			}
+		} else if (strcmp(a_argv[i], "dio") == 0) {
+			int pin = strcmp(eq + 1, "reg") != 0;
+			if (pin && (parse_int(eq + 1, &val) == -1 || val < 0 || val > RP_BANK_DIO_MAX)) {
+				error(NULL, 0, "invalid value '%s' for dio (0-%d or reg)", eq + 1, RP_BANK_DIO_MAX);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].pin = pin;
+				cfg[ch].dio = pin ? val : cfg[ch].dio;
+			}
+		} else if (strcmp(a_argv[i], "scale") == 0) {
+			if (parse_int(eq + 1, &val) == -1 || val < 0 || val > 1) {
+				error(NULL, 0, "invalid value '%s' for scale (0 or 1)", eq + 1);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].scale = val;
+			}
+		} else if (strcmp(a_argv[i], "hold") == 0) {
+			int pin = strcmp(eq + 1, "off") != 0;
+			if (pin && (parse_int(eq + 1, &val) == -1 || val < 0 || val > RP_BANK_DIO_MAX)) {
+				error(NULL, 0, "invalid value '%s' for hold (0-%d or off)", eq + 1, RP_BANK_DIO_MAX);
+				return EXIT_FAILURE;
+			}
+			for (int ch = first; ch <= last; ++ch) {
+				cfg[ch].hold = pin ? val : -1;
+			}
+		} else {
+			error(NULL, 0, "unknown parameter '%s'", a_argv[i]);
+			return EXIT_FAILURE;
+		}
+		changed = 1;
+	}
+	for (int ch = first; changed && ch <= last; ++ch) {
+		rp_bank_set(a_regs, ch, &cfg[ch]);
+	}
+	for (int ch = first; reload && ch <= last; ++ch) {
+		rp_bank_reload(a_regs, ch);
+	}
+	if (!changed && !reload) {
+		print_bank(a_regs, first, last);
+	}
+	return EXIT_SUCCESS;
+}
+
+/* channel table in use, as read from the discovery ROM */
+static int cmd_info(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static const char *featName[] = { "shadow", "telemetry", "capture", "bode", "ramp", "deriv", "antiwindup",
+	                                  "route", "ff", "bank" };
+	uint32_t features = rp_info_features();
+
+	if (a_argc != 1) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	printf("#Map %s, %d channels, clock %u Hz, features",
+	       rp_info_found() ? "from ROM" : "built in", rp_pid_num(), rp_info_clock());
+	for (int i = 0; i < sizeof(featName) / sizeof(featName[0]); ++i) {
+		if ((features >> i) & 1) {
+			printf(" %s", featName[i]);
+		}
+	}
+	printf("\n#PID\ttype\twidth\tgain\tfine\tflags");
+	for (int i = 0; i < ePidParNum; ++i) {
+		printf("\t%s", rp_pid_par_name(i));
+	}
+	printf("\ttlm\tramp\tderiv\tff\n");
+	for (int ch = 0; ch < rp_pid_num(); ++ch) {
+		const rpChan_t *chan = &rpChan[ch];
+
+		printf("%d\t%s\t%d\t%d\t%d\t0x%02x", ch + 1, chan->type.name, chan->type.width,
+		       chan->gainWidth, chan->gainFrac, chan->flags);
+		for (int i = 0; i < ePidParNum; ++i) {
+			printf("\t0x%03x", chan->off[i]);
+		}
+		printf("\t0x%03x\t0x%03x\t0x%03x\t0x%03x\n", chan->tlm, chan->ramp, chan->deriv, chan->ff);
+	}
+	return EXIT_SUCCESS;
+}
+
+int pid_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	if (strcmp(a_argv[0], "set") == 0) {
+		return cmd_set(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "get") == 0) {
+		return cmd_get(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "apply") == 0) {
+		return cmd_apply(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "ramp") == 0) {
+		return cmd_ramp(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "deriv") == 0) {
+		return cmd_deriv(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "windup") == 0) {
+		return cmd_windup(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "fine") == 0) {
+		return cmd_fine(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "route") == 0) {
+		return cmd_route(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "ff") == 0) {
+		return cmd_ff(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "bank") == 0) {
+		return cmd_bank(a_regs, a_argc, a_argv);
+	}
+	if (strcmp(a_argv[0], "info") == 0) {
+		return cmd_info(a_regs, a_argc, a_argv);
+	}
+	usage();
+	return EXIT_FAILURE;
+}
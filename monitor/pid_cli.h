@@ -0,0 +1,26 @@
+/**
+ * @brief Non-interactive PID commands of the monitor utility.
+ *
+ * monitor pid set <1-8|all> par=val [par=val ...]
+ * monitor pid get <1-8|all> [par ...] [--format=table|csv|plain]
+ * monitor pid apply <file> [--check]
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef PID_CLI_H
+#define PID_CLI_H
+
+#include "rp_regs.h"
+
+/*
+ * Runs one PID command, a_argv[0] is the sub command ("set", "get" or
+ * "apply"). Returns EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int pid_cli(rpRegs_t *a_regs, int a_argc, char **a_argv);
+
+#endif /* PID_CLI_H */
@@ -0,0 +1,321 @@
+/**
+ * @brief PID control daemon.
+ *
+ * Keeps the register windows mapped and serves the request/response
+ * protocol described in pidd.h over a Unix domain socket. All clients are
+ * served from one poll() loop; every complete request found in a client's
+ * input is executed and the answers go back in one write, so pipelined
+ * requests cost one system call per burst instead of one per request.
+ *
+ * Usage: pidd [-s socket] [-b backend]
+ *
+ * The backend defaults to $RP_BACKEND or /dev/mem, see rp_regs.h.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "version.h"
+#include "rp_regs.h"
+#include "pidd.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+#define CLIENT_MAX 16
+// largest possible response
+#define RESP_MAX (sizeof(piddResp_t) + PIDD_BATCH_MAX * sizeof(int32_t))
+
+typedef struct {
+	int fd;
+	size_t inLen;
+	size_t outLen;
+	size_t outPos;
+	uint8_t in[PIDD_BUF_SIZE];
+	uint8_t out[PIDD_BUF_SIZE];
+} client_t;
+
+static volatile sig_atomic_t running = 1;
+static rpRegs_t regs;
+static client_t clients[CLIENT_MAX];
+
+static void on_signal(int a_sig)
+{
+	running = 0;
+}
+
+static int valid(int a_ch, int a_par)
+{
+	return a_ch < rp_pid_num() && a_par < ePidParNum;
+}
+
+/* Executes one request, returns the number of values written to a_vals */
+static uint32_t execute(const piddReq_t *a_req, const piddItem_t *a_items, int32_t *a_status, int32_t *a_vals)
+{
+	volatile void *reg;
+	uint32_t mask = 0;
+	int i;
+
+	*a_status = 0;
+	switch (a_req->op) {
+		case ePiddGet:
+			if (!valid(a_req->ch, a_req->par)) {
+				break;
+			}
+			a_vals[0] = rp_pid_get(&regs, a_req->ch, a_req->par);
+			return 1;
+
+		case ePiddSet:
+			if (!valid(a_req->ch, a_req->par)) {
+				break;
+			}
+			// out of range values would wrap in the register, refused as by pid set
+			if (rp_pid_check(a_req->ch, a_req->par, a_req->val) != 0) {
+				*a_status = -ERANGE;
+				return 0;
+			}
+			rp_pid_set(&regs, a_req->ch, a_req->par, a_req->val);
+			return 0;
+
+		case ePiddGetBatch:
+			for (i = 0; i < a_req->num; ++i) {
+				if (!valid(a_items[i].ch, a_items[i].par)) {
+					*a_status = -EINVAL;
+					return 0;
+				}
+			}
+			for (i = 0; i < a_req->num; ++i) {
+				a_vals[i] = rp_pid_get(&regs, a_items[i].ch, a_items[i].par);
+			}
+			return a_req->num;
+
+		case ePiddSetBatch:
+			for (i = 0; i < a_req->num; ++i) {
+				if (!valid(a_items[i].ch, a_items[i].par)) {
+					*a_status = -EINVAL;
+					return 0;
+				}
+				if (rp_pid_check(a_items[i].ch, a_items[i].par, a_items[i].val) != 0) {
+					*a_status = -ERANGE;
+					return 0;
+				}
+			}
+			// stage everything, then activate all touched channels at once
+			for (i = 0; i < a_req->num; ++i) {
+				rp_pid_stage(&regs, a_items[i].ch, a_items[i].par, a_items[i].val);
+				mask |= 1UL << a_items[i].ch;
+			}
+			rp_pid_commit(&regs, mask);
+			return 0;
+
+		case ePiddAms:
+			for (i = 0; i < sizeof(amsReg_t) / sizeof(uint32_t); ++i) {
+				a_vals[i] = ((volatile uint32_t *)regs.ams)[i];
+			}
+			return i;
+
+		case ePiddRead:
+			reg = rp_map(&regs, a_req->addr & ~3UL);
+			if (reg == NULL) {
+				*a_status = -errno;
+				return 0;
+			}
+			a_vals[0] = *(volatile uint32_t *)reg;
+			return 1;
+
+		case ePiddWrite:
+			reg = rp_map(&regs, a_req->addr & ~3UL);
+			if (reg == NULL) {
+				*a_status = -errno;
+				return 0;
+			}
+			*(volatile uint32_t *)reg = a_req->val;
+			rp_sync(&regs);
+			return 0;
+	}
+	*a_status = -EINVAL;
+	return 0;
+}
+
+/* Runs all complete requests in the input buffer while there is room for the answers */
+static void process(client_t *a_cl)
+{
+	size_t pos = 0;
+
+	while (a_cl->inLen - pos >= sizeof(piddReq_t) && sizeof(a_cl->out) - a_cl->outLen >= RESP_MAX) {
+		const piddReq_t *req = (const piddReq_t *)(a_cl->in + pos);
+		size_t len = sizeof(*req);
+
+		if (req->op == ePiddGetBatch || req->op == ePiddSetBatch) {
+			len += req->num * sizeof(piddItem_t);
+		}
+		if (a_cl->inLen - pos < len) {
+			break;
+		}
+
+		piddResp_t *resp = (piddResp_t *)(a_cl->out + a_cl->outLen);
+		resp->seq = req->seq;
+		resp->num = execute(req, (const piddItem_t *)(req + 1), &resp->status, (int32_t *)(resp + 1));
+		a_cl->outLen += sizeof(*resp) + resp->num * sizeof(int32_t);
+		pos += len;
+	}
+	memmove(a_cl->in, a_cl->in + pos, a_cl->inLen - pos);
+	a_cl->inLen -= pos;
+}
+
+static void drop(client_t *a_cl)
+{
+	close(a_cl->fd);
+	a_cl->fd = -1;
+}
+
+static void flush(client_t *a_cl)
+{
+	while (a_cl->outPos < a_cl->outLen) {
+		ssize_t ret = send(a_cl->fd, a_cl->out + a_cl->outPos, a_cl->outLen - a_cl->outPos, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (ret == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			drop(a_cl);
+			return;
+		}
+		a_cl->outPos += ret;
+	}
+	a_cl->outPos = a_cl->outLen = 0;
+}
+
+int main(int argc, char **argv)
+{
+	const char *sock = PIDD_SOCKET;
+	const char *spec = NULL;
+	struct sockaddr_un sa;
+	struct pollfd pfd[CLIENT_MAX + 1];
+	int listenFd;
+	int opt;
+	int i;
+
+	while ((opt = getopt(argc, argv, "s:b:")) != -1) {
+		switch (opt) {
+			case 's':
+				sock = optarg;
+				break;
+			case 'b':
+				spec = optarg;
+				break;
+			default:
+				fprintf(stderr,
+					"%s version %s-%s\n"
+					"\nUsage: %s [-s socket] [-b backend]\n",
+					argv[0], VERSION_STR, REVISION_STR, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (rp_open(&regs, spec) == -1) FATAL;
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd == -1) FATAL;
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	strncpy(sa.sun_path, sock, sizeof(sa.sun_path) - 1);
+	unlink(sock);
+	if (bind(listenFd, (struct sockaddr *)&sa, sizeof(sa)) == -1) FATAL;
+	if (listen(listenFd, CLIENT_MAX) == -1) FATAL;
+
+	for (i = 0; i < CLIENT_MAX; ++i) {
+		clients[i].fd = -1;
+	}
+
+	while (running) {
+		pfd[0].fd = listenFd;
+		pfd[0].events = POLLIN;
+		for (i = 0; i < CLIENT_MAX; ++i) {
+			client_t *cl = &clients[i];
+			pfd[i + 1].fd = cl->fd;
+			// stop reading from clients that do not collect their answers
+			pfd[i + 1].events = (cl->outLen ? POLLOUT : 0) | (cl->inLen < sizeof(cl->in) && !cl->outLen ? POLLIN : 0);
+		}
+
+		if (poll(pfd, CLIENT_MAX + 1, -1) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			FATAL;
+		}
+
+		if (pfd[0].revents & POLLIN) {
+			int fd = accept(listenFd, NULL, NULL);
+			for (i = 0; fd != -1 && i < CLIENT_MAX; ++i) {
+				if (clients[i].fd == -1) {
+					clients[i].fd = fd;
+					clients[i].inLen = clients[i].outLen = clients[i].outPos = 0;
+					break;
+				}
+			}
+			if (fd != -1 && i == CLIENT_MAX) {
+				close(fd);
+			}
+		}
+
+		for (i = 0; i < CLIENT_MAX; ++i) {
+			client_t *cl = &clients[i];
+			if (cl->fd == -1 || pfd[i + 1].fd == -1) {
+				continue;
+			}
+			if (pfd[i + 1].revents & POLLOUT) {
+				flush(cl);
+				if (cl->fd != -1 && !cl->outLen) {
+					process(cl);
+					flush(cl);
+				}
+			}
+			if (cl->fd != -1 && (pfd[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+				ssize_t ret = recv(cl->fd, cl->in + cl->inLen, sizeof(cl->in) - cl->inLen, MSG_DONTWAIT);
+				if (ret == 0 || (ret == -1 && errno != EAGAIN && errno != EINTR)) {
+					drop(cl);
+					continue;
+				}
+				if (ret > 0) {
+					cl->inLen += ret;
+					process(cl);
+					flush(cl);
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < CLIENT_MAX; ++i) {
+		if (clients[i].fd != -1) {
+			close(clients[i].fd);
+		}
+	}
+	close(listenFd);
+	unlink(sock);
+	rp_close(&regs);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+/**
+ * @brief PID control daemon protocol and client interface.
+ *
+ * The daemon (pidd) keeps the register windows mapped and serves requests
+ * over a Unix domain socket. Requests and responses are fixed size binary
+ * records in host byte order; batch requests and responses are followed by
+ * their items. Every response echoes the sequence number of its request and
+ * responses are sent in request order, so a client may pipeline any number
+ * of requests before it reads the answers.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef PIDD_H
+#define PIDD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIDD_SOCKET    "/tmp/pidd.sock"
+#define PIDD_BATCH_MAX 255
+#define PIDD_BUF_SIZE  65536
+
+typedef enum {
+	ePiddGet=1,      // ch, par              -> 1 value
+	ePiddSet,        // ch, par, val         -> 0 values, -ERANGE outside rp_pid_range()
+	ePiddGetBatch,   // num items (ch, par)  -> num values
+	ePiddSetBatch,   // num items            -> 0 values, committed atomically, nothing on -ERANGE
+	ePiddAms,        //                      -> amsReg_t snapshot as words
+	ePiddRead,       // addr                 -> 1 raw value
+	ePiddWrite       // addr, val            -> 0 values
+} piddOp_t;
+
+typedef struct {
+	uint32_t seq;
+	uint8_t  op;
+	uint8_t  ch;
+	uint8_t  par;
+	uint8_t  num;    // number of piddItem_t following a batch request
+	int32_t  val;
+	uint32_t addr;
+} piddReq_t;
+
+typedef struct {
+	uint8_t  ch;
+	uint8_t  par;
+	uint16_t reserved;
+	int32_t  val;
+} piddItem_t;
+
+typedef struct {
+	uint32_t seq;
+	int32_t  status; // 0 or -errno
+	uint32_t num;    // number of int32_t values following
+} piddResp_t;
+
+/* buffered client connection */
+typedef struct {
+	int fd;
+	uint32_t seq;
+	size_t len;
+	size_t pos;
+	size_t olen;
+	uint8_t buf[PIDD_BUF_SIZE];
+	uint8_t obuf[PIDD_BUF_SIZE];
+} piddClient_t;
+
+int pidd_connect(piddClient_t *a_cl, const char *a_path);
+void pidd_disconnect(piddClient_t *a_cl);
+
+/* Queue one request and store its sequence number in a_req->seq, returns 0 or -1 */
+int pidd_send(piddClient_t *a_cl, piddReq_t *a_req, const piddItem_t *a_items);
+/* Send all queued requests, pidd_recv() does this implicitly */
+int pidd_flush(piddClient_t *a_cl);
+/* Read the next response, up to a_max values are stored in a_vals */
+int pidd_recv(piddClient_t *a_cl, piddResp_t *a_resp, int32_t *a_vals, uint32_t a_max);
+
+/* Synchronous helpers, return 0 or -errno */
+int pidd_get(piddClient_t *a_cl, int a_ch, pidPar_t a_par, int32_t *a_val);
+int pidd_set(piddClient_t *a_cl, int a_ch, pidPar_t a_par, int32_t a_val);
+int pidd_get_batch(piddClient_t *a_cl, int a_num, piddItem_t *a_items);
+int pidd_set_batch(piddClient_t *a_cl, int a_num, const piddItem_t *a_items);
+int pidd_ams(piddClient_t *a_cl, amsReg_t *a_ams);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIDD_H */
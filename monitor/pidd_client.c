@@ -0,0 +1,196 @@
+/**
+ * @brief PID control daemon client.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "pidd.h"
+
+int pidd_connect(piddClient_t *a_cl, const char *a_path)
+{
+	struct sockaddr_un sa;
+
+	memset(a_cl, 0, offsetof(piddClient_t, buf));
+	a_cl->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (a_cl->fd == -1) {
+		return -1;
+	}
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	strncpy(sa.sun_path, a_path ? a_path : PIDD_SOCKET, sizeof(sa.sun_path) - 1);
+	if (connect(a_cl->fd, (struct sockaddr *)&sa, sizeof(sa)) == -1) {
+		int err = errno;
+		close(a_cl->fd);
+		a_cl->fd = -1;
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+void pidd_disconnect(piddClient_t *a_cl)
+{
+	if (a_cl->fd != -1) {
+		close(a_cl->fd);
+		a_cl->fd = -1;
+	}
+}
+
+int pidd_flush(piddClient_t *a_cl)
+{
+	size_t done = 0;
+
+	while (done < a_cl->olen) {
+		ssize_t ret = send(a_cl->fd, a_cl->obuf + done, a_cl->olen - done, MSG_NOSIGNAL);
+		if (ret == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		done += ret;
+	}
+	a_cl->olen = 0;
+	return 0;
+}
+
+int pidd_send(piddClient_t *a_cl, piddReq_t *a_req, const piddItem_t *a_items)
+{
+	size_t itemLen = 0;
+
+	if (a_req->op == ePiddGetBatch || a_req->op == ePiddSetBatch) {
+		itemLen = a_req->num * sizeof(piddItem_t);
+	}
+	if (a_cl->olen + sizeof(*a_req) + itemLen > sizeof(a_cl->obuf)) {
+		if (pidd_flush(a_cl) == -1) {
+			return -1;
+		}
+	}
+	a_req->seq = a_cl->seq++;
+	memcpy(a_cl->obuf + a_cl->olen, a_req, sizeof(*a_req));
+	a_cl->olen += sizeof(*a_req);
+	if (itemLen) {
+		memcpy(a_cl->obuf + a_cl->olen, a_items, itemLen);
+		a_cl->olen += itemLen;
+	}
+	return 0;
+}
+
+/* copy a_len bytes from the receive buffer, refilling it as needed */
+static int recv_full(piddClient_t *a_cl, void *a_dst, size_t a_len)
+{
+	uint8_t *dst = a_dst;
+
+	while (a_len) {
+		if (a_cl->pos == a_cl->len) {
+			ssize_t ret = recv(a_cl->fd, a_cl->buf, sizeof(a_cl->buf), 0);
+			if (ret == -1 && errno == EINTR) {
+				continue;
+			}
+			if (ret <= 0) {
+				if (ret == 0) {
+					errno = ECONNRESET;
+				}
+				return -1;
+			}
+			a_cl->pos = 0;
+			a_cl->len = ret;
+		}
+		size_t n = a_cl->len - a_cl->pos;
+		if (n > a_len) {
+			n = a_len;
+		}
+		if (dst) {
+			memcpy(dst, a_cl->buf + a_cl->pos, n);
+			dst += n;
+		}
+		a_cl->pos += n;
+		a_len -= n;
+	}
+	return 0;
+}
+
+int pidd_recv(piddClient_t *a_cl, piddResp_t *a_resp, int32_t *a_vals, uint32_t a_max)
+{
+	if (a_cl->olen && pidd_flush(a_cl) == -1) {
+		return -1;
+	}
+	if (recv_full(a_cl, a_resp, sizeof(*a_resp)) == -1) {
+		return -1;
+	}
+	uint32_t keep = (a_resp->num < a_max) ? a_resp->num : a_max;
+	if (recv_full(a_cl, a_vals, keep * sizeof(int32_t)) == -1) {
+		return -1;
+	}
+	// drop what does not fit
+	return recv_full(a_cl, NULL, (a_resp->num - keep) * sizeof(int32_t));
+}
+
+static int call(piddClient_t *a_cl, piddReq_t *a_req, const piddItem_t *a_items, int32_t *a_vals, uint32_t a_max)
+{
+	piddResp_t resp;
+
+	if (pidd_send(a_cl, a_req, a_items) == -1 || pidd_recv(a_cl, &resp, a_vals, a_max) == -1) {
+		return -errno;
+	}
+	return resp.status;
+}
+
+int pidd_get(piddClient_t *a_cl, int a_ch, pidPar_t a_par, int32_t *a_val)
+{
+	piddReq_t req = { .op = ePiddGet, .ch = a_ch, .par = a_par };
+	return call(a_cl, &req, NULL, a_val, 1);
+}
+
+int pidd_set(piddClient_t *a_cl, int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	piddReq_t req = { .op = ePiddSet, .ch = a_ch, .par = a_par, .val = a_val };
+	return call(a_cl, &req, NULL, NULL, 0);
+}
+
+int pidd_get_batch(piddClient_t *a_cl, int a_num, piddItem_t *a_items)
+{
+	piddReq_t req = { .op = ePiddGetBatch, .num = a_num };
+	int32_t vals[PIDD_BATCH_MAX];
+	int ret;
+
+	if (a_num > PIDD_BATCH_MAX) {
+		return -EINVAL;
+	}
+	ret = call(a_cl, &req, a_items, vals, a_num);
+	for (int i = 0; ret == 0 && i < a_num; ++i) {
+		a_items[i].val = vals[i];
+	}
+	return ret;
+}
+
+int pidd_set_batch(piddClient_t *a_cl, int a_num, const piddItem_t *a_items)
+{
+	piddReq_t req = { .op = ePiddSetBatch, .num = a_num };
+
+	if (a_num > PIDD_BATCH_MAX) {
+		return -EINVAL;
+	}
+	return call(a_cl, &req, a_items, NULL, 0);
+}
+
+int pidd_ams(piddClient_t *a_cl, amsReg_t *a_ams)
+{
+	piddReq_t req = { .op = ePiddAms };
+	return call(a_cl, &req, NULL, (int32_t *)a_ams, sizeof(*a_ams) / sizeof(int32_t));
+}
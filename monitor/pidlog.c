@@ -0,0 +1,244 @@
+/**
+ * @brief Continuous telemetry logger.
+ *
+ * Samples the setpoint, error and output of all PID channels and the AMS
+ * housekeeping values (temperature, supply rails, AI0-AI4) at a fixed rate
+ * and stores them in a memory-mapped ring file (see ringlog.h). The file
+ * is preallocated and mapped once, rows go straight into the mapping and
+ * are published in batches, so the logger does no system calls per row
+ * beyond the register reads and the sleep.
+ *
+ * Usage: pidlog [-b backend] [-r rate_hz] [-d decimation] [-n block_rows] [-s size_MB] [-a] file
+ *
+ * -b  register backend, default $RP_BACKEND or /dev/mem
+ * -r  sample rate in Hz, default 1000
+ * -d  store the mean of every N samples, default 1
+ * -n  rows per block, default 1024
+ * -s  ring file size in MB, default 64
+ * -a  append to an existing ring file instead of creating a new one
+ *
+ * Read the ring back with pidlog_read.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+#include "version.h"
+#include "rp_regs.h"
+#include "monitor_io.h"
+#include "ringlog.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+/* setpoint, error and output of every channel, then the AMS values */
+#define COL_SP   0
+#define COL_ERR  (COL_SP + RP_PID_NUM)
+#define COL_OUT  (COL_ERR + RP_PID_NUM)
+#define COL_AMS  (COL_OUT + RP_PID_NUM)
+#define AMS_NUM  12
+#define COL_NUM  (COL_AMS + AMS_NUM)
+
+/* published at least every COMMIT_ROWS rows and COMMIT_NS nanoseconds */
+#define COMMIT_ROWS 64
+#define COMMIT_NS   100000000LL
+
+static const char *pidName[RP_PID_NUM] = {
+	"11", "12", "21", "22", "aa", "bb", "cc", "dd"
+};
+
+static const ams_t amsCol[AMS_NUM] = {
+	eAmsTemp, eAmsVCCPINT, eAmsVCCPAUX, eAmsVCCBRAM, eAmsVCCINT, eAmsVCCAUX, eAmsVCCDDR,
+	eAmsAI0, eAmsAI1, eAmsAI2, eAmsAI3, eAmsAI4
+};
+
+static const char *amsName[AMS_NUM] = {
+	"temp", "vccpint", "vccpaux", "vccbram", "vccint", "vccaux", "vccddr",
+	"ai0", "ai1", "ai2", "ai3", "ai4"
+};
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int a_sig)
+{
+	running = 0;
+}
+
+static int64_t ns(const struct timespec *a_t)
+{
+	return (int64_t)a_t->tv_sec * 1000000000LL + a_t->tv_nsec;
+}
+
+/* one raw sample of all columns */
+static void sample(rpRegs_t *a_regs, int64_t *a_sum)
+{
+	volatile amsReg_t *ams = a_regs->ams;
+	pidTlm_t tlm[RP_PID_NUM];
+
+	rp_pid_status(a_regs, tlm);
+	for (int i = 0; i < RP_PID_NUM; ++i) {
+		a_sum[COL_SP + i] += rp_pid_get(a_regs, i, ePidSp);
+		a_sum[COL_ERR + i] += tlm[i].err;
+		a_sum[COL_OUT + i] += tlm[i].out;
+	}
+	a_sum[COL_AMS + 0] += ams->temp;
+	a_sum[COL_AMS + 1] += ams->vccPint;
+	a_sum[COL_AMS + 2] += ams->vccPaux;
+	a_sum[COL_AMS + 3] += ams->vccBram;
+	a_sum[COL_AMS + 4] += ams->vccInt;
+	a_sum[COL_AMS + 5] += ams->vccAux;
+	a_sum[COL_AMS + 6] += ams->vccDddr;
+	for (int i = 0; i < 5; ++i) {
+		a_sum[COL_AMS + 7 + i] += ams->aif[i];
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *spec = NULL;
+	double rate = 1000;
+	long dec = 1;
+	long blockRows = 1024;
+	long sizeMb = 64;
+	int append = 0;
+	rpLog_t log;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:r:d:n:s:a")) != -1) {
+		switch (opt) {
+			case 'b':
+				spec = optarg;
+				break;
+			case 'r':
+				rate = strtod(optarg, 0);
+				break;
+			case 'd':
+				dec = strtol(optarg, 0, 0);
+				break;
+			case 'n':
+				blockRows = strtol(optarg, 0, 0);
+				break;
+			case 's':
+				sizeMb = strtol(optarg, 0, 0);
+				break;
+			case 'a':
+				append = 1;
+				break;
+			default:
+				goto usage;
+		}
+	}
+	if (optind != argc - 1 || rate <= 0 || rate > 1e6 || dec < 1 || blockRows < 1 || sizeMb < 1) {
+		goto usage;
+	}
+
+	if (append) {
+		if (rp_log_open(&log, argv[optind], 1) == -1) FATAL;
+		if (log.hdr->colNum != COL_NUM) {
+			fprintf(stderr, "%s: %s holds %u columns, expected %d\n", argv[0], argv[optind],
+			        log.hdr->colNum, COL_NUM);
+			return EXIT_FAILURE;
+		}
+	} else {
+		const char *names[COL_NUM];
+		char buf[COL_AMS][RP_LOG_NAME_LEN];
+		int8_t ams[COL_NUM];
+
+		for (int i = 0; i < RP_PID_NUM; ++i) {
+			snprintf(buf[COL_SP + i], RP_LOG_NAME_LEN, "sp%s", pidName[i]);
+			snprintf(buf[COL_ERR + i], RP_LOG_NAME_LEN, "err%s", pidName[i]);
+			snprintf(buf[COL_OUT + i], RP_LOG_NAME_LEN, "out%s", pidName[i]);
+		}
+		for (int i = 0; i < COL_NUM; ++i) {
+			names[i] = (i < COL_AMS) ? buf[i] : amsName[i - COL_AMS];
+			ams[i] = (i < COL_AMS) ? -1 : amsCol[i - COL_AMS];
+		}
+		uint32_t blockSize = sizeof(rpLogBlock_t) + blockRows * (sizeof(int64_t) + COL_NUM * sizeof(int32_t));
+		long blockNum = (sizeMb << 20) / blockSize;
+		if (blockNum < 2) {
+			fprintf(stderr, "%s: %ld MB hold less than two blocks of %ld rows\n", argv[0], sizeMb, blockRows);
+			return EXIT_FAILURE;
+		}
+		if (rp_log_create(&log, argv[optind], COL_NUM, names, ams, blockRows, blockNum, rate / dec) == -1) FATAL;
+	}
+	if (rp_open(&regs, spec) == -1) FATAL;
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	int64_t period = 1e9 / rate;
+	int64_t sum[COL_NUM];
+	int32_t row[COL_NUM];
+	struct timespec next, now;
+	int64_t tRow = 0, tCommit;
+	unsigned long rows = 0, overruns = 0;
+	long n = 0;
+
+	memset(sum, 0, sizeof(sum));
+	clock_gettime(CLOCK_REALTIME, &next);
+	tCommit = ns(&next);
+
+	while (running) {
+		clock_gettime(CLOCK_REALTIME, &now);
+		if (n == 0) {
+			tRow = ns(&now);
+		}
+		sample(&regs, sum);
+		if (++n == dec) {
+			for (int i = 0; i < COL_NUM; ++i) {
+				row[i] = sum[i] / dec;
+				sum[i] = 0;
+			}
+			rp_log_append(&log, tRow, row);
+			n = 0;
+			if (++rows % COMMIT_ROWS == 0 || ns(&now) - tCommit >= COMMIT_NS) {
+				rp_log_commit(&log);
+				tCommit = ns(&now);
+			}
+		}
+
+		// absolute schedule, a late sample does not shift the ones after it
+		next.tv_nsec += period;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			++next.tv_sec;
+		}
+		if (ns(&next) < ns(&now)) {
+			++overruns;
+			next = now;
+			continue;
+		}
+		clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &next, NULL);
+	}
+
+	rp_log_close(&log);
+	rp_close(&regs);
+	fprintf(stderr, "%s: %lu rows, %lu overruns\n", argv[0], rows, overruns);
+	return EXIT_SUCCESS;
+
+usage:
+	fprintf(stderr,
+		"%s version %s-%s\n"
+		"\nUsage: %s [-b backend] [-r rate_hz] [-d decimation] [-n block_rows] [-s size_MB] [-a] file\n"
+		"\n"
+		"\t-r  sample rate in Hz, default 1000\n"
+		"\t-d  store the mean of every N samples, default 1\n"
+		"\t-n  rows per block, default 1024\n"
+		"\t-s  ring file size in MB, default 64\n"
+		"\t-a  append to an existing ring file\n",
+		argv[0], VERSION_STR, REVISION_STR, argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+/**
+ * @brief Reader of the pidlog telemetry ring files.
+ *
+ * Prints a time window of a ring file (see ringlog.h) as tab separated
+ * values. The window is found with a binary search over the block time
+ * ranges, only the blocks it covers are read, and the file may be read
+ * while pidlog keeps writing it.
+ *
+ * Usage: pidlog_read [-s start] [-e end] [-c col,col,...] [-r] [-i] file
+ *
+ * -s, -e  window in seconds since the epoch; values <= 0 are relative to
+ *         the newest row, e.g. '-s -60' prints the last minute
+ * -c      columns to print, default all
+ * -r      print raw AMS counts instead of converted values
+ * -i      print the file layout and the time range held
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "version.h"
+#include "monitor_io.h"
+#include "ringlog.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+/* time of the newest published row, 0 if the ring is empty */
+static int64_t newest(const rpLog_t *a_log)
+{
+	uint64_t seq = a_log->hdr->seq;
+
+	for (uint64_t s = seq + 1; s-- > rp_log_first(a_log);) {
+		const rpLogBlock_t *blk = rp_log_block(a_log, s);
+		if (blk && __atomic_load_n(&blk->rows, __ATOMIC_ACQUIRE)) {
+			return blk->tLast;
+		}
+	}
+	return 0;
+}
+
+static int64_t oldest(const rpLog_t *a_log)
+{
+	uint64_t seq = a_log->hdr->seq;
+
+	for (uint64_t s = rp_log_first(a_log); s <= seq; ++s) {
+		const rpLogBlock_t *blk = rp_log_block(a_log, s);
+		if (blk && __atomic_load_n(&blk->rows, __ATOMIC_ACQUIRE)) {
+			return blk->tFirst;
+		}
+	}
+	return 0;
+}
+
+static int64_t to_ns(double a_sec, int64_t a_newest)
+{
+	return (a_sec <= 0) ? a_newest + (int64_t)(a_sec * 1e9) : (int64_t)(a_sec * 1e9);
+}
+
+static void info(const rpLog_t *a_log)
+{
+	const rpLogHeader_t *hdr = a_log->hdr;
+	int64_t t0 = oldest(a_log), t1 = newest(a_log);
+
+	printf("#Columns\t%u\n#BlockRows\t%u\n#Blocks\t%u\n#Rate\t%g\n#Block\t%llu\n",
+	       hdr->colNum, hdr->blockRows, hdr->blockNum, hdr->rate, (unsigned long long)hdr->seq);
+	printf("#First\t%lld.%09lld\n#Last\t%lld.%09lld\n",
+	       (long long)(t0 / 1000000000LL), (long long)(t0 % 1000000000LL),
+	       (long long)(t1 / 1000000000LL), (long long)(t1 % 1000000000LL));
+	for (uint32_t i = 0; i < hdr->colNum; ++i) {
+		printf("%u\t%s\n", i, hdr->colName[i]);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double start = NAN, end = NAN;
+	char *cols = NULL;
+	int raw = 0, showInfo = 0;
+	rpLog_t log;
+	int sel[RP_LOG_COL_MAX];
+	int selNum = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "s:e:c:ri")) != -1) {
+		switch (opt) {
+			case 's':
+				start = strtod(optarg, 0);
+				break;
+			case 'e':
+				end = strtod(optarg, 0);
+				break;
+			case 'c':
+				cols = optarg;
+				break;
+			case 'r':
+				raw = 1;
+				break;
+			case 'i':
+				showInfo = 1;
+				break;
+			default:
+				goto usage;
+		}
+	}
+	if (optind != argc - 1) {
+		goto usage;
+	}
+	if (rp_log_open(&log, argv[optind], 0) == -1) FATAL;
+	const rpLogHeader_t *hdr = log.hdr;
+
+	if (showInfo) {
+		info(&log);
+		rp_log_close(&log);
+		return EXIT_SUCCESS;
+	}
+
+	if (cols) {
+		for (char *tok = strtok(cols, ","); tok; tok = strtok(NULL, ",")) {
+			int c = rp_log_col_lookup(&log, tok);
+			if (c == -1 || selNum == RP_LOG_COL_MAX) {
+				fprintf(stderr, "%s: unknown column '%s'\n", argv[0], tok);
+				return EXIT_FAILURE;
+			}
+			sel[selNum++] = c;
+		}
+	} else {
+		for (uint32_t c = 0; c < hdr->colNum; ++c) {
+			sel[selNum++] = c;
+		}
+	}
+
+	int64_t tNew = newest(&log);
+	int64_t t0 = isnan(start) ? INT64_MIN : to_ns(start, tNew);
+	int64_t t1 = isnan(end) ? INT64_MAX : to_ns(end, tNew);
+
+	// one block is copied out and checked before it is printed
+	int64_t *time = malloc(hdr->blockRows * sizeof(int64_t));
+	int32_t *val = malloc((size_t)hdr->blockRows * selNum * sizeof(int32_t));
+	if (time == NULL || val == NULL) FATAL;
+
+	printf("#Time");
+	for (int i = 0; i < selNum; ++i) {
+		printf("\t%s", hdr->colName[sel[i]]);
+	}
+	printf("\n");
+
+	uint64_t last = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+	for (uint64_t s = rp_log_find(&log, t0); s <= last; ++s) {
+		const rpLogBlock_t *blk = rp_log_block(&log, s);
+		if (blk == NULL) {
+			continue;
+		}
+		uint32_t rows = __atomic_load_n(&blk->rows, __ATOMIC_ACQUIRE);
+		if (rows == 0 || blk->tFirst > t1) {
+			break;
+		}
+		memcpy(time, rp_log_times(&log, blk), rows * sizeof(int64_t));
+		for (int i = 0; i < selNum; ++i) {
+			memcpy(val + i * hdr->blockRows, rp_log_column(&log, blk, sel[i]), rows * sizeof(int32_t));
+		}
+		// the writer took the slot over while it was copied
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (rp_log_block(&log, s) == NULL) {
+			continue;
+		}
+
+		for (uint32_t r = 0; r < rows; ++r) {
+			if (time[r] < t0 || time[r] > t1) {
+				continue;
+			}
+			printf("%lld.%09lld", (long long)(time[r] / 1000000000LL), (long long)(time[r] % 1000000000LL));
+			for (int i = 0; i < selNum; ++i) {
+				int32_t v = val[i * hdr->blockRows + r];
+				int8_t ams = hdr->colAms[sel[i]];
+				if (ams >= 0 && !raw) {
+					printf("\t%.3f", AmsConversion(ams, v));
+				} else {
+					printf("\t%d", v);
+				}
+			}
+			printf("\n");
+		}
+	}
+
+	free(time);
+	free(val);
+	rp_log_close(&log);
+	return EXIT_SUCCESS;
+
+usage:
+	fprintf(stderr,
+		"%s version %s-%s\n"
+		"\nUsage: %s [-s start] [-e end] [-c col,col,...] [-r] [-i] file\n"
+		"\n"
+		"\t-s, -e  window in seconds since the epoch, <= 0 relative to the newest row\n"
+		"\t-c      columns to print, default all\n"
+		"\t-r      raw AMS counts\n"
+		"\t-i      file layout and time range\n",
+		argv[0], VERSION_STR, REVISION_STR, argv[0]);
+	return EXIT_FAILURE;
+}
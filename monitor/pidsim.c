@@ -0,0 +1,425 @@
+/**
+ * @brief Register simulator for off-board runs.
+ *
+ * Serves a shared memory (or file) register image in place of the FPGA:
+ * it keeps applying the register widths and pending commits, so plain
+ * writes from any tool (monitor -, raw pidd writes) read back as they
+ * would on the board.
+ *
+ * With -P a channel is closed over a simulated first order plus dead time
+ * plant: the PID block is modelled from its registers, the plant output is
+ * fed back as the channel input, the telemetry follows the loop and
+ * captures and loop analyzer points of the channel record it. Simulated
+ * time runs with the sync period and jumps ahead by the capture window
+ * when a capture is armed, or by the settling and accumulation time of a
+ * started analyzer point.
+ *
+ * Usage: pidsim [-b backend] [-p period_us] [-r] [-P ch,K,tau,theta[,y0]] ...
+ *
+ * -b  register image to serve, default shm:/rp_regs
+ * -p  sync period in microseconds, default 100
+ * -r  load the FPGA reset values on start
+ * -P  plant on channel 1-8: input counts per output count, time constant
+ *     and dead time in seconds, input with zero output (default 0)
+ *
+ * Point the tools at the same image, e.g. RP_BACKEND=shm:/rp_regs monitor -ams
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <math.h>
+
+#include "version.h"
+#include "rp_regs.h"
+#include "capture.h"
+#include "bode.h"
+#include "deriv.h"
+
+#define FATAL do { fprintf(stderr, "Error at line %d, file %s (%d) [%s]\n", \
+  __LINE__, __FILE__, errno, strerror(errno)); exit(1); } while(0)
+
+/* slots of the dead time line */
+#define DELAY_NUM 512
+/* integration steps per plant time constant, and at most per capture sample */
+#define STEPS_TAU    32
+#define STEPS_SAMPLE 64
+/* integration steps per analyzer excitation period, at least */
+#define STEPS_PERIOD 64
+
+/* channel registers, sign extended and with the hardware defaults applied */
+typedef struct {
+	int width;
+	int frac;                    // gain bits of the block below the set point resolution
+	int32_t sp, kp, ki, kd;
+	int irst;
+	int psr, isr, dsr;
+	uint32_t icd;
+	int32_t tol;
+} loopPar_t;
+
+typedef struct {
+	int ch;
+	double k, tau, theta, y0;    // tau and theta in clocks
+	double y;                    // plant output less y0
+	double t;                    // simulated clock cycles
+	double dly[DELAY_NUM];
+	double dlyStep;              // clock cycles per slot
+	int64_t dlyLast;             // last slot written
+	/* PID block */
+	int64_t integ;
+	double icnt;                 // integrator updates due
+	int64_t kdPrev;
+	int32_t adc, err, p, i, d, out;
+	int32_t excSp, excOut;       // loop analyzer excitation of the set point and output
+	uint32_t sat;                // sticky RP_PID_TLM_* flags
+	uint32_t snap;               // snapshot count the flags were cleared at
+} plant_t;
+
+static volatile sig_atomic_t running = 1;
+
+static void on_signal(int a_sig)
+{
+	running = 0;
+}
+
+static int32_t sign_extend(uint32_t a_raw, int a_width)
+{
+	a_raw &= (1UL << a_width) - 1;
+	return (a_raw >> (a_width - 1)) ? (int32_t)a_raw - (1L << a_width) : (int32_t)a_raw;
+}
+
+static int16_t sat16(int64_t a_val)
+{
+	return (a_val > 32767) ? 32767 : (a_val < -32768) ? -32768 : a_val;
+}
+
+static void load_loop(const rpRegs_t *a_regs, int a_ch, loopPar_t *a_par)
+{
+	int gw = rp_pid_width(a_ch, ePidKp);
+
+	a_par->width = rp_pid_width(a_ch, ePidSp);
+	a_par->frac = rp_fine_bits(a_ch);
+	// without fine gains the registers hold the upper bits of the block gains
+	int32_t scale = 1L << (a_par->width + a_par->frac - gw);
+	a_par->sp = sign_extend(rp_pid_read_raw(a_regs, a_ch, ePidSp), a_par->width);
+	a_par->kp = sign_extend(rp_pid_read_raw(a_regs, a_ch, ePidKp), gw) * scale;
+	a_par->ki = sign_extend(rp_pid_read_raw(a_regs, a_ch, ePidKi), gw) * scale;
+	a_par->kd = sign_extend(rp_pid_read_raw(a_regs, a_ch, ePidKd), gw) * scale;
+	a_par->irst = rp_pid_read_raw(a_regs, a_ch, ePidIrst) & 1;
+	// out of range shifts fall back to the default case of red_pitaya_pid_block.v
+	a_par->psr = rp_pid_read_raw(a_regs, a_ch, ePidPSR);
+	a_par->psr = (a_par->psr >= 5 && a_par->psr <= 15) ? a_par->psr : 12;
+	a_par->isr = rp_pid_read_raw(a_regs, a_ch, ePidISR);
+	a_par->isr = (a_par->isr >= 14 && a_par->isr <= 24) ? a_par->isr : 18;
+	a_par->dsr = rp_pid_read_raw(a_regs, a_ch, ePidDSR);
+	a_par->dsr = (a_par->dsr >= 3 && a_par->dsr <= 13) ? a_par->dsr : 10;
+	a_par->icd = rp_pid_read_raw(a_regs, a_ch, ePidICD);
+	a_par->tol = rp_pid_read_raw(a_regs, a_ch, ePidTol);
+}
+
+static double delay(plant_t *a_pl, double a_u)
+{
+	int64_t slot = floor(a_pl->t / a_pl->dlyStep);
+
+	if (slot - a_pl->dlyLast > DELAY_NUM) {
+		a_pl->dlyLast = slot - DELAY_NUM;
+	}
+	for (int64_t s = a_pl->dlyLast + 1; s <= slot; ++s) {
+		a_pl->dly[s % DELAY_NUM] = a_u;
+	}
+	a_pl->dlyLast = slot;
+
+	int64_t read = floor((a_pl->t - a_pl->theta) / a_pl->dlyStep);
+	return (read < 0) ? 0 : a_pl->dly[read % DELAY_NUM];
+}
+
+/* advances the loop by a_h clock cycles */
+static void step(plant_t *a_pl, const loopPar_t *a_par, double a_h)
+{
+	int32_t max = (1L << (a_par->width - 1)) - 1;
+	int32_t min = -max - 1;
+	double in = round(a_pl->y0 + a_pl->y);
+
+	int32_t sp = a_par->sp + a_pl->excSp;
+
+	a_pl->adc = (in > max) ? max : (in < min) ? min : in;
+	sp = (sp > max) ? max : (sp < min) ? min : sp;
+	a_pl->err = sp - a_pl->adc;
+	if (abs(a_pl->err) < a_par->tol) {
+		a_pl->err = 0;
+	}
+
+	a_pl->p = ((int64_t)a_pl->err * a_par->kp) >> (a_par->psr + a_par->frac);
+
+	if (a_par->irst) {
+		a_pl->integ = 0;
+		a_pl->icnt = 0;
+	} else {
+		a_pl->icnt += a_h / (a_par->icd + 1.0);
+		int64_t num = floor(a_pl->icnt);
+		a_pl->icnt -= num;
+		a_pl->integ += num * a_pl->err * a_par->ki;
+		// the integrator is 32 bits plus the fractional gain bits wide
+		int64_t imax = ((int64_t)INT32_MAX << a_par->frac) | ((1LL << a_par->frac) - 1);
+		if (a_pl->integ > imax || a_pl->integ < -imax - 1) {
+			a_pl->integ = (a_pl->integ > 0) ? imax : -imax - 1;
+			a_pl->sat |= RP_PID_TLM_INT_SAT;
+		}
+	}
+	a_pl->i = a_pl->integ >> (a_par->isr + a_par->frac);
+
+	// the derivative is a one clock difference, spread over the step
+	int64_t kd = ((int64_t)a_pl->err * a_par->kd) >> (a_par->dsr + a_par->frac);
+	a_pl->d = (kd - a_pl->kdPrev) / a_h;
+	a_pl->kdPrev = kd;
+
+	int64_t sum = (int64_t)a_pl->p + a_pl->i + a_pl->d;
+	a_pl->out = (sum > max) ? max : (sum < min) ? min : sum;
+	if (a_pl->out != sum) {
+		a_pl->sat |= RP_PID_TLM_OUT_SAT;
+	}
+
+	// output injection adds to the DAC value
+	int32_t dac = a_pl->out + a_pl->excOut;
+	double u = delay(a_pl, (dac > max) ? max : (dac < min) ? min : dac);
+	a_pl->y += (1 - exp(-a_h / a_pl->tau)) * (a_pl->k * u - a_pl->y);
+	a_pl->t += a_h;
+}
+
+/* longest step that still follows the plant */
+static double step_max(const plant_t *a_pl)
+{
+	double h = (a_pl->theta > 0 && a_pl->theta < a_pl->tau) ? a_pl->theta : a_pl->tau;
+
+	h /= STEPS_TAU;
+	return (h < 1) ? 1 : h;
+}
+
+static void run(plant_t *a_pl, const loopPar_t *a_par, double a_clocks)
+{
+	int steps = ceil(a_clocks / step_max(a_pl));
+
+	steps = (steps < 1) ? 1 : (steps > 1024) ? 1024 : steps;
+	for (int i = 0; i < steps; ++i) {
+		step(a_pl, a_par, a_clocks / steps);
+	}
+}
+
+/* records an armed capture of the plant channel, triggered at once */
+static void capture(rpRegs_t *a_regs, plant_t *a_pl, const loopPar_t *a_par)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	uint32_t ctrl = pid[RP_CAP_CTRL >> 2];
+	uint32_t src = pid[RP_CAP_SRC >> 2];
+	uint32_t dec = pid[RP_CAP_DEC >> 2];
+	uint32_t num = pid[RP_CAP_PRE >> 2] + pid[RP_CAP_POST >> 2];
+	int sigA = (src >> 4) & 0x7;
+	int sigB = (src >> 8) & 0x7;
+
+	volatile uint32_t *buf = rp_map_block(a_regs, RP_ADDR_PID + RP_CAP_BUF, RP_CAP_DEPTH * sizeof(uint32_t));
+	if (buf == NULL) {
+		return;
+	}
+	dec = dec ? dec : 1;
+	int steps = ceil(dec / step_max(a_pl));
+	steps = (steps > STEPS_SAMPLE) ? STEPS_SAMPLE : steps;
+	pid[RP_CAP_TIME >> 2] = (uint64_t)a_pl->t;
+	pid[(RP_CAP_TIME + 4) >> 2] = (uint64_t)a_pl->t >> 32;
+
+	for (uint32_t n = 0; n < num && n < RP_CAP_DEPTH; ++n) {
+		for (int i = 0; i < steps; ++i) {
+			step(a_pl, a_par, (double)dec / steps);
+		}
+		int64_t val[eCapSigNum] = {
+			a_pl->adc, a_pl->err, a_pl->p, a_pl->i, a_pl->d, a_pl->out, a_pl->integ >> (16 + a_par->frac)
+		};
+		uint16_t a = (sigA < eCapSigNum) ? sat16(val[sigA]) : 0;
+		uint16_t b = (sigB < eCapSigNum) ? sat16(val[sigB]) : 0;
+		buf[n] = ((uint32_t)b << 16) | a;
+	}
+	pid[RP_CAP_START >> 2] = 0;
+	__atomic_compare_exchange_n(&pid[RP_CAP_CTRL >> 2], &ctrl, RP_CAP_TRIGGERED | RP_CAP_DONE, 0,
+	                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/* measures a started analyzer point of the plant channel */
+static void bode(rpRegs_t *a_regs, plant_t *a_pl, const loopPar_t *a_par)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	uint32_t ctrl = pid[RP_BODE_CTRL >> 2];
+	uint32_t src = pid[RP_BODE_SRC >> 2];
+	int inj = (src >> 4) & 0x3;
+	int sigA = (src >> 8) & 0x7;
+	int sigB = (src >> 12) & 0x7;
+	double fw = pid[RP_BODE_FREQ >> 2];
+	int32_t amp = pid[RP_BODE_AMP >> 2] & 0x7fff;
+	double len = pid[RP_BODE_LEN >> 2];
+	double acc[4] = { 0, 0, 0, 0 };
+	double clk = 0;
+
+	// the synthesizer phase is held over a step, so keep the steps short
+	double h = step_max(a_pl);
+	if (fw > 0) {
+		h = fmax(1, fmin(h, 4294967296.0 / fw / STEPS_PERIOD));
+	}
+	for (int part = 0; part < 2; ++part) {
+		double clocks = part ? len : pid[RP_BODE_SETTLE >> 2];
+		int64_t steps = ceil(clocks / h);
+		for (int64_t n = 0; n < steps; ++n) {
+			double ph = 2 * M_PI * fmod(fw * clk, 4294967296.0) / 4294967296.0;
+			int32_t sn = round(RP_BODE_SINE * sin(ph));
+			int32_t cs = round(RP_BODE_SINE * cos(ph));
+			int32_t exc = (sn * amp) >> 15;
+			a_pl->excSp = (inj == eBodeInjSp) ? exc : 0;
+			a_pl->excOut = (inj == eBodeInjOut) ? exc : 0;
+			step(a_pl, a_par, clocks / steps);
+			clk += clocks / steps;
+			if (part) {
+				// the loop signals of the start of the step, as the excitation
+				int64_t val[RP_BODE_SIG_NUM] = {
+					a_pl->adc, a_pl->err, a_pl->p, a_pl->i, a_pl->d, a_pl->out, a_pl->integ >> (16 + a_par->frac), exc
+				};
+				int16_t a = sat16(val[sigA]);
+				int16_t b = sat16(val[sigB]);
+				double w = clocks / steps;
+				acc[0] += a * sn * w;
+				acc[1] += a * cs * w;
+				acc[2] += b * sn * w;
+				acc[3] += b * cs * w;
+			}
+		}
+	}
+	a_pl->excSp = 0;
+	a_pl->excOut = 0;
+
+	for (int n = 0; n < 4; ++n) {
+		int64_t val = llround(acc[n]);
+		pid[(RP_BODE_ACC >> 2) + 2 * n] = val;
+		pid[(RP_BODE_ACC >> 2) + 2 * n + 1] = (uint64_t)val >> 32;
+	}
+	pid[RP_BODE_COUNT >> 2] = len;
+	__atomic_compare_exchange_n(&pid[RP_BODE_CTRL >> 2], &ctrl, RP_BODE_DONE | RP_BODE_EXC, 0,
+	                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static void telemetry(rpRegs_t *a_regs, plant_t *a_pl, const loopPar_t *a_par)
+{
+	volatile uint32_t *tlm = &a_regs->pid[(RP_PID_TLM_BASE + a_pl->ch * RP_PID_TLM_STRIDE) >> 2];
+	uint32_t snap = a_regs->pid[RP_PID_TLM_TRIG >> 2];
+
+	tlm[0] = a_pl->err;
+	tlm[1] = (int32_t)(a_pl->integ >> a_par->frac);  // upper 32 bits, as red_pitaya_pid_block.v
+	tlm[2] = a_pl->p;
+	tlm[3] = a_pl->i;
+	tlm[4] = a_pl->d;
+	tlm[5] = a_pl->out;
+	tlm[6] = a_pl->sat;
+	// a snapshot clears the sticky flags
+	if (snap != a_pl->snap) {
+		a_pl->sat = 0;
+		a_pl->snap = snap;
+	}
+}
+
+static void simulate(rpRegs_t *a_regs, plant_t *a_pl, int a_num, long a_period)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	loopPar_t par;
+
+	for (int n = 0; n < a_num; ++n) {
+		load_loop(a_regs, a_pl[n].ch, &par);
+		if ((pid[RP_CAP_CTRL >> 2] & RP_CAP_ARM) && (pid[RP_CAP_SRC >> 2] & 0x7) == a_pl[n].ch) {
+			capture(a_regs, &a_pl[n], &par);
+		} else if ((pid[RP_BODE_CTRL >> 2] & RP_BODE_START) && (pid[RP_BODE_SRC >> 2] & 0x7) == a_pl[n].ch) {
+			bode(a_regs, &a_pl[n], &par);
+		} else {
+			run(&a_pl[n], &par, a_period * (RP_PID_CLOCK / 1e6));
+		}
+		telemetry(a_regs, &a_pl[n], &par);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *spec = RP_SHM_DEFAULT;
+	long period = 100;
+	int reset = 0;
+	rpRegs_t regs;
+	plant_t plant[RP_PID_NUM];
+	int plantNum = 0;
+	uint32_t mask = 0;
+	int opt;
+
+	memset(plant, 0, sizeof(plant));
+	while ((opt = getopt(argc, argv, "b:p:rP:")) != -1) {
+		switch (opt) {
+			case 'b':
+				spec = optarg;
+				break;
+			case 'p':
+				period = strtol(optarg, 0, 0);
+				break;
+			case 'r':
+				reset = 1;
+				break;
+			case 'P': {
+				plant_t *pl = &plant[plantNum];
+				int num = sscanf(optarg, "%d,%lf,%lf,%lf,%lf", &pl->ch, &pl->k, &pl->tau, &pl->theta, &pl->y0);
+				if (num < 4 || pl->ch < 1 || pl->ch > RP_PID_NUM || (mask >> (pl->ch - 1)) & 1 ||
+				    pl->tau <= 0 || pl->theta < 0) {
+					fprintf(stderr, "%s: invalid plant '%s'\n", argv[0], optarg);
+					return EXIT_FAILURE;
+				}
+				pl->ch -= 1;
+				pl->tau *= RP_PID_CLOCK;
+				pl->theta *= RP_PID_CLOCK;
+				pl->dlyStep = fmax(1, pl->theta / (DELAY_NUM - 8));
+				pl->dlyLast = -1;
+				mask |= 1UL << pl->ch;
+				++plantNum;
+				break;
+			}
+			default:
+				fprintf(stderr,
+					"%s version %s-%s\n"
+					"\nUsage: %s [-b backend] [-p period_us] [-r] [-P ch,K,tau,theta[,y0]] ...\n",
+					argv[0], VERSION_STR, REVISION_STR, argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (rp_open(&regs, spec) == -1) FATAL;
+	if (regs.backend == eRpDevMem) {
+		fprintf(stderr, "%s: refusing to simulate on %s\n", argv[0], spec);
+		return EXIT_FAILURE;
+	}
+	if (reset) {
+		rp_reset(&regs);
+	}
+	regs.pid[RP_SIM_PLANT >> 2] = mask;
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	while (running) {
+		rp_sync(&regs);
+		simulate(&regs, plant, plantNum, period);
+		usleep(period);
+	}
+
+	regs.pid[RP_SIM_PLANT >> 2] = 0;
+	rp_close(&regs);
+	return EXIT_SUCCESS;
+}
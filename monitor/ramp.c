@@ -0,0 +1,136 @@
+/**
+ * @brief Set point ramps of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+
+#include "ramp.h"
+#include "codec.h"
+
+int rp_ramp_check(const rampConfig_t *a_cfg)
+{
+	if (a_cfg->rate > RP_RAMP_RATE_MAX || a_cfg->div < 1 || a_cfg->div > RP_RAMP_DIV_MAX ||
+	    a_cfg->acc > RP_RAMP_ACC_MAX || (a_cfg->scurve != 0 && a_cfg->scurve != 1)) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+double rp_ramp_slew(const rampConfig_t *a_cfg)
+{
+	return a_cfg->rate * RP_PID_CLOCK / (a_cfg->div ? a_cfg->div : 1);
+}
+
+void rp_ramp_from_slew(rampConfig_t *a_cfg, double a_slew)
+{
+	double div = round(RP_PID_CLOCK / a_slew);
+
+	if (div >= 1) {
+		a_cfg->rate = 1;
+		a_cfg->div = (div > RP_RAMP_DIV_MAX) ? RP_RAMP_DIV_MAX : div;
+	} else {
+		double rate = round(a_slew / RP_PID_CLOCK);
+		a_cfg->rate = (rate > RP_RAMP_RATE_MAX) ? RP_RAMP_RATE_MAX : rate;
+		a_cfg->div = 1;
+	}
+}
+
+uint64_t rp_ramp_ticks(const rampConfig_t *a_cfg, int32_t a_from, int32_t a_to)
+{
+	// the registers of red_pitaya_pid_ramp.v, positions and steps in 1/256 counts
+	int64_t pos = (int64_t)a_from << RP_RAMP_FRAC;
+	int64_t tgt = (int64_t)a_to << RP_RAMP_FRAC;
+	int64_t vmax = (int64_t)a_cfg->rate << RP_RAMP_FRAC;
+	int64_t acc = a_cfg->acc ? a_cfg->acc : 1;
+	int64_t vel = 0, brk = 0;
+	uint64_t ticks = 0;
+
+	if (a_cfg->rate == 0) {
+		return 0;
+	}
+	while (pos != tgt) {
+		int64_t dist = llabs(tgt - pos);
+		int brake = dist <= brk;
+		int64_t next = brake ? ((vel > acc) ? vel - acc : acc) : (vel + acc >= vmax) ? vmax : vel + acc;
+		int64_t step = a_cfg->scurve ? next : vmax;
+
+		++ticks;
+		if (dist <= step) {
+			break;
+		}
+		pos += (tgt < pos) ? -step : step;
+		if (brake) {
+			brk = (brk > vel) ? brk - vel : 0;
+		} else if (next > vel) {
+			brk += next;
+		}
+		vel = step;
+	}
+	return ticks;
+}
+
+/* ramp registers of channel a_ch */
+static inline volatile uint32_t *ramp_regs(const rpRegs_t *a_regs, int a_ch)
+{
+	return &a_regs->pid[rpChan[a_ch].ramp >> 2];
+}
+
+void rp_ramp_set(rpRegs_t *a_regs, int a_ch, const rampConfig_t *a_cfg)
+{
+	volatile uint32_t *ramp = ramp_regs(a_regs, a_ch);
+
+	ramp[RP_RAMP_DIV >> 2]  = a_cfg->div - 1;
+	ramp[RP_RAMP_CFG >> 2]  = (a_cfg->acc << 16) | (a_cfg->scurve & 1);
+	ramp[RP_RAMP_RATE >> 2] = a_cfg->rate;
+	rp_sync(a_regs);
+}
+
+void rp_ramp_get(const rpRegs_t *a_regs, int a_ch, rampConfig_t *a_cfg)
+{
+	volatile uint32_t *ramp = ramp_regs(a_regs, a_ch);
+	uint32_t cfg = ramp[RP_RAMP_CFG >> 2];
+
+	a_cfg->rate = ramp[RP_RAMP_RATE >> 2] & RP_RAMP_RATE_MAX;
+	a_cfg->div = (ramp[RP_RAMP_DIV >> 2] & (RP_RAMP_DIV_MAX - 1)) + 1;
+	a_cfg->scurve = cfg & 1;
+	a_cfg->acc = cfg >> 16;
+}
+
+int32_t rp_ramp_setpoint(const rpRegs_t *a_regs, int a_ch)
+{
+	return rp_pid_decode(a_ch, ePidSp, ramp_regs(a_regs, a_ch)[RP_RAMP_SP >> 2]);
+}
+
+uint32_t rp_ramp_done(const rpRegs_t *a_regs)
+{
+	return a_regs->pid[RP_RAMP_DONE >> 2] & rp_pid_mask(0, rp_pid_num() - 1);
+}
+
+int rp_ramp_wait(const rpRegs_t *a_regs, uint32_t a_mask, int a_timeoutMs)
+{
+	struct timespec t0, t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while ((rp_ramp_done(a_regs) & a_mask) != a_mask) {
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if ((t.tv_sec - t0.tv_sec) * 1000 + (t.tv_nsec - t0.tv_nsec) / 1000000 >= a_timeoutMs) {
+			return -ETIMEDOUT;
+		}
+		usleep(100);
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @brief Set point ramps of the PID channels.
+ *
+ * Drives red_pitaya_pid_ramp.v: with a ramp configured, the set point
+ * register of a channel is a target the FPGA moves the loop set point to
+ * at a limited slew rate, linearly or with an S-curve profile. A set point
+ * change is then one register write (rp_pid_set_setpoint() or 'pid set'),
+ * and the done mask tells when every ramp has arrived.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef RAMP_H
+#define RAMP_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * registers in the PID window, see red_pitaya_pid_ramp.v: the block of
+ * channel n starts at rpChan[n].ramp (codec.h), RP_RAMP_BASE(n) on the
+ * default bitstream
+ */
+#define RP_RAMP_BASE(n)   (0x600 + 0x10 * (n))
+#define RP_RAMP_RATE      0x0
+#define RP_RAMP_DIV       0x4
+#define RP_RAMP_CFG       0x8
+#define RP_RAMP_SP        0xC
+#define RP_RAMP_DONE      0x680
+
+#define RP_RAMP_RATE_MAX  0xffff
+#define RP_RAMP_DIV_MAX   (1UL << 24)
+#define RP_RAMP_ACC_MAX   0xffff
+/* fractional bits of the ramp position and the S-curve acceleration */
+#define RP_RAMP_FRAC      8
+
+typedef struct {
+	uint32_t rate;    // counts per tick, 0 = no ramp
+	uint32_t div;     // clocks per tick, 1 - RP_RAMP_DIV_MAX
+	int scurve;       // S-curve profile instead of a constant rate
+	uint32_t acc;     // S-curve step increase per tick, 1/256 counts
+} rampConfig_t;
+
+/* 0 if a_cfg is valid, -ERANGE otherwise */
+int rp_ramp_check(const rampConfig_t *a_cfg);
+
+/*
+ * Slew rate of a_cfg in counts per second, and the rate and divider that
+ * come closest to a_slew counts per second (rate 1 while that allows it).
+ */
+double rp_ramp_slew(const rampConfig_t *a_cfg);
+void rp_ramp_from_slew(rampConfig_t *a_cfg, double a_slew);
+
+/*
+ * Ticks a ramp from a_from to a_to takes, with the algorithm of the FPGA
+ * (counts as the set point registers hold them, sign extended).
+ */
+uint64_t rp_ramp_ticks(const rampConfig_t *a_cfg, int32_t a_from, int32_t a_to);
+
+void rp_ramp_set(rpRegs_t *a_regs, int a_ch, const rampConfig_t *a_cfg);
+void rp_ramp_get(const rpRegs_t *a_regs, int a_ch, rampConfig_t *a_cfg);
+/* Set point the loop of channel a_ch runs with, in user units (see rp_pid_get()) */
+int32_t rp_ramp_setpoint(const rpRegs_t *a_regs, int a_ch);
+/* Channels whose set point is at the target, bit n = channel n */
+uint32_t rp_ramp_done(const rpRegs_t *a_regs);
+/* Waits until all channels of a_mask are done, 0 or -ETIMEDOUT */
+int rp_ramp_wait(const rpRegs_t *a_regs, uint32_t a_mask, int a_timeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RAMP_H */
@@ -0,0 +1,254 @@
+/**
+ * @brief Memory-mapped ring file of telemetry rows.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "ringlog.h"
+
+static uint8_t *slot(const rpLog_t *a_log, uint64_t a_seq)
+{
+	return a_log->base + a_log->hdr->headerSize + (a_seq % a_log->hdr->blockNum) * a_log->hdr->blockSize;
+}
+
+static int map(rpLog_t *a_log, int a_write)
+{
+	a_log->hdr = mmap(0, a_log->size, PROT_READ | (a_write ? PROT_WRITE : 0), MAP_SHARED, a_log->fd, 0);
+	if (a_log->hdr == MAP_FAILED) {
+		a_log->hdr = NULL;
+		return -1;
+	}
+	a_log->base = (uint8_t *)a_log->hdr;
+	return 0;
+}
+
+/* starts block a_seq: empty until the first commit */
+static void start_block(rpLog_t *a_log, uint64_t a_seq)
+{
+	rpLogBlock_t *blk = (rpLogBlock_t *)slot(a_log, a_seq);
+
+	// readers check the sequence number before and after they copy a block
+	__atomic_store_n(&blk->rows, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&blk->seq, a_seq, __ATOMIC_RELEASE);
+	__atomic_store_n(&a_log->hdr->seq, a_seq, __ATOMIC_RELEASE);
+	a_log->blk = blk;
+	a_log->rows = 0;
+}
+
+int rp_log_create(rpLog_t *a_log, const char *a_path, int a_colNum, const char *const *a_names,
+                  const int8_t *a_ams, uint32_t a_blockRows, uint32_t a_blockNum, double a_rate)
+{
+	memset(a_log, 0, sizeof(*a_log));
+	a_log->fd = -1;
+
+	if (a_colNum < 1 || a_colNum > RP_LOG_COL_MAX || a_blockRows < 1 || a_blockNum < 2) {
+		errno = EINVAL;
+		return -1;
+	}
+	uint32_t blockSize = sizeof(rpLogBlock_t) + a_blockRows * (sizeof(int64_t) + a_colNum * sizeof(int32_t));
+	a_log->size = sizeof(rpLogHeader_t) + (size_t)a_blockNum * blockSize;
+
+	a_log->fd = open(a_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (a_log->fd == -1) {
+		return -1;
+	}
+	// allocate all blocks now, a full disk must not end a run overnight
+	int err = posix_fallocate(a_log->fd, 0, a_log->size);
+	if (err || map(a_log, 1) == -1) {
+		err = err ? err : errno;
+		rp_log_close(a_log);
+		errno = err;
+		return -1;
+	}
+
+	rpLogHeader_t *hdr = a_log->hdr;
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, RP_LOG_MAGIC, sizeof(hdr->magic));
+	hdr->version = RP_LOG_VERSION;
+	hdr->headerSize = sizeof(rpLogHeader_t);
+	hdr->colNum = a_colNum;
+	hdr->blockRows = a_blockRows;
+	hdr->blockNum = a_blockNum;
+	hdr->blockSize = blockSize;
+	hdr->rate = a_rate;
+	for (int i = 0; i < RP_LOG_COL_MAX; ++i) {
+		if (i < a_colNum) {
+			strncpy(hdr->colName[i], a_names[i], RP_LOG_NAME_LEN - 1);
+		}
+		hdr->colAms[i] = (a_ams && i < a_colNum) ? a_ams[i] : -1;
+	}
+	// no block is valid yet: every slot holds a sequence number of another slot
+	for (uint32_t i = 0; i < a_blockNum; ++i) {
+		((rpLogBlock_t *)slot(a_log, i))->seq = i + 1;
+	}
+	start_block(a_log, 0);
+	return 0;
+}
+
+int rp_log_open(rpLog_t *a_log, const char *a_path, int a_write)
+{
+	struct stat st;
+
+	memset(a_log, 0, sizeof(*a_log));
+	a_log->fd = open(a_path, a_write ? O_RDWR : O_RDONLY);
+	if (a_log->fd == -1) {
+		return -1;
+	}
+	if (fstat(a_log->fd, &st) == -1) {
+		goto fail;
+	}
+	a_log->size = st.st_size;
+	if (a_log->size < sizeof(rpLogHeader_t)) {
+		errno = EINVAL;
+		goto fail;
+	}
+	if (map(a_log, a_write) == -1) {
+		goto fail;
+	}
+	rpLogHeader_t *hdr = a_log->hdr;
+	if (memcmp(hdr->magic, RP_LOG_MAGIC, sizeof(hdr->magic)) || hdr->version != RP_LOG_VERSION ||
+	    hdr->colNum < 1 || hdr->colNum > RP_LOG_COL_MAX || hdr->blockNum < 2 ||
+	    a_log->size < hdr->headerSize + (size_t)hdr->blockNum * hdr->blockSize) {
+		errno = EINVAL;
+		goto fail;
+	}
+	if (a_write) {
+		// continue in a fresh block, the last one may be cut short
+		start_block(a_log, hdr->seq + 1);
+	}
+	return 0;
+
+fail:
+	{
+		int err = errno;
+		rp_log_close(a_log);
+		errno = err;
+	}
+	return -1;
+}
+
+void rp_log_close(rpLog_t *a_log)
+{
+	if (a_log->hdr) {
+		if (a_log->blk) {
+			rp_log_commit(a_log);
+		}
+		munmap(a_log->hdr, a_log->size);
+	}
+	if (a_log->fd != -1) {
+		close(a_log->fd);
+	}
+	memset(a_log, 0, sizeof(*a_log));
+	a_log->fd = -1;
+}
+
+void rp_log_append(rpLog_t *a_log, int64_t a_time, const int32_t *a_vals)
+{
+	rpLogHeader_t *hdr = a_log->hdr;
+
+	if (a_log->rows == hdr->blockRows) {
+		rp_log_commit(a_log);
+		start_block(a_log, a_log->blk->seq + 1);
+	}
+
+	uint32_t row = a_log->rows++;
+	int64_t *time = (int64_t *)(a_log->blk + 1);
+	int32_t *col = (int32_t *)(time + hdr->blockRows);
+
+	time[row] = a_time;
+	for (uint32_t c = 0; c < hdr->colNum; ++c) {
+		col[c * hdr->blockRows + row] = a_vals[c];
+	}
+}
+
+void rp_log_commit(rpLog_t *a_log)
+{
+	rpLogBlock_t *blk = a_log->blk;
+
+	if (a_log->rows == blk->rows) {
+		return;
+	}
+	const int64_t *time = (const int64_t *)(blk + 1);
+	if (blk->rows == 0) {
+		blk->tFirst = time[0];
+	}
+	blk->tLast = time[a_log->rows - 1];
+	__atomic_store_n(&blk->rows, a_log->rows, __ATOMIC_RELEASE);
+}
+
+const rpLogBlock_t *rp_log_block(const rpLog_t *a_log, uint64_t a_seq)
+{
+	const rpLogBlock_t *blk = (const rpLogBlock_t *)slot(a_log, a_seq);
+
+	return (__atomic_load_n(&blk->seq, __ATOMIC_ACQUIRE) == a_seq) ? blk : NULL;
+}
+
+const int64_t *rp_log_times(const rpLog_t *a_log, const rpLogBlock_t *a_blk)
+{
+	return (const int64_t *)(a_blk + 1);
+}
+
+const int32_t *rp_log_column(const rpLog_t *a_log, const rpLogBlock_t *a_blk, int a_col)
+{
+	return (const int32_t *)(rp_log_times(a_log, a_blk) + a_log->hdr->blockRows) + a_col * a_log->hdr->blockRows;
+}
+
+uint64_t rp_log_first(const rpLog_t *a_log)
+{
+	uint64_t seq = __atomic_load_n(&a_log->hdr->seq, __ATOMIC_ACQUIRE);
+	uint64_t first = (seq + 1 > a_log->hdr->blockNum) ? seq + 1 - a_log->hdr->blockNum : 0;
+
+	// the oldest slot may already be reused by the writer
+	while (first < seq && rp_log_block(a_log, first) == NULL) {
+		++first;
+	}
+	return first;
+}
+
+uint64_t rp_log_find(const rpLog_t *a_log, int64_t a_time)
+{
+	uint64_t lo = rp_log_first(a_log);
+	uint64_t hi = __atomic_load_n(&a_log->hdr->seq, __ATOMIC_ACQUIRE);
+
+	// first block whose last row is at or after a_time; blocks are in time order
+	while (lo < hi) {
+		uint64_t mid = lo + (hi - lo) / 2;
+		const rpLogBlock_t *blk = rp_log_block(a_log, mid);
+		if (blk == NULL) {
+			// overwritten while searching, the window starts later
+			lo = mid + 1;
+		} else if (__atomic_load_n(&blk->rows, __ATOMIC_ACQUIRE) == 0 || blk->tLast < a_time) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+int rp_log_col_lookup(const rpLog_t *a_log, const char *a_name)
+{
+	for (uint32_t i = 0; i < a_log->hdr->colNum; ++i) {
+		if (strcasecmp(a_name, a_log->hdr->colName[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,100 @@
+/**
+ * @brief Memory-mapped ring file of telemetry rows.
+ *
+ * The file is preallocated and mapped once. After the header it holds a
+ * ring of blocks with a fixed number of rows each, stored column by column:
+ *
+ *   rpLogHeader_t | block 0 | block 1 | ... | block blockNum-1
+ *   block: rpLogBlock_t | int64_t time[blockRows] | int32_t col0[blockRows] | col1 ...
+ *
+ * Blocks are numbered with an ever increasing sequence number, block seq
+ * lives in slot seq % blockNum. The writer fills the rows of its current
+ * block in place and publishes them in batches by raising the row count of
+ * the block (rp_log_commit()), so readers never see a partial row. The time
+ * range in every block header lets a reader find a time window with a
+ * binary search over the ring instead of scanning the file.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef RINGLOG_H
+#define RINGLOG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RP_LOG_MAGIC    "RPLOG\0\0\0"
+#define RP_LOG_VERSION  1
+#define RP_LOG_COL_MAX  64
+#define RP_LOG_NAME_LEN 16
+
+typedef struct {
+	char magic[8];                             // RP_LOG_MAGIC
+	uint32_t version;                          // RP_LOG_VERSION
+	uint32_t headerSize;                       // offset of block 0
+	uint32_t colNum;
+	uint32_t blockRows;
+	uint32_t blockNum;
+	uint32_t blockSize;                        // bytes per block
+	double rate;                               // nominal rows per second
+	uint64_t seq;                              // block being written, blocks from seq - blockNum + 1 on are valid
+	char colName[RP_LOG_COL_MAX][RP_LOG_NAME_LEN];
+	int8_t colAms[RP_LOG_COL_MAX];             // AMS channel (ams_t) of a raw AMS column, else -1
+} rpLogHeader_t;
+
+typedef struct {
+	uint64_t seq;     // sequence number of the block held in the slot
+	uint32_t rows;    // published rows
+	uint32_t reserved;
+	int64_t tFirst;   // time of the first and the last published row,
+	int64_t tLast;    // ns since the epoch (CLOCK_REALTIME)
+} rpLogBlock_t;
+
+typedef struct {
+	int fd;
+	size_t size;
+	rpLogHeader_t *hdr;
+	uint8_t *base;
+	/* writer state */
+	rpLogBlock_t *blk;
+	uint32_t rows;
+} rpLog_t;
+
+/*
+ * Creates (or replaces) a_path with a ring of a_blockNum blocks of
+ * a_blockRows rows. Returns 0, -1 with errno set on failure.
+ */
+int rp_log_create(rpLog_t *a_log, const char *a_path, int a_colNum, const char *const *a_names,
+                  const int8_t *a_ams, uint32_t a_blockRows, uint32_t a_blockNum, double a_rate);
+/* Opens an existing ring, for appending (a new block) if a_write is set */
+int rp_log_open(rpLog_t *a_log, const char *a_path, int a_write);
+void rp_log_close(rpLog_t *a_log);
+
+/* Stores one row in the current block, published by the next rp_log_commit() */
+void rp_log_append(rpLog_t *a_log, int64_t a_time, const int32_t *a_vals);
+/* Publishes the rows appended so far */
+void rp_log_commit(rpLog_t *a_log);
+
+/* Block slot of sequence number a_seq, NULL if it is no longer (or not yet) held */
+const rpLogBlock_t *rp_log_block(const rpLog_t *a_log, uint64_t a_seq);
+const int64_t *rp_log_times(const rpLog_t *a_log, const rpLogBlock_t *a_blk);
+const int32_t *rp_log_column(const rpLog_t *a_log, const rpLogBlock_t *a_blk, int a_col);
+/* Oldest held block sequence number */
+uint64_t rp_log_first(const rpLog_t *a_log);
+/* Sequence number of the first block with rows at or after a_time (binary search) */
+uint64_t rp_log_find(const rpLog_t *a_log, int64_t a_time);
+/* Column by name, -1 if unknown */
+int rp_log_col_lookup(const rpLog_t *a_log, const char *a_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RINGLOG_H */
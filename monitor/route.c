@@ -0,0 +1,180 @@
+/**
+ * @brief Input and output routing of the PID channels.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "route.h"
+#include "info.h"
+
+static const char *srcName[RP_ROUTE_SRC_NUM] = {
+	"in1", "in2", "ai0", "ai1", "ai2", "ai3", "zero", "zero",
+	"pid1", "pid2", "pid3", "pid4", "pid5", "pid6", "pid7", "pid8"
+};
+
+static const char *outName[RP_ROUTE_OUT_NUM] = { "out1", "out2", "ao0", "ao1", "ao2", "ao3" };
+
+/* reset values of red_pitaya_pid_route.v */
+static const uint32_t IN_RESET[RP_ROUTE_CH_NUM] = { 0, 1, 0, 1, 2, 3, 4, 5 };
+static const uint32_t OUT_RESET[RP_ROUTE_OUT_NUM] = { 0x0005, 0x0050, 0x0100, 0x0400, 0x1000, 0x4000 };
+
+int rp_route_present(void)
+{
+	return (rp_info_features() & RP_INFO_ROUTE) != 0;
+}
+
+const char *rp_route_src_name(int a_src)
+{
+	return (a_src >= 0 && a_src < RP_ROUTE_SRC_NUM) ? srcName[a_src] : "?";
+}
+
+int rp_route_src_lookup(const char *a_name)
+{
+	for (int i = 0; i < RP_ROUTE_SRC_NUM; ++i) {
+		if (strcmp(a_name, srcName[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+const char *rp_route_out_name(int a_out)
+{
+	return (a_out >= 0 && a_out < RP_ROUTE_OUT_NUM) ? outName[a_out] : "?";
+}
+
+int rp_route_out_lookup(const char *a_name)
+{
+	for (int i = 0; i < RP_ROUTE_OUT_NUM; ++i) {
+		if (strcmp(a_name, outName[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+char *rp_route_sum_format(const routeOut_t *a_out, char *a_buf)
+{
+	char *p = a_buf;
+
+	for (int ch = 0; ch < RP_ROUTE_CH_NUM; ++ch) {
+		if (a_out->term[ch] != 0) {
+			p += sprintf(p, "%s%s", (a_out->term[ch] < 0) ? "-" : (p == a_buf) ? "" : "+",
+			             srcName[RP_ROUTE_SRC_PID(ch)]);
+		}
+	}
+	if (p == a_buf) {
+		strcpy(a_buf, "none");
+	}
+	return a_buf;
+}
+
+int rp_route_sum_parse(const char *a_str, routeOut_t *a_out)
+{
+	memset(a_out, 0, sizeof(*a_out));
+	if (strcmp(a_str, "none") == 0) {
+		return 0;
+	}
+	while (*a_str) {
+		int sign = 1;
+		int ch, len;
+
+		if (*a_str == '+' || *a_str == '-') {
+			sign = (*a_str++ == '-') ? -1 : 1;
+		}
+		if (sscanf(a_str, "pid%d%n", &ch, &len) != 1 || ch < 1 || ch > RP_ROUTE_CH_NUM ||
+		    a_out->term[ch - 1] != 0) {
+			return -EINVAL;
+		}
+		a_out->term[ch - 1] = sign;
+		a_str += len;
+		if (*a_str != '\0' && *a_str != '+' && *a_str != '-') {
+			return -EINVAL;
+		}
+	}
+	return 0;
+}
+
+int rp_route_set_in(rpRegs_t *a_regs, int a_ch, const routeIn_t *a_in)
+{
+	if (!rp_route_present()) {
+		return -ENODEV;
+	}
+	if (a_ch < 0 || a_ch >= RP_ROUTE_CH_NUM || a_in->in < 0 || a_in->in >= RP_ROUTE_SRC_NUM ||
+	    a_in->sp < RP_ROUTE_SP_REG || a_in->sp >= RP_ROUTE_SRC_NUM) {
+		return -ERANGE;
+	}
+	a_regs->pid[RP_ROUTE_IN(a_ch) >> 2] = a_in->in |
+		((a_in->sp == RP_ROUTE_SP_REG) ? 0 : (a_in->sp << 8) | RP_ROUTE_SP_SEL);
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_route_get_in(const rpRegs_t *a_regs, int a_ch, routeIn_t *a_in)
+{
+	if (!rp_route_present()) {
+		return -ENODEV;
+	}
+	if (a_ch < 0 || a_ch >= RP_ROUTE_CH_NUM) {
+		return -ERANGE;
+	}
+	uint32_t reg = a_regs->pid[RP_ROUTE_IN(a_ch) >> 2];
+
+	a_in->in = reg & 0xf;
+	a_in->sp = (reg & RP_ROUTE_SP_SEL) ? (reg >> 8) & 0xf : RP_ROUTE_SP_REG;
+	return 0;
+}
+
+int rp_route_set_out(rpRegs_t *a_regs, int a_out, const routeOut_t *a_sum)
+{
+	uint32_t reg = 0;
+
+	if (!rp_route_present()) {
+		return -ENODEV;
+	}
+	if (a_out < 0 || a_out >= RP_ROUTE_OUT_NUM) {
+		return -ERANGE;
+	}
+	for (int ch = 0; ch < RP_ROUTE_CH_NUM; ++ch) {
+		reg |= (a_sum->term[ch] > 0 ? 1 : a_sum->term[ch] < 0 ? 3 : 0) << (2 * ch);
+	}
+	a_regs->pid[RP_ROUTE_OUT(a_out) >> 2] = reg;
+	rp_sync(a_regs);
+	return 0;
+}
+
+int rp_route_get_out(const rpRegs_t *a_regs, int a_out, routeOut_t *a_sum)
+{
+	if (!rp_route_present()) {
+		return -ENODEV;
+	}
+	if (a_out < 0 || a_out >= RP_ROUTE_OUT_NUM) {
+		return -ERANGE;
+	}
+	uint32_t reg = a_regs->pid[RP_ROUTE_OUT(a_out) >> 2];
+
+	// 2 reads as no term, as in the FPGA
+	for (int ch = 0; ch < RP_ROUTE_CH_NUM; ++ch) {
+		uint32_t t = (reg >> (2 * ch)) & 3;
+		a_sum->term[ch] = (t == 1) ? 1 : (t == 3) ? -1 : 0;
+	}
+	return 0;
+}
+
+void rp_route_reset(rpRegs_t *a_regs)
+{
+	for (int ch = 0; ch < RP_ROUTE_CH_NUM; ++ch) {
+		a_regs->pid[RP_ROUTE_IN(ch) >> 2] = IN_RESET[ch];
+	}
+	for (int m = 0; m < RP_ROUTE_OUT_NUM; ++m) {
+		a_regs->pid[RP_ROUTE_OUT(m) >> 2] = OUT_RESET[m];
+	}
+}
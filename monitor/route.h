@@ -0,0 +1,81 @@
+/**
+ * @brief Input and output routing of the PID channels.
+ *
+ * Drives red_pitaya_pid_route.v: every channel takes its input, and
+ * optionally its set point, from a fast or slow ADC or from another
+ * channel's output, and every fast and slow DAC output is a signed sum of
+ * channel outputs. A slow loop can so set the set point of a fast one in
+ * the fabric, without a host in the cascade. Values cross between fast
+ * and slow channels at the same fraction of full scale.
+ *
+ * The reset values are the fixed wiring of the plain bitstream: 1 and 3 on
+ * in1, 2 and 4 on in2, 5 - 8 on ai0 - ai3; out1 = pid1 + pid2,
+ * out2 = pid3 + pid4 and ao0 - ao3 = pid5 - pid8.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* registers in the PID window, see red_pitaya_pid_route.v */
+#define RP_ROUTE_IN(n)      (0x800 + 0x4 * (n))
+#define RP_ROUTE_OUT(m)     (0x820 + 0x4 * (m))
+#define RP_ROUTE_SP_SEL     0x10000
+
+#define RP_ROUTE_CH_NUM     8           /* channels of the crossbar */
+#define RP_ROUTE_OUT_NUM    6           /* out1, out2, ao0 - ao3 */
+#define RP_ROUTE_SRC_NUM    16
+#define RP_ROUTE_SRC_ZERO   6
+#define RP_ROUTE_SRC_PID(n) (8 + (n))
+#define RP_ROUTE_SP_REG     (-1)        /* set point from its register */
+
+typedef struct {
+	int in;           // input source
+	int sp;           // set point source, RP_ROUTE_SP_REG for the register
+} routeIn_t;
+
+typedef struct {
+	int term[RP_ROUTE_CH_NUM];          // +1, -1 or 0 per channel
+} routeOut_t;
+
+/* 1 if the bitstream has the crossbar */
+int rp_route_present(void);
+
+/* Source and output names ("in1", "ai0", "pid3", "zero"; "out1", "ao2"), and back, -1 if unknown */
+const char *rp_route_src_name(int a_src);
+int rp_route_src_lookup(const char *a_name);
+const char *rp_route_out_name(int a_out);
+int rp_route_out_lookup(const char *a_name);
+
+/* Sum as "pid1+pid2-pid5" ("none" without terms), a_buf of at least 64 bytes */
+char *rp_route_sum_format(const routeOut_t *a_out, char *a_buf);
+/* 0, or -EINVAL for a malformed sum */
+int rp_route_sum_parse(const char *a_str, routeOut_t *a_out);
+
+/* -ENODEV without the crossbar, -ERANGE for a bad channel, output or source */
+int rp_route_set_in(rpRegs_t *a_regs, int a_ch, const routeIn_t *a_in);
+int rp_route_get_in(const rpRegs_t *a_regs, int a_ch, routeIn_t *a_in);
+int rp_route_set_out(rpRegs_t *a_regs, int a_out, const routeOut_t *a_sum);
+int rp_route_get_out(const rpRegs_t *a_regs, int a_out, routeOut_t *a_sum);
+
+/* Stand-in images only: writes the reset values */
+void rp_route_reset(rpRegs_t *a_regs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROUTE_H */
@@ -0,0 +1,707 @@
+/**
+ * @brief Persistent register access library for the Red Pitaya PID controller.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "rp_regs.h"
+#include "capture.h"
+#include "bode.h"
+#include "codec.h"
+#include "wave.h"
+#include "ramp.h"
+#include "info.h"
+#include "deriv.h"
+#include "route.h"
+#include "ff.h"
+#include "bank.h"
+
+// nominal AMS readings loaded into new images, see AmsConversion() in monitor.c
+static const uint32_t AMS_TEMP_RESET = 0xa19; // 45 C
+static const uint32_t AMS_AI4_RESET  = 0x68b; // 5.0 V
+static const uint32_t AMS_1V0_RESET  = 0x555;
+static const uint32_t AMS_1V5_RESET  = 0x800;
+static const uint32_t AMS_1V8_RESET  = 0x999;
+
+int64_t rp_offset(const rpRegs_t *a_regs, uint32_t a_addr)
+{
+	if (a_regs->backend == eRpDevMem) {
+		return a_addr;
+	}
+	// compact image: the three sections one after the other
+	switch (a_addr & ~(RP_SECTION_SIZE - 1)) {
+		case RP_ADDR_HK:  return 0 * RP_SECTION_SIZE + (a_addr & (RP_SECTION_SIZE - 1));
+		case RP_ADDR_AMS: return 1 * RP_SECTION_SIZE + (a_addr & (RP_SECTION_SIZE - 1));
+		case RP_ADDR_PID: return 2 * RP_SECTION_SIZE + (a_addr & (RP_SECTION_SIZE - 1));
+	}
+	return -1;
+}
+
+static void *map_window(const rpRegs_t *a_regs, uint32_t a_addr)
+{
+	int64_t offs = rp_offset(a_regs, a_addr & ~RP_MAP_MASK);
+	if (offs == -1) {
+		errno = ENXIO;
+		return NULL;
+	}
+	void *base = mmap(0, RP_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, a_regs->fd, offs);
+	return (base == MAP_FAILED) ? NULL : base;
+}
+
+static int open_backend(rpRegs_t *a_regs, const char *a_spec)
+{
+	char name[256];
+
+	if (strncmp(a_spec, "file:", 5) == 0) {
+		a_regs->backend = eRpFile;
+		return open(a_spec + 5, O_RDWR | O_CREAT, 0644);
+	}
+	if (strncmp(a_spec, "shm:", 4) == 0) {
+		a_regs->backend = eRpShm;
+		snprintf(name, sizeof(name), "%s%s", (a_spec[4] == '/') ? "" : "/", a_spec + 4);
+		return shm_open(name, O_RDWR | O_CREAT, 0644);
+	}
+	a_regs->backend = eRpDevMem;
+	return open(a_spec, O_RDWR | O_SYNC);
+}
+
+int rp_open(rpRegs_t *a_regs, const char *a_spec)
+{
+	struct stat st;
+	int fresh = 0;
+
+	memset(a_regs, 0, sizeof(*a_regs));
+
+	if (a_spec == NULL || *a_spec == '\0') {
+		a_spec = getenv(RP_ENV_BACKEND);
+	}
+	if (a_spec == NULL || *a_spec == '\0') {
+		a_spec = RP_DEV_MEM;
+	}
+
+	a_regs->fd = open_backend(a_regs, a_spec);
+	if (a_regs->fd == -1) {
+		return -1;
+	}
+
+	if (a_regs->backend != eRpDevMem) {
+		// new (or foreign) image, size it and load the reset values below
+		if (fstat(a_regs->fd, &st) == -1) {
+			goto fail;
+		}
+		if (st.st_size < RP_IMAGE_SIZE) {
+			if (ftruncate(a_regs->fd, RP_IMAGE_SIZE) == -1) {
+				goto fail;
+			}
+			fresh = 1;
+		}
+	}
+
+	a_regs->hk  = map_window(a_regs, RP_ADDR_HK);
+	a_regs->ams = map_window(a_regs, RP_ADDR_AMS);
+	a_regs->pid = map_window(a_regs, RP_ADDR_PID);
+	if (!a_regs->hk || !a_regs->ams || !a_regs->pid) {
+		goto fail;
+	}
+	if (fresh) {
+		rp_reset(a_regs);
+	}
+	// channel table of this bitstream, the built-in one without a ROM
+	rp_info_load(a_regs);
+	rp_fine_load(a_regs);
+	return 0;
+
+fail:
+	{
+		int err = errno;
+		rp_close(a_regs);
+		errno = err;
+	}
+	return -1;
+}
+
+void rp_close(rpRegs_t *a_regs)
+{
+	if (a_regs->pid) {
+		rp_sync(a_regs);
+	}
+	if (a_regs->hk) {
+		munmap((void *)a_regs->hk, RP_MAP_SIZE);
+	}
+	if (a_regs->ams) {
+		munmap((void *)a_regs->ams, RP_MAP_SIZE);
+	}
+	if (a_regs->pid) {
+		munmap((void *)a_regs->pid, RP_MAP_SIZE);
+	}
+	for (int i = 0; i < a_regs->extraNum; ++i) {
+		munmap(a_regs->extraBase[i], RP_MAP_SIZE);
+	}
+	for (int i = 0; i < a_regs->blockNum; ++i) {
+		munmap(a_regs->blockBase[i], a_regs->blockLen[i]);
+	}
+	if (a_regs->fd != -1) {
+		close(a_regs->fd);
+	}
+	memset(a_regs, 0, sizeof(*a_regs));
+	a_regs->fd = -1;
+}
+
+volatile void *rp_map(rpRegs_t *a_regs, uint32_t a_addr)
+{
+	uint32_t page = a_addr & ~RP_MAP_MASK;
+	uint32_t offs = a_addr & RP_MAP_MASK;
+	const int extraMax = sizeof(a_regs->extraBase) / sizeof(a_regs->extraBase[0]);
+	int i;
+
+	if (page == RP_ADDR_HK) {
+		return (volatile uint8_t *)a_regs->hk + offs;
+	}
+	if (page == RP_ADDR_AMS) {
+		return (volatile uint8_t *)a_regs->ams + offs;
+	}
+	if (page == RP_ADDR_PID) {
+		return (volatile uint8_t *)a_regs->pid + offs;
+	}
+
+	for (i = 0; i < a_regs->extraNum; ++i) {
+		if (a_regs->extraAddr[i] == page) {
+			return (volatile uint8_t *)a_regs->extraBase[i] + offs;
+		}
+	}
+
+	// any other page stays mapped as well, the oldest one is recycled
+	if (a_regs->extraNum == extraMax) {
+		munmap(a_regs->extraBase[0], RP_MAP_SIZE);
+		memmove(&a_regs->extraAddr[0], &a_regs->extraAddr[1], (extraMax - 1) * sizeof(a_regs->extraAddr[0]));
+		memmove(&a_regs->extraBase[0], &a_regs->extraBase[1], (extraMax - 1) * sizeof(a_regs->extraBase[0]));
+		--a_regs->extraNum;
+	}
+	void *base = map_window(a_regs, page);
+	if (!base) {
+		return NULL;
+	}
+	a_regs->extraAddr[a_regs->extraNum] = page;
+	a_regs->extraBase[a_regs->extraNum] = base;
+	++a_regs->extraNum;
+	return (volatile uint8_t *)base + offs;
+}
+
+volatile void *rp_map_block(rpRegs_t *a_regs, uint32_t a_addr, uint32_t a_len)
+{
+	const int blockMax = sizeof(a_regs->blockBase) / sizeof(a_regs->blockBase[0]);
+	int i;
+
+	for (i = 0; i < a_regs->blockNum; ++i) {
+		if (a_regs->blockAddr[i] == a_addr && a_regs->blockLen[i] >= a_len) {
+			return a_regs->blockBase[i];
+		}
+	}
+
+	int64_t offs = rp_offset(a_regs, a_addr);
+	// a window must not leave the section it starts in
+	if ((a_addr & RP_MAP_MASK) || offs == -1 || rp_offset(a_regs, a_addr + a_len - 1) != offs + a_len - 1) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (a_regs->blockNum == blockMax) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	void *base = mmap(0, a_len, PROT_READ | PROT_WRITE, MAP_SHARED, a_regs->fd, offs);
+	if (base == MAP_FAILED) {
+		return NULL;
+	}
+	a_regs->blockAddr[a_regs->blockNum] = a_addr;
+	a_regs->blockLen[a_regs->blockNum] = a_len;
+	a_regs->blockBase[a_regs->blockNum] = base;
+	++a_regs->blockNum;
+	return base;
+}
+
+int rp_pid_num(void)
+{
+	return rpChanNum;
+}
+
+/*
+ * PID register map, see the channel table in codec.h. Channel index of the
+ * default bitstream:
+ * 0 => Fast 11, 1 => Fast 12, 2 => Fast 21, 3 => Fast 22
+ * 4 => Slow 1,  5 => Slow 2,  6 => Slow 3,  7 => Slow 4
+ */
+uint32_t rp_pid_offset(int a_ch, pidPar_t a_par)
+{
+	return (a_par >= 0 && a_par < ePidParNum) ? rp_codec_offset(a_ch, a_par) : 0;
+}
+
+int rp_pid_width(int a_ch, pidPar_t a_par)
+{
+	return (a_par >= 0 && a_par < ePidParNum) ? rp_codec_width(a_ch, a_par) : 32;
+}
+
+uint32_t rp_pid_read_raw(const rpRegs_t *a_regs, int a_ch, pidPar_t a_par)
+{
+	return a_regs->pid[rp_pid_offset(a_ch, a_par) >> 2];
+}
+
+void rp_pid_write_raw(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, uint32_t a_raw)
+{
+	a_regs->pid[rp_pid_offset(a_ch, a_par) >> 2] = a_raw;
+	if (a_regs->backend != eRpDevMem) {
+		// the hardware stages every live write as well
+		a_regs->pid[(RP_PID_SHADOW + rp_pid_offset(a_ch, a_par)) >> 2] = a_raw;
+	}
+}
+
+int32_t rp_pid_decode(int a_ch, pidPar_t a_par, uint32_t a_raw)
+{
+	return (a_par >= 0 && a_par < ePidParNum) ? rp_codec_decode(a_ch, a_par, a_raw) : (int32_t)a_raw;
+}
+
+uint32_t rp_pid_encode(int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	return (a_par >= 0 && a_par < ePidParNum) ? rp_codec_encode(a_ch, a_par, a_val) : (uint32_t)a_val;
+}
+
+void rp_pid_range(int a_ch, pidPar_t a_par, int32_t *a_min, int32_t *a_max)
+{
+	if (a_par >= 0 && a_par < ePidParNum) {
+		rp_codec_range(a_ch, a_par, a_min, a_max);
+	} else {
+		*a_min = *a_max = 0;
+	}
+}
+
+int rp_pid_check(int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	int32_t min, max;
+
+	if (a_ch < 0 || a_ch >= rp_pid_num() || a_par < 0 || a_par >= ePidParNum) {
+		return -EINVAL;
+	}
+	rp_pid_range(a_ch, a_par, &min, &max);
+	return (a_val < min || a_val > max) ? -ERANGE : 0;
+}
+
+const char *rp_pid_par_name(pidPar_t a_par)
+{
+	return (a_par >= 0 && a_par < ePidParNum) ? rpParDesc[a_par].name : "?";
+}
+
+pidPar_t rp_pid_par_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < ePidParNum; ++i) {
+		if (strcasecmp(a_name, rpParDesc[i].name) == 0) {
+			break;
+		}
+	}
+	return i;
+}
+
+int32_t rp_pid_get(const rpRegs_t *a_regs, int a_ch, pidPar_t a_par)
+{
+	return rp_pid_decode(a_ch, a_par, rp_pid_read_raw(a_regs, a_ch, a_par));
+}
+
+void rp_pid_set(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	rp_pid_write_raw(a_regs, a_ch, a_par, rp_pid_encode(a_ch, a_par, a_val));
+}
+
+void rp_pid_get_all(const rpRegs_t *a_regs, int a_ch, pidParams_t *a_par)
+{
+	uint32_t raw[ePidParNum];
+
+	rp_codec_read_set(a_regs, a_ch, raw);
+	rp_codec_decode_set(a_ch, raw, a_par);
+}
+
+void rp_pid_set_all(rpRegs_t *a_regs, int a_ch, const pidParams_t *a_par)
+{
+	uint32_t raw[ePidParNum];
+
+	rp_codec_encode_set(a_ch, a_par, raw);
+	rp_codec_write_set(a_regs, a_ch, raw);
+}
+
+void rp_pid_stage(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, int32_t a_val)
+{
+	a_regs->pid[(RP_PID_SHADOW + rp_pid_offset(a_ch, a_par)) >> 2] = rp_pid_encode(a_ch, a_par, a_val);
+}
+
+void rp_pid_stage_all(rpRegs_t *a_regs, int a_ch, const pidParams_t *a_par)
+{
+	for (int i = 0; i < ePidParNum; ++i) {
+		rp_pid_stage(a_regs, a_ch, i, a_par->val[i]);
+	}
+}
+
+void rp_pid_commit(rpRegs_t *a_regs, uint32_t a_mask)
+{
+	a_regs->pid[RP_PID_COMMIT >> 2] = a_mask & rp_pid_mask(0, rp_pid_num() - 1);
+	rp_sync(a_regs);
+}
+
+void rp_pid_set_batch(rpRegs_t *a_regs, int a_num, const int *a_ch, const pidParams_t *a_par)
+{
+	uint32_t mask = 0;
+
+	for (int i = 0; i < a_num; ++i) {
+		rp_pid_stage_all(a_regs, a_ch[i], &a_par[i]);
+		mask |= rp_pid_mask(a_ch[i], a_ch[i]);
+	}
+	rp_pid_commit(a_regs, mask);
+}
+
+uint32_t rp_pid_snapshot(rpRegs_t *a_regs)
+{
+	volatile uint32_t *trig = &a_regs->pid[RP_PID_TLM_TRIG >> 2];
+
+	if (a_regs->backend != eRpDevMem) {
+		// the images have no PID blocks, only the snapshot count moves and
+		// the channel blocks keep what was written to them
+		return __atomic_add_fetch(trig, 1, __ATOMIC_SEQ_CST);
+	}
+	*trig = 1;
+	return *trig;
+}
+
+void rp_pid_tlm_read(const rpRegs_t *a_regs, int a_ch, pidTlm_t *a_tlm)
+{
+	volatile const uint32_t *src = &a_regs->pid[rpChan[a_ch].tlm >> 2];
+	uint32_t *dst = (uint32_t *)a_tlm;
+
+	for (size_t i = 0; i < sizeof(pidTlm_t) / sizeof(uint32_t); ++i) {
+		dst[i] = src[i];
+	}
+}
+
+uint32_t rp_pid_status(rpRegs_t *a_regs, pidTlm_t *a_tlm)
+{
+	uint32_t num = rp_pid_snapshot(a_regs);
+
+	for (int ch = 0; ch < rp_pid_num(); ++ch) {
+		rp_pid_tlm_read(a_regs, ch, &a_tlm[ch]);
+	}
+	return num;
+}
+
+/*
+ * Register model of the stand-in images
+ */
+
+void rp_reset(rpRegs_t *a_regs)
+{
+	if (a_regs->backend == eRpDevMem) {
+		return;
+	}
+
+	// PID reset values and discovery ROM, see red_pitaya_pid.v
+	memset((void *)a_regs->pid, 0, RP_MAP_SIZE);
+	rp_info_write(a_regs);
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		int fast = ch < RP_PID_FAST_NUM;
+		rp_pid_write_raw(a_regs, ch, ePidIrst, 1);
+		rp_pid_write_raw(a_regs, ch, ePidPSR, fast ? 12 : 8);
+		rp_pid_write_raw(a_regs, ch, ePidISR, fast ? 18 : 20);
+		rp_pid_write_raw(a_regs, ch, ePidDSR, fast ? 10 : 6);
+		if (rp_windup_present(ch)) {
+			a_regs->pid[(rpChan[ch].deriv + RP_DERIV_AW) >> 2] = RP_WINDUP_TRACK_MIN << RP_WINDUP_TRACK_SH;
+		}
+		if (rp_bank_present(ch)) {
+			a_regs->pid[RP_BANK_HOLD(ch) >> 2] = rp_bank_hold_reset(ch);
+		}
+	}
+	a_regs->pid[RP_BODE_SRC >> 2] = (eCapOut << 8) | (RP_BODE_SIG_EXC << 12);
+	rp_route_reset(a_regs);
+
+	// AMS and waveform generator, see red_pitaya_ams_wave.v
+	volatile uint32_t *ams = (volatile uint32_t *)a_regs->ams;
+	memset((void *)ams, 0, RP_MAP_SIZE);
+	for (int n = 0; n < SLOW_DAC_NUM; ++n) {
+		ams[RP_WAVE_DIV(n) >> 2] = 1249;
+		ams[RP_WAVE_LEN(n) >> 2] = RP_WAVE_DEPTH - 1;
+	}
+	a_regs->ams->aif[4]  = AMS_AI4_RESET;
+	a_regs->ams->temp    = AMS_TEMP_RESET;
+	a_regs->ams->vccPint = AMS_1V0_RESET;
+	a_regs->ams->vccPaux = AMS_1V8_RESET;
+	a_regs->ams->vccBram = AMS_1V0_RESET;
+	a_regs->ams->vccInt  = AMS_1V0_RESET;
+	a_regs->ams->vccAux  = AMS_1V8_RESET;
+	a_regs->ams->vccDddr = AMS_1V5_RESET;
+}
+
+static int16_t sat16(int32_t a_val)
+{
+	return (a_val > 32767) ? 32767 : (a_val < -32768) ? -32768 : a_val;
+}
+
+/*
+ * An armed capture completes at once, the traces hold the channel telemetry.
+ * Channels with a simulated plant are left to pidsim.
+ */
+static void sync_capture(rpRegs_t *a_regs)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	uint32_t ctrl = pid[RP_CAP_CTRL >> 2];
+
+	if (!(ctrl & RP_CAP_ARM)) {
+		return;
+	}
+	uint32_t src = pid[RP_CAP_SRC >> 2];
+	int ch = src & 0x7;
+	if ((pid[RP_SIM_PLANT >> 2] >> ch) & 1) {
+		return;
+	}
+	pidTlm_t tlm;
+	rp_pid_tlm_read(a_regs, ch, &tlm);
+	int32_t val[eCapSigNum] = {
+		rp_pid_get(a_regs, ch, ePidSp) - tlm.err,
+		tlm.err, tlm.p, tlm.i, tlm.d, tlm.out, tlm.integ >> 16
+	};
+	int sigA = (src >> 4) & 0x7;
+	int sigB = (src >> 8) & 0x7;
+	uint16_t a = (sigA < eCapSigNum) ? sat16(val[sigA]) : 0;
+	uint16_t b = (sigB < eCapSigNum) ? sat16(val[sigB]) : 0;
+
+	volatile uint32_t *buf = rp_map_block(a_regs, RP_ADDR_PID + RP_CAP_BUF, RP_CAP_DEPTH * sizeof(uint32_t));
+	if (buf == NULL) {
+		return;
+	}
+	uint32_t num = pid[RP_CAP_PRE >> 2] + pid[RP_CAP_POST >> 2];
+	for (uint32_t i = 0; i < num && i < RP_CAP_DEPTH; ++i) {
+		buf[i] = ((uint32_t)b << 16) | a;
+	}
+	pid[RP_CAP_START >> 2] = 0;
+	pid[RP_CAP_TIME >> 2] = 0;
+	pid[(RP_CAP_TIME + 4) >> 2] = 0;
+	__atomic_compare_exchange_n(&pid[RP_CAP_CTRL >> 2], &ctrl, RP_CAP_TRIGGERED | RP_CAP_DONE, 0,
+	                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * A started analyzer point completes at once. Without a loop only the
+ * excitation trace has a response, the accumulators hold its sums.
+ * Channels with a simulated plant are left to pidsim.
+ */
+static void sync_bode(rpRegs_t *a_regs)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	uint32_t ctrl = pid[RP_BODE_CTRL >> 2];
+	uint32_t src = pid[RP_BODE_SRC >> 2];
+	uint32_t status = 0;
+
+	// written bits and status share the image word: a finished point reads
+	// back as DONE | EXC, a stop alone as STOP
+	if (ctrl == RP_BODE_STOP) {
+		status = 0;
+	} else if (ctrl & RP_BODE_START) {
+		if ((pid[RP_SIM_PLANT >> 2] >> (src & 0x7)) & 1) {
+			return;
+		}
+		uint32_t len = pid[RP_BODE_LEN >> 2];
+		int64_t exc = (int64_t)len * (pid[RP_BODE_AMP >> 2] & 0x7fff) * RP_BODE_SINE / 2;
+		int64_t acc[4] = {
+			(((src >> 8) & 0x7) == RP_BODE_SIG_EXC) ? exc : 0, 0,
+			(((src >> 12) & 0x7) == RP_BODE_SIG_EXC) ? exc : 0, 0
+		};
+		for (int n = 0; n < 4; ++n) {
+			pid[(RP_BODE_ACC >> 2) + 2 * n] = acc[n];
+			pid[(RP_BODE_ACC >> 2) + 2 * n + 1] = (uint64_t)acc[n] >> 32;
+		}
+		pid[RP_BODE_COUNT >> 2] = len;
+		status = RP_BODE_DONE | RP_BODE_EXC;
+	} else {
+		return;
+	}
+	__atomic_compare_exchange_n(&pid[RP_BODE_CTRL >> 2], &ctrl, status, 0,
+	                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Started waveforms of untriggered channels finish at once (one-shot) or
+ * keep running (loop). The control word reads back the status, which the
+ * image keeps at RP_WAVE_SIM_STATUS as well; a control word equal to it
+ * was not written since the last sync.
+ */
+static void sync_wave(rpRegs_t *a_regs)
+{
+	volatile uint32_t *ams = (volatile uint32_t *)a_regs->ams;
+	uint32_t ctrl = ams[RP_WAVE_CTRL >> 2];
+	uint32_t status = ams[RP_WAVE_SIM_STATUS >> 2];
+
+	if (ctrl == status) {
+		return;
+	}
+	for (int n = 0; n < SLOW_DAC_NUM; ++n) {
+		uint32_t cfg = ams[RP_WAVE_CFG(n) >> 2];
+		uint32_t chan = RP_WAVE_RUNNING(n) | RP_WAVE_ARMED(n) | RP_WAVE_DONE(n) | RP_WAVE_ACTIVE(n);
+		int run = 0;
+
+		if ((ctrl & RP_WAVE_STOP(n)) || (cfg & 0x3) == eWaveOff) {
+			status &= ~(RP_WAVE_RUNNING(n) | RP_WAVE_ARMED(n) | RP_WAVE_ACTIVE(n));
+			continue;
+		}
+		if (ctrl & RP_WAVE_START(n)) {
+			status = (status & ~chan) | RP_WAVE_ACTIVE(n);
+			ams[RP_WAVE_POS(n) >> 2] = 0;
+			if (cfg & 0x10) {
+				status |= RP_WAVE_ARMED(n);
+			} else {
+				run = 1;
+			}
+		} else if ((ctrl & RP_WAVE_SWTRIG(n)) && (status & RP_WAVE_ARMED(n))) {
+			status &= ~RP_WAVE_ARMED(n);
+			run = 1;
+		}
+		if (run && (cfg & 0x3) == eWaveLoop) {
+			status |= RP_WAVE_RUNNING(n);
+		} else if (run) {
+			status |= RP_WAVE_DONE(n);
+			ams[RP_WAVE_POS(n) >> 2] = ams[RP_WAVE_LEN(n) >> 2] & (RP_WAVE_DEPTH - 1);
+		}
+	}
+	ams[RP_WAVE_SIM_STATUS >> 2] = status;
+	__atomic_compare_exchange_n(&ams[RP_WAVE_CTRL >> 2], &ctrl, status, 0,
+	                            __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Parameter banks: a new selection, or a reload, copies the bank into the
+ * live and staged registers. The pins read as low off-board, so a channel
+ * selecting by pins runs with bank 0.
+ */
+static void sync_bank(rpRegs_t *a_regs)
+{
+	volatile uint32_t *pid = a_regs->pid;
+	volatile uint32_t *win = NULL;
+
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		if (!rp_bank_present(ch)) {
+			continue;
+		}
+		if (win == NULL) {
+			win = rp_map_block(a_regs, RP_ADDR_PID + RP_BANK_WIN, sizeof(bankImage_t));
+			if (win == NULL) {
+				return;
+			}
+		}
+
+		uint32_t cfg = pid[RP_BANK_CFG(ch) >> 2];
+		uint32_t sel = (cfg & RP_BANK_PIN) ? 0 : cfg & (RP_BANK_NUM - 1);
+		uint32_t act = (cfg >> RP_BANK_ACTIVE_SH) & (RP_BANK_NUM - 1);
+		volatile uint32_t *word = &win[(RP_BANK_ADDR(ch, sel) - RP_BANK_WIN) >> 2];
+
+		for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+			word[p] &= (1UL << rp_pid_width(ch, rpBankPar[p])) - 1;
+		}
+		if (sel != act || (cfg & RP_BANK_RELOAD)) {
+			for (int p = 0; p < RP_BANK_PAR_NUM; ++p) {
+				uint32_t off = rp_pid_offset(ch, rpBankPar[p]);
+				pid[off >> 2] = word[p];
+				pid[(RP_PID_SHADOW + off) >> 2] = word[p];
+			}
+		}
+		pid[RP_BANK_CFG(ch) >> 2] = (cfg & (RP_BANK_SCALE | 0x700 | RP_BANK_PIN | (RP_BANK_NUM - 1))) |
+		                            (sel << RP_BANK_ACTIVE_SH);
+		pid[RP_BANK_HOLD(ch) >> 2] &= RP_BANK_HOLD_EN | RP_BANK_DIO_MAX;
+	}
+}
+
+void rp_sync(rpRegs_t *a_regs)
+{
+	if (a_regs->backend == eRpDevMem) {
+		return;
+	}
+
+	volatile uint32_t *pid = a_regs->pid;
+	// the commit register is a strobe and reads back as 0; the exchange keeps
+	// a commit from getting lost when pidsim syncs the same image
+	uint32_t commit = __atomic_exchange_n(&pid[RP_PID_COMMIT >> 2], 0, __ATOMIC_SEQ_CST);
+
+	// the gain widths follow the fine gains, which another tool may have set
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		if (rp_fine_present(ch)) {
+			pid[(rpChan[ch].deriv + RP_DERIV_FINE) >> 2] &= 1;
+		}
+	}
+	rp_fine_load(a_regs);
+
+	sync_bank(a_regs);
+
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		for (int par = 0; par < ePidParNum; ++par) {
+			uint32_t live = rp_pid_offset(ch, par) >> 2;
+			uint32_t shd = (RP_PID_SHADOW + rp_pid_offset(ch, par)) >> 2;
+			uint32_t mask = (1UL << rp_pid_width(ch, par)) - 1;
+
+			pid[shd] &= mask;
+			pid[live] = ((commit >> ch) & 1) ? pid[shd] : (pid[live] & mask);
+		}
+	}
+
+	// derivative divider, filter and anti-windup widths
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		if (rp_deriv_present(ch)) {
+			pid[(rpChan[ch].deriv + RP_DERIV_DCD) >> 2] &= RP_DERIV_DIV_MAX - 1;
+			pid[(rpChan[ch].deriv + RP_DERIV_DFL) >> 2] &= RP_DERIV_ORDER2 | RP_DERIV_SHIFT_MAX;
+		} else if (rpChan[ch].deriv) {
+			pid[(rpChan[ch].deriv + RP_DERIV_DCD) >> 2] = 0;
+			pid[(rpChan[ch].deriv + RP_DERIV_DFL) >> 2] = 0;
+		}
+		if (rp_windup_present(ch)) {
+			pid[(rpChan[ch].deriv + RP_DERIV_AW) >> 2] &= (RP_WINDUP_TRACK_MAX << RP_WINDUP_TRACK_SH) |
+			                                              RP_WINDUP_COND | RP_WINDUP_BACK;
+		}
+	}
+
+	// routing crossbar widths
+	for (int n = 0; n < RP_ROUTE_CH_NUM; ++n) {
+		pid[RP_ROUTE_IN(n) >> 2] &= RP_ROUTE_SP_SEL | 0xf0f;
+	}
+	for (int m = 0; m < RP_ROUTE_OUT_NUM; ++m) {
+		pid[RP_ROUTE_OUT(m) >> 2] &= 0xffff;
+	}
+
+	// feedforward widths, a trigger restarts the table at entry 0
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		if (rpChan[ch].ff) {
+			volatile uint32_t *ff = &pid[rpChan[ch].ff >> 2];
+			ff[RP_FF_CFG >> 2] &= 0x7733;
+			ff[RP_FF_GAIN >> 2] = (int16_t)ff[RP_FF_GAIN >> 2];
+			ff[RP_FF_TRIG >> 2] = 0;
+		}
+	}
+
+	// set point ramps arrive at once
+	for (int ch = 0; ch < RP_PID_NUM; ++ch) {
+		int width = rp_pid_width(ch, ePidSp);
+		uint32_t sp = pid[rp_pid_offset(ch, ePidSp) >> 2];
+		pid[(rpChan[ch].ramp + RP_RAMP_SP) >> 2] = (int32_t)(sp << (32 - width)) >> (32 - width);
+	}
+	pid[RP_RAMP_DONE >> 2] = rp_pid_mask(0, RP_PID_NUM - 1);
+
+	sync_capture(a_regs);
+	sync_bode(a_regs);
+	sync_wave(a_regs);
+}
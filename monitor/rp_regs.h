@@ -0,0 +1,266 @@
+/**
+ * @brief Persistent register access library for the Red Pitaya PID controller.
+ *
+ * Opens the memory device once and keeps the house keeping, analog mixed
+ * signal (AMS) and PID register windows mapped for the lifetime of the
+ * handle. Typed per-channel accessors hide the register map, so callers
+ * never deal with physical addresses or per-access mmap()/munmap().
+ *
+ * Backends, selected by the spec given to rp_open() or the RP_BACKEND
+ * environment variable:
+ *   /dev/mem (default)  the FPGA registers at their physical addresses
+ *   file:PATH           image file of the HK, AMS and PID windows
+ *   shm:NAME            POSIX shared memory image, served by pidsim
+ * The images are created on first use with the FPGA reset values. The
+ * library applies the register widths and the commit of staged parameters
+ * to them (rp_sync()), so all tools behave as on the board.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef RP_REGS_H
+#define RP_REGS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RP_MAP_SIZE 4096UL
+#define RP_MAP_MASK (RP_MAP_SIZE - 1)
+
+#define RP_ADDR_HK   0x40000000UL
+#define RP_ADDR_AMS  0x40400000UL
+#define RP_ADDR_PID  0x40600000UL
+
+#define RP_DEV_MEM   "/dev/mem"
+#define RP_ENV_BACKEND "RP_BACKEND"
+#define RP_SHM_DEFAULT "shm:/rp_regs"
+
+/* address range decoded by one FPGA module, see red_pitaya_ps.v */
+#define RP_SECTION_SIZE 0x100000UL
+/* stand-in images hold the HK, AMS and PID sections in this order */
+#define RP_IMAGE_SIZE   (3 * RP_SECTION_SIZE)
+
+/*
+ * Channels of the default bitstream, used when the PID window has no
+ * discovery ROM (see info.h) and by the stand-in images. The tools size
+ * their tables with RP_PID_MAX and loop over rp_pid_num() channels.
+ */
+#define RP_PID_NUM      8
+#define RP_PID_FAST_NUM 4
+#define RP_PID_MAX      32          /* bits of the commit register */
+/* processing clock of all PID channels, see red_pitaya_pid.v */
+#define RP_PID_CLOCK    125000000.0
+
+/* staged copy of the parameter registers, see red_pitaya_pid.v */
+#define RP_PID_SHADOW   0x200
+/* write a channel mask to copy the staged parameters into the active set */
+#define RP_PID_COMMIT   0x150
+
+/* write to latch the telemetry of all channels, reads the number of snapshots */
+#define RP_PID_TLM_TRIG   0x400
+/* telemetry snapshot of channel n at RP_PID_TLM_BASE + n * RP_PID_TLM_STRIDE */
+#define RP_PID_TLM_BASE   0x420
+#define RP_PID_TLM_STRIDE 0x20
+
+/* sticky saturation flags, set since the previous snapshot */
+#define RP_PID_TLM_INT_SAT 0x1
+#define RP_PID_TLM_OUT_SAT 0x2
+
+/*
+ * Stand-in images only: mask of the channels pidsim runs against a
+ * simulated plant (pidsim -P). Captures of these channels are served by
+ * pidsim instead of rp_sync().
+ */
+#define RP_SIM_PLANT 0xFFC
+
+#define SLOW_DAC_NUM 4
+
+typedef struct {
+	uint32_t aif[5];
+	uint32_t reserved[3];
+	uint32_t dac[SLOW_DAC_NUM];
+	uint32_t temp;
+	uint32_t vccPint;
+	uint32_t vccPaux;
+	uint32_t vccBram;
+	uint32_t vccInt;
+	uint32_t vccAux;
+	uint32_t vccDddr;
+} amsReg_t;
+
+/* PID channel parameters, in the order they appear in the monitor menus */
+typedef enum {
+	ePidSp=0,
+	ePidKp,
+	ePidKi,
+	ePidKd,
+	ePidIrst,
+	ePidPSR,
+	ePidISR,
+	ePidDSR,
+	ePidICD,
+	ePidTol,
+	ePidParNum
+} pidPar_t;
+
+/* all parameters of one channel, in user units (see rp_pid_get()) */
+typedef struct {
+	int32_t val[ePidParNum];
+} pidParams_t;
+
+/* telemetry snapshot of one channel, in register order; values are signed counts */
+typedef struct {
+	int32_t err;
+	int32_t integ;
+	int32_t p;
+	int32_t i;
+	int32_t d;
+	int32_t out;
+	uint32_t flags;
+	uint32_t reserved;
+} pidTlm_t;
+
+typedef enum {
+	eRpDevMem=0,
+	eRpFile,
+	eRpShm
+} rpBackend_t;
+
+typedef struct {
+	int fd;
+	rpBackend_t backend;
+	volatile uint32_t *hk;
+	volatile amsReg_t *ams;
+	volatile uint32_t *pid;
+	/* extra pages mapped on demand by rp_map() */
+	uint32_t extraAddr[8];
+	void *extraBase[8];
+	int extraNum;
+	/* multi-page windows mapped by rp_map_block(), e.g. block RAM buffers */
+	uint32_t blockAddr[4];
+	uint32_t blockLen[4];
+	void *blockBase[4];
+	int blockNum;
+} rpRegs_t;
+
+/*
+ * Opens the backend a_spec (NULL for $RP_BACKEND, else /dev/mem) and maps
+ * the register windows. Returns 0 on success, -1 with errno set on failure.
+ */
+int rp_open(rpRegs_t *a_regs, const char *a_spec);
+void rp_close(rpRegs_t *a_regs);
+
+/* Pointer to the register at physical address a_addr, NULL on failure */
+volatile void *rp_map(rpRegs_t *a_regs, uint32_t a_addr);
+/*
+ * Contiguous window of a_len bytes at the page aligned address a_addr,
+ * mapped once and kept until rp_close(). NULL on failure.
+ */
+volatile void *rp_map_block(rpRegs_t *a_regs, uint32_t a_addr, uint32_t a_len);
+/* Offset of physical address a_addr in the backend file, -1 if not held */
+int64_t rp_offset(const rpRegs_t *a_regs, uint32_t a_addr);
+
+/*
+ * Stand-in images only: load the FPGA reset values, and apply what the
+ * hardware does on its own (register widths, pending commit). Plain
+ * writes through rp_map() take effect on the next rp_sync(), the library
+ * calls it after its own writes and in rp_close().
+ */
+void rp_reset(rpRegs_t *a_regs);
+void rp_sync(rpRegs_t *a_regs);
+
+/* Number of PID channels of the open bitstream */
+int rp_pid_num(void);
+
+/* Mask of channels a_first - a_last (bit n = channel n), up to all 32 */
+static inline uint32_t rp_pid_mask(int a_first, int a_last)
+{
+	return (uint32_t)(((uint64_t)2 << a_last) - ((uint64_t)1 << a_first));
+}
+
+/* Register offset inside the PID window, channel index 0 - rp_pid_num() - 1 */
+uint32_t rp_pid_offset(int a_ch, pidPar_t a_par);
+/* Number of implemented bits of a register */
+int rp_pid_width(int a_ch, pidPar_t a_par);
+
+uint32_t rp_pid_read_raw(const rpRegs_t *a_regs, int a_ch, pidPar_t a_par);
+void rp_pid_write_raw(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, uint32_t a_raw);
+
+/*
+ * Values in user units: gains and set point are counts (signed on the fast
+ * PIDs, 0-4095 on the slow ones), ICD is the integrator frequency in Hz,
+ * everything else is the plain register value.
+ */
+int32_t rp_pid_decode(int a_ch, pidPar_t a_par, uint32_t a_raw);
+uint32_t rp_pid_encode(int a_ch, pidPar_t a_par, int32_t a_val);
+
+/*
+ * Valid range of a parameter in user units, the same limits the monitor
+ * menus enforce. rp_pid_check() returns 0 if a_val is in range, -ERANGE if
+ * not and -EINVAL for an unknown channel or parameter.
+ */
+void rp_pid_range(int a_ch, pidPar_t a_par, int32_t *a_min, int32_t *a_max);
+int rp_pid_check(int a_ch, pidPar_t a_par, int32_t a_val);
+
+/* Short parameter names used on the command line: sp, kp, ki, kd, irst, ... */
+const char *rp_pid_par_name(pidPar_t a_par);
+/* Parameter by name (case insensitive), ePidParNum if unknown */
+pidPar_t rp_pid_par_lookup(const char *a_name);
+
+int32_t rp_pid_get(const rpRegs_t *a_regs, int a_ch, pidPar_t a_par);
+void rp_pid_set(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, int32_t a_val);
+
+void rp_pid_get_all(const rpRegs_t *a_regs, int a_ch, pidParams_t *a_par);
+void rp_pid_set_all(rpRegs_t *a_regs, int a_ch, const pidParams_t *a_par);
+
+/*
+ * Staged writes only reach the shadow registers. rp_pid_commit() makes the
+ * staged parameters of all channels in a_mask (bit n = channel n) active
+ * on the same clock edge.
+ */
+void rp_pid_stage(rpRegs_t *a_regs, int a_ch, pidPar_t a_par, int32_t a_val);
+void rp_pid_stage_all(rpRegs_t *a_regs, int a_ch, const pidParams_t *a_par);
+void rp_pid_commit(rpRegs_t *a_regs, uint32_t a_mask);
+
+/* Stages a_num complete parameter sets and activates them with one commit */
+void rp_pid_set_batch(rpRegs_t *a_regs, int a_num, const int *a_ch, const pidParams_t *a_par);
+
+/*
+ * Latches the telemetry of all channels on one clock edge and clears the
+ * sticky flags. Returns the number of snapshots taken so far.
+ */
+uint32_t rp_pid_snapshot(rpRegs_t *a_regs);
+/* Telemetry of channel a_ch as latched by the last rp_pid_snapshot() */
+void rp_pid_tlm_read(const rpRegs_t *a_regs, int a_ch, pidTlm_t *a_tlm);
+/* New snapshot of all rp_pid_num() channels, returns its number */
+uint32_t rp_pid_status(rpRegs_t *a_regs, pidTlm_t *a_tlm);
+
+#define RP_PID_ACCESSOR(name, par) \
+static inline int32_t rp_pid_get_##name(const rpRegs_t *a_regs, int a_ch) \
+	{ return rp_pid_get(a_regs, a_ch, par); } \
+static inline void rp_pid_set_##name(rpRegs_t *a_regs, int a_ch, int32_t a_val) \
+	{ rp_pid_set(a_regs, a_ch, par, a_val); }
+
+RP_PID_ACCESSOR(setpoint, ePidSp)
+RP_PID_ACCESSOR(kp,       ePidKp)
+RP_PID_ACCESSOR(ki,       ePidKi)
+RP_PID_ACCESSOR(kd,       ePidKd)
+RP_PID_ACCESSOR(irst,     ePidIrst)
+RP_PID_ACCESSOR(psr,      ePidPSR)
+RP_PID_ACCESSOR(isr,      ePidISR)
+RP_PID_ACCESSOR(dsr,      ePidDSR)
+RP_PID_ACCESSOR(icd,      ePidICD)
+RP_PID_ACCESSOR(tol,      ePidTol)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RP_REGS_H */
@@ -0,0 +1,255 @@
+/**
+ * @brief Slow DAC waveform command of the monitor utility.
+ *
+ * Uploads a table to the waveform generator of one slow DAC and starts it;
+ * the FPGA then times every entry, the host is not involved any more:
+ *
+ *   monitor -sdac --wave ramp.txt ch=2 rate=20000 mode=loop
+ *   monitor -sdac --wave step.txt ch=1 rate=1e5 trig=dio-rise dio=3
+ *
+ * The file holds one output in volts (0 - 1.8 V) per line, up to
+ * RP_WAVE_DEPTH of them; blank lines and lines starting with '#' are
+ * skipped.
+ *
+ * Parameters: ch (1-4), rate in entries per second or div in clocks per
+ * entry, mode (once loop), trig (none dio-rise dio-fall) and dio (0-7).
+ * --stop hands the DAC back to its static register (-sdac AO0 ...),
+ * --trigger starts armed channels and --status lists all channels; these
+ * apply to every channel without ch.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "wave.h"
+#include "sdac_cli.h"
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage:\n"
+		"\t-sdac --wave file [ch=1-4] [rate=Hz|div=n] [mode=once|loop]\n"
+		"\t      [trig=none|dio-rise|dio-fall] [dio=0-7]\n"
+		"\t-sdac --stop|--trigger|--status [ch=1-4]\n"
+		"One output in V (0 - 1.8) per line, up to %d lines\n", RP_WAVE_DEPTH);
+}
+
+static int parse_double(const char *a_str, double *a_val)
+{
+	char *end;
+
+	errno = 0;
+	*a_val = strtod(a_str, &end);
+	return (end == a_str || *end != '\0' || errno) ? -1 : 0;
+}
+
+/* one par=val token, a_rate is set when the rate is given in Hz */
+static int parse_assign(waveConfig_t *a_cfg, double *a_rate, char *a_tok)
+{
+	char *eq = strchr(a_tok, '=');
+	double val = 0;
+
+	if (eq == NULL) {
+		fprintf(stderr, "sdac: expected par=val, got '%s'\n", a_tok);
+		return -1;
+	}
+	*eq++ = '\0';
+
+	if (strcasecmp(a_tok, "mode") == 0) {
+		a_cfg->mode = rp_wave_mode_lookup(eq);
+		if (a_cfg->mode == eWaveModeNum || a_cfg->mode == eWaveOff) {
+			fprintf(stderr, "sdac: unknown mode '%s'\n", eq);
+			return -1;
+		}
+		return 0;
+	}
+	if (strcasecmp(a_tok, "trig") == 0) {
+		a_cfg->trig = rp_wave_trig_lookup(eq);
+		if (a_cfg->trig == eWaveTrigNum) {
+			fprintf(stderr, "sdac: unknown trigger '%s'\n", eq);
+			return -1;
+		}
+		return 0;
+	}
+	if (parse_double(eq, &val) == -1 || val < 0 || val > UINT32_MAX ||
+	    (val == 0 && strcasecmp(a_tok, "rate") == 0)) {
+		fprintf(stderr, "sdac: invalid value '%s' for %s\n", eq, a_tok);
+		return -1;
+	}
+	if (strcasecmp(a_tok, "ch") == 0 && val == (int)val) {
+		a_cfg->ch = (int)val - 1;
+	} else if (strcasecmp(a_tok, "dio") == 0 && val == (int)val) {
+		a_cfg->dio = val;
+	} else if (strcasecmp(a_tok, "div") == 0 && val == (uint32_t)val) {
+		a_cfg->div = val;
+		*a_rate = 0;
+	} else if (strcasecmp(a_tok, "rate") == 0) {
+		*a_rate = val;
+	} else {
+		fprintf(stderr, "sdac: unknown parameter '%s'\n", a_tok);
+		return -1;
+	}
+	return 0;
+}
+
+/* PWM words of a wave file, returns their number or -1 */
+static long read_wave(const char *a_path, uint32_t *a_words)
+{
+	FILE *fp = strcmp(a_path, "-") ? fopen(a_path, "r") : stdin;
+	char line[256];
+	long num = 0, lineNum = 0;
+
+	if (fp == NULL) {
+		fprintf(stderr, "sdac: %s: %s\n", a_path, strerror(errno));
+		return -1;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		char *p = line, *end;
+		double val;
+
+		++lineNum;
+		while (isspace((unsigned char)*p)) {
+			++p;
+		}
+		if (*p == '\0' || *p == '#') {
+			continue;
+		}
+		line[strcspn(line, "\r\n")] = '\0';
+		val = strtod(p, &end);
+		while (isspace((unsigned char)*end)) {
+			++end;
+		}
+		if (end == p || *end != '\0' || val < 0 || val > 1.8) {
+			fprintf(stderr, "sdac: %s:%ld: expected 0 - 1.8 V, got '%s'\n", a_path, lineNum, p);
+			num = -1;
+			break;
+		}
+		if (num == RP_WAVE_DEPTH) {
+			fprintf(stderr, "sdac: %s: more than %d entries\n", a_path, RP_WAVE_DEPTH);
+			num = -1;
+			break;
+		}
+		a_words[num++] = rp_wave_word(val);
+	}
+	if (num == 0) {
+		fprintf(stderr, "sdac: %s: no entries\n", a_path);
+		num = -1;
+	}
+	if (fp != stdin) {
+		fclose(fp);
+	}
+	return num;
+}
+
+static void print_status(const rpRegs_t *a_regs, uint32_t a_mask)
+{
+	volatile uint32_t *ams = (volatile uint32_t *)a_regs->ams;
+	uint32_t status = rp_wave_status(a_regs);
+
+	printf("#DAC\tState\tMode\tTrig\tDIO\tRate[Hz]\tLen\tPos\n");
+	for (int n = 0; n < SLOW_DAC_NUM; ++n) {
+		if (!((a_mask >> n) & 1)) {
+			continue;
+		}
+		uint32_t cfg = ams[RP_WAVE_CFG(n) >> 2];
+		const char *state = (status & RP_WAVE_RUNNING(n)) ? "running" :
+		                    (status & RP_WAVE_ARMED(n))   ? "armed" :
+		                    (status & RP_WAVE_DONE(n))    ? "done" : "idle";
+		waveTrig_t trig = !(cfg & 0x10) ? eWaveTrigNone : (cfg & 0x1000) ? eWaveTrigDioFall : eWaveTrigDioRise;
+
+		printf("%d\t%s%s\t%s\t%s\t%u\t%.1f\t%u\t%u\n", n + 1, state,
+		       (status & RP_WAVE_ACTIVE(n)) ? "" : " (static)", rp_wave_mode_name(cfg & 0x3),
+		       rp_wave_trig_name(trig), (cfg >> 8) & 0x7, rp_wave_rate(ams[RP_WAVE_DIV(n) >> 2] + 1),
+		       ams[RP_WAVE_LEN(n) >> 2] + 1, rp_wave_pos(a_regs, n));
+	}
+}
+
+int sdac_cli(rpRegs_t *a_regs, int a_argc, char **a_argv)
+{
+	static uint32_t words[RP_WAVE_DEPTH];
+	const char *path = NULL;
+	waveConfig_t cfg;
+	double rate = 0;
+	int chGiven = 0;
+	int first = 1;
+	int ret;
+
+	rp_wave_defaults(&cfg);
+	if (a_argc < 1) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (strcmp(a_argv[0], "--wave") == 0) {
+		if (a_argc < 2) {
+			usage();
+			return EXIT_FAILURE;
+		}
+		path = a_argv[1];
+		first = 2;
+	} else if (strcmp(a_argv[0], "--stop") && strcmp(a_argv[0], "--trigger") && strcmp(a_argv[0], "--status")) {
+		usage();
+		return EXIT_FAILURE;
+	}
+	for (int i = first; i < a_argc; ++i) {
+		chGiven |= (strncasecmp(a_argv[i], "ch=", 3) == 0);
+		if (parse_assign(&cfg, &rate, a_argv[i]) == -1) {
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+	if (cfg.ch < 0 || cfg.ch >= SLOW_DAC_NUM) {
+		fprintf(stderr, "sdac: no slow DAC %d\n", cfg.ch + 1);
+		return EXIT_FAILURE;
+	}
+	uint32_t mask = chGiven ? (1 << cfg.ch) : (1 << SLOW_DAC_NUM) - 1;
+
+	if (path == NULL) {
+		if (strcmp(a_argv[0], "--stop") == 0) {
+			rp_wave_stop(a_regs, mask);
+		} else if (strcmp(a_argv[0], "--trigger") == 0) {
+			rp_wave_trigger(a_regs, mask);
+		}
+		print_status(a_regs, mask);
+		return EXIT_SUCCESS;
+	}
+
+	long num = read_wave(path, words);
+	if (num == -1) {
+		return EXIT_FAILURE;
+	}
+	if (rate > 0) {
+		cfg.div = rp_wave_div(rate);
+	}
+	cfg.len = num;
+	if ((ret = rp_wave_check(&cfg)) != 0) {
+		fprintf(stderr, "sdac: %s\n", (ret == -EINVAL) ? "invalid configuration" : "value out of range");
+		usage();
+		return EXIT_FAILURE;
+	}
+	if (rp_wave_rate(cfg.div) > RP_WAVE_PWM_RATE) {
+		fprintf(stderr, "sdac: %.0f entries/s, the DAC output only follows %.0f/s\n",
+		        rp_wave_rate(cfg.div), RP_WAVE_PWM_RATE);
+	}
+
+	// the running table must not change under the player
+	rp_wave_stop(a_regs, 1 << cfg.ch);
+	if (rp_wave_load(a_regs, cfg.ch, words, num) == -1) {
+		fprintf(stderr, "sdac: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	rp_wave_start(a_regs, &cfg);
+	print_status(a_regs, 1 << cfg.ch);
+	return EXIT_SUCCESS;
+}
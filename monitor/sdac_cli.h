@@ -0,0 +1,25 @@
+/**
+ * @brief Slow DAC waveform command of the monitor utility.
+ *
+ * monitor -sdac --wave file [par=val ...]
+ * monitor -sdac --stop|--trigger|--status [ch=1-4]
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef SDAC_CLI_H
+#define SDAC_CLI_H
+
+#include "rp_regs.h"
+
+/*
+ * Loads and starts a waveform, or stops, triggers or lists the waveform
+ * channels; a_argv[0] is the option. Returns EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int sdac_cli(rpRegs_t *a_regs, int a_argc, char **a_argv);
+
+#endif /* SDAC_CLI_H */
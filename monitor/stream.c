@@ -0,0 +1,368 @@
+/**
+ * @brief Register command streaming for the monitor '-' modes.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+#include "stream.h"
+
+typedef struct {
+	rpRegs_t *regs;
+	// page of the last access, saves the rp_map() lookup for runs on one window
+	uint32_t page;
+	volatile uint8_t *base;
+	int out;
+	size_t olen;
+	uint8_t obuf[RP_STREAM_BUF_SIZE];
+} stream_t;
+
+/* state of the current text block */
+typedef struct {
+	uint32_t addr;
+	int type;
+	int open;
+	long vals;
+} block_t;
+
+static void stream_init(stream_t *a_s, rpRegs_t *a_regs, int a_out)
+{
+	a_s->regs = a_regs;
+	a_s->page = 1;  // never a page address
+	a_s->base = NULL;
+	a_s->out = a_out;
+	a_s->olen = 0;
+}
+
+static int flush(stream_t *a_s)
+{
+	size_t done = 0;
+
+	while (done < a_s->olen) {
+		ssize_t ret = write(a_s->out, a_s->obuf + done, a_s->olen - done);
+		if (ret == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		done += ret;
+	}
+	a_s->olen = 0;
+	return 0;
+}
+
+static volatile uint8_t *reg(stream_t *a_s, uint32_t a_addr)
+{
+	uint32_t page = a_addr & ~RP_MAP_MASK;
+
+	if (page != a_s->page) {
+		volatile uint8_t *base = rp_map(a_s->regs, page);
+		if (base == NULL) {
+			return NULL;
+		}
+		a_s->page = page;
+		a_s->base = base;
+	}
+	return a_s->base + (a_addr & RP_MAP_MASK);
+}
+
+static int access_write(stream_t *a_s, uint32_t a_addr, int a_width, uint32_t a_val)
+{
+	volatile uint8_t *r = reg(a_s, a_addr);
+
+	if (r == NULL) {
+		return -1;
+	}
+	switch (a_width) {
+		case 1:
+			*r = a_val;
+			break;
+		case 2:
+			*(volatile uint16_t *)r = a_val;
+			break;
+		case 4:
+			*(volatile uint32_t *)r = a_val;
+			break;
+		default:
+			errno = EINVAL;
+			return -1;
+	}
+	return 0;
+}
+
+static int access_read(stream_t *a_s, uint32_t a_addr, uint32_t *a_val)
+{
+	volatile uint8_t *r = reg(a_s, a_addr);
+
+	if (r == NULL) {
+		return -1;
+	}
+	*a_val = *(volatile uint32_t *)r;
+	return 0;
+}
+
+static int out_reserve(stream_t *a_s, size_t a_len)
+{
+	if (a_s->olen + a_len > sizeof(a_s->obuf)) {
+		return flush(a_s);
+	}
+	return 0;
+}
+
+/* same output as read_value(): 0x%08x\n */
+static int out_hex(stream_t *a_s, uint32_t a_val)
+{
+	static const char digit[] = "0123456789abcdef";
+
+	if (out_reserve(a_s, 11) == -1) {
+		return -1;
+	}
+	uint8_t *o = a_s->obuf + a_s->olen;
+	o[0] = '0';
+	o[1] = 'x';
+	for (int i = 0; i < 8; ++i) {
+		o[2 + i] = digit[(a_val >> (28 - 4 * i)) & 0xf];
+	}
+	o[10] = '\n';
+	a_s->olen += 11;
+	return 0;
+}
+
+/* strtoul(.., 0) on [a_p, a_end): 0x hex, leading 0 octal, decimal, optional sign */
+static const char *parse_num(const char *a_p, const char *a_end, unsigned long *a_val)
+{
+	unsigned long val = 0;
+	unsigned base = 10;
+	int neg = 0;
+
+	if (a_p < a_end && (*a_p == '-' || *a_p == '+')) {
+		neg = (*a_p == '-');
+		++a_p;
+	}
+	if (a_p < a_end && *a_p == '0') {
+		base = 8;
+		++a_p;
+		if (a_p < a_end && (*a_p == 'x' || *a_p == 'X')) {
+			base = 16;
+			++a_p;
+		}
+	}
+	for (; a_p < a_end; ++a_p) {
+		unsigned d;
+		if (*a_p >= '0' && *a_p <= '9') {
+			d = *a_p - '0';
+		} else if (*a_p >= 'a' && *a_p <= 'f') {
+			d = *a_p - 'a' + 10;
+		} else if (*a_p >= 'A' && *a_p <= 'F') {
+			d = *a_p - 'A' + 10;
+		} else {
+			break;
+		}
+		if (d >= base) {
+			break;
+		}
+		val = val * base + d;
+	}
+	*a_val = neg ? -val : val;
+	return a_p;
+}
+
+static const char *skip_blank(const char *a_p, const char *a_end)
+{
+	while (a_p < a_end && (*a_p == ' ' || *a_p == '\t' || *a_p == '\r')) {
+		++a_p;
+	}
+	return a_p;
+}
+
+static const char *skip_token(const char *a_p, const char *a_end)
+{
+	while (a_p < a_end && *a_p != ' ' && *a_p != '\t' && *a_p != '\r') {
+		++a_p;
+	}
+	return a_p;
+}
+
+static long block_end(stream_t *a_s, block_t *a_b)
+{
+	uint32_t val;
+
+	a_b->open = 0;
+	if (a_b->addr == 0 || a_b->vals) {
+		return 0;
+	}
+	if (access_read(a_s, a_b->addr, &val) == -1 || out_hex(a_s, val) == -1) {
+		return -1;
+	}
+	return 1;
+}
+
+/* one line without its newline, returns the number of accesses */
+static long text_line(stream_t *a_s, block_t *a_b, const char *a_p, const char *a_end)
+{
+	unsigned long val;
+	long num = 0;
+
+	a_p = skip_blank(a_p, a_end);
+	if (a_p == a_end) {
+		return block_end(a_s, a_b);
+	}
+
+	if (!a_b->open) {
+		a_p = parse_num(a_p, a_end, &val);
+		a_b->addr = val;
+		a_b->open = 1;
+		a_b->vals = 0;
+		a_p = skip_blank(skip_token(a_p, a_end), a_end);
+		if (a_p == a_end) {
+			// address without type is a single read
+			return block_end(a_s, a_b);
+		}
+		a_b->type = tolower((unsigned char)*a_p);
+		a_p = skip_blank(skip_token(a_p, a_end), a_end);
+	}
+
+	while (a_p < a_end) {
+		a_p = parse_num(a_p, a_end, &val);
+		a_p = skip_blank(skip_token(a_p, a_end), a_end);
+		++a_b->vals;
+		if (a_b->addr == 0) {
+			continue;
+		}
+		int width = (a_b->type == 'b') ? 1 : (a_b->type == 'h') ? 2 : (a_b->type == 'w') ? 4 : 0;
+		if (width == 0) {
+			continue;
+		}
+		if (access_write(a_s, a_b->addr, width, val) == -1) {
+			return -1;
+		}
+		++num;
+	}
+	return num;
+}
+
+long rp_stream_text(rpRegs_t *a_regs, int a_in, int a_out)
+{
+	static stream_t s;
+	static char buf[RP_STREAM_BUF_SIZE];
+	block_t b = { 0 };
+	size_t len = 0;
+	long total = 0;
+	long ret;
+
+	stream_init(&s, a_regs, a_out);
+
+	for (;;) {
+		// answer everything so far before waiting for more input
+		if (flush(&s) == -1) {
+			return -1;
+		}
+		ssize_t got = read(a_in, buf + len, sizeof(buf) - len);
+		if (got == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (got == 0) {
+			break;
+		}
+		len += got;
+
+		char *p = buf;
+		char *end = buf + len;
+		char *nl;
+		while ((nl = memchr(p, '\n', end - p)) != NULL) {
+			if ((ret = text_line(&s, &b, p, nl)) == -1) {
+				return -1;
+			}
+			total += ret;
+			p = nl + 1;
+		}
+		if (p == buf && len == sizeof(buf)) {
+			errno = E2BIG;
+			return -1;
+		}
+		len = end - p;
+		memmove(buf, p, len);
+	}
+
+	// last line without newline, then the last block
+	if (len) {
+		if ((ret = text_line(&s, &b, buf, buf + len)) == -1) {
+			return -1;
+		}
+		total += ret;
+	}
+	if (b.open) {
+		if ((ret = block_end(&s, &b)) == -1) {
+			return -1;
+		}
+		total += ret;
+	}
+	return (flush(&s) == -1) ? -1 : total;
+}
+
+long rp_stream_binary(rpRegs_t *a_regs, int a_in, int a_out)
+{
+	static stream_t s;
+	static rpRecord_t rec[RP_STREAM_BUF_SIZE / sizeof(rpRecord_t)];
+	size_t len = 0;
+	long total = 0;
+
+	stream_init(&s, a_regs, a_out);
+
+	for (;;) {
+		if (flush(&s) == -1) {
+			return -1;
+		}
+		ssize_t got = read(a_in, (uint8_t *)rec + len, sizeof(rec) - len);
+		if (got == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		if (got == 0) {
+			break;
+		}
+		len += got;
+
+		size_t num = len / sizeof(rpRecord_t);
+		for (size_t i = 0; i < num; ++i) {
+			if (rec[i].flags & RP_REC_READ) {
+				uint32_t val;
+				if (access_read(&s, rec[i].addr, &val) == -1 || out_reserve(&s, sizeof(val)) == -1) {
+					return -1;
+				}
+				memcpy(s.obuf + s.olen, &val, sizeof(val));
+				s.olen += sizeof(val);
+			} else if (access_write(&s, rec[i].addr, rec[i].width, rec[i].value) == -1) {
+				return -1;
+			}
+		}
+		total += num;
+		len -= num * sizeof(rpRecord_t);
+		memmove(rec, (uint8_t *)rec + num * sizeof(rpRecord_t), len);
+	}
+
+	if (len) {
+		// truncated record
+		errno = EINVAL;
+		return -1;
+	}
+	return (flush(&s) == -1) ? -1 : total;
+}
@@ -0,0 +1,60 @@
+/**
+ * @brief Register command streaming for the monitor '-' modes.
+ *
+ * Text format (monitor -), one block per access, blocks end with an empty
+ * line or when the address line has no type:
+ *
+ *   addr            read, prints 0x%08x
+ *   addr type       read if the block has no values
+ *   addr type val.. write every value in the block to addr (type b, h or w)
+ *   val val ..      more values for the same block
+ *
+ * Binary format (monitor -b) is a sequence of rpRecord_t in host byte
+ * order; every read record produces one uint32_t result.
+ *
+ * Input is parsed in place from large chunks and results are collected in
+ * one output buffer, nothing is allocated per command.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RP_STREAM_BUF_SIZE 65536
+
+/* rpRecord_t flags */
+#define RP_REC_READ 0x1
+
+typedef struct {
+	uint32_t addr;
+	uint16_t width;  // access width in bytes: 1, 2 or 4
+	uint16_t flags;  // RP_REC_READ, otherwise value is written
+	uint32_t value;
+} rpRecord_t;
+
+/*
+ * Execute all commands read from a_in, results are written to a_out.
+ * Returns the number of register accesses, -1 with errno set on failure
+ * (unmapped address, malformed record or I/O error).
+ */
+long rp_stream_text(rpRegs_t *a_regs, int a_in, int a_out);
+long rp_stream_binary(rpRegs_t *a_regs, int a_in, int a_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_H */
@@ -0,0 +1,182 @@
+/**
+ * @brief Waveform generator of the slow DACs.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <math.h>
+
+#include "decode.h"
+#include "wave.h"
+
+static const char *modeName[eWaveModeNum] = {
+	"off", "once", "loop"
+};
+
+static const char *trigName[eWaveTrigNum] = {
+	"none", "dio-rise", "dio-fall"
+};
+
+/* fine PWM patterns of 0-15 extra clocks, see slow_dac_coverter.v */
+static const uint16_t finePattern[16] = {
+	0x0000, 0x0001, 0x0101, 0x0821, 0x1111, 0x2491, 0x2929, 0x54a9,
+	0x5555, 0xab56, 0xd6d6, 0xdb6e, 0xeeee, 0xf7de, 0xfefe, 0xfffe
+};
+
+static volatile uint32_t *ams_regs(const rpRegs_t *a_regs)
+{
+	return (volatile uint32_t *)a_regs->ams;
+}
+
+const char *rp_wave_mode_name(waveMode_t a_mode)
+{
+	return (a_mode >= 0 && a_mode < eWaveModeNum) ? modeName[a_mode] : "?";
+}
+
+waveMode_t rp_wave_mode_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eWaveModeNum && strcasecmp(a_name, modeName[i]); ++i) {
+	}
+	return i;
+}
+
+const char *rp_wave_trig_name(waveTrig_t a_trig)
+{
+	return (a_trig >= 0 && a_trig < eWaveTrigNum) ? trigName[a_trig] : "?";
+}
+
+waveTrig_t rp_wave_trig_lookup(const char *a_name)
+{
+	int i;
+
+	for (i = 0; i < eWaveTrigNum && strcasecmp(a_name, trigName[i]); ++i) {
+	}
+	return i;
+}
+
+void rp_wave_defaults(waveConfig_t *a_cfg)
+{
+	memset(a_cfg, 0, sizeof(*a_cfg));
+	a_cfg->mode = eWaveOnce;
+	a_cfg->trig = eWaveTrigNone;
+	a_cfg->div = 1250;
+	a_cfg->len = RP_WAVE_DEPTH;
+}
+
+int rp_wave_check(const waveConfig_t *a_cfg)
+{
+	if (a_cfg->ch < 0 || a_cfg->ch >= SLOW_DAC_NUM ||
+	    a_cfg->mode < 0 || a_cfg->mode >= eWaveModeNum ||
+	    a_cfg->trig < 0 || a_cfg->trig >= eWaveTrigNum) {
+		return -EINVAL;
+	}
+	if (a_cfg->dio < 0 || a_cfg->dio > 7 || a_cfg->div < 1 ||
+	    a_cfg->len < 1 || a_cfg->len > RP_WAVE_DEPTH) {
+		return -ERANGE;
+	}
+	return 0;
+}
+
+uint32_t rp_wave_div(double a_rate)
+{
+	if (!(a_rate > 0)) {
+		return UINT32_MAX;
+	}
+	double div = round(RP_WAVE_CLOCK / a_rate);
+	return (div < 1) ? 1 : (div > UINT32_MAX) ? UINT32_MAX : (uint32_t)div;
+}
+
+double rp_wave_rate(uint32_t a_div)
+{
+	return RP_WAVE_CLOCK / (a_div ? a_div : 1);
+}
+
+uint32_t rp_wave_word(double a_volts)
+{
+	const long full = 16 * RP_DEC_PWM_FULL;
+	long cnt = lround(a_volts / 1.8 * full);
+
+	cnt = (cnt < 0) ? 0 : (cnt > full) ? full : cnt;
+	return ((uint32_t)(cnt >> 4) << 16) | finePattern[cnt & 0xf];
+}
+
+double rp_wave_volts(uint32_t a_word)
+{
+	uint32_t cnt = 16 * ((a_word >> 16) & 0xff) + __builtin_popcount(a_word & 0xffff);
+	return 1.8 * cnt / (16 * RP_DEC_PWM_FULL);
+}
+
+int rp_wave_load(rpRegs_t *a_regs, int a_ch, const uint32_t *a_words, uint32_t a_num)
+{
+	if (a_ch < 0 || a_ch >= SLOW_DAC_NUM || a_num > RP_WAVE_DEPTH) {
+		errno = EINVAL;
+		return -1;
+	}
+	volatile void *buf = rp_map_block(a_regs, RP_ADDR_AMS + RP_WAVE_BUF(a_ch), RP_WAVE_DEPTH * sizeof(uint32_t));
+	if (buf == NULL) {
+		return -1;
+	}
+	// whole words only, the table ignores the bus byte selects
+	volatile uint32_t *dst = buf;
+	for (uint32_t i = 0; i < a_num; ++i) {
+		dst[i] = a_words[i];
+	}
+	return 0;
+}
+
+int rp_wave_start(rpRegs_t *a_regs, const waveConfig_t *a_cfg)
+{
+	volatile uint32_t *ams = ams_regs(a_regs);
+	int ret = rp_wave_check(a_cfg);
+	int ch = a_cfg->ch;
+
+	if (ret) {
+		return ret;
+	}
+	uint32_t cfg = a_cfg->mode | (a_cfg->dio << 8);
+	if (a_cfg->trig != eWaveTrigNone) {
+		cfg |= 0x10 | ((a_cfg->trig == eWaveTrigDioFall) << 12);
+	}
+	ams[RP_WAVE_CTRL >> 2]     = RP_WAVE_STOP(ch);
+	ams[RP_WAVE_CFG(ch) >> 2]  = cfg;
+	ams[RP_WAVE_DIV(ch) >> 2]  = a_cfg->div - 1;
+	ams[RP_WAVE_LEN(ch) >> 2]  = a_cfg->len - 1;
+	ams[RP_WAVE_CTRL >> 2]     = RP_WAVE_START(ch);
+	rp_sync(a_regs);
+	return 0;
+}
+
+void rp_wave_trigger(rpRegs_t *a_regs, uint32_t a_mask)
+{
+	ams_regs(a_regs)[RP_WAVE_CTRL >> 2] = RP_WAVE_SWTRIG(0) * (a_mask & 0xf);
+	rp_sync(a_regs);
+}
+
+void rp_wave_stop(rpRegs_t *a_regs, uint32_t a_mask)
+{
+	ams_regs(a_regs)[RP_WAVE_CTRL >> 2] = RP_WAVE_STOP(0) * (a_mask & 0xf);
+	rp_sync(a_regs);
+}
+
+uint32_t rp_wave_status(const rpRegs_t *a_regs)
+{
+	return ams_regs(a_regs)[RP_WAVE_CTRL >> 2];
+}
+
+uint32_t rp_wave_pos(const rpRegs_t *a_regs, int a_ch)
+{
+	return ams_regs(a_regs)[RP_WAVE_POS(a_ch) >> 2];
+}
@@ -0,0 +1,124 @@
+/**
+ * @brief Waveform generator of the slow DACs.
+ *
+ * Drives red_pitaya_ams_wave.v: every slow DAC has a table of
+ * RP_WAVE_DEPTH PWM words in block RAM that the FPGA plays with a fixed
+ * number of clocks per entry, once, in a loop, or from a DIO_P edge on.
+ * Tables are written in one go through the mapped table window.
+ *
+ * @Author Lewis Woolfson
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef WAVE_H
+#define WAVE_H
+
+#include <stdint.h>
+
+#include "rp_regs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* registers in the AMS window, see red_pitaya_ams_wave.v */
+#define RP_WAVE_CTRL      0x050
+#define RP_WAVE_CFG(n)    (0x100 + 0x10 * (n))
+#define RP_WAVE_DIV(n)    (0x104 + 0x10 * (n))
+#define RP_WAVE_LEN(n)    (0x108 + 0x10 * (n))
+#define RP_WAVE_POS(n)    (0x10C + 0x10 * (n))
+#define RP_WAVE_BUF(n)    (0x10000 + 0x1000 * (n))
+
+/* entries per table and the clock that times them */
+#define RP_WAVE_DEPTH     1024
+#define RP_WAVE_CLOCK     125000000.0
+/*
+ * The PWM stage takes a new word every 16 PWM periods of 156 clocks at
+ * 250 MHz; faster tables skip entries on the output.
+ */
+#define RP_WAVE_PWM_RATE  (250e6 / (16 * 156))
+
+/* written bits of RP_WAVE_CTRL, shifted by the channel index 0-3 */
+#define RP_WAVE_START(n)    (0x001 << (n))
+#define RP_WAVE_STOP(n)     (0x010 << (n))
+#define RP_WAVE_SWTRIG(n)   (0x100 << (n))
+/* status bits read from RP_WAVE_CTRL */
+#define RP_WAVE_RUNNING(n)  (0x001 << (n))
+#define RP_WAVE_ARMED(n)    (0x010 << (n))
+#define RP_WAVE_DONE(n)     (0x100 << (n))
+#define RP_WAVE_ACTIVE(n)   (0x1000 << (n))
+
+/*
+ * Stand-in images only: the status word rp_sync() keeps, the control
+ * register itself reads back what was last written.
+ */
+#define RP_WAVE_SIM_STATUS 0xFFC
+
+typedef enum {
+	eWaveOff=0,
+	eWaveOnce,    // plays the table once and holds the last entry
+	eWaveLoop,
+	eWaveModeNum
+} waveMode_t;
+
+typedef enum {
+	eWaveTrigNone=0,  // runs on start
+	eWaveTrigDioRise,
+	eWaveTrigDioFall,
+	eWaveTrigNum
+} waveTrig_t;
+
+typedef struct {
+	int ch;           // slow DAC 0-3
+	waveMode_t mode;
+	waveTrig_t trig;
+	int dio;          // DIO_P pin 0-7 of the DIO triggers
+	uint32_t div;     // clocks per entry, 1 or more
+	uint32_t len;     // entries, 1 - RP_WAVE_DEPTH
+} waveConfig_t;
+
+/* Names used on the command line: off, once, loop / none, dio-rise, dio-fall */
+const char *rp_wave_mode_name(waveMode_t a_mode);
+waveMode_t rp_wave_mode_lookup(const char *a_name);
+const char *rp_wave_trig_name(waveTrig_t a_trig);
+waveTrig_t rp_wave_trig_lookup(const char *a_name);
+
+/* Default configuration: DAC 0, one-shot, no trigger, 10 us per entry, full table */
+void rp_wave_defaults(waveConfig_t *a_cfg);
+/* 0 if a_cfg is valid, -EINVAL for an unknown channel, mode or trigger, -ERANGE otherwise */
+int rp_wave_check(const waveConfig_t *a_cfg);
+
+/* Clocks per entry closest to a_rate entries per second, and back */
+uint32_t rp_wave_div(double a_rate);
+double rp_wave_rate(uint32_t a_div);
+
+/*
+ * PWM word of a_volts (0 - 1.8 V), with the 16 fine steps of
+ * slow_dac_converter.v between the coarse counts, and back.
+ */
+uint32_t rp_wave_word(double a_volts);
+double rp_wave_volts(uint32_t a_word);
+
+/*
+ * Writes a_num words (at most RP_WAVE_DEPTH) to the table of DAC a_ch.
+ * Returns 0, -1 with errno set on failure.
+ */
+int rp_wave_load(rpRegs_t *a_regs, int a_ch, const uint32_t *a_words, uint32_t a_num);
+
+/* Configures and starts (or arms) a channel, returns rp_wave_check() */
+int rp_wave_start(rpRegs_t *a_regs, const waveConfig_t *a_cfg);
+/* Software trigger and stop of the channels in a_mask (bit n = DAC n) */
+void rp_wave_trigger(rpRegs_t *a_regs, uint32_t a_mask);
+void rp_wave_stop(rpRegs_t *a_regs, uint32_t a_mask);
+uint32_t rp_wave_status(const rpRegs_t *a_regs);
+/* Table entry DAC a_ch is playing */
+uint32_t rp_wave_pos(const rpRegs_t *a_regs, int a_ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_H */